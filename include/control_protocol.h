@@ -0,0 +1,72 @@
+#ifndef __CONTROL_PROTOCOL_H__
+#define __CONTROL_PROTOCOL_H__
+
+#include <cstdint>
+#include <cstddef>
+
+#include "cmd_dispatch.hpp"
+#include "radio_device.h"
+
+#define CONTROL_FRAME_MAX_LEN 11
+
+/// @brief 2.4G信道表：频率 = 基础频率 + 步进 × 信道序号
+///        信道码为信道序号 × CHANNEL_CODE_STEP
+#define CHANNEL_BASE_MHZ 2402
+#define CHANNEL_STEP_MHZ 7
+#define CHANNEL_CODE_STEP 5
+#define CHANNEL_COUNT 16
+
+/// @brief 将信道码转换成频率
+/// @param code 信道码
+/// @return 频率，单位为Hz，非法信道码返回0
+constexpr uint32_t channel_code_to_hz(uint8_t code)
+{
+    return (code % CHANNEL_CODE_STEP == 0 && code / CHANNEL_CODE_STEP < CHANNEL_COUNT)
+               ? (CHANNEL_BASE_MHZ + CHANNEL_STEP_MHZ * (code / CHANNEL_CODE_STEP)) * 1000000UL
+               : 0;
+}
+
+/// @brief 换频命令：c0 00 08 00 00 e7 80 [信道码] 00 00 00
+/// @param radio 需要换频的设备
+/// @param data 数据，长度已由命令签名保证
+/// @return 是否换频成功
+inline bool control_channel_hop(RadioDevice &radio, const uint8_t *data, size_t)
+{
+    const uint32_t frequency_hz{channel_code_to_hz(data[7])};
+    if (frequency_hz == 0)
+    {
+        return false;
+    }
+    return radio.retune(frequency_hz) == frequency_hz;
+}
+
+using ControlEntry = CmdEntry<RadioDevice, CONTROL_FRAME_MAX_LEN>;
+
+/// @brief 控制命令表，新增控制帧时在此追加
+constexpr ControlEntry control_table[]{
+    {{11,
+      {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0xff, 0xff, 0xff},
+      {0xc0, 0x00, 0x08, 0x00, 0x00, 0xe7, 0x80, 0x00, 0x00, 0x00, 0x00}},
+     control_channel_hop},
+};
+
+/// @brief 解析并执行控制帧
+/// @param radio 控制帧作用的设备
+/// @param data 数据
+/// @param len 数据长度
+/// @return 分发结果
+inline CmdResult control_dispatch(RadioDevice &radio, const uint8_t *data, size_t len)
+{
+    return cmd_dispatch(control_table, radio, data, len);
+}
+
+/// @brief 判断数据是否为控制帧
+/// @param data 数据
+/// @param len 数据长度
+/// @return 是否为控制帧
+inline bool control_match(const uint8_t *data, size_t len)
+{
+    return cmd_match(control_table, data, len);
+}
+
+#endif // __CONTROL_PROTOCOL_H__
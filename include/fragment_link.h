@@ -0,0 +1,130 @@
+#ifndef __FRAGMENT_LINK_H__
+#define __FRAGMENT_LINK_H__
+
+#include <cstdint>
+#include <cstddef>
+
+#include "radio_device.h"
+#include "fragment.hpp"
+
+/// @brief 在RadioDevice之上提供自动分片与重组，使长度超过单包MTU的串口帧可以完整传输
+///        分片通过send_async发送，不阻塞；发送队列已满时保存进度，之后从未发送的分片继续
+///        注意：分片头会改变空中数据格式，对端也需要使用FragmentLink
+/// @tparam _Mtu 设备单包最大长度，nRF24为32字节
+/// @tparam _Slots 可同时发送和重组的帧数量
+template <size_t _Mtu = 32, size_t _Slots = 4>
+class FragmentLink
+{
+private:
+    /// @brief 正在发送的帧，以帧数据的地址识别同一帧的重试
+    struct __Pending
+    {
+        const uint8_t *data{nullptr};
+        FragmentCursor<_Mtu> cursor;
+    };
+
+    RadioDevice &__radio;
+    Fragmenter<_Mtu> __fragmenter;
+    Reassembler<_Mtu, _Slots> __reassembler;
+    __Pending __pending[_Slots];
+
+public:
+    static constexpr size_t max_frame_size{Fragmenter<_Mtu>::max_frame_size};
+
+    /// @param radio 底层设备
+    /// @param timeout_ms 重组超时时间，单位为毫秒
+    explicit FragmentLink(RadioDevice &radio, uint32_t timeout_ms = 100)
+        : __radio(radio), __reassembler(timeout_ms) {}
+
+    /// @brief 开始对一个帧分片，由调用者控制每个分片的发送时机，
+    ///        可以在两个分片之间插入其它帧（如控制帧）的分片
+    /// @param data 帧数据，在所有分片发送完之前必须保持有效
+    /// @param len 帧长度
+    /// @return 分片游标
+    FragmentCursor<_Mtu> begin(const uint8_t *data, size_t len)
+    {
+        return __fragmenter.begin(data, len);
+    }
+
+    /// @brief 发送游标中的下一个分片，发送队列已满时游标不前进
+    /// @param cursor 分片游标
+    /// @return 是否发送成功，游标已结束时返回false
+    bool send_next(FragmentCursor<_Mtu> &cursor)
+    {
+        uint8_t packet[_Mtu];
+        auto next{cursor};
+        const size_t len{next.next(packet)};
+        if (len == 0 || !__radio.send_async(packet, len))
+        {
+            return false;
+        }
+        cursor = next;
+        return true;
+    }
+
+    /// @brief 分片并发送整个帧，不阻塞
+    ///        发送队列已满时返回false并保存进度，之后以相同的data再次调用时从未发送的分片继续，
+    ///        其它帧（如控制帧）可以在此期间发送，最多同时有_Slots个帧未发送完
+    /// @param data 帧数据，在返回true之前必须保持有效且地址不变
+    /// @param len 帧长度，0或超过max_frame_size时返回false
+    /// @return 全部分片都已交给设备时返回true
+    bool send(const uint8_t *data, size_t len)
+    {
+        __Pending *pending{nullptr};
+        for (auto &item : __pending)
+        {
+            if (item.data == data)
+            {
+                pending = &item;
+                break;
+            }
+            if (!pending && !item.data)
+            {
+                pending = &item;
+            }
+        }
+        if (!pending)
+        {
+            return false; // 未发送完的帧过多
+        }
+        if (pending->data != data)
+        {
+            pending->cursor = begin(data, len);
+            if (pending->cursor.done())
+            {
+                return false;
+            }
+            pending->data = data;
+        }
+        while (!pending->cursor.done())
+        {
+            if (!send_next(pending->cursor))
+            {
+                return false;
+            }
+        }
+        pending->data = nullptr;
+        return true;
+    }
+
+    /// @brief 输入从设备收到的一个数据包
+    /// @tparam _FrameFun 形如 void(const uint8_t *data, size_t len) 的回调
+    /// @param packet 数据包
+    /// @param len 数据包长度
+    /// @param now_ms 当前时间，单位为毫秒
+    /// @param on_frame 帧重组完成时调用，数据只在回调期间有效
+    /// @return 是否有帧重组完成
+    template <typename _FrameFun>
+    bool receive(const uint8_t *packet, size_t len, uint32_t now_ms, _FrameFun &&on_frame)
+    {
+        return __reassembler.push(packet, len, now_ms, on_frame);
+    }
+
+    /// @brief 读取重组统计
+    const typename Reassembler<_Mtu, _Slots>::Stats &stats() const
+    {
+        return __reassembler.stats();
+    }
+};
+
+#endif // __FRAGMENT_LINK_H__
@@ -0,0 +1,43 @@
+#ifndef __FSK_PROFILES_H__
+#define __FSK_PROFILES_H__
+
+#include <cstdint>
+#include <cstddef>
+
+#include "link_adapt.hpp"
+
+/// @brief SX1262 FSK速率档位
+///        频偏为比特率的一半（调制指数1），接收带宽取SX126x支持的、不小于卡森带宽（比特率 + 2 × 频偏）的最小值；
+///        门限按 -174 + 10lg(接收带宽) + 噪声系数6 dB + 解调信噪比9 dB 估算灵敏度，再留3 dB余量
+struct FskProfile
+{
+    float bitrate_kbps;
+    float freq_dev_khz;
+    float rx_bw_khz;
+    int16_t min_rssi_x10; // 维持该档位所需的RSSI，单位为0.1 dBm
+};
+
+constexpr FskProfile fsk_profiles[]{
+    {4.8f, 2.4f, 11.7f, -1153},
+    {9.6f, 4.8f, 23.4f, -1123},
+    {19.2f, 9.6f, 46.9f, -1093},
+    {30.0f, 15.0f, 78.2f, -1071},
+    {60.0f, 30.0f, 156.2f, -1041},
+    {120.0f, 60.0f, 312.0f, -1011},
+};
+
+#define FSK_PROFILE_COUNT (sizeof(fsk_profiles) / sizeof(fsk_profiles[0]))
+#define FSK_PROFILE_HOME 3 // 启动档位，与原来的30 kbps比特率相同
+
+/// @brief 由档位表生成链路自适应的门限配置
+inline LinkAdapter<FSK_PROFILE_COUNT>::Config fsk_adapt_config()
+{
+    LinkAdapter<FSK_PROFILE_COUNT>::Config config{};
+    for (size_t i = 0; i < FSK_PROFILE_COUNT; ++i)
+    {
+        config.min_rssi_x10[i] = fsk_profiles[i].min_rssi_x10;
+    }
+    return config;
+}
+
+#endif // __FSK_PROFILES_H__
@@ -3,14 +3,145 @@
 
 #include <RadioLib.h>
 #include <cstdint>
+#include <mutex>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "radio_device.h"
+#include "spsc_queue.hpp"
+#include "packet_pool.hpp"
+#include "metrics.hpp"
+
+#ifndef NRF24_TX_QUEUE_SIZE
+#define NRF24_TX_QUEUE_SIZE 8 // 异步发送队列长度，必须为2的幂
+#endif
+
+#ifndef NRF24_TX_TIMEOUT_MS
+#define NRF24_TX_TIMEOUT_MS 10 // 等待TX_DS/MAX_RT中断的超时时间
+#endif
+
+#ifndef NRF24_RX_POOL_SLOTS
+#define NRF24_RX_POOL_SLOTS 8 // 接收数据包池槽位数量，同时作为接收队列长度，必须为2的幂
+#endif
 
 class nRF24Device : public RadioDevice
 {
 private:
     SPIClass *__radio_spi{nullptr}; // 默认为HSPI
     SPISettings __spi_setting{60000000, MSBFIRST, SPI_MODE0};
+    Module *__radio_mod{nullptr}; // 与__radio共用，用于直接访问TX FIFO
     nRF24 *__radio{nullptr};
+    std::mutex __lock; // 保护对射频芯片的访问，换频时用于暂停收发
+
+    /// @brief 换频的实际实现，调用前需要持有__lock
+    uint32_t __set_frequency(uint32_t frequency);
+
+public:
+    /// @brief 异步发送统计
+    struct TxStats
+    {
+        std::atomic<uint32_t> queued{0};    // 进入发送队列的数据包数量
+        std::atomic<uint32_t> sent{0};      // 发送完成的数据包数量
+        std::atomic<uint32_t> failed{0};    // 发送失败（启动失败或中断超时）的数据包数量
+        std::atomic<uint32_t> max_depth{0}; // 发送队列深度的最大值
+    };
+
+    /// @brief 接收统计
+    struct RxStats
+    {
+        std::atomic<uint32_t> received{0};    // 进入接收队列的数据包数量
+        std::atomic<uint32_t> dropped{0};     // 接收数据包池耗尽而丢弃的数据包数量
+        std::atomic<uint32_t> failed{0};      // 读取失败的数据包数量
+        std::atomic<uint32_t> turnarounds{0}; // 从发送切换到接收的次数
+    };
+
+    using RxPacketPool = PacketPool<RADIOLIB_NRF24_MAX_PACKET_LENGTH, NRF24_RX_POOL_SLOTS>;
+    using RxPacket = RxPacketPool::Packet;
+
+    /// @brief 从send_async入队到发送完成的时延分布，单位为微秒
+    using TxLatencyHistogram = Histogram<6>;
+
+    /// @brief 异步发送完成回调，在收发任务中调用
+    /// @param success 是否发送成功
+    /// @param size 数据长度
+    using tx_callback_t = void (*)(bool success, size_t size);
+
+    /// @brief 有新数据包进入接收队列时的回调，在收发任务中调用，不能阻塞
+    using rx_callback_t = void (*)();
+
+private:
+    struct __TxPacket
+    {
+        uint32_t queued_us; // 入队时间，用于统计发送时延
+        uint32_t trace_id;  // 数据包标识，send_async时取自TRACE_CURRENT
+        uint8_t len;
+        uint8_t data[RADIOLIB_NRF24_MAX_PACKET_LENGTH];
+    };
+
+    // 收发任务的通知位，IRQ引脚由TX_DS/MAX_RT与RX_DR共用，
+    // 由收发任务当前所处的阶段区分中断来源
+    static constexpr uint32_t __NOTIFY_WAKE{1UL << 0}; // 有新的发送数据或需要重新进入接收
+    static constexpr uint32_t __NOTIFY_IRQ{1UL << 1};  // IRQ引脚中断
+
+    // RadioLib没有提供连续写入TX FIFO的接口，以下命令和寄存器取自nRF24L01+数据手册
+    static constexpr uint8_t __CMD_W_TX_PAYLOAD{0xA0};
+    static constexpr uint8_t __CMD_FLUSH_TX{0xE1};
+    static constexpr uint8_t __REG_STATUS{0x07};
+    static constexpr uint8_t __REG_FIFO_STATUS{0x17};
+    static constexpr uint8_t __STATUS_TX_DS{0x20};
+    static constexpr uint8_t __STATUS_MAX_RT{0x10};
+    static constexpr uint8_t __FIFO_TX_EMPTY{0x10};
+    static constexpr uint8_t __FIFO_RX_EMPTY{0x01};
+    static constexpr uint32_t __FIFO_DEPTH{3}; // 芯片TX FIFO和RX FIFO各自可以容纳的数据包数量
+
+    SpscRingQueue<__TxPacket, NRF24_TX_QUEUE_SIZE> __tx_queue; // 调用send_async的任务写入，收发任务读取
+    tx_callback_t __tx_callback{nullptr};
+    TxStats __tx_stats;
+    TxLatencyHistogram __tx_latency{{250, 500, 1000, 2000, 5000, 10000}};
+
+    // 接收队列中只传递数据包句柄，句柄总数受数据包池限制，因此队列不会溢出
+    RxPacketPool __rx_pool;
+    SpscRingQueue<RxPacketPool::handle_t, NRF24_RX_POOL_SLOTS> __rx_queue; // 收发任务写入，调用rx_front的任务读取
+    rx_callback_t __rx_callback{nullptr};
+    RxStats __rx_stats;
+
+    TaskHandle_t __trx_task{nullptr};
+    bool __rx_armed{false}; // 芯片是否处于接收状态，由__lock保护
+
+    static nRF24Device *__irq_owner; // IRQ中断对应的设备，只支持一个nRF24
+    static void __on_irq();
+    static void __trx_task_entry(void *arg);
+    void __trx_loop();
+
+    /// @brief 连续发送队列中的全部数据包，TX FIFO中保持最多3个数据包，发送期间CE保持高电平
+    void __transmit_pending();
+
+    /// @brief 移除发送队列头部的数据包并更新统计，调用发送完成回调
+    void __retire_tx(bool success);
+
+    /// @brief 进入接收状态并等待数据包或新的发送请求
+    void __receive_once();
+
+    /// @brief 读取一个数据包到接收队列，调用前需要持有__lock
+    void __read_packet();
+
+    /// @brief 读取RX FIFO中的全部数据包后清除IRQ通知，调用前需要持有__lock
+    ///        RX FIFO非空时RX_DR不会产生新的中断，因此每次中断和离开接收状态前都需要读空
+    void __drain_rx();
+
+    /// @brief 清除残留的IRQ通知
+    void __clear_irq();
+
+    /// @brief 等待IRQ中断
+    /// @param timeout 超时时间
+    /// @return 超时返回false
+    bool __wait_irq(TickType_t timeout);
+
+    /// @brief 唤醒收发任务，芯片状态被外部改变后需要调用以重新进入接收
+    void __wake();
+
+    /// @brief 启动收发任务，在init成功后调用
+    bool __start_trx_engine();
 
 public:
     /// @brief 构造函数
@@ -53,20 +184,70 @@ public:
     /// @return bool
     bool send(uint8_t *message, size_t size) override;
 
-    /// @brief 接收数据
-    /// @param buffer 接收数据的缓冲区
+    /// @brief 异步发送数据，数据被复制到发送队列后立即返回，由收发任务根据IRQ中断连续发送
+    ///        注意：只能由一个任务调用（发送队列为单生产者）
+    /// @param message 需要发送的数据
+    /// @param size 数据长度，不能超过32字节
+    /// @return 队列已满或数据过长返回false
+    bool send_async(const uint8_t *message, size_t size) override;
+
+    /// @brief 设置异步发送完成回调
+    /// @param callback 回调函数，nullptr表示不需要回调
+    void set_tx_callback(tx_callback_t callback) { __tx_callback = callback; }
+
+    /// @brief 读取异步发送统计
+    const TxStats &tx_stats() const { return __tx_stats; }
+
+    /// @brief 查询异步发送队列中等待发送的数据包数量
+    uint32_t tx_queue_depth() const { return __tx_queue.len(); }
+
+    /// @brief 读取发送时延分布
+    const TxLatencyHistogram &tx_latency() const { return __tx_latency; }
+
+    /// @brief 访问接收队列头部的数据包，数据在rx_pop之前保持有效
+    ///        注意：只能由一个任务调用（接收队列为单消费者），与recv不能同时使用
+    /// @return 接收队列为空返回nullptr
+    const RxPacket *rx_front();
+
+    /// @brief 移除接收队列头部的数据包并归还到数据包池
+    void rx_pop();
+
+    /// @brief 设置接收回调
+    /// @param callback 回调函数，nullptr表示不需要回调
+    void set_rx_callback(rx_callback_t callback) { __rx_callback = callback; }
+
+    /// @brief 读取接收统计
+    const RxStats &rx_stats() const { return __rx_stats; }
+
+    /// @brief 查询接收队列中等待读取的数据包数量
+    uint32_t rx_queue_depth() const { return __rx_queue.len(); }
+
+    /// @brief 接收数据，从接收队列中取出一个数据包，不阻塞
+    /// @param buffer 接收数据的缓冲区，长度至少为32字节
     /// @param size 接收数据的长度
-    /// @return bool
+    /// @return 接收队列为空返回false
     bool recv(uint8_t *buffer, size_t &size) override;
 
-    int32_t set_frequency(uint32_t frequency) override;
+    uint32_t set_frequency(uint32_t frequency) override;
 
+    uint32_t retune(uint32_t frequency_hz) override;
+
+    /// @param power 输出功率，单位为dBm，按int8_t解释，可选-18、-12、-6、0，负数功率需要先转换为uint8_t
+    /// @return 设置成功返回power，失败返回0（0 dBm成功时同样返回0，需要区分时使用set_link_profile）
     uint8_t set_power(uint8_t power) override;
 
+    /// @param rate 数据速率，单位为kbps，可选250、1000、2000
     uint32_t set_data_rate(uint32_t rate) override;
 
+    /// @param addr_width 地址宽度，可选3～5字节，修改后需要重新设置收发地址
     uint8_t set_addr_width(uint8_t addr_width) override;
 
+    /// @brief 同时切换数据速率和输出功率，只暂停一次收发
+    /// @param data_rate_kbps 数据速率，单位为kbps，可选250、1000、2000
+    /// @param power_dbm 输出功率，单位为dBm，可选-18、-12、-6、0
+    /// @return 是否成功
+    bool set_link_profile(uint16_t data_rate_kbps, int8_t power_dbm);
+
     bool shutdown() override;
 
     bool reboot() override;
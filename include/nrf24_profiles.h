@@ -0,0 +1,42 @@
+#ifndef __NRF24_PROFILES_H__
+#define __NRF24_PROFILES_H__
+
+#include <cstdint>
+#include <cstddef>
+
+#include "link_adapt.hpp"
+
+/// @brief nRF24速率/功率档位，从最稳健到速率最高、功率最低排列
+///        近距离时先提高数据速率，已经是2 Mbps仍然没有丢包时再降低输出功率，减少对其它设备的干扰；
+///        nRF24不提供RSSI，只按丢包率切换
+struct Nrf24Profile
+{
+    uint16_t data_rate_kbps;
+    int8_t power_dbm;
+};
+
+constexpr Nrf24Profile nrf24_profiles[]{
+    {250, 0},
+    {1000, 0},
+    {2000, 0},
+    {2000, -6},
+    {2000, -12},
+};
+
+#define NRF24_PROFILE_COUNT (sizeof(nrf24_profiles) / sizeof(nrf24_profiles[0]))
+#define NRF24_PROFILE_HOME 1 // 启动档位，与原来的1000 kbps、0 dBm相同
+
+/// @brief 链路自适应配置，没有RSSI时只能试探升档，因此需要更多连续的无丢包窗口
+inline LinkAdapter<NRF24_PROFILE_COUNT>::Config nrf24_adapt_config()
+{
+    LinkAdapter<NRF24_PROFILE_COUNT>::Config config{};
+    for (size_t i = 0; i < NRF24_PROFILE_COUNT; ++i)
+    {
+        config.min_rssi_x10[i] = LINK_RSSI_UNKNOWN;
+    }
+    config.up_loss_permille = 10;
+    config.up_windows = 5;
+    return config;
+}
+
+#endif // __NRF24_PROFILES_H__
@@ -0,0 +1,65 @@
+#ifndef __PTY_SERIAL_H__
+#define __PTY_SERIAL_H__
+
+#include <cstdlib>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+/// @brief 伪终端，代替Linux上不存在的硬件串口
+///        转发程序使用主设备端，外部程序（串口工具、测试脚本）打开slave_name()对应的从设备
+class PtySerial
+{
+private:
+    int __master{-1};
+    char __slave_name[64]{}; // ptsname返回的是静态缓存，多个伪终端需要各自保存
+
+public:
+    PtySerial() = default;
+    PtySerial(const PtySerial &) = delete;
+    PtySerial &operator=(const PtySerial &) = delete;
+
+    ~PtySerial()
+    {
+        if (__master >= 0)
+        {
+            close(__master);
+        }
+    }
+
+    /// @brief 创建伪终端，设置为原始模式（不回显、不处理换行），主设备端为非阻塞
+    /// @return 是否成功
+    bool open()
+    {
+        __master = posix_openpt(O_RDWR | O_NOCTTY);
+        if (__master < 0 || grantpt(__master) != 0 || unlockpt(__master) != 0)
+        {
+            return false;
+        }
+        termios attr;
+        if (ptsname_r(__master, __slave_name, sizeof(__slave_name)) != 0 || tcgetattr(__master, &attr) != 0)
+        {
+            return false;
+        }
+        cfmakeraw(&attr);
+        if (tcsetattr(__master, TCSANOW, &attr) != 0)
+        {
+            return false;
+        }
+        return fcntl(__master, F_SETFL, fcntl(__master, F_GETFL) | O_NONBLOCK) == 0;
+    }
+
+    /// @brief 主设备端的文件描述符，用于FdByteSource和FdPort
+    int fd() const
+    {
+        return __master;
+    }
+
+    /// @brief 从设备路径，如/dev/pts/3
+    const char *slave_name() const
+    {
+        return __slave_name;
+    }
+};
+
+#endif // __PTY_SERIAL_H__
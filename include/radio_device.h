@@ -26,6 +26,15 @@ public:
         return send((uint8_t *)message.data(), message.size());
     }
 
+    /// @brief 异步发送数据，数据被复制后立即返回，默认实现为同步发送
+    /// @param message 需要发送的数据
+    /// @param size 数据长度
+    /// @return 发送队列已满或数据过长返回false
+    virtual bool send_async(const uint8_t *message, size_t size)
+    {
+        return send(const_cast<uint8_t *>(message), size);
+    }
+
     /// @brief 接收数据
     /// @param buffer 接收数据的缓冲区
     /// @param size 接收数据的长度
@@ -35,7 +44,13 @@ public:
     /// @brief 设置设备的工作频率
     /// @param frequency_hz 目前工作频率，单位为Hz
     /// @return 返回设置后真实的频率，单位为Hz，0表示失败
-    virtual int32_t set_frequency(uint32_t frequency_hz) = 0;
+    virtual uint32_t set_frequency(uint32_t frequency_hz) = 0;
+
+    /// @brief 在线切换工作频率，不重启设备：等待当前发送完成、暂停收发、换频后恢复
+    ///        换频期间调用send/recv会阻塞，换频完成后继续，队列中的数据不会丢失
+    /// @param frequency_hz 目标频率，单位为Hz
+    /// @return 返回设置后真实的频率，单位为Hz，0表示失败
+    virtual uint32_t retune(uint32_t frequency_hz) { return set_frequency(frequency_hz); }
 
     /// @brief 设置设备的功率
     /// @param power 输出功率，单位为dBm。默认值为-12 dBm。
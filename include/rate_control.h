@@ -0,0 +1,428 @@
+#ifndef __RATE_CONTROL_H__
+#define __RATE_CONTROL_H__
+
+#include <cstdint>
+#include <cstddef>
+
+#include "radio_device.h"
+#include "cmd_dispatch.hpp"
+#include "link_adapt.hpp"
+
+#define RATE_CONTROL_FRAME_LEN 13
+
+/// @brief 链路计数，由设备的收发统计得到
+struct LinkSample
+{
+    uint32_t tx_sent;     // 发送完成的数据包数量，包括速率控制帧
+    uint32_t rx_received; // 收到的数据包数量，包括速率控制帧
+    uint32_t rx_errors;   // CRC错误等读取失败的数据包数量
+    int16_t rssi_x10;     // 最近一个数据包的RSSI，单位为0.1 dBm，不支持时为LINK_RSSI_UNKNOWN
+};
+
+/// @brief 与对端协商切换速率档位（如FSK比特率/频偏/接收带宽，或nRF24的数据速率）
+///        双方周期发送心跳帧，携带自己的发送计数和建议档位，收到对端心跳时计算丢包率；
+///        发起方取两端建议档位的较小值，发送PROPOSE，应答方回复ACCEPT后延迟切换，发起方收到ACCEPT后立即切换；
+///        切换后在试用期内没有收到任何数据包则回到原档位，长时间收不到数据包则回到最稳健的0档
+///        速率控制帧格式：c0 00 08 00 00 e7 81 [操作] [档位] [序号] [建议档位] [发送计数低字节] [发送计数高字节]
+///        注意：poll与handle需要在同一个任务中调用，该任务通过send_async发送控制帧
+/// @tparam _Levels 档位数量，0档最稳健
+template <uint8_t _Levels>
+class RateControl
+{
+public:
+    /// @brief 切换到指定档位，返回是否成功
+    using apply_t = bool (*)(void *ctx, uint8_t level);
+
+    /// @brief 读取设备的链路计数
+    using sample_t = LinkSample (*)(void *ctx);
+
+    struct Config
+    {
+        typename LinkAdapter<_Levels>::Config adapt;
+        uint8_t home_level{0};              // 启动时的档位，两端必须相同
+        bool initiator{false};              // 是否由本端发起切换，两端必须不同
+        uint32_t window_ms{1000};           // 心跳周期，即统计窗口
+        uint32_t handshake_timeout_ms{300}; // 等待ACCEPT的时间
+        uint8_t handshake_retries{3};       // PROPOSE的重发次数
+        uint32_t switch_delay_ms{100};      // 应答方回复ACCEPT后切换前等待的时间，保证ACCEPT已经发出
+        uint32_t probation_ms{3000};        // 切换后需要收到数据包的时间，否则回到原档位
+        uint32_t link_lost_ms{5000};        // 收不到任何数据包的时间超过该值时回到0档
+    };
+
+    /// @brief 速率控制统计
+    struct Stats
+    {
+        uint32_t switches{0}; // 切换档位的次数
+        uint32_t reverts{0};  // 试用期内收不到数据而回退的次数
+        uint32_t lost{0};     // 链路中断后回到0档的次数
+        uint32_t rejected{0}; // 被对端拒绝的PROPOSE数量
+    };
+
+private:
+    enum : uint8_t
+    {
+        __OP_KEEPALIVE,
+        __OP_PROPOSE,
+        __OP_ACCEPT,
+        __OP_REJECT,
+    };
+
+    enum class __State : uint8_t
+    {
+        STABLE,
+        PROPOSING, // 发起方等待ACCEPT
+        SWITCHING, // 应答方已回复ACCEPT，等待切换时间
+        PROBATION, // 已切换，等待收到新档位上的数据包
+    };
+
+    RadioDevice &__radio;
+    Config __config;
+    apply_t __apply;
+    sample_t __sample;
+    void *__ctx;
+    LinkAdapter<_Levels> __adapter;
+    Stats __stats;
+
+    __State __state{__State::STABLE};
+    uint8_t __level;
+    uint8_t __prev_level;   // 试用期失败时回到的档位
+    uint8_t __target;       // 正在协商的档位
+    uint8_t __token{0};     // 协商序号，区分重发的PROPOSE
+    uint8_t __retries{0};
+    uint32_t __deadline_ms{0};
+    uint8_t __recommend;      // 本端的建议档位
+    uint8_t __peer_recommend; // 对端的建议档位
+
+    uint32_t __last_rx{0};      // 上一次poll时的接收计数
+    uint32_t __last_rx_ms{0};   // 最近一次收到数据包的时间
+    uint32_t __next_keepalive_ms{0};
+    bool __peer_valid{false};   // 是否收到过当前档位上的对端心跳
+    uint16_t __peer_sent{0};    // 上一个对端心跳中的发送计数
+    uint32_t __rx_at_peer{0};   // 收到上一个对端心跳时的接收计数
+    uint32_t __errors_at_peer{0};
+    uint32_t __last_peer_ms{0}; // 最近一次收到对端心跳（或切换档位）的时间
+
+    uint8_t __pending[RATE_CONTROL_FRAME_LEN]; // 发送队列已满时保存，下一次poll重发
+    bool __has_pending{false};
+
+    static constexpr uint8_t __header[7]{0xc0, 0x00, 0x08, 0x00, 0x00, 0xe7, 0x81};
+
+    /// @brief 发送队列已满时只能保存一帧，应答优先于提议，提议优先于心跳
+    static uint8_t __priority(uint8_t op)
+    {
+        return op == __OP_ACCEPT || op == __OP_REJECT ? 2 : op == __OP_PROPOSE ? 1 : 0;
+    }
+
+    /// @brief 重发保存的帧
+    void __flush()
+    {
+        if (__has_pending)
+        {
+            __has_pending = !__radio.send_async(__pending, RATE_CONTROL_FRAME_LEN);
+        }
+    }
+
+    void __send(uint8_t op, uint8_t level, uint8_t token)
+    {
+        const uint16_t sent{static_cast<uint16_t>(__sample(__ctx).tx_sent)};
+        uint8_t frame[RATE_CONTROL_FRAME_LEN];
+        for (size_t i = 0; i < sizeof(__header); ++i)
+        {
+            frame[i] = __header[i];
+        }
+        frame[7] = op;
+        frame[8] = level;
+        frame[9] = token;
+        frame[10] = __recommend;
+        frame[11] = static_cast<uint8_t>(sent);
+        frame[12] = static_cast<uint8_t>(sent >> 8);
+        // 先发出保存的帧，保持发送顺序
+        __flush();
+        if (!__has_pending && __radio.send_async(frame, RATE_CONTROL_FRAME_LEN))
+        {
+            return;
+        }
+        // 不用较低优先级的帧覆盖尚未发出的帧，例如ACCEPT不能被心跳替换
+        if (!__has_pending || __priority(op) >= __priority(__pending[7]))
+        {
+            for (size_t i = 0; i < RATE_CONTROL_FRAME_LEN; ++i)
+            {
+                __pending[i] = frame[i];
+            }
+            __has_pending = true;
+        }
+    }
+
+    /// @brief 切换档位并重新开始统计
+    void __switch(uint8_t level, uint32_t now_ms)
+    {
+        if (level == __level || !__apply(__ctx, level))
+        {
+            return;
+        }
+        __adapter.on_switched(level);
+        __prev_level = __level;
+        __level = __recommend = __peer_recommend = level;
+        __peer_valid = false;
+        __last_peer_ms = now_ms;
+        __last_rx = __sample(__ctx).rx_received;
+        __last_rx_ms = now_ms;
+        __next_keepalive_ms = now_ms; // 立即在新档位上发送心跳，让对端结束试用期
+        ++__stats.switches;
+    }
+
+    void __propose(uint8_t level, uint32_t now_ms)
+    {
+        __target = level;
+        __retries = __config.handshake_retries;
+        __state = __State::PROPOSING;
+        __deadline_ms = now_ms + __config.handshake_timeout_ms;
+        __send(__OP_PROPOSE, level, ++__token);
+    }
+
+    /// @brief 发起方取两端建议档位的较小值，与当前档位不同时发起协商
+    void __maybe_propose(uint32_t now_ms)
+    {
+        if (__config.initiator && __state == __State::STABLE)
+        {
+            const uint8_t target{__recommend < __peer_recommend ? __recommend : __peer_recommend};
+            if (target != __level)
+            {
+                __propose(target, now_ms);
+            }
+        }
+    }
+
+    /// @brief 根据对端心跳计算窗口内的丢包率并更新建议档位
+    void __on_keepalive(const uint8_t *data, uint32_t now_ms)
+    {
+        const LinkSample sample{__sample(__ctx)};
+        const uint16_t peer_sent{static_cast<uint16_t>(data[11] | data[12] << 8)};
+        __peer_recommend = data[10] < _Levels ? data[10] : __level;
+        if (__peer_valid)
+        {
+            // 两个心跳之间对端发出的数据包数量与本端收到的数量之差即为丢包
+            const uint16_t sent{static_cast<uint16_t>(peer_sent - __peer_sent)};
+            const uint16_t received{static_cast<uint16_t>(sample.rx_received - __rx_at_peer)};
+            const uint32_t errors{sample.rx_errors - __errors_at_peer};
+            uint32_t loss{sent > received ? (sent - received) * 1000U / sent : 0U};
+            if (errors > 0)
+            {
+                const uint32_t error_loss{errors * 1000U / (received + errors)};
+                loss = error_loss > loss ? error_loss : loss;
+            }
+            __recommend = __adapter.update(static_cast<uint16_t>(loss), sample.rssi_x10);
+        }
+        __peer_valid = true;
+        __peer_sent = peer_sent;
+        __rx_at_peer = sample.rx_received;
+        __errors_at_peer = sample.rx_errors;
+        __last_peer_ms = now_ms;
+        __maybe_propose(now_ms);
+    }
+
+    static bool __handle_keepalive(RateControl &self, const uint8_t *data, size_t)
+    {
+        self.__on_keepalive(data, self.__now_ms);
+        return true;
+    }
+
+    static bool __handle_propose(RateControl &self, const uint8_t *data, size_t)
+    {
+        const uint8_t level{data[8]};
+        if (self.__config.initiator || level >= _Levels)
+        {
+            return false;
+        }
+        if (self.__state == __State::SWITCHING)
+        {
+            // ACCEPT丢失时发起方会重发PROPOSE，切换前再次应答
+            self.__send(level == self.__target ? __OP_ACCEPT : __OP_REJECT, level, data[9]);
+            return true;
+        }
+        // 降档总是接受，升档需要本端的链路质量也允许
+        if (level <= self.__level || level <= self.__recommend)
+        {
+            self.__target = level;
+            self.__state = __State::SWITCHING;
+            self.__deadline_ms = self.__now_ms + self.__config.switch_delay_ms;
+            self.__send(__OP_ACCEPT, level, data[9]);
+        }
+        else
+        {
+            self.__send(__OP_REJECT, level, data[9]);
+        }
+        return true;
+    }
+
+    static bool __handle_accept(RateControl &self, const uint8_t *data, size_t)
+    {
+        if (self.__state != __State::PROPOSING || data[9] != self.__token || data[8] != self.__target)
+        {
+            return false;
+        }
+        self.__switch(self.__target, self.__now_ms);
+        self.__state = __State::PROBATION;
+        self.__deadline_ms = self.__now_ms + self.__config.probation_ms;
+        return true;
+    }
+
+    static bool __handle_reject(RateControl &self, const uint8_t *data, size_t)
+    {
+        if (self.__state != __State::PROPOSING || data[9] != self.__token)
+        {
+            return false;
+        }
+        self.__peer_recommend = data[10] < _Levels ? data[10] : self.__level;
+        self.__state = __State::STABLE;
+        ++self.__stats.rejected;
+        return true;
+    }
+
+    using __Entry = CmdEntry<RateControl, RATE_CONTROL_FRAME_LEN>;
+
+    static constexpr __Entry __signature(uint8_t op, bool (*handler)(RateControl &, const uint8_t *, size_t))
+    {
+        return {{RATE_CONTROL_FRAME_LEN,
+                 {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00},
+                 {0xc0, 0x00, 0x08, 0x00, 0x00, 0xe7, 0x81, op, 0x00, 0x00, 0x00, 0x00, 0x00}},
+                handler};
+    }
+
+    static const __Entry __table[4];
+
+    uint32_t __now_ms{0}; // handle时的当前时间，供命令处理函数使用
+    bool __started{false};
+
+public:
+    /// @param radio 发送控制帧的设备
+    /// @param config 配置
+    /// @param apply 切换档位的函数，启动时设备需要已经处于home_level
+    /// @param sample 读取链路计数的函数
+    /// @param ctx apply和sample的参数
+    RateControl(RadioDevice &radio, const Config &config, apply_t apply, sample_t sample, void *ctx = nullptr)
+        : __radio(radio), __config(config), __apply(apply), __sample(sample), __ctx(ctx),
+          __adapter(config.adapt, config.home_level), __level(__adapter.level()), __prev_level(__level),
+          __target(__level), __recommend(__level), __peer_recommend(__level) {}
+
+    RateControl(const RateControl &) = delete;
+    RateControl &operator=(const RateControl &) = delete;
+
+    /// @brief 判断数据是否为速率控制帧
+    static bool match(const uint8_t *data, size_t len)
+    {
+        return cmd_match(__table, data, len);
+    }
+
+    /// @brief 处理收到的数据包
+    /// @param data 数据
+    /// @param len 数据长度
+    /// @param now_ms 当前时间，单位为毫秒
+    /// @return 是否为速率控制帧，是则调用者不需要再转发
+    bool handle(const uint8_t *data, size_t len, uint32_t now_ms)
+    {
+        __now_ms = now_ms;
+        return cmd_dispatch(__table, *this, data, len) != CmdResult::NO_MATCH;
+    }
+
+    /// @brief 周期调用，处理超时、心跳和链路中断，调用间隔应远小于window_ms
+    /// @param now_ms 当前时间，单位为毫秒
+    void poll(uint32_t now_ms)
+    {
+        if (!__started)
+        {
+            __started = true;
+            __last_rx = __sample(__ctx).rx_received;
+            __last_rx_ms = __last_peer_ms = __next_keepalive_ms = now_ms;
+        }
+        __flush();
+        const uint32_t received{__sample(__ctx).rx_received};
+        if (received != __last_rx)
+        {
+            __last_rx = received;
+            __last_rx_ms = now_ms;
+            if (__state == __State::PROBATION)
+            {
+                __state = __State::STABLE; // 新档位上收到了数据包
+            }
+        }
+
+        switch (__state)
+        {
+        case __State::PROPOSING:
+            if (static_cast<int32_t>(now_ms - __deadline_ms) >= 0)
+            {
+                if (__retries-- > 0)
+                {
+                    __deadline_ms = now_ms + __config.handshake_timeout_ms;
+                    __send(__OP_PROPOSE, __target, __token);
+                }
+                else
+                {
+                    __state = __State::STABLE;
+                }
+            }
+            break;
+        case __State::SWITCHING:
+            if (static_cast<int32_t>(now_ms - __deadline_ms) >= 0)
+            {
+                __switch(__target, now_ms);
+                __state = __State::PROBATION;
+                __deadline_ms = now_ms + __config.probation_ms;
+            }
+            break;
+        case __State::PROBATION:
+            if (static_cast<int32_t>(now_ms - __deadline_ms) >= 0)
+            {
+                // 对端没有切换（ACCEPT丢失）或新档位无法通信，两端都会回到原档位
+                __switch(__prev_level, now_ms);
+                __state = __State::STABLE;
+                ++__stats.reverts;
+            }
+            break;
+        default:
+            break;
+        }
+
+        if (__state == __State::STABLE && __level != 0 && now_ms - __last_rx_ms >= __config.link_lost_ms)
+        {
+            __switch(0, now_ms);
+            ++__stats.lost;
+        }
+        if (static_cast<int32_t>(now_ms - __next_keepalive_ms) >= 0)
+        {
+            __next_keepalive_ms = now_ms + __config.window_ms;
+            if (now_ms - __last_peer_ms >= 2 * __config.window_ms)
+            {
+                // 连续两个窗口收不到对端心跳，按整个窗口丢失统计，不等到链路中断才降档
+                __recommend = __adapter.update(1000);
+                __maybe_propose(now_ms);
+            }
+            __send(__OP_KEEPALIVE, __level, 0);
+        }
+    }
+
+    /// @brief 当前档位
+    uint8_t level() const { return __level; }
+
+    /// @brief 本端的建议档位
+    uint8_t recommend() const { return __recommend; }
+
+    /// @brief 平滑后的丢包率，单位为千分之一
+    uint16_t loss_permille() const { return __adapter.loss_permille(); }
+
+    /// @brief 平滑后的RSSI，单位为0.1 dBm
+    int16_t rssi_x10() const { return __adapter.rssi_x10(); }
+
+    const Stats &stats() const { return __stats; }
+};
+
+template <uint8_t _Levels>
+const typename RateControl<_Levels>::__Entry RateControl<_Levels>::__table[4]{
+    __signature(__OP_KEEPALIVE, __handle_keepalive),
+    __signature(__OP_PROPOSE, __handle_propose),
+    __signature(__OP_ACCEPT, __handle_accept),
+    __signature(__OP_REJECT, __handle_reject),
+};
+
+#endif // __RATE_CONTROL_H__
@@ -0,0 +1,116 @@
+#ifndef __ROUTER_PORTS_H__
+#define __ROUTER_PORTS_H__
+
+#include <cstdint>
+#include <cstddef>
+
+#ifdef ARDUINO
+#include <HardwareSerial.h>
+#else
+#include <algorithm>
+#include <cstring>
+#include <unistd.h>
+#endif
+
+#include "router.hpp"
+#include "radio_device.h"
+
+/// @brief 以RadioDevice作为路由端口，通过send_async发送，发送队列已满时由路由器稍后重试
+class RadioPort : public RouterPort
+{
+private:
+    RadioDevice &__radio;
+
+public:
+    explicit RadioPort(RadioDevice &radio) : __radio(radio) {}
+
+    bool write(const uint8_t *data, size_t len) override { return __radio.send_async(data, len); }
+};
+
+/// @brief 以无线设备之上的链路层作为路由端口，链路层的send返回false时由路由器稍后重试
+///        ArqLink：数据帧加入发送窗口后由ArqLink::poll发送和重发，窗口已满时返回false
+///        FragmentLink：分片交给设备的发送队列，队列已满时保存进度并返回false，重试时从未发送的分片继续
+/// @tparam _Link 链路层类型，提供bool send(const uint8_t *data, size_t len)
+template <typename _Link>
+class LinkPort : public RouterPort
+{
+private:
+    _Link &__link;
+
+public:
+    explicit LinkPort(_Link &link) : __link(link) {}
+
+    bool write(const uint8_t *data, size_t len) override { return __link.send(data, len); }
+};
+
+#ifdef ARDUINO
+/// @brief 以HardwareSerial作为路由端口，发送缓存空间不足时不阻塞，由路由器稍后重试
+class SerialPort : public RouterPort
+{
+private:
+    HardwareSerial &__serial;
+
+public:
+    explicit SerialPort(HardwareSerial &serial) : __serial(serial) {}
+
+    bool write(const uint8_t *data, size_t len) override
+    {
+        if (static_cast<size_t>(__serial.availableForWrite()) < len)
+        {
+            return false;
+        }
+        TRACE_EVENT(UART_WRITE, TRACE_CURRENT());
+        return __serial.write(data, len) == len;
+    }
+};
+#else
+/// @brief 以文件描述符（pty、管道等）作为路由端口，文件描述符应设置为非阻塞
+///        一次只写入了部分数据时保存剩余部分，之后的write和flush先写出剩余部分，写完之前拒绝新的帧
+class FdPort : public RouterPort
+{
+private:
+    int __fd;
+    uint8_t __tail[0xFF]{}; // 上一帧没有写出的部分，路由器的帧不超过0xFF字节
+    size_t __tail_len{0};
+
+public:
+    explicit FdPort(int fd) : __fd(fd) {}
+
+    /// @brief 写出上一帧剩余的部分
+    /// @return 没有剩余数据时返回true
+    bool flush()
+    {
+        if (__tail_len == 0)
+        {
+            return true;
+        }
+        const ssize_t written{::write(__fd, __tail, __tail_len)};
+        if (written <= 0)
+        {
+            return false;
+        }
+        __tail_len -= written;
+        memmove(__tail, __tail + written, __tail_len);
+        return __tail_len == 0;
+    }
+
+    bool write(const uint8_t *data, size_t len) override
+    {
+        if (!flush())
+        {
+            return false;
+        }
+        TRACE_EVENT(UART_WRITE, TRACE_CURRENT());
+        const ssize_t written{::write(__fd, data, len)};
+        if (written <= 0)
+        {
+            return false;
+        }
+        __tail_len = std::min(len - written, sizeof(__tail));
+        memcpy(__tail, data + written, __tail_len);
+        return true;
+    }
+};
+#endif
+
+#endif // __ROUTER_PORTS_H__
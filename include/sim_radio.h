@@ -0,0 +1,190 @@
+#ifndef __SIM_RADIO_H__
+#define __SIM_RADIO_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include "radio_device.h"
+
+#define SIM_RADIO_MAX_PACKET_LENGTH 255
+
+/// @brief 对数距离路径损耗模型，1米处为自由空间损耗
+/// @param distance_m 距离，单位为米
+/// @param exponent 路径损耗指数，自由空间为2，城市环境约为2.7～3.5
+/// @param frequency_mhz 载波频率，单位为MHz，SX1262为915，nRF24为2402
+/// @return 路径损耗，单位为dB
+double sim_path_loss_db(double distance_m, double exponent, double frequency_mhz = 915.0);
+
+class SimRadio;
+
+/// @brief 模拟的空中信道，发送的数据包会被投递到同一频率上的其它SimRadio
+///        丢包由固定种子的随机数决定，相同的输入得到相同的结果；
+///        设置路径损耗后，接收端的RSSI = 发射功率 - 路径损耗 + 高斯衰落，并按RSSI与接收端灵敏度之差产生误包，
+///        发送端与接收端的比特率不同时无法解调
+class SimMedium
+{
+private:
+    std::mutex __lock;
+    std::vector<SimRadio *> __radios;
+    std::mt19937 __rng;
+    std::uniform_real_distribution<double> __uniform{0.0, 1.0};
+    std::normal_distribution<double> __normal{0.0, 1.0};
+    bool __path_loss_enabled{false};
+    double __path_loss_db{0.0};
+    double __fading_db{0.0};
+
+public:
+    /// @param seed 丢包随机数种子
+    explicit SimMedium(uint32_t seed = 1) : __rng(seed) {}
+
+    SimMedium(const SimMedium &) = delete;
+    SimMedium &operator=(const SimMedium &) = delete;
+
+    /// @brief 注册设备，由SimRadio的构造函数调用
+    void attach(SimRadio *radio);
+
+    /// @brief 注销设备，由SimRadio的析构函数调用
+    void detach(SimRadio *radio);
+
+    /// @brief 把数据包投递给同一频率上的其它设备
+    /// @param from 发送设备
+    /// @param data 数据
+    /// @param size 数据长度
+    /// @param arrival 到达接收端的时间
+    void broadcast(SimRadio *from, const uint8_t *data, size_t size, std::chrono::steady_clock::time_point arrival);
+
+    /// @brief 设置路径损耗并启用基于RSSI的误包模型
+    /// @param path_loss_db 路径损耗，单位为dB
+    /// @param fading_db 衰落的标准差，单位为dB
+    void set_path_loss(double path_loss_db, double fading_db = 0.0);
+};
+
+/// @brief 模拟射频设备，在Linux上代替nRF24/SX1262运行转发逻辑
+///        空中时间 = (数据长度 + 固定开销) × 8 / 比特率，发送期间设备忙，之后再经过固定时延到达对端
+class SimRadio : public RadioDevice
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    /// @brief 模拟参数
+    struct Config
+    {
+        uint32_t bitrate_bps{1000000}; // 空中比特率
+        uint32_t overhead_bytes{9};    // 每个数据包的固定开销（前导码、地址、CRC等）
+        uint32_t latency_us{0};        // 发送完成到对端收到之间的额外时延
+        double loss{0.0};              // 丢包率，范围为[0, 1]
+        size_t mtu{32};                // 单包最大长度，不超过SIM_RADIO_MAX_PACKET_LENGTH
+        double tx_power_dbm{22.0};     // 发射功率，只在设置了路径损耗时使用，可以通过set_power修改
+        double noise_figure_db{6.0};   // 接收机噪声系数
+        double required_snr_db{9.0};   // 解调所需信噪比
+        uint32_t retune_us{130};       // retune后频率合成器重新稳定的时间，期间不能收发（nRF24为130us）
+    };
+
+    /// @brief 收发统计
+    struct Stats
+    {
+        uint32_t sent{0};       // 发送的数据包数量
+        uint32_t busy{0};       // 发送时设备忙的次数
+        uint32_t received{0};   // 收到的数据包数量
+        uint32_t lost{0};       // 发往本设备但被丢弃的数据包数量
+        uint32_t crc_errors{0}; // 信号可以检测到但误包的数量，包含在lost中
+        uint32_t retune_dropped{0}; // retune时丢弃的已在空中但尚未读取的数据包
+        uint64_t airtime_us{0};
+    };
+
+private:
+    struct __Delivery
+    {
+        clock::time_point due;
+        uint8_t len;
+        uint8_t data[SIM_RADIO_MAX_PACKET_LENGTH];
+    };
+
+    SimMedium &__medium;
+    Config __config;
+    uint32_t __frequency{2402000000UL};
+    uint8_t __addr_width{5};
+    int16_t __last_rssi_x10{INT16_MIN};
+    bool __enabled{true};
+    clock::time_point __busy_until{};
+    clock::time_point __settled_at{}; // 在此之前到达的数据包因频率合成器未稳定而丢失
+    std::deque<__Delivery> __inbox;
+    Stats __stats;
+    std::mutex __lock;
+
+    friend class SimMedium;
+
+    /// @brief 由SimMedium调用，按到达时间保存数据包
+    void __deliver(const uint8_t *data, size_t size, clock::time_point arrival, bool lost, bool crc_error, int16_t rssi_x10);
+
+public:
+    SimRadio(SimMedium &medium, const Config &config);
+
+    SimRadio() = delete;
+    SimRadio(const SimRadio &) = delete;
+    SimRadio &operator=(const SimRadio &) = delete;
+
+    virtual ~SimRadio();
+
+    /// @brief 计算数据包的空中时间
+    /// @param size 数据长度
+    /// @return 空中时间，单位为微秒
+    uint32_t airtime_us(size_t size) const;
+
+    /// @brief 同步发送，等待上一个数据包发送完成
+    bool send(uint8_t *message, size_t size) override;
+
+    /// @brief 异步发送，设备忙时返回false，不阻塞
+    bool send_async(const uint8_t *message, size_t size) override;
+
+    /// @brief 取出一个已经到达的数据包，不阻塞
+    bool recv(uint8_t *buffer, size_t &size) override;
+
+    uint32_t set_frequency(uint32_t frequency_hz) override;
+
+    /// @brief 在线换频：等待正在进行的发送完成，换频后在retune_us内不能收发，
+    ///        已在空中但尚未读取的数据包被丢弃并计入retune_dropped
+    uint32_t retune(uint32_t frequency_hz) override;
+
+    /// @param power 发射功率，单位为dBm，按int8_t解释（与nRF24/SX1262相同），负数功率需要先转换为uint8_t
+    uint8_t set_power(uint8_t power) override;
+
+    /// @param rate 数据速率，单位为kbps
+    uint32_t set_data_rate(uint32_t rate) override;
+
+    uint8_t set_addr_width(uint8_t addr_width) override;
+
+    bool shutdown() override;
+
+    bool reboot() override;
+
+    void *device() override { return this; }
+
+    /// @brief 当前频率，单位为Hz
+    uint32_t frequency();
+
+    /// @brief 设置空中比特率，两端比特率相同时才能通信
+    void set_bitrate_bps(uint32_t bitrate_bps);
+
+    uint32_t bitrate_bps();
+
+    /// @brief 当前发射功率，单位为dBm
+    double tx_power_dbm();
+
+    /// @brief 接收灵敏度，按接收带宽为比特率的2.5倍估算
+    /// @return 灵敏度，单位为dBm
+    double sensitivity_dbm();
+
+    /// @brief 最近一个数据包的RSSI，单位为0.1 dBm，没有启用路径损耗时为INT16_MIN
+    int16_t last_rssi_x10();
+
+    /// @brief 读取收发统计
+    Stats stats();
+};
+
+#endif // __SIM_RADIO_H__
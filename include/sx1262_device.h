@@ -0,0 +1,245 @@
+#ifndef __SX1262_DEVICE_H__
+#define __SX1262_DEVICE_H__
+
+#include <RadioLib.h>
+#include <cstdint>
+#include <mutex>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "radio_device.h"
+#include "spsc_queue.hpp"
+#include "packet_pool.hpp"
+#include "metrics.hpp"
+
+#ifndef SX1262_MAX_PACKET_LENGTH
+#define SX1262_MAX_PACKET_LENGTH 255 // SX1262单包最大长度
+#endif
+
+#ifndef SX1262_TX_QUEUE_SIZE
+#define SX1262_TX_QUEUE_SIZE 4 // 异步发送队列长度，必须为2的幂
+#endif
+
+#ifndef SX1262_TX_TIMEOUT_MARGIN_MS
+#define SX1262_TX_TIMEOUT_MARGIN_MS 10 // 等待TX_DONE中断时在空中时间之外额外等待的时间
+#endif
+
+#ifndef SX1262_RX_POOL_SLOTS
+#define SX1262_RX_POOL_SLOTS 8 // 接收数据包池槽位数量，同时作为接收队列长度，必须为2的幂
+#endif
+
+/// @brief SX1262设备
+///        由一个收发任务驱动状态机：startReceive（连续接收） → DIO1 → readData → 继续接收，
+///        连续接收模式下读取数据时芯片仍处于接收状态，不存在未进入接收的空档；
+///        发送时从接收切换到发送，发送完成后在同一个临界区内立即重新进入接收
+class SX1262Device : public RadioDevice
+{
+private:
+    SPIClass *__radio_spi{nullptr};
+    SPISettings __spi_setting{2000000, MSBFIRST, SPI_MODE0};
+    SX1262 *__radio{nullptr};
+    uint32_t __rx_en;
+    uint32_t __tx_en;
+    std::mutex __lock; // 保护对射频芯片的访问，换频时用于暂停收发
+
+    /// @brief 换频的实际实现，调用前需要持有__lock
+    uint32_t __set_frequency(uint32_t frequency);
+
+public:
+    /// @brief 异步发送统计
+    struct TxStats
+    {
+        std::atomic<uint32_t> queued{0};    // 进入发送队列的数据包数量
+        std::atomic<uint32_t> sent{0};      // 发送完成的数据包数量
+        std::atomic<uint32_t> failed{0};    // 发送失败（启动失败或中断超时）的数据包数量
+        std::atomic<uint32_t> max_depth{0}; // 发送队列深度的最大值
+    };
+
+    /// @brief 接收统计
+    struct RxStats
+    {
+        std::atomic<uint32_t> received{0};    // 进入接收队列的数据包数量
+        std::atomic<uint32_t> dropped{0};     // 接收数据包池耗尽而丢弃的数据包数量
+        std::atomic<uint32_t> crc_errors{0};  // CRC校验失败的数据包数量
+        std::atomic<uint32_t> failed{0};      // 其它原因读取失败的数据包数量
+        std::atomic<uint32_t> turnarounds{0}; // 从发送切换回接收的次数
+        std::atomic<int32_t> rssi_x10{0};     // 最近一个数据包的RSSI，单位为0.1 dBm（FSK模式没有SNR）
+    };
+
+    using RxPacketPool = PacketPool<SX1262_MAX_PACKET_LENGTH, SX1262_RX_POOL_SLOTS>;
+    using RxPacket = RxPacketPool::Packet;
+
+    /// @brief 从send_async入队到发送完成的时延分布，单位为微秒
+    using TxLatencyHistogram = Histogram<6>;
+
+    /// @brief 异步发送完成回调，在收发任务中调用
+    /// @param success 是否发送成功
+    /// @param size 数据长度
+    using tx_callback_t = void (*)(bool success, size_t size);
+
+    /// @brief 有新数据包进入接收队列时的回调，在收发任务中调用，不能阻塞
+    using rx_callback_t = void (*)();
+
+private:
+    struct __TxPacket
+    {
+        uint32_t queued_us; // 入队时间，用于统计发送时延
+        uint32_t trace_id;  // 数据包标识，send_async时取自TRACE_CURRENT
+        uint8_t len;
+        uint8_t data[SX1262_MAX_PACKET_LENGTH];
+    };
+
+    // 收发任务的通知位，DIO1由TX_DONE与RX_DONE共用，由收发任务当前所处的阶段区分中断来源
+    static constexpr uint32_t __NOTIFY_WAKE{1UL << 0}; // 有新的发送数据或需要重新进入接收
+    static constexpr uint32_t __NOTIFY_IRQ{1UL << 1};  // DIO1中断
+
+    SpscRingQueue<__TxPacket, SX1262_TX_QUEUE_SIZE> __tx_queue; // 调用send_async的任务写入，收发任务读取
+    tx_callback_t __tx_callback{nullptr};
+    TxStats __tx_stats;
+    TxLatencyHistogram __tx_latency{{5000, 10000, 20000, 50000, 100000, 200000}};
+
+    // 接收队列中只传递数据包句柄，句柄总数受数据包池限制，因此队列不会溢出
+    RxPacketPool __rx_pool;
+    SpscRingQueue<RxPacketPool::handle_t, SX1262_RX_POOL_SLOTS> __rx_queue; // 收发任务写入，调用rx_front的任务读取
+    rx_callback_t __rx_callback{nullptr};
+    RxStats __rx_stats;
+
+    TaskHandle_t __trx_task{nullptr};
+    bool __rx_armed{false}; // 芯片是否处于接收状态，由__lock保护
+
+    static SX1262Device *__irq_owner; // DIO1中断对应的设备，只支持一个SX1262
+    static void __on_irq();
+    static void __trx_task_entry(void *arg);
+    void __trx_loop();
+
+    /// @brief 连续发送队列中的全部数据包，完成后立即重新进入接收
+    void __transmit_pending();
+
+    /// @brief 进入接收状态，调用前需要持有__lock
+    /// @return 是否成功
+    bool __arm_receive();
+
+    /// @brief 等待数据包或新的发送请求
+    void __receive_once();
+
+    /// @brief 读取一个数据包到接收队列，调用前需要持有__lock
+    void __read_packet();
+
+    /// @brief 清除残留的DIO1通知
+    void __clear_irq();
+
+    /// @brief 等待DIO1中断
+    /// @param timeout 超时时间
+    /// @return 超时返回false
+    bool __wait_irq(TickType_t timeout);
+
+    /// @brief 唤醒收发任务，芯片状态被外部改变后需要调用以重新进入接收
+    void __wake();
+
+    /// @brief 启动收发任务，在init成功后调用
+    bool __start_trx_engine();
+
+public:
+    /// @brief 构造函数
+    /// @param spi_bus spi总线
+    /// @param sck spi sck
+    /// @param miso spi miso
+    /// @param mosi spi mosi
+    /// @param ss spi ss/cs
+    /// @param irq sx1262 dio1
+    /// @param rst sx1262 nrst
+    /// @param busy sx1262 busy
+    /// @param rx_en 外部射频开关的接收使能引脚，RADIOLIB_NC表示不使用
+    /// @param tx_en 外部射频开关的发送使能引脚，RADIOLIB_NC表示不使用
+    SX1262Device(uint8_t spi_bus, int8_t sck, int8_t miso, int8_t mosi, int8_t ss, uint32_t irq, uint32_t rst,
+                 uint32_t busy, uint32_t rx_en = RADIOLIB_NC, uint32_t tx_en = RADIOLIB_NC);
+
+    /// @brief 禁止使用默认构造函数
+    SX1262Device() = delete;
+
+    virtual ~SX1262Device();
+
+    /// @brief 以FSK模式初始化sx1262，并进入连续接收
+    /// @param freq 载波频率，单位为MHz
+    /// @param br 数据速率，单位为kbps
+    /// @param freq_dev 频偏，单位为kHz
+    /// @param rx_bw 接收带宽，单位为kHz
+    /// @param power 输出功率，单位为dBm
+    /// @return bool
+    bool init(float freq = 915.0, float br = 30.0, float freq_dev = 5.0, float rx_bw = 156.2, int8_t power = 22);
+
+    /// @brief 同步发送数据，发送完成后由收发任务重新进入接收
+    /// @param message 需要发送的数据
+    /// @param size 数据长度
+    /// @return bool
+    bool send(uint8_t *message, size_t size) override;
+
+    /// @brief 异步发送数据，数据被复制到发送队列后立即返回，由收发任务根据DIO1中断连续发送
+    ///        注意：只能由一个任务调用（发送队列为单生产者）
+    /// @param message 需要发送的数据
+    /// @param size 数据长度，不能超过255字节
+    /// @return 队列已满或数据过长返回false
+    bool send_async(const uint8_t *message, size_t size) override;
+
+    /// @brief 设置异步发送完成回调
+    /// @param callback 回调函数，nullptr表示不需要回调
+    void set_tx_callback(tx_callback_t callback) { __tx_callback = callback; }
+
+    /// @brief 读取异步发送统计
+    const TxStats &tx_stats() const { return __tx_stats; }
+
+    /// @brief 查询异步发送队列中等待发送的数据包数量
+    uint32_t tx_queue_depth() const { return __tx_queue.len(); }
+
+    /// @brief 读取发送时延分布
+    const TxLatencyHistogram &tx_latency() const { return __tx_latency; }
+
+    /// @brief 访问接收队列头部的数据包，数据在rx_pop之前保持有效
+    ///        注意：只能由一个任务调用（接收队列为单消费者），与recv不能同时使用
+    /// @return 接收队列为空返回nullptr
+    const RxPacket *rx_front();
+
+    /// @brief 移除接收队列头部的数据包并归还到数据包池
+    void rx_pop();
+
+    /// @brief 设置接收回调
+    /// @param callback 回调函数，nullptr表示不需要回调
+    void set_rx_callback(rx_callback_t callback) { __rx_callback = callback; }
+
+    /// @brief 读取接收统计
+    const RxStats &rx_stats() const { return __rx_stats; }
+
+    /// @brief 查询接收队列中等待读取的数据包数量
+    uint32_t rx_queue_depth() const { return __rx_queue.len(); }
+
+    /// @brief 接收数据，从接收队列中取出一个数据包，不阻塞
+    /// @param buffer 接收数据的缓冲区，长度至少为255字节
+    /// @param size 接收数据的长度
+    /// @return 接收队列为空返回false
+    bool recv(uint8_t *buffer, size_t &size) override;
+
+    uint32_t set_frequency(uint32_t frequency) override;
+
+    uint32_t retune(uint32_t frequency_hz) override;
+
+    uint8_t set_power(uint8_t power) override;
+
+    uint32_t set_data_rate(uint32_t rate) override;
+
+    uint8_t set_addr_width(uint8_t addr_width) override;
+
+    /// @brief 同时修改FSK比特率、频偏和接收带宽，用于链路自适应，与set_frequency相同会暂停收发
+    /// @param bitrate_kbps 比特率，单位为kbps
+    /// @param freq_dev_khz 频偏，单位为kHz
+    /// @param rx_bw_khz 接收带宽，单位为kHz，必须为SX126x支持的值
+    /// @return 是否全部设置成功
+    bool set_fsk_profile(float bitrate_kbps, float freq_dev_khz, float rx_bw_khz);
+
+    bool shutdown() override;
+
+    bool reboot() override;
+
+    void *device() override { return __radio; }
+};
+
+#endif // __SX1262_DEVICE_H__
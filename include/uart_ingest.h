@@ -0,0 +1,165 @@
+#ifndef __UART_INGEST_H__
+#define __UART_INGEST_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+#include "trace.hpp"
+
+#ifdef ARDUINO
+#include <HardwareSerial.h>
+#else
+#include <unistd.h>
+#include <sys/ioctl.h>
+#endif
+
+/// @brief 字节流来源，屏蔽串口驱动的差异，便于在Linux上使用pty或文件驱动
+class ByteSource
+{
+public:
+    ByteSource() = default;
+    virtual ~ByteSource() = default;
+
+    /// @brief 查询可以立即读取的字节数
+    virtual size_t available() = 0;
+
+    /// @brief 读取数据，不阻塞
+    /// @param buffer 输出缓存
+    /// @param size 最多读取的字节数
+    /// @return 实际读取的字节数
+    virtual size_t read(uint8_t *buffer, size_t size) = 0;
+};
+
+#ifdef ARDUINO
+/// @brief 基于HardwareSerial（ESP-IDF UART驱动及其事件队列）的字节流来源
+class SerialByteSource : public ByteSource
+{
+private:
+    HardwareSerial &__serial;
+
+public:
+    explicit SerialByteSource(HardwareSerial &serial) : __serial(serial) {}
+
+    size_t available() override { return __serial.available(); }
+
+    size_t read(uint8_t *buffer, size_t size) override { return __serial.read(buffer, size); }
+};
+#else
+/// @brief 基于文件描述符的字节流来源，可以是pty、管道或普通文件
+class FdByteSource : public ByteSource
+{
+private:
+    int __fd;
+
+public:
+    explicit FdByteSource(int fd) : __fd(fd) {}
+
+    size_t available() override
+    {
+        int count{0};
+        return ioctl(__fd, FIONREAD, &count) == 0 && count > 0 ? static_cast<size_t>(count) : 0;
+    }
+
+    size_t read(uint8_t *buffer, size_t size) override
+    {
+        auto result{::read(__fd, buffer, size)};
+        return result > 0 ? static_cast<size_t>(result) : 0;
+    }
+};
+#endif
+
+/// @brief 串口数据接收：直接读入数据包池的槽位，再把句柄放入队列，中间不经过栈上缓存
+///        数据包池耗尽或队列已满时剩余数据留在驱动缓存中，不会越界写入；
+///        此时stalled()为true，调用者释放槽位后需要再次调用poll，不能等待下一次串口回调
+/// @tparam _Pool 数据包池类型，见packet_pool.hpp
+/// @tparam _Queue 句柄队列类型，需要提供bool push(handle)和bool full()
+template <typename _Pool, typename _Queue>
+class UartIngest
+{
+public:
+    /// @brief 接收统计
+    struct Stats
+    {
+        std::atomic<uint32_t> bytes{0};          // 读入的字节数
+        std::atomic<uint32_t> packets{0};        // 生成的数据包数量
+        std::atomic<uint32_t> pool_exhausted{0}; // 数据包池耗尽的次数
+        std::atomic<uint32_t> overflows{0};      // 驱动报告的缓存溢出次数
+    };
+
+private:
+    ByteSource &__source;
+    _Pool &__pool;
+    _Queue &__queue;
+    size_t __chunk_size;
+    Stats __stats;
+    bool __stalled{false};
+
+public:
+    /// @param source 字节流来源
+    /// @param pool 数据包池
+    /// @param queue 句柄队列
+    /// @param chunk_size 单个数据包的最大字节数，不能超过数据包池的槽位大小
+    UartIngest(ByteSource &source, _Pool &pool, _Queue &queue, size_t chunk_size)
+        : __source(source), __pool(pool), __queue(queue),
+          __chunk_size(chunk_size < _Pool::slot_size() ? chunk_size : _Pool::slot_size()) {}
+
+    /// @brief 读取当前所有可读的数据
+    /// @return 生成的数据包数量
+    size_t poll()
+    {
+        size_t packets{0};
+        size_t len{__source.available()};
+        __stalled = false;
+        while (len > 0)
+        {
+            if (__queue.full())
+            {
+                __stalled = true; // 先检查队列，避免读出数据后无处存放
+                break;
+            }
+            auto handle{__pool.acquire()};
+            if (handle == _Pool::invalid_handle)
+            {
+                __stats.pool_exhausted.fetch_add(1, std::memory_order_relaxed);
+                __stalled = true;
+                break;
+            }
+            auto &packet{__pool[handle]};
+            packet.len = __source.read(packet.data, len < __chunk_size ? len : __chunk_size);
+            packet.trace_id = TRACE_NEW_ID();
+            // 入队之后槽位属于消费者，需要在入队之前记录
+            TRACE_EVENT(UART_INGEST, packet.trace_id);
+            if (packet.len == 0 || !__queue.push(handle))
+            {
+                __pool.release(handle);
+                break;
+            }
+            len -= packet.len;
+            ++packets;
+            __stats.bytes.fetch_add(packet.len, std::memory_order_relaxed);
+        }
+        __stats.packets.fetch_add(packets, std::memory_order_relaxed);
+        return packets;
+    }
+
+    /// @brief 上一次poll是否因为数据包池耗尽或队列已满而留下了未读取的数据
+    bool stalled() const
+    {
+        return __stalled;
+    }
+
+    /// @brief 记录一次驱动缓存溢出，在串口错误回调中调用
+    void report_overflow()
+    {
+        __stats.overflows.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// @brief 读取接收统计
+    const Stats &stats() const
+    {
+        return __stats;
+    }
+};
+
+#endif // __UART_INGEST_H__
@@ -0,0 +1,459 @@
+/// @brief 选择重传（Selective Repeat）ARQ，在不可靠的无线链路上提供按序、可靠的数据帧传输
+///        数据帧：[0x40 | (序号 - 发送窗口起点)] [序号] [数据]，ACK帧：[0x60] [累计确认] [选择确认位图(4字节，小端)]
+///        累计确认为接收端期望的下一个序号，位图第i位表示序号 累计确认+1+i 已经收到；
+///        发送端最多有_Window个未确认的帧，每帧独立的重发定时器，超时时间按RFC 6298由RTT估算（重发的帧不采样），
+///        选择确认显示更晚发出的帧已经到达时立即重发（快速重发）；
+///        数据帧携带发送窗口起点，对端放弃重发或重启后接收端据此跳过空洞重新同步，不会永久阻塞
+///        注意：两端都需要启用ARQ，不以0x40～0x60开头的数据包不是ARQ帧，由调用者按原来的方式处理
+
+#ifndef __ARQ_HPP__
+#define __ARQ_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#include "trace.hpp"
+
+#define ARQ_HEADER_SIZE 2
+#define ARQ_ACK_SIZE 6
+#define ARQ_TYPE_DATA 0x40 // 低5位为序号与发送窗口起点之差
+#define ARQ_TYPE_ACK 0x60
+
+/// @brief ARQ链路的一端，同时负责发送和接收
+///        send/receive/poll需要在同一个任务中调用
+/// @tparam _Mtu 链路单包最大长度（含ARQ头）
+/// @tparam _Window 发送和接收窗口大小，不超过32的2的幂，使序号回绕到0时 序号 % _Window 仍然连续
+template <size_t _Mtu, uint8_t _Window = 8>
+class ArqLink
+{
+  static_assert(_Mtu > ARQ_HEADER_SIZE && _Mtu >= ARQ_ACK_SIZE && _Mtu <= 0xFF + ARQ_HEADER_SIZE, "invalid mtu");
+  static_assert(_Window > 0 && _Window <= 32 && (_Window & (_Window - 1)) == 0, "_Window must be a power of 2 in range [1, 32]");
+
+public:
+  struct Config
+  {
+    uint32_t initial_rto_us{20000}; // 还没有RTT采样时的重发超时
+    uint32_t min_rto_us{2000};
+    uint32_t max_rto_us{250000};
+    uint8_t max_retries{16}; // 单帧的最大重发次数，超过后放弃，0表示不限制
+  };
+
+  struct Stats
+  {
+    uint32_t sent{0};             // 首次发送的数据帧数量
+    uint32_t retransmits{0};      // 重发次数，包括快速重发
+    uint32_t fast_retransmits{0}; // 快速重发次数
+    uint32_t expired{0};          // 超过最大重发次数而放弃的数据帧数量
+    uint32_t acks_sent{0};
+    uint32_t acks_received{0};
+    uint32_t delivered{0};  // 按序交付的数据帧数量
+    uint32_t duplicates{0}; // 重复收到的数据帧数量
+    uint32_t skipped{0};    // 对端放弃或重新同步而跳过的序号数量
+  };
+
+  /// @brief 单个数据帧的最大数据长度
+  static constexpr size_t payload_size{_Mtu - ARQ_HEADER_SIZE};
+
+private:
+  enum class __TxState : uint8_t
+  {
+    EMPTY,
+    QUEUED, // 等待首次发送
+    SENT,   // 等待确认
+    ACKED,  // 已确认或已放弃，等待窗口起点越过
+  };
+
+  struct __TxSlot
+  {
+    __TxState state{__TxState::EMPTY};
+    bool fast_retx{false}; // 已经安排快速重发，还没有发出
+    uint8_t tries{0};      // 已发送次数
+    uint8_t len{0};
+    uint32_t sent_us{0};  // 最近一次发送的时间
+    uint32_t tx_order{0}; // 最近一次发送的发送序号，同一次poll中发出的帧发送时间相同，只能用它区分先后
+    uint32_t deadline_us{0};
+    uint32_t trace_id{0}; // 数据包标识，见trace.hpp
+    uint8_t data[payload_size];
+  };
+
+  struct __RxSlot
+  {
+    bool present{false};
+    uint8_t len{0};
+    uint8_t data[payload_size];
+  };
+
+  Config __config;
+  Stats __stats;
+
+  __TxSlot __tx[_Window];
+  uint8_t __tx_base{0}; // 最早未确认的序号
+  uint8_t __tx_next{0}; // 下一个新帧的序号
+  uint32_t __tx_order{0}; // 每发送一次数据帧（包括重发）加一
+
+  __RxSlot __rx[_Window];
+  uint8_t __rx_expected{0}; // 期望收到的下一个序号
+  bool __ack_pending{false};
+
+  uint32_t __srtt_us{0};
+  uint32_t __rttvar_us{0};
+  uint32_t __rto_us;
+  bool __has_rtt{false};
+
+  static bool __time_reached(uint32_t now_us, uint32_t deadline_us)
+  {
+    return static_cast<int32_t>(now_us - deadline_us) >= 0;
+  }
+
+  uint8_t __in_flight() const
+  {
+    return static_cast<uint8_t>(__tx_next - __tx_base);
+  }
+
+  uint32_t __clamp_rto(uint32_t rto_us) const
+  {
+    return rto_us < __config.min_rto_us ? __config.min_rto_us : (rto_us > __config.max_rto_us ? __config.max_rto_us : rto_us);
+  }
+
+  /// @brief RFC 6298：SRTT = 7/8 SRTT + 1/8 R，RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|，RTO = SRTT + 4 RTTVAR
+  void __sample_rtt(uint32_t rtt_us)
+  {
+    if (!__has_rtt)
+    {
+      __srtt_us = rtt_us;
+      __rttvar_us = rtt_us / 2;
+      __has_rtt = true;
+    }
+    else
+    {
+      const uint32_t delta{__srtt_us > rtt_us ? __srtt_us - rtt_us : rtt_us - __srtt_us};
+      __rttvar_us = (__rttvar_us * 3 + delta) / 4;
+      __srtt_us = (__srtt_us * 7 + rtt_us) / 8;
+    }
+    __rto_us = __clamp_rto(__srtt_us + 4 * __rttvar_us);
+  }
+
+  void __advance_tx_base()
+  {
+    while (__tx_base != __tx_next && __tx[__tx_base % _Window].state == __TxState::ACKED)
+    {
+      __tx[__tx_base % _Window].state = __TxState::EMPTY;
+      ++__tx_base;
+    }
+  }
+
+  void __on_ack(const uint8_t *packet, uint32_t now_us)
+  {
+    ++__stats.acks_received;
+    const uint8_t cum{packet[1]};
+    const uint32_t bitmap{static_cast<uint32_t>(packet[2]) | static_cast<uint32_t>(packet[3]) << 8 |
+                          static_cast<uint32_t>(packet[4]) << 16 | static_cast<uint32_t>(packet[5]) << 24};
+    const uint8_t in_flight{__in_flight()};
+    bool has_latest{false};
+    uint32_t latest_order{0}; // 本次新确认的帧中最晚的发送序号
+    const auto ack{[&](uint8_t seq)
+                   {
+                     auto &slot{__tx[seq % _Window]};
+                     if (slot.state != __TxState::SENT)
+                     {
+                       return;
+                     }
+                     slot.state = __TxState::ACKED;
+                     if (slot.tries == 1)
+                     {
+                       __sample_rtt(now_us - slot.sent_us); // Karn算法：重发过的帧无法区分是哪一次发送的确认
+                     }
+                     if (!has_latest || static_cast<int32_t>(slot.tx_order - latest_order) > 0)
+                     {
+                       latest_order = slot.tx_order;
+                       has_latest = true;
+                     }
+                   }};
+    // 累计确认不在已发送的范围内时只使用位图（如对端重启后的确认）
+    const uint8_t cum_offset{static_cast<uint8_t>(cum - __tx_base)};
+    if (cum_offset <= in_flight)
+    {
+      for (uint8_t i = 0; i < cum_offset; ++i)
+      {
+        ack(static_cast<uint8_t>(__tx_base + i));
+      }
+    }
+    for (uint8_t i = 0; i < 32 && bitmap >> i; ++i)
+    {
+      const uint8_t seq{static_cast<uint8_t>(cum + 1 + i)};
+      if ((bitmap >> i & 1) && static_cast<uint8_t>(seq - __tx_base) < in_flight)
+      {
+        ack(seq);
+      }
+    }
+    // 链路不会乱序，比某帧更晚发出的帧已经到达说明该帧丢失，不必等待超时
+    if (has_latest)
+    {
+      for (uint8_t i = 0; i < in_flight; ++i)
+      {
+        auto &slot{__tx[(__tx_base + i) % _Window]};
+        if (slot.state == __TxState::SENT && !slot.fast_retx && static_cast<int32_t>(latest_order - slot.tx_order) > 0)
+        {
+          slot.fast_retx = true;
+          slot.deadline_us = now_us;
+          ++__stats.fast_retransmits;
+        }
+      }
+    }
+    __advance_tx_base();
+  }
+
+  template <typename _DeliverFun>
+  void __deliver_in_order(_DeliverFun &deliver)
+  {
+    while (__rx[__rx_expected % _Window].present)
+    {
+      auto &slot{__rx[__rx_expected % _Window]};
+      slot.present = false;
+      ++__rx_expected;
+      ++__stats.delivered;
+      deliver(static_cast<const uint8_t *>(slot.data), static_cast<size_t>(slot.len));
+    }
+  }
+
+  /// @brief 对端已经不再发送target之前的帧，交付已经收到的帧并跳过空洞
+  template <typename _DeliverFun>
+  void __skip_to(uint8_t target, _DeliverFun &deliver)
+  {
+    for (uint8_t i = 0; i < _Window && __rx_expected != target; ++i)
+    {
+      auto &slot{__rx[__rx_expected % _Window]};
+      if (slot.present)
+      {
+        slot.present = false;
+        ++__stats.delivered;
+        deliver(static_cast<const uint8_t *>(slot.data), static_cast<size_t>(slot.len));
+      }
+      else
+      {
+        ++__stats.skipped;
+      }
+      ++__rx_expected;
+    }
+    if (__rx_expected != target)
+    {
+      // 相差超过一个窗口（对端重启），窗口内已经没有缓存的帧
+      __stats.skipped += static_cast<uint8_t>(target - __rx_expected);
+      __rx_expected = target;
+    }
+  }
+
+  template <typename _DeliverFun>
+  void __on_data(const uint8_t *packet, size_t len, _DeliverFun &deliver)
+  {
+    __ack_pending = true; // 重复的帧也需要确认，对端可能没有收到上一次的ACK
+    const uint8_t seq{packet[1]};
+    const uint8_t sender_base{static_cast<uint8_t>(seq - (packet[0] & 0x1F))};
+    const uint8_t base_offset{static_cast<uint8_t>(sender_base - __rx_expected)};
+    if (base_offset != 0 && base_offset < 0x80)
+    {
+      __skip_to(sender_base, deliver);
+    }
+    const uint8_t offset{static_cast<uint8_t>(seq - __rx_expected)};
+    if (offset >= _Window)
+    {
+      if (static_cast<uint8_t>(__rx_expected - seq) <= _Window)
+      {
+        ++__stats.duplicates; // 已经交付过的帧
+        return;
+      }
+      __skip_to(sender_base, deliver); // 对端重启，序号与本端无关
+    }
+    auto &slot{__rx[seq % _Window]};
+    if (slot.present)
+    {
+      ++__stats.duplicates;
+      return;
+    }
+    slot.present = true;
+    slot.len = static_cast<uint8_t>(len - ARQ_HEADER_SIZE);
+    memcpy(slot.data, packet + ARQ_HEADER_SIZE, slot.len);
+    __deliver_in_order(deliver);
+  }
+
+public:
+  ArqLink() : __rto_us(__config.initial_rto_us) {}
+
+  explicit ArqLink(const Config &config) : __config(config), __rto_us(config.initial_rto_us) {}
+
+  ArqLink(const ArqLink &) = delete;
+  ArqLink &operator=(const ArqLink &) = delete;
+
+  /// @brief 判断数据包是否为ARQ帧
+  static bool match(const uint8_t *packet, size_t len)
+  {
+    return (len > ARQ_HEADER_SIZE && (packet[0] & 0xE0) == ARQ_TYPE_DATA) ||
+           (len == ARQ_ACK_SIZE && packet[0] == ARQ_TYPE_ACK);
+  }
+
+  /// @brief 发送窗口是否还有空间
+  bool writable() const { return __in_flight() < _Window; }
+
+  /// @brief 未确认（包括还未发出）的数据帧数量
+  uint8_t in_flight() const { return __in_flight(); }
+
+  /// @brief 加入一个数据帧，由poll发送
+  /// @param data 数据
+  /// @param len 数据长度，不能超过payload_size
+  /// @return 发送窗口已满或长度无效返回false
+  bool send(const uint8_t *data, size_t len)
+  {
+    if (len == 0 || len > payload_size || !writable())
+    {
+      return false;
+    }
+    auto &slot{__tx[__tx_next % _Window]};
+    slot.state = __TxState::QUEUED;
+    slot.tries = 0;
+    slot.fast_retx = false;
+    slot.len = static_cast<uint8_t>(len);
+    slot.trace_id = TRACE_CURRENT();
+    memcpy(slot.data, data, len);
+    ++__tx_next;
+    return true;
+  }
+
+  /// @brief 输入从设备收到的一个数据包
+  /// @tparam _DeliverFun 形如 void(const uint8_t *data, size_t len) 的回调
+  /// @param packet 数据包
+  /// @param len 数据包长度
+  /// @param now_us 当前时间，单位为微秒
+  /// @param deliver 按序交付数据帧，数据只在回调期间有效
+  /// @return 是否为ARQ帧，不是则调用者按原来的方式处理
+  template <typename _DeliverFun>
+  bool receive(const uint8_t *packet, size_t len, uint32_t now_us, _DeliverFun &&deliver)
+  {
+    if (!match(packet, len))
+    {
+      return false;
+    }
+    if (packet[0] == ARQ_TYPE_ACK)
+    {
+      __on_ack(packet, now_us);
+    }
+    else
+    {
+      __on_data(packet, len, deliver);
+    }
+    return true;
+  }
+
+  /// @brief 发送待发的ACK、超时或快速重发的帧和新帧，应在收到数据包和定时器到期后调用
+  /// @tparam _TransmitFun 形如 bool(const uint8_t *data, size_t len) 的发送函数，设备忙时返回false
+  /// @param now_us 当前时间，单位为微秒
+  /// @param transmit 发送函数
+  template <typename _TransmitFun>
+  void poll(uint32_t now_us, _TransmitFun &&transmit)
+  {
+    uint8_t packet[_Mtu];
+    if (__ack_pending)
+    {
+      packet[0] = ARQ_TYPE_ACK;
+      packet[1] = __rx_expected;
+      uint32_t bitmap{0};
+      for (uint8_t i = 0; i + 1 < _Window; ++i)
+      {
+        bitmap |= static_cast<uint32_t>(__rx[(__rx_expected + 1 + i) % _Window].present) << i;
+      }
+      for (uint8_t i = 0; i < 4; ++i)
+      {
+        packet[2 + i] = static_cast<uint8_t>(bitmap >> (8 * i));
+      }
+      if (!transmit(static_cast<const uint8_t *>(packet), static_cast<size_t>(ARQ_ACK_SIZE)))
+      {
+        return;
+      }
+      __ack_pending = false;
+      ++__stats.acks_sent;
+    }
+    bool backoff{false};
+    const uint8_t in_flight{__in_flight()};
+    for (uint8_t i = 0; i < in_flight; ++i)
+    {
+      const uint8_t seq{static_cast<uint8_t>(__tx_base + i)};
+      auto &slot{__tx[seq % _Window]};
+      const bool retransmit{slot.state == __TxState::SENT && __time_reached(now_us, slot.deadline_us)};
+      if (slot.state != __TxState::QUEUED && !retransmit)
+      {
+        continue;
+      }
+      if (retransmit && __config.max_retries && slot.tries > __config.max_retries)
+      {
+        slot.state = __TxState::ACKED; // 放弃，对端通过窗口起点跳过
+        ++__stats.expired;
+        continue;
+      }
+      packet[0] = static_cast<uint8_t>(ARQ_TYPE_DATA | i);
+      packet[1] = seq;
+      memcpy(packet + ARQ_HEADER_SIZE, slot.data, slot.len);
+      TRACE_SET_CURRENT(slot.trace_id); // 重发时设备记录的是同一个数据包
+      const bool transmitted{transmit(static_cast<const uint8_t *>(packet), static_cast<size_t>(slot.len + ARQ_HEADER_SIZE))};
+      TRACE_SET_CURRENT(0);
+      if (!transmitted)
+      {
+        break; // 设备忙，下一次poll继续
+      }
+      if (retransmit)
+      {
+        ++__stats.retransmits;
+        backoff = backoff || !slot.fast_retx;
+      }
+      else
+      {
+        ++__stats.sent;
+      }
+      ++slot.tries;
+      slot.state = __TxState::SENT;
+      slot.fast_retx = false;
+      slot.sent_us = now_us;
+      slot.tx_order = ++__tx_order;
+      slot.deadline_us = now_us + __rto_us;
+    }
+    if (backoff)
+    {
+      __rto_us = __clamp_rto(__rto_us * 2); // 超时重发时按指数退避，直到新的RTT采样
+    }
+    __advance_tx_base();
+  }
+
+  /// @brief 距离下一次需要调用poll的时间，用于设置等待超时
+  /// @param now_us 当前时间，单位为微秒
+  /// @return 单位为微秒，有待发的ACK或新帧时为0，没有未确认的帧时为UINT32_MAX
+  uint32_t time_to_next_us(uint32_t now_us) const
+  {
+    if (__ack_pending)
+    {
+      return 0;
+    }
+    uint32_t wait_us{UINT32_MAX};
+    for (uint8_t i = 0; i < __in_flight(); ++i)
+    {
+      const auto &slot{__tx[(__tx_base + i) % _Window]};
+      if (slot.state == __TxState::QUEUED || (slot.state == __TxState::SENT && __time_reached(now_us, slot.deadline_us)))
+      {
+        return 0;
+      }
+      if (slot.state == __TxState::SENT && slot.deadline_us - now_us < wait_us)
+      {
+        wait_us = slot.deadline_us - now_us;
+      }
+    }
+    return wait_us;
+  }
+
+  /// @brief 平滑后的RTT，单位为微秒，没有采样时为0
+  uint32_t srtt_us() const { return __srtt_us; }
+
+  /// @brief 当前的重发超时，单位为微秒
+  uint32_t rto_us() const { return __rto_us; }
+
+  const Stats &stats() const { return __stats; }
+};
+
+#endif // __ARQ_HPP__
@@ -24,6 +24,13 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+// x86主机（native环境）上编码和解码使用SSSE3按16字符一块处理，运行时检测CPU是否支持，ESP32上不编译
+#if defined(__x86_64__) && defined(__GNUC__)
+#define BASE64_SSSE3 1
+#include <immintrin.h>
+#endif
 
 // base64 转换表, 共64个
 static const char base64_alphabet[] = {
@@ -63,79 +70,142 @@ static const unsigned char base64_suffix_map[256] = {
     255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
     255, 255, 255, 255};
 
-static char cmove_bits(unsigned char src, unsigned lnum, unsigned rnum)
+int base64_encode_len(const int inlen)
 {
-  src <<= lnum; // src = src << lnum;
-  src >>= rnum; // src = src >> rnum;
-  return src;
+  return inlen * 8 / 6 + 4; // 缺位补齐1 俩等号2 最后0-1位
 }
 
-int base64_encode_len(const int inlen)
+/// @brief 编码一组完整的3字节，输出4个字符
+///        将3字节拼成24位整数后一次取出4个6位索引，避免逐位移动
+static inline void base64_encode_group(const unsigned char *in, char *out)
 {
-  return inlen * 8 / 6 + 4; // 缺位补齐1 俩等号2 最后0-1位
+  unsigned int v = ((unsigned int)in[0] << 16) | ((unsigned int)in[1] << 8) | in[2];
+  out[0] = base64_alphabet[(v >> 18) & 0x3f];
+  out[1] = base64_alphabet[(v >> 12) & 0x3f];
+  out[2] = base64_alphabet[(v >> 6) & 0x3f];
+  out[3] = base64_alphabet[v & 0x3f];
 }
 
-int base64_encode(const void *indata, int inlen, char *outdata, int *outlen)
+/// @brief 编码连续的完整分组，循环展开为每次处理两个分组（6字节输出8个字符），
+///        每个字符仍单独查表，不是按机器字并行处理
+/// @return 输出的字符数
+static int base64_encode_blocks(const unsigned char *in, int groups, char *out)
 {
-  int ret = 0; // return value
-  if (indata == NULL || inlen == 0)
+  char *p = out;
+  for (; groups >= 2; groups -= 2)
   {
-    return ret = -1;
+    base64_encode_group(in, p);
+    base64_encode_group(in + 3, p + 4);
+    in += 6;
+    p += 8;
   }
-  const char *inbuf = (const char *)indata;
-
-  int in_len = 0;  // 源字符串长度, 如果in_len不是3的倍数, 那么需要补成3的倍数
-  int pad_num = 0; // 需要补齐的字符个数, 这样只有2, 1, 0(0的话不需要拼接, )
-  if (inlen % 3 != 0)
+  if (groups)
   {
-    pad_num = 3 - inlen % 3;
+    base64_encode_group(in, p);
+    p += 4;
   }
-  in_len = inlen + pad_num; // 拼接后的长度, 实际编码需要的长度(3的倍数)
-
-  int out_len = in_len * 8 / 6; // 编码后的长度
-
-  char *p = outdata; // 定义指针指向传出data的首地址
+  return (int)(p - out);
+}
 
-  // 编码, 长度为调整后的长度, 3字节一组
-  for (int i = 0; i < in_len; i += 3)
+#ifdef BASE64_SSSE3
+/// @brief SSSE3编码：每次读取16字节，使用其中的12字节输出16个字符
+///        先用pshufb把每3字节复制到一个32位通道，再用乘法把4个6位索引移到各自字节的低位，
+///        最后按索引所在的区间（A-Z、a-z、0-9、+、/）查表得到与ASCII码的差值
+/// @return 处理的分组数，剩余的分组（不足6个时不能安全读取16字节）由标量代码处理
+__attribute__((target("ssse3"))) static int base64_encode_blocks_ssse3(const unsigned char *in, int groups, char *out)
+{
+  const __m128i shuffle = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+  const __m128i shift_lut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+  int done = 0;
+  for (; groups - done >= 6; done += 4)
   {
-    int value = *inbuf >> 2;         // 将indata第一个字符向右移动2bit(丢弃2bit)
-    char c = base64_alphabet[value]; // 对应base64转换表的字符
-    *p = c;                          // 将对应字符(编码后字符)赋值给outdata第一字节
+    __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(in + done * 3)), shuffle);
+    const __m128i t0 = _mm_mulhi_epu16(_mm_and_si128(v, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+    const __m128i t1 = _mm_mullo_epi16(_mm_and_si128(v, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+    const __m128i indices = _mm_or_si128(t0, t1);
+    // 0～25映射到13，26～51映射到0，52～63映射到1～12
+    __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+    v = _mm_add_epi8(_mm_shuffle_epi8(shift_lut, range), indices);
+    _mm_storeu_si128((__m128i *)(out + done * 4), v);
+  }
+  return done;
+}
 
-    // 处理最后一组(最后3字节)的数据
-    if (i == inlen + pad_num - 3 && pad_num != 0)
+/// @brief SSSE3解码：每次处理16个字符，输出12字节
+///        按高低半字节查表检查字符是否都在编码表中，再按高半字节查表把ASCII码转换为6位值，用乘加指令拼接
+/// @return 解码的块数，遇到换行、'='或非法字符的块由标量代码处理
+__attribute__((target("ssse3"))) static int base64_decode_blocks_ssse3(const unsigned char *in, int inlen, unsigned char *out)
+{
+  const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                       0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+  const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                       0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  const __m128i nibble = _mm_set1_epi8(0x0f);
+  int blocks = 0;
+  for (; inlen >= 16; inlen -= 16, ++blocks)
+  {
+    const __m128i v = _mm_loadu_si128((const __m128i *)(in + blocks * 16));
+    const __m128i hi = _mm_and_si128(_mm_srli_epi32(v, 4), nibble);
+    const __m128i lo = _mm_and_si128(v, nibble);
+    const __m128i invalid = _mm_and_si128(_mm_shuffle_epi8(lut_lo, lo), _mm_shuffle_epi8(lut_hi, hi));
+    if (_mm_movemask_epi8(_mm_cmpgt_epi8(invalid, _mm_setzero_si128())) != 0)
     {
-      if (pad_num == 1)
-      {
-        *(p + 1) = base64_alphabet[(int)(cmove_bits(*inbuf, 6, 2) + cmove_bits(*(inbuf + 1), 0, 4))];
-        *(p + 2) = base64_alphabet[(int)cmove_bits(*(inbuf + 1), 4, 2)];
-        *(p + 3) = '=';
-      }
-      else if (pad_num == 2)
-      { // 编码后的数据要补两个 '='
-        *(p + 1) = base64_alphabet[(int)cmove_bits(*inbuf, 6, 2)];
-        *(p + 2) = '=';
-        *(p + 3) = '=';
-      }
-    }
-    else
-    { // 处理正常的3字节的数据
-      *(p + 1) = base64_alphabet[cmove_bits(*inbuf, 6, 2) + cmove_bits(*(inbuf + 1), 0, 4)];
-      *(p + 2) = base64_alphabet[cmove_bits(*(inbuf + 1), 4, 2) + cmove_bits(*(inbuf + 2), 0, 6)];
-      *(p + 3) = base64_alphabet[*(inbuf + 2) & 0x3f];
+      break;
     }
+    const __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('/')), hi));
+    __m128i bits = _mm_maddubs_epi16(_mm_add_epi8(v, roll), _mm_set1_epi32(0x01400140));
+    bits = _mm_shuffle_epi8(_mm_madd_epi16(bits, _mm_set1_epi32(0x00011000)), pack);
+    // 只写出有效的12字节，调用者的缓冲区没有多余的空间
+    unsigned char *p = out + blocks * 12;
+    _mm_storel_epi64((__m128i *)p, bits);
+    const int last = _mm_cvtsi128_si32(_mm_srli_si128(bits, 8));
+    memcpy(p + 8, &last, 4);
+  }
+  return blocks;
+}
+#endif
 
-    p += 4;
-    inbuf += 3;
+/// @brief 编码不足3字节的结尾，并补齐'='
+/// @return 输出的字符数
+static int base64_encode_tail(const unsigned char *in, int len, char *out)
+{
+  if (len == 0)
+  {
+    return 0;
+  }
+  unsigned int v = (unsigned int)in[0] << 16;
+  if (len == 2)
+  {
+    v |= (unsigned int)in[1] << 8;
+  }
+  out[0] = base64_alphabet[(v >> 18) & 0x3f];
+  out[1] = base64_alphabet[(v >> 12) & 0x3f];
+  out[2] = len == 2 ? base64_alphabet[(v >> 6) & 0x3f] : '=';
+  out[3] = '=';
+  return 4;
+}
+
+int base64_encode(const void *indata, int inlen, char *outdata, int *outlen)
+{
+  if (indata == NULL || inlen == 0)
+  {
+    return -1;
   }
+  base64_encode_state state;
+  base64_encode_begin(&state);
+  int out_len = base64_encode_update(&state, indata, inlen, outdata);
+  out_len += base64_encode_end(&state, outdata + out_len);
 
   if (outlen != NULL)
   {
     *outlen = out_len;
   }
 
-  return ret;
+  return 0;
 }
 
 int base64_decode_len(const char *indata, const int inlen)
@@ -146,52 +216,170 @@ int base64_decode_len(const char *indata, const int inlen)
   return flen * 6 / 8 + 1;
 }
 
-int base64_decode(const char *indata, int inlen, void *outdata, int *outlen)
+void base64_encode_begin(base64_encode_state *state)
 {
-  int ret = 0;
-  if (indata == NULL || inlen <= 0 || outdata == NULL || outlen == NULL)
+  state->len = 0;
+}
+
+int base64_encode_update(base64_encode_state *state, const void *indata, int inlen, char *outdata)
+{
+  const unsigned char *inbuf = (const unsigned char *)indata;
+  int out_len = 0;
+
+  // 先补齐上一次剩余的不完整分组
+  while (state->len > 0 && state->len < 3 && inlen > 0)
   {
-    return ret = -1;
+    state->buf[state->len++] = *inbuf++;
+    inlen--;
   }
-  if (inlen % 4 != 0) // 需要解码的数据不是4字节倍数
+  if (state->len == 3)
   {
-    return ret = -2;
+    base64_encode_group(state->buf, outdata);
+    out_len += 4;
+    state->len = 0;
   }
 
-  char *outbuf = (char *)outdata;
+  int groups = inlen / 3;
+#ifdef BASE64_SSSE3
+  if (groups >= 6 && __builtin_cpu_supports("ssse3"))
+  {
+    int done = base64_encode_blocks_ssse3(inbuf, groups, outdata + out_len);
+    inbuf += done * 3;
+    inlen -= done * 3;
+    out_len += done * 4;
+    groups -= done;
+  }
+#endif
+  out_len += base64_encode_blocks(inbuf, groups, outdata + out_len);
+  inbuf += groups * 3;
+  inlen -= groups * 3;
+
+  // 剩余字节留到下一次调用
+  while (inlen-- > 0)
+  {
+    state->buf[state->len++] = *inbuf++;
+  }
+  return out_len;
+}
+
+int base64_encode_end(base64_encode_state *state, char *outdata)
+{
+  int out_len = base64_encode_tail(state->buf, state->len, outdata);
+  state->len = 0;
+  return out_len;
+}
+
+void base64_decode_begin(base64_decode_state *state)
+{
+  state->bits = 0;
+  state->count = 0;
+  state->pad = 0;
+}
 
-  int t = 0, x = 0, y = 0, i = 0;
-  unsigned char c = 0;
-  int g = 3;
+int base64_decode_update(base64_decode_state *state, const char *indata, int inlen, void *outdata)
+{
+  const unsigned char *inbuf = (const unsigned char *)indata;
+  unsigned char *outbuf = (unsigned char *)outdata;
+  int i = 0;
 
-  while (indata[x] != 0)
+#ifdef BASE64_SSSE3
+  const int ssse3 = inlen >= 16 && __builtin_cpu_supports("ssse3");
+#endif
+  while (inlen > 0)
   {
-    c = base64_suffix_map[(int)indata[x++]]; // 需要解码的数据对应的ASCII值对应base64_suffix_map的值
+#ifdef BASE64_SSSE3
+    if (ssse3 && state->count == 0 && inlen >= 16)
+    {
+      int blocks = base64_decode_blocks_ssse3(inbuf, inlen, outbuf + i);
+      inbuf += blocks * 16;
+      inlen -= blocks * 16;
+      i += blocks * 12;
+      if (blocks > 0)
+      {
+        continue;
+      }
+    }
+#endif
+    // 快速路径：分组边界上连续4个字符都是有效编码字符时一次解码3字节
+    if (state->count == 0 && inlen >= 4)
+    {
+      unsigned char a = base64_suffix_map[inbuf[0]];
+      unsigned char b = base64_suffix_map[inbuf[1]];
+      unsigned char c = base64_suffix_map[inbuf[2]];
+      unsigned char d = base64_suffix_map[inbuf[3]];
+      if (((a | b | c | d) & 0xC0) == 0)
+      {
+        unsigned int t = ((unsigned int)a << 18) | ((unsigned int)b << 12) | ((unsigned int)c << 6) | d;
+        outbuf[i++] = (unsigned char)(t >> 16);
+        outbuf[i++] = (unsigned char)(t >> 8);
+        outbuf[i++] = (unsigned char)t;
+        inbuf += 4;
+        inlen -= 4;
+        continue;
+      }
+    }
+
+    // 慢速路径：逐字符处理换行、'='以及分组跨越两次调用的情况
+    unsigned char c = base64_suffix_map[*inbuf++];
+    inlen--;
     if (c == 255)
       return -1; // 对应的值不在转码表中
     if (c == 253)
       continue; // 对应的值是换行或者回车
     if (c == 254)
-    {
+    { // 对应的值是'='
       c = 0;
-      g--;
-    }                 // 对应的值是'='
-    t = (t << 6) | c; // 将其依次放入一个int型中占3字节
-    if (++y == 4)
+      state->pad++;
+    }
+    state->bits = (state->bits << 6) | c;
+    if (++state->count == 4)
     {
-      outbuf[i++] = (unsigned char)((t >> 16) & 0xff);
-      if (g > 1)
-        outbuf[i++] = (unsigned char)((t >> 8) & 0xff);
-      if (g > 2)
-        outbuf[i++] = (unsigned char)(t & 0xff);
-      y = t = 0;
+      outbuf[i++] = (unsigned char)((state->bits >> 16) & 0xff);
+      if (state->pad < 2)
+        outbuf[i++] = (unsigned char)((state->bits >> 8) & 0xff);
+      if (state->pad < 1)
+        outbuf[i++] = (unsigned char)(state->bits & 0xff);
+      state->bits = 0;
+      state->count = 0;
+      state->pad = 0;
     }
   }
-  if (outlen != NULL)
-  {
-    *outlen = i;
-  }
+  return i;
+}
+
+int base64_decode_end(base64_decode_state *state)
+{
+  int ret = state->count == 0 ? 0 : -2; // 剩余不完整的分组
+  base64_decode_begin(state);
   return ret;
 }
 
+int base64_decode(const char *indata, int inlen, void *outdata, int *outlen)
+{
+  if (indata == NULL || inlen <= 0 || outdata == NULL || outlen == NULL)
+  {
+    return -1;
+  }
+  if (inlen % 4 != 0) // 需要解码的数据不是4字节倍数
+  {
+    return -2;
+  }
+
+  // 与原实现保持一致：遇到字符串结束符时停止
+  const char *end = (const char *)memchr(indata, 0, inlen);
+  int len = end != NULL ? (int)(end - indata) : inlen;
 
+  base64_decode_state state;
+  base64_decode_begin(&state);
+  int ret = base64_decode_update(&state, indata, len, outdata);
+  if (ret < 0)
+  {
+    return ret;
+  }
+  if (base64_decode_end(&state) != 0) // 结束符或换行导致最后的分组不完整
+  {
+    return -2;
+  }
+  *outlen = ret;
+  return 0;
+}
@@ -32,9 +32,59 @@ int base64_decode_len(const char *indata, const int inlen);
 /// @param inlen 输入数据长度，为实际字符长度
 /// @param outdata 输出数据地址
 /// @param outlen 输出数据长度地址
-/// @return 是否成功，-1为异常
+/// @return 是否成功，-1为异常或存在非法字符，-2为长度不是4的倍数或最后的分组不完整
 int base64_decode(const char *indata, int inlen, void *outdata, int *outlen);
 
+/// @brief 流式编码状态，保存上一次调用剩余的不完整分组
+typedef struct
+{
+  unsigned char buf[3];
+  int len;
+} base64_encode_state;
+
+/// @brief 流式解码状态，保存当前分组已累计的6位数据
+typedef struct
+{
+  unsigned int bits;
+  int count;
+  int pad;
+} base64_decode_state;
+
+/// @brief 开始一次流式编码
+/// @param state 编码状态
+void base64_encode_begin(base64_encode_state *state);
+
+/// @brief 编码一段数据，不足3字节的部分保留到下一次调用
+/// @param state 编码状态
+/// @param indata 输入数据
+/// @param inlen 输入数据长度
+/// @param outdata 输出数据地址，长度至少为 (inlen + 2) / 3 * 4
+/// @return 本次输出的字符数
+int base64_encode_update(base64_encode_state *state, const void *indata, int inlen, char *outdata);
+
+/// @brief 结束流式编码，输出剩余数据并补齐'='
+/// @param state 编码状态
+/// @param outdata 输出数据地址，长度至少为4
+/// @return 本次输出的字符数
+int base64_encode_end(base64_encode_state *state, char *outdata);
+
+/// @brief 开始一次流式解码
+/// @param state 解码状态
+void base64_decode_begin(base64_decode_state *state);
+
+/// @brief 解码一段字符，分组可以跨越多次调用，换行与回车会被忽略
+/// @param state 解码状态
+/// @param indata 输入字符
+/// @param inlen 输入字符数
+/// @param outdata 输出数据地址，长度至少为 (inlen / 4 + 1) * 3
+/// @return 本次输出的字节数，-1为存在非法字符
+int base64_decode_update(base64_decode_state *state, const char *indata, int inlen, void *outdata);
+
+/// @brief 结束流式解码
+/// @param state 解码状态
+/// @return 0为成功，-2为存在不完整的分组
+int base64_decode_end(base64_decode_state *state);
+
 #if __cplusplus
 }
 #endif
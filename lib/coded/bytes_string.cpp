@@ -7,6 +7,112 @@
 const char hexme_uppercase[]{"0123456789ABCDEF"};
 const char hexme_lowercase[]{"0123456789abcdef"};
 
+/// @brief 每个字节对应的两个16进制字符，一次查表得到两个字符
+struct HexPairTable
+{
+  char pairs[256][2];
+};
+
+static constexpr HexPairTable make_hex_pair_table(const char *hexme)
+{
+  HexPairTable table{};
+  for (int i = 0; i < 256; ++i)
+  {
+    table.pairs[i][0] = hexme[i >> 4];
+    table.pairs[i][1] = hexme[i & 0x0F];
+  }
+  return table;
+}
+
+static constexpr HexPairTable hex_pairs_uppercase{make_hex_pair_table("0123456789ABCDEF")};
+static constexpr HexPairTable hex_pairs_lowercase{make_hex_pair_table("0123456789abcdef")};
+
+size_t to_hex_buf(char *dst, const size_t dst_size, const void *data_ptr, const size_t size, bool hex_uppercase)
+{
+  if (!dst || dst_size == 0)
+  {
+    return 0;
+  }
+  size_t count{data_ptr ? size : 0};
+  if (hex_str_len(count) >= dst_size)
+  {
+    count = dst_size / 3; // 每个字节占3个字符，最后一个字节的空格位置用于结束符
+  }
+  auto str_ptr = static_cast<const unsigned char *>(data_ptr);
+  auto &pairs = hex_uppercase ? hex_pairs_uppercase.pairs : hex_pairs_lowercase.pairs;
+  char *out{dst};
+  for (size_t pos = 0; pos < count; ++pos)
+  {
+    out[0] = pairs[str_ptr[pos]][0];
+    out[1] = pairs[str_ptr[pos]][1];
+    out[2] = ' ';
+    out += 3;
+  }
+  if (count)
+  {
+    --out; // 去掉最后一个空格
+  }
+  *out = '\0';
+  return out - dst;
+}
+
+/// @brief to_byte_buf与to_byte_vibuf的公共实现
+/// @tparam _IsPlain 判断字符是否原样输出
+template <typename _IsPlain>
+static size_t to_escaped_buf(char *dst, const size_t dst_size, const void *data_ptr, const size_t size, bool hex_uppercase, _IsPlain is_plain)
+{
+  if (!dst || dst_size == 0)
+  {
+    return 0;
+  }
+  if (!data_ptr)
+  {
+    *dst = '\0';
+    return 0;
+  }
+  auto str_ptr = static_cast<const unsigned char *>(data_ptr);
+  auto &pairs = hex_uppercase ? hex_pairs_uppercase.pairs : hex_pairs_lowercase.pairs;
+  char *out{dst};
+  char *const end{dst + dst_size - 1}; // 预留结束符
+  for (size_t pos = 0; pos < size; ++pos)
+  {
+    if (is_plain(str_ptr[pos]))
+    {
+      if (out + 1 > end)
+      {
+        break;
+      }
+      *out++ = str_ptr[pos];
+    }
+    else
+    {
+      if (out + 4 > end)
+      {
+        break;
+      }
+      out[0] = '\\';
+      out[1] = 'x';
+      out[2] = pairs[str_ptr[pos]][0];
+      out[3] = pairs[str_ptr[pos]][1];
+      out += 4;
+    }
+  }
+  *out = '\0';
+  return out - dst;
+}
+
+size_t to_byte_buf(char *dst, const size_t dst_size, const void *data_ptr, const size_t size, bool hex_uppercase)
+{
+  return to_escaped_buf(dst, dst_size, data_ptr, size, hex_uppercase, [](unsigned char chr)
+                        { return isascii(chr); });
+}
+
+size_t to_byte_vibuf(char *dst, const size_t dst_size, const void *data_ptr, const size_t size, bool hex_uppercase)
+{
+  return to_escaped_buf(dst, dst_size, data_ptr, size, hex_uppercase, [](unsigned char chr)
+                        { return isprint(chr); });
+}
+
 /// @brief 转换成byte字符串
 /// @param data_ptr 输入数据
 /// @param size 数据长度
@@ -14,22 +120,12 @@ const char hexme_lowercase[]{"0123456789abcdef"};
 /// @return 形如“ff aa bb”的数据
 const std::string to_hex_str(const void *data_ptr, const size_t size, bool hex_uppercase)
 {
-  if (!data_ptr)
+  if (!data_ptr || size == 0)
   {
     return "";
   }
-  auto str_ptr = static_cast<const unsigned char *>(data_ptr);
-  auto hexme = hex_uppercase ? hexme_uppercase : hexme_lowercase;
-  std::string result{};
-  size_t pos{0};
-  for (; pos < size - 1; ++pos)
-  {
-    result.push_back(hexme[(str_ptr[pos] & 0xF0) >> 4]);
-    result.push_back(hexme[str_ptr[pos] & 0x0F]);
-    result.push_back(' ');
-  }
-  result.push_back(hexme[(str_ptr[pos] & 0xF0) >> 4]);
-  result.push_back(hexme[str_ptr[pos] & 0x0F]);
+  std::string result(hex_str_len(size), '\0');
+  to_hex_buf(&result[0], result.size() + 1, data_ptr, size, hex_uppercase); // C++11起string保证末尾有结束符的空间
   return result;
 }
 
@@ -3,6 +3,8 @@
 
 #include <string>
 #include <vector>
+#include <array>
+#include <cstddef>
 #include <ctype.h>
 
 /// @brief 转换成byte字符串
@@ -30,4 +32,56 @@ const std::string to_byte_vistr(const void *data_ptr, const size_t size, bool he
 
 const std::string to_byte_vistr(const char chr_val, bool hex_uppercase);
 
+/// @brief 计算to_hex_buf输出的字符数（不含结束符）
+/// @param size 数据长度
+/// @return 形如“ff aa bb”的字符数
+constexpr size_t hex_str_len(const size_t size)
+{
+  return size ? size * 3 - 1 : 0;
+}
+
+/// @brief 转换成byte字符串，写入调用者提供的缓存，不申请堆内存
+///        缓存不足时只输出能完整容纳的字节，结果始终以'\0'结尾
+/// @param dst 输出缓存
+/// @param dst_size 输出缓存长度（含结束符）
+/// @param data_ptr 输入数据
+/// @param size 数据长度
+/// @param hex_uppercase 是否使用大写的16进制表示
+/// @return 写入的字符数（不含结束符）
+size_t to_hex_buf(char *dst, const size_t dst_size, const void *data_ptr, const size_t size, bool hex_uppercase = false);
+
+/// @brief 转换成byte字符串（形如“abc\x00\x01”），写入调用者提供的缓存，不申请堆内存
+///        缓存不足时只输出能完整容纳的字节，结果始终以'\0'结尾
+/// @param dst 输出缓存，最坏情况下需要 size * 4 + 1 字节
+/// @param dst_size 输出缓存长度（含结束符）
+/// @param data_ptr 输入数据
+/// @param size 数据长度
+/// @param hex_uppercase 是否使用大写的16进制表示
+/// @return 写入的字符数（不含结束符）
+size_t to_byte_buf(char *dst, const size_t dst_size, const void *data_ptr, const size_t size, bool hex_uppercase = false);
+
+/// @brief 与to_byte_buf相同，只显示可见字符（如回车、空格等不显示）
+/// @param dst 输出缓存，最坏情况下需要 size * 4 + 1 字节
+/// @param dst_size 输出缓存长度（含结束符）
+/// @param data_ptr 输入数据
+/// @param size 数据长度
+/// @param hex_uppercase 是否使用大写的16进制表示
+/// @return 写入的字符数（不含结束符）
+size_t to_byte_vibuf(char *dst, const size_t dst_size, const void *data_ptr, const size_t size, bool hex_uppercase = false);
+
+/// @brief 转换成byte字符串并存放在定长数组中，适合在栈上格式化日志
+/// @tparam _MaxBytes 最多转换的字节数，超出部分被截断
+/// @param data_ptr 输入数据
+/// @param size 数据长度
+/// @param hex_uppercase 是否使用大写的16进制表示
+/// @return 以'\0'结尾的字符数组，通过data()取得字符串
+template <size_t _MaxBytes>
+std::array<char, _MaxBytes * 3> to_hex_array(const void *data_ptr, const size_t size, bool hex_uppercase = false)
+{
+  static_assert(_MaxBytes > 0, "_MaxBytes must be greater than 0");
+  std::array<char, _MaxBytes * 3> result;
+  to_hex_buf(result.data(), result.size(), data_ptr, size, hex_uppercase);
+  return result;
+}
+
 #endif // __BTYES_STRING_HPP__
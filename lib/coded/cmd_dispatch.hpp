@@ -0,0 +1,94 @@
+/// @brief 表驱动的控制帧分发器
+///        每条命令由帧长度和逐字节的mask/value签名描述，匹配时不需要逐字节分支，
+///        新增命令只需要在命令表中增加一项
+
+#ifndef __CMD_DISPATCH_HPP__
+#define __CMD_DISPATCH_HPP__
+
+#include <cstdint>
+#include <cstddef>
+
+/// @brief 命令签名
+/// @tparam _MaxLen 签名最大长度
+template <size_t _MaxLen>
+struct CmdSignature
+{
+  uint8_t length;         // 帧长度，必须完全相等
+  uint8_t mask[_MaxLen];  // 为1的位参与比较，为0的位是参数
+  uint8_t value[_MaxLen]; // 参与比较的位的期望值
+
+  /// @brief 判断数据是否与签名匹配
+  /// @param data 数据
+  /// @param len 数据长度
+  /// @return 是否匹配
+  bool match(const uint8_t *data, size_t len) const
+  {
+    if (len != length)
+    {
+      return false;
+    }
+    uint8_t diff{0};
+    for (size_t i = 0; i < length; ++i)
+    {
+      diff |= (data[i] ^ value[i]) & mask[i];
+    }
+    return diff == 0;
+  }
+};
+
+/// @brief 命令表中的一项
+/// @tparam _Context 处理函数的上下文类型
+/// @tparam _MaxLen 签名最大长度
+template <typename _Context, size_t _MaxLen>
+struct CmdEntry
+{
+  CmdSignature<_MaxLen> signature;
+  bool (*handler)(_Context &ctx, const uint8_t *data, size_t len); // 返回命令是否执行成功
+};
+
+/// @brief 分发结果
+enum class CmdResult : uint8_t
+{
+  NO_MATCH, // 不是控制帧
+  SUCCESS,  // 匹配且执行成功
+  FAILED,   // 匹配但执行失败
+};
+
+/// @brief 在命令表中查找匹配的命令并执行，第一个匹配的命令生效
+/// @param table 命令表
+/// @param ctx 处理函数的上下文
+/// @param data 数据
+/// @param len 数据长度
+/// @return 分发结果
+template <typename _Context, size_t _MaxLen, size_t _Count>
+CmdResult cmd_dispatch(const CmdEntry<_Context, _MaxLen> (&table)[_Count], _Context &ctx, const uint8_t *data, size_t len)
+{
+  for (const auto &entry : table)
+  {
+    if (entry.signature.match(data, len))
+    {
+      return entry.handler(ctx, data, len) ? CmdResult::SUCCESS : CmdResult::FAILED;
+    }
+  }
+  return CmdResult::NO_MATCH;
+}
+
+/// @brief 判断数据是否与命令表中的某个命令匹配，不执行命令
+/// @param table 命令表
+/// @param data 数据
+/// @param len 数据长度
+/// @return 是否匹配
+template <typename _Context, size_t _MaxLen, size_t _Count>
+bool cmd_match(const CmdEntry<_Context, _MaxLen> (&table)[_Count], const uint8_t *data, size_t len)
+{
+  for (const auto &entry : table)
+  {
+    if (entry.signature.match(data, len))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+#endif // __CMD_DISPATCH_HPP__
@@ -0,0 +1,144 @@
+/// @brief 编译期生成查表的CRC16计算模板
+///        使用slicing-by-N算法，每次处理N个字节，N为1时逐字节查表，支持流式增量计算（init/update/final）
+///        参数模型与常见的CRC参数表一致（poly/init/refin=refout/xorout）
+
+#ifndef __CRC_HPP__
+#define __CRC_HPP__
+
+#include <cstdint>
+#include <cstddef>
+
+template <uint16_t _Poly, uint16_t _Init, bool _Reflect, uint16_t _XorOut, size_t _Slices = 8>
+class Crc16
+{
+  static_assert(_Slices >= 1 && _Slices <= 16, "slices must be in range [1, 16]");
+
+private:
+  struct __Tables
+  {
+    uint16_t t[_Slices][256]{};
+  };
+
+  static constexpr uint16_t __reflect(uint16_t val)
+  {
+    uint16_t result{0};
+    for (int i = 0; i < 16; ++i)
+    {
+      if (val & (1U << i))
+      {
+        result |= static_cast<uint16_t>(1U << (15 - i));
+      }
+    }
+    return result;
+  }
+
+  static constexpr __Tables __make_tables()
+  {
+    __Tables tables{};
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+      uint16_t crc{0};
+      if (_Reflect)
+      {
+        crc = static_cast<uint16_t>(i);
+        for (int bit = 0; bit < 8; ++bit)
+        {
+          crc = (crc & 1) ? static_cast<uint16_t>((crc >> 1) ^ __reflect(_Poly)) : static_cast<uint16_t>(crc >> 1);
+        }
+      }
+      else
+      {
+        crc = static_cast<uint16_t>(i << 8);
+        for (int bit = 0; bit < 8; ++bit)
+        {
+          crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ _Poly) : static_cast<uint16_t>(crc << 1);
+        }
+      }
+      tables.t[0][i] = crc;
+    }
+    for (size_t k = 1; k < _Slices; ++k)
+    {
+      for (uint32_t i = 0; i < 256; ++i)
+      {
+        const uint16_t prev{tables.t[k - 1][i]};
+        tables.t[k][i] = _Reflect ? static_cast<uint16_t>((prev >> 8) ^ tables.t[0][prev & 0xFF])
+                                  : static_cast<uint16_t>((prev << 8) ^ tables.t[0][prev >> 8]);
+      }
+    }
+    return tables;
+  }
+
+  static constexpr __Tables __tables{__make_tables()};
+
+public:
+  /// @brief 增量计算的初始值
+  /// @return 内部寄存器初始值
+  static constexpr uint16_t init()
+  {
+    return _Reflect ? __reflect(_Init) : _Init;
+  }
+
+  /// @brief 将一段数据累加到CRC中
+  /// @param crc 当前值，由init或上一次update得到
+  /// @param buffer 数据
+  /// @param length 数据长度
+  /// @return 更新后的值
+  static uint16_t update(uint16_t crc, const void *buffer, size_t length)
+  {
+    auto ptr = static_cast<const uint8_t *>(buffer);
+    const auto &t = __tables.t;
+    if constexpr (_Slices > 1)
+    {
+      for (; length >= _Slices; length -= _Slices, ptr += _Slices)
+      {
+        uint16_t x{0};
+        if (_Reflect)
+        {
+          x = static_cast<uint16_t>(crc ^ (ptr[0] | (ptr[1] << 8)));
+          crc = t[_Slices - 1][x & 0xFF] ^ t[_Slices - 2][x >> 8];
+        }
+        else
+        {
+          x = static_cast<uint16_t>(crc ^ ((ptr[0] << 8) | ptr[1]));
+          crc = t[_Slices - 1][x >> 8] ^ t[_Slices - 2][x & 0xFF];
+        }
+        for (size_t j = 2; j < _Slices; ++j)
+        {
+          crc ^= t[_Slices - 1 - j][ptr[j]];
+        }
+      }
+    }
+    while (length--)
+    {
+      crc = _Reflect ? static_cast<uint16_t>((crc >> 8) ^ t[0][(crc ^ *ptr++) & 0xFF])
+                     : static_cast<uint16_t>((crc << 8) ^ t[0][((crc >> 8) ^ *ptr++) & 0xFF]);
+    }
+    return crc;
+  }
+
+  /// @brief 得到最终的CRC值
+  /// @param crc 当前值
+  /// @return CRC16
+  static constexpr uint16_t final(uint16_t crc)
+  {
+    return crc ^ _XorOut;
+  }
+
+  /// @brief 一次性计算整段数据的CRC
+  /// @param buffer 数据
+  /// @param length 数据长度
+  /// @return CRC16
+  static uint16_t compute(const void *buffer, size_t length)
+  {
+    return final(update(init(), buffer, length));
+  }
+};
+
+/// @brief CRC-16/MODBUS，结果按数值表示（低字节先发送），
+///        与crc16()的返回值互为字节交换：crc16() == bswap16(Crc16Modbus::compute())
+using Crc16Modbus = Crc16<0x8005, 0xFFFF, true, 0x0000>;
+
+/// @brief CRC-16/CCITT-FALSE，nRF24硬件CRC使用的多项式
+using Crc16Ccitt = Crc16<0x1021, 0xFFFF, false, 0x0000>;
+
+#endif // __CRC_HPP__
@@ -59,13 +59,18 @@ static const unsigned char table_crc_lo[] = {
     0x44, 0x84, 0x85, 0x45, 0x87, 0x47, 0x46, 0x86, 0x82, 0x42,
     0x43, 0x83, 0x41, 0x81, 0x80, 0x40};
 
-unsigned short crc16(void *buffer, size_t buffer_length)
+unsigned short crc16_init(void)
+{
+  return 0xFFFF;
+}
+
+unsigned short crc16_update(unsigned short crc, const void *buffer, size_t buffer_length)
 {
-  unsigned char crc_hi = 0xFF; // 高位CRC byte 初始化
-  unsigned char crc_lo = 0xFF; // 低位CRC byte 初始化
+  unsigned char crc_hi = crc >> 8;   // 高位CRC byte
+  unsigned char crc_lo = crc & 0xFF; // 低位CRC byte
   unsigned int i;
 
-  unsigned char *ucbuf = (unsigned char *)buffer;
+  const unsigned char *ucbuf = (const unsigned char *)buffer;
 
   while (buffer_length--)
   {
@@ -76,3 +81,13 @@ unsigned short crc16(void *buffer, size_t buffer_length)
 
   return (crc_hi << 8 | crc_lo);
 }
+
+unsigned short crc16_final(unsigned short crc)
+{
+  return crc;
+}
+
+unsigned short crc16(void *buffer, size_t buffer_length)
+{
+  return crc16_final(crc16_update(crc16_init(), buffer, buffer_length));
+}
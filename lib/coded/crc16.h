@@ -1,13 +1,36 @@
 #ifndef __CRC16_H__
 #define __CRC16_H__
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+/// @brief 计算Modbus CRC16，返回值高字节为先发送的字节（与Modbus帧中的字节顺序一致）
+/// @param buffer 数据
+/// @param buffer_length 数据长度
+/// @return CRC16
 unsigned short crc16(void *buffer, size_t buffer_length);
 
+/// @brief 增量计算Modbus CRC16的初始值
+///        用法：crc = crc16_init(); crc = crc16_update(crc, ...); ...; crc16_final(crc)
+/// @return CRC初始值
+unsigned short crc16_init(void);
+
+/// @brief 将一段数据累加到CRC中，可在数据流式到达时分段调用
+/// @param crc 当前CRC值，由crc16_init或上一次crc16_update得到
+/// @param buffer 数据
+/// @param buffer_length 数据长度
+/// @return 更新后的CRC值
+unsigned short crc16_update(unsigned short crc, const void *buffer, size_t buffer_length);
+
+/// @brief 得到最终的CRC值，与一次性调用crc16的结果相同
+/// @param crc 当前CRC值
+/// @return CRC16
+unsigned short crc16_final(unsigned short crc);
+
 #ifdef __cplusplus
 }
 #endif
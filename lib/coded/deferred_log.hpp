@@ -0,0 +1,208 @@
+/// @brief 延迟格式化的二进制日志
+///        记录点只把格式描述的地址（编译期确定的格式ID）、时间戳和原始整数参数写入无锁队列，
+///        由低优先级任务调用dlog_drain完成格式化和输出，发送路径上不再同步格式化和打印；
+///        低于DLOG_MIN_LEVEL的记录点在预处理阶段删除，不产生代码
+///        格式字符串只支持32位整数说明符（%d %u %x %X %c），附带的二进制数据以16进制追加在行尾
+
+#ifndef __DEFERRED_LOG_HPP__
+#define __DEFERRED_LOG_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+#include <type_traits>
+
+#include "mpsc_queue.hpp"
+#include "bytes_string.hpp"
+#include "trace.hpp"
+
+#define DLOG_LEVEL_TRACE 0
+#define DLOG_LEVEL_DEBUG 1
+#define DLOG_LEVEL_INFO 2
+#define DLOG_LEVEL_WARN 3
+#define DLOG_LEVEL_ERROR 4
+#define DLOG_LEVEL_NONE 5
+
+#ifndef DLOG_MIN_LEVEL
+#define DLOG_MIN_LEVEL DLOG_LEVEL_INFO // 低于该等级的记录点在编译时删除
+#endif
+
+#ifndef DLOG_QUEUE_SIZE
+#define DLOG_QUEUE_SIZE 64 // 记录数量，必须为2的幂
+#endif
+
+#define DLOG_MAX_ARGS 4  // 每条记录的整数参数数量
+#define DLOG_MAX_BLOB 32 // 每条记录附带的二进制数据长度，超出部分截断
+
+/// @brief 记录点描述，每个记录点一个静态常量，其地址即格式ID
+struct DlogSite
+{
+  uint8_t level;
+  const char *fmt;
+};
+
+/// @brief 队列中的一条记录
+struct DlogRecord
+{
+  const DlogSite *site;
+  uint64_t ts_us;
+  uint32_t args[DLOG_MAX_ARGS];
+  uint8_t blob_len;
+  uint8_t blob[DLOG_MAX_BLOB];
+};
+
+/// @brief 把记录点的参数转换为32位整数，只接受整数、枚举和指针
+template <typename _ArgType>
+inline uint32_t dlog_arg(_ArgType value)
+{
+  if constexpr (std::is_pointer_v<_ArgType>)
+  {
+    return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(value));
+  }
+  else
+  {
+    static_assert(std::is_integral_v<_ArgType> || std::is_enum_v<_ArgType>,
+                  "deferred log arguments must be integers, enums or pointers");
+    return static_cast<uint32_t>(value);
+  }
+}
+
+/// @brief 延迟日志队列
+///        record可以在多个任务中同时调用，队列满时丢弃新记录并计数；drain只能由一个任务调用
+template <uint32_t _Capacity>
+class DeferredLog
+{
+private:
+  MpscRingQueue<DlogRecord, _Capacity> __queue;
+  std::atomic<uint32_t> __dropped{0};
+  uint32_t __reported_dropped{0}; // drain已经报告过的丢弃数量
+
+public:
+  /// @brief 写入一条记录
+  /// @param site 记录点描述
+  /// @param blob 附带的二进制数据，可以为nullptr
+  /// @param blob_len 附带数据的长度
+  /// @param args 整数参数，最多DLOG_MAX_ARGS个
+  template <typename... _Args>
+  void record(const DlogSite *site, const void *blob, size_t blob_len, _Args... args)
+  {
+    static_assert(sizeof...(_Args) <= DLOG_MAX_ARGS, "too many deferred log arguments");
+    DlogRecord record{site, trace_now_us(), {dlog_arg(args)...}, 0, {}}; // 未使用的参数为0
+    record.blob_len = static_cast<uint8_t>(blob_len < DLOG_MAX_BLOB ? blob_len : DLOG_MAX_BLOB);
+    if (record.blob_len)
+    {
+      memcpy(record.blob, blob, record.blob_len);
+    }
+    if (!__queue.push(record))
+    {
+      __dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  /// @brief 取出记录并格式化输出，每条记录一行
+  /// @tparam _WriteFun 形如 void(const char *data, size_t len) 的输出函数
+  /// @param write 输出函数
+  /// @param max_records 本次最多处理的记录数量
+  /// @return 处理的记录数量
+  template <typename _WriteFun>
+  size_t drain(_WriteFun &&write, size_t max_records = _Capacity)
+  {
+    constexpr const char level_chars[]{'T', 'D', 'I', 'W', 'E'};
+    char line[160 + hex_str_len(DLOG_MAX_BLOB)];
+    size_t count{0};
+    DlogRecord record;
+    while (count < max_records && __queue.pop(record))
+    {
+      ++count;
+      int len{snprintf(line, sizeof(line), "[%c][%lu.%03lu] ",
+                       record.site->level < sizeof(level_chars) ? level_chars[record.site->level] : '?',
+                       static_cast<unsigned long>(record.ts_us / 1000000),
+                       static_cast<unsigned long>(record.ts_us / 1000 % 1000))};
+      // 多余的参数会被忽略
+      len += snprintf(line + len, sizeof(line) - len, record.site->fmt,
+                      static_cast<unsigned>(record.args[0]), static_cast<unsigned>(record.args[1]),
+                      static_cast<unsigned>(record.args[2]), static_cast<unsigned>(record.args[3]));
+      len = len < static_cast<int>(sizeof(line)) - 1 ? len : static_cast<int>(sizeof(line)) - 1;
+      if (record.blob_len && len + 1 < static_cast<int>(sizeof(line)) - 1)
+      {
+        line[len++] = ' ';
+        len += to_hex_buf(line + len, sizeof(line) - len - 1, record.blob, record.blob_len);
+      }
+      line[len++] = '\n';
+      write(line, static_cast<size_t>(len));
+    }
+    const uint32_t dropped{__dropped.load(std::memory_order_relaxed)};
+    if (dropped != __reported_dropped)
+    {
+      const int len{snprintf(line, sizeof(line), "[W] deferred log dropped %lu records\n",
+                             static_cast<unsigned long>(dropped - __reported_dropped))};
+      __reported_dropped = dropped;
+      write(line, static_cast<size_t>(len));
+    }
+    return count;
+  }
+
+  /// @brief 因队列已满而丢弃的记录数量
+  uint32_t dropped() const { return __dropped.load(std::memory_order_relaxed); }
+};
+
+inline DeferredLog<DLOG_QUEUE_SIZE> dlog;
+
+/// @brief 格式化并输出全局队列中的记录，由低优先级任务周期调用
+/// @tparam _WriteFun 形如 void(const char *data, size_t len) 的输出函数
+template <typename _WriteFun>
+size_t dlog_drain(_WriteFun &&write, size_t max_records = DLOG_QUEUE_SIZE)
+{
+  return dlog.drain(write, max_records);
+}
+
+#define __DLOG_RECORD(level, fmt, blob, blob_len, ...)                \
+  do                                                                  \
+  {                                                                   \
+    static constexpr DlogSite __dlog_site{level, fmt};                \
+    dlog.record(&__dlog_site, blob, blob_len, ##__VA_ARGS__);         \
+  } while (0)
+
+#if DLOG_MIN_LEVEL <= DLOG_LEVEL_TRACE
+#define DLOG_TRACE(fmt, ...) __DLOG_RECORD(DLOG_LEVEL_TRACE, fmt, nullptr, 0, ##__VA_ARGS__)
+#define DLOG_TRACE_HEX(fmt, data, len, ...) __DLOG_RECORD(DLOG_LEVEL_TRACE, fmt, data, len, ##__VA_ARGS__)
+#else
+#define DLOG_TRACE(fmt, ...) ((void)0)
+#define DLOG_TRACE_HEX(fmt, data, len, ...) ((void)0)
+#endif
+
+#if DLOG_MIN_LEVEL <= DLOG_LEVEL_DEBUG
+#define DLOG_DEBUG(fmt, ...) __DLOG_RECORD(DLOG_LEVEL_DEBUG, fmt, nullptr, 0, ##__VA_ARGS__)
+#define DLOG_DEBUG_HEX(fmt, data, len, ...) __DLOG_RECORD(DLOG_LEVEL_DEBUG, fmt, data, len, ##__VA_ARGS__)
+#else
+#define DLOG_DEBUG(fmt, ...) ((void)0)
+#define DLOG_DEBUG_HEX(fmt, data, len, ...) ((void)0)
+#endif
+
+#if DLOG_MIN_LEVEL <= DLOG_LEVEL_INFO
+#define DLOG_INFO(fmt, ...) __DLOG_RECORD(DLOG_LEVEL_INFO, fmt, nullptr, 0, ##__VA_ARGS__)
+#define DLOG_INFO_HEX(fmt, data, len, ...) __DLOG_RECORD(DLOG_LEVEL_INFO, fmt, data, len, ##__VA_ARGS__)
+#else
+#define DLOG_INFO(fmt, ...) ((void)0)
+#define DLOG_INFO_HEX(fmt, data, len, ...) ((void)0)
+#endif
+
+#if DLOG_MIN_LEVEL <= DLOG_LEVEL_WARN
+#define DLOG_WARN(fmt, ...) __DLOG_RECORD(DLOG_LEVEL_WARN, fmt, nullptr, 0, ##__VA_ARGS__)
+#define DLOG_WARN_HEX(fmt, data, len, ...) __DLOG_RECORD(DLOG_LEVEL_WARN, fmt, data, len, ##__VA_ARGS__)
+#else
+#define DLOG_WARN(fmt, ...) ((void)0)
+#define DLOG_WARN_HEX(fmt, data, len, ...) ((void)0)
+#endif
+
+#if DLOG_MIN_LEVEL <= DLOG_LEVEL_ERROR
+#define DLOG_ERROR(fmt, ...) __DLOG_RECORD(DLOG_LEVEL_ERROR, fmt, nullptr, 0, ##__VA_ARGS__)
+#define DLOG_ERROR_HEX(fmt, data, len, ...) __DLOG_RECORD(DLOG_LEVEL_ERROR, fmt, data, len, ##__VA_ARGS__)
+#else
+#define DLOG_ERROR(fmt, ...) ((void)0)
+#define DLOG_ERROR_HEX(fmt, data, len, ...) ((void)0)
+#endif
+
+#endif // __DEFERRED_LOG_HPP__
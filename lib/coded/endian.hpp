@@ -6,47 +6,134 @@
 #include <type_traits>
 #include <initializer_list>
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#if __has_include(<bit>)
+#include <bit>
+#endif
 
 #ifndef LITTLE_ENDIAN
-#ifndef BIG_ENDIAN
-
 #define LITTLE_ENDIAN 0x00000041UL
+#endif
+#ifndef BIG_ENDIAN
 #define BIG_ENDIAN 0x41000000UL
+#endif
+#ifndef UNKNOWN_ENDIAN
 #define UNKNOWN_ENDIAN 0xFFFFFFFFUL
-#define ENDIAN_ORDER_TEST ('A')
+#endif
 
-#if LITTLE_ENDIAN == ENDIAN_ORDER_TEST
+// 由编译器给出的字节序判断，结果在编译期确定
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
 #define MACHINE_ENDIAN LITTLE_ENDIAN
-#elif BIG_ENDIAN == ENDIAN_ORDER_TEST
+#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
 #define MACHINE_ENDIAN BIG_ENDIAN
 #else
 #define MACHINE_ENDIAN UNKNOWN_ENDIAN
 #endif
 
-#else
-#define MACHINE_ENDIAN BIG_ENDIAN
-#endif // BIG_ENDIAN
-
-#else
-#define MACHINE_ENDIAN LITTLE_ENDIAN
-#endif // LITTLE_ENDIAN
-
 /// @brief 判断为大端还是小端面设备
 /// @return 0为大端，1为小端，其它未知
 const char machine_endian();
 
+/// @brief 编译期判断当前设备是否为小端
+constexpr bool endian_native_little()
+{
+  return MACHINE_ENDIAN == LITTLE_ENDIAN;
+}
+
+/// @brief 反转整数的字节顺序，使用编译器内建指令，可在编译期求值
+/// @tparam _InputType 整数类型
+/// @param val 输入数据
+/// @return 反转后的数据
+template <typename _InputType, typename std::enable_if<std::is_integral<_InputType>::value &&
+                                                          !std::is_same<_InputType, bool>::value,
+                                                      int>::type = 0>
+constexpr _InputType byte_swap(const _InputType val)
+{
+#if defined(__cpp_lib_byteswap)
+  return std::byteswap(val);
+#else
+  using _UType = typename std::make_unsigned<_InputType>::type;
+  if (sizeof(_InputType) == 1)
+  {
+    return val;
+  }
+  else if (sizeof(_InputType) == 2)
+  {
+    return static_cast<_InputType>(__builtin_bswap16(static_cast<_UType>(val)));
+  }
+  else if (sizeof(_InputType) == 4)
+  {
+    return static_cast<_InputType>(__builtin_bswap32(static_cast<_UType>(val)));
+  }
+  else
+  {
+    return static_cast<_InputType>(__builtin_bswap64(static_cast<_UType>(val)));
+  }
+#endif
+}
+
+/// @brief bool只占一个字节，反转后保持不变
+constexpr bool byte_swap(const bool val)
+{
+  return val;
+}
+
+/// @brief 反转浮点数的字节顺序
+///        float/double借用同宽度的整数指令，long double等没有对应整数宽度的类型按sizeof逐字节反转
+/// @tparam _InputType 浮点类型
+/// @param val 输入数据
+/// @return 反转后的数据
+template <typename _InputType, typename std::enable_if<std::is_floating_point<_InputType>::value, int>::type = 0>
+inline _InputType byte_swap(const _InputType val)
+{
+  _InputType result;
+  if constexpr (sizeof(_InputType) == 4 || sizeof(_InputType) == 8)
+  {
+    using _UType = typename std::conditional<sizeof(_InputType) == 4, uint32_t, uint64_t>::type;
+    _UType bits;
+    std::memcpy(&bits, &val, sizeof(bits));
+    bits = byte_swap(bits);
+    std::memcpy(&result, &bits, sizeof(result));
+  }
+  else
+  {
+    auto src = reinterpret_cast<const unsigned char *>(&val);
+    std::reverse_copy(src, src + sizeof(val), reinterpret_cast<unsigned char *>(&result));
+  }
+  return result;
+}
+
+/// @brief 本地字节序与大端之间的转换（两个方向相同）
+template <typename _InputType>
+constexpr _InputType endian_to_big(const _InputType val)
+{
+  return endian_native_little() ? byte_swap(val) : val;
+}
+
+/// @brief 本地字节序与小端之间的转换（两个方向相同）
+template <typename _InputType>
+constexpr _InputType endian_to_little(const _InputType val)
+{
+  return endian_native_little() ? val : byte_swap(val);
+}
+
 template <typename _InputType, typename = std::enable_if<std::is_arithmetic<_InputType>::value>>
 const _InputType endian_reverse(const _InputType *val)
 {
-  _InputType result{0};
-  auto len = sizeof(_InputType);
-  unsigned char *rptr{reinterpret_cast<unsigned char *>(&result)};
-  unsigned char *vptr{reinterpret_cast<unsigned char *>((const_cast<_InputType *>(val)))};
-  for (decltype(len) i = 0; i < len; i++)
+  _InputType result;
+  if constexpr (std::is_floating_point<_InputType>::value && sizeof(_InputType) != 4 && sizeof(_InputType) != 8)
   {
-    rptr[i] = vptr[len - i - 1];
+    // 直接在内存之间反转，避免按值传递时丢失long double的填充字节
+    auto src = reinterpret_cast<const unsigned char *>(val);
+    std::reverse_copy(src, src + sizeof(result), reinterpret_cast<unsigned char *>(&result));
+    return result;
+  }
+  else
+  {
+    std::memcpy(&result, val, sizeof(result)); // 允许指向未对齐的数据包缓存
+    return byte_swap(result);
   }
-  return result;
 }
 
 #define endian_big_to_little(val) endian_reverse(val) // 将大端数据成小端
@@ -68,6 +155,61 @@ const _InputType endian_reverse(const _InputType *val)
 #define USHORT_LSB(val) ((unsigned char)((val)&0x00FF))                 // 取16位的低8位
 #define FETCH_BYTE(val, n) ((unsigned char)(((val) >> (n * 8)) & 0xFF)) // 按位取数
 
+/// @brief 指定字节序的数据字段，可直接覆盖在数据包缓存上进行零拷贝解析
+///        内部按字节存储，对齐要求为1，读写时自动完成字节序转换
+/// @tparam _ValueType 数值类型
+/// @tparam _BigEndian 是否为大端存储
+template <typename _ValueType, bool _BigEndian>
+struct EndianField
+{
+  static_assert(std::is_arithmetic<_ValueType>::value, "EndianField requires an arithmetic type");
+
+  uint8_t bytes[sizeof(_ValueType)];
+
+  /// @brief 读取本地字节序的值
+  _ValueType get() const
+  {
+    _ValueType val;
+    std::memcpy(&val, bytes, sizeof(val));
+    return _BigEndian ? endian_to_big(val) : endian_to_little(val);
+  }
+
+  /// @brief 以本地字节序的值写入
+  void set(const _ValueType val)
+  {
+    const _ValueType raw{_BigEndian ? endian_to_big(val) : endian_to_little(val)};
+    std::memcpy(bytes, &raw, sizeof(raw));
+  }
+
+  operator _ValueType() const
+  {
+    return get();
+  }
+
+  EndianField &operator=(const _ValueType val)
+  {
+    set(val);
+    return *this;
+  }
+};
+
+using be_u16 = EndianField<uint16_t, true>;
+using be_u32 = EndianField<uint32_t, true>;
+using be_u64 = EndianField<uint64_t, true>;
+using be_i16 = EndianField<int16_t, true>;
+using be_i32 = EndianField<int32_t, true>;
+using be_i64 = EndianField<int64_t, true>;
+using be_f32 = EndianField<float, true>;
+using be_f64 = EndianField<double, true>;
+using le_u16 = EndianField<uint16_t, false>;
+using le_u32 = EndianField<uint32_t, false>;
+using le_u64 = EndianField<uint64_t, false>;
+using le_i16 = EndianField<int16_t, false>;
+using le_i32 = EndianField<int32_t, false>;
+using le_i64 = EndianField<int64_t, false>;
+using le_f32 = EndianField<float, false>;
+using le_f64 = EndianField<double, false>;
+
 /// @brief 将输入数据合并成数字
 /// @tparam _ResultType 返回的数据类型
 /// @tparam _InputType 输入的数据类型
@@ -103,8 +245,9 @@ const _ResultType number_merge(const _InputType *dptr, unsigned char size)
 template <typename _InputType, typename _ResultType, typename = std::enable_if<std::is_arithmetic<_ResultType>::value>>
 const _ResultType number_merge_reverse(std::initializer_list<_InputType> datlist)
 {
-  std::reverse(datlist.begin(), datlist.end());
-  return number_merge(datlist);
+  _ResultType num{0};
+  std::reverse_copy(datlist.begin(), datlist.end(), reinterpret_cast<_InputType *>(&num));
+  return num;
 }
 
 /// @brief 将输入数据合并成数字（合并前先反转数据顺序）
@@ -116,31 +259,32 @@ const _ResultType number_merge_reverse(std::initializer_list<_InputType> datlist
 template <typename _InputType, typename _ResultType, typename = std::enable_if<std::is_arithmetic<_ResultType>::value>>
 const _ResultType number_merge_reverse(const _InputType *dptr, unsigned char size)
 {
-  std::reverse(dptr, dptr + size);
-  return number_merge(dptr);
+  _ResultType num{0};
+  std::reverse_copy(dptr, dptr + size, reinterpret_cast<_InputType *>(&num));
+  return num;
 }
 
 /// @brief 将数据填充到指定的内存中
 /// @tparam _InputType 输入数据的类型
 /// @param num 输入数据
-/// @param dest 内存地址
+/// @param dest 内存地址，不要求对齐
 /// @return dest
 template <typename _InputType, typename = std::enable_if<std::is_arithmetic<_InputType>::value>>
 const void *number_fill(_InputType num, void *dest)
 {
-  *static_cast<_InputType *>(dest) = num;
+  std::memcpy(dest, &num, sizeof(num));
   return dest;
 }
 
 /// @brief 将数据填充到指定的内存中（复制前先反转数据顺序）
 /// @tparam _InputType 输入数据的类型
 /// @param num 输入数据
-/// @param dest 内存地址
+/// @param dest 内存地址，不要求对齐
 /// @return dest
 template <typename _InputType, typename = std::enable_if<std::is_arithmetic<_InputType>::value>>
 const void *number_fill_reverse(_InputType num, void *dest)
 {
-  return number_fill(endian_reverse<_InputType>(num));
+  return number_fill(byte_swap(num), dest);
 }
 
 #endif //__ENDIAN_H__
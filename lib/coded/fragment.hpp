@@ -0,0 +1,249 @@
+/// @brief 按MTU分片与重组
+///        每个分片带2字节头：[帧序号] [分片序号(高4位) | 分片总数-1(低4位)]，
+///        单帧最多16个分片；不同帧的分片可以交错发送，接收端按帧序号分别重组
+
+#ifndef __FRAGMENT_HPP__
+#define __FRAGMENT_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#define FRAGMENT_HEADER_SIZE 2
+#define FRAGMENT_MAX_COUNT 16
+
+/// @brief 一个帧的分片游标，每次调用next生成一个分片，便于与其它帧的分片交错发送
+/// @tparam _Mtu 链路单包最大长度（含分片头）
+template <size_t _Mtu>
+class FragmentCursor
+{
+  static_assert(_Mtu > FRAGMENT_HEADER_SIZE, "mtu too small");
+
+private:
+  const uint8_t *__data{nullptr};
+  size_t __len{0};
+  uint8_t __id{0};
+  uint8_t __index{0};
+  uint8_t __count{0};
+
+public:
+  static constexpr size_t payload_size{_Mtu - FRAGMENT_HEADER_SIZE};
+
+  FragmentCursor() = default;
+
+  /// @param data 帧数据，在所有分片生成完之前必须保持有效
+  /// @param len 帧长度，0或超过max_frame_size时游标为空
+  /// @param id 帧序号
+  FragmentCursor(const uint8_t *data, size_t len, uint8_t id)
+      : __data(data), __len(len), __id(id)
+  {
+    const size_t count{(len + payload_size - 1) / payload_size};
+    __count = (len > 0 && count <= FRAGMENT_MAX_COUNT) ? static_cast<uint8_t>(count) : 0;
+  }
+
+  /// @brief 是否已经生成全部分片
+  bool done() const
+  {
+    return __index >= __count;
+  }
+
+  /// @brief 生成下一个分片
+  /// @param out 输出缓存，长度至少为_Mtu
+  /// @return 分片长度，全部生成完毕返回0
+  size_t next(uint8_t *out)
+  {
+    if (done())
+    {
+      return 0;
+    }
+    const size_t offset{__index * payload_size};
+    const size_t chunk{(__len - offset) < payload_size ? (__len - offset) : payload_size};
+    out[0] = __id;
+    out[1] = static_cast<uint8_t>((__index << 4) | (__count - 1));
+    memcpy(out + FRAGMENT_HEADER_SIZE, __data + offset, chunk);
+    ++__index;
+    return chunk + FRAGMENT_HEADER_SIZE;
+  }
+};
+
+/// @brief 分片器，负责分配帧序号
+/// @tparam _Mtu 链路单包最大长度（含分片头）
+template <size_t _Mtu>
+class Fragmenter
+{
+private:
+  uint8_t __next_id{0};
+
+public:
+  static constexpr size_t payload_size{_Mtu - FRAGMENT_HEADER_SIZE};
+  static constexpr size_t max_frame_size{payload_size * FRAGMENT_MAX_COUNT};
+
+  /// @brief 开始对一个帧分片
+  /// @param data 帧数据，在所有分片生成完之前必须保持有效
+  /// @param len 帧长度
+  /// @return 分片游标
+  FragmentCursor<_Mtu> begin(const uint8_t *data, size_t len)
+  {
+    return FragmentCursor<_Mtu>{data, len, __next_id++};
+  }
+};
+
+/// @brief 分片重组器，重组缓存在对象内静态分配
+/// @tparam _Mtu 链路单包最大长度（含分片头）
+/// @tparam _Slots 可同时重组的帧数量
+template <size_t _Mtu, size_t _Slots = 4>
+class Reassembler
+{
+public:
+  static constexpr size_t payload_size{_Mtu - FRAGMENT_HEADER_SIZE};
+  static constexpr size_t max_frame_size{payload_size * FRAGMENT_MAX_COUNT};
+
+  /// @brief 重组统计
+  struct Stats
+  {
+    uint32_t completed{0};  // 重组完成的帧数量
+    uint32_t duplicates{0}; // 重复的分片数量
+    uint32_t timeouts{0};   // 超时丢弃的帧数量
+    uint32_t evicted{0};    // 缓存不足时被挤出的帧数量
+    uint32_t malformed{0};  // 格式错误的分片数量
+  };
+
+private:
+  /// @brief 重组缓存状态，数值越小越优先被分配给新帧
+  enum class __SlotState : uint8_t
+  {
+    FREE,       // 空闲
+    DONE,       // 已完成，保留帧序号用于识别迟到的重复分片
+    ASSEMBLING, // 正在重组
+  };
+
+  struct __Slot
+  {
+    __SlotState state{__SlotState::FREE};
+    uint8_t id{0};
+    uint8_t count{0};
+    uint16_t received{0}; // 已收到的分片位图
+    uint16_t len{0};
+    uint32_t start_ms{0};
+    uint8_t data[max_frame_size];
+  };
+
+  __Slot __slots[_Slots];
+  uint32_t __timeout_ms;
+  Stats __stats;
+
+  /// @brief 查找帧对应的重组缓存，不存在时按 空闲 > 已完成 > 最早开始的顺序分配
+  __Slot *__find_slot(uint8_t id, uint8_t count, uint32_t now_ms)
+  {
+    __Slot *victim{nullptr};
+    for (auto &slot : __slots)
+    {
+      if (slot.state != __SlotState::FREE && slot.id == id && slot.count == count)
+      {
+        return &slot;
+      }
+      if (!victim || slot.state < victim->state ||
+          (slot.state == victim->state && (now_ms - slot.start_ms) > (now_ms - victim->start_ms)))
+      {
+        victim = &slot;
+      }
+    }
+    if (victim->state == __SlotState::ASSEMBLING)
+    {
+      ++__stats.evicted;
+    }
+    victim->state = __SlotState::ASSEMBLING;
+    victim->id = id;
+    victim->count = count;
+    victim->received = 0;
+    victim->len = 0;
+    victim->start_ms = now_ms;
+    return victim;
+  }
+
+public:
+  /// @param timeout_ms 帧从收到第一个分片起的最长重组时间
+  explicit Reassembler(uint32_t timeout_ms = 100) : __timeout_ms(timeout_ms) {}
+
+  /// @brief 输入一个分片
+  /// @tparam _FrameFun 形如 void(const uint8_t *data, size_t len) 的回调
+  /// @param frag 分片数据（含分片头）
+  /// @param len 分片长度
+  /// @param now_ms 当前时间，单位为毫秒
+  /// @param on_frame 帧重组完成时调用，数据只在回调期间有效
+  /// @return 是否有帧重组完成
+  template <typename _FrameFun>
+  bool push(const uint8_t *frag, size_t len, uint32_t now_ms, _FrameFun &&on_frame)
+  {
+    if (len <= FRAGMENT_HEADER_SIZE || len > _Mtu)
+    {
+      ++__stats.malformed;
+      return false;
+    }
+    const uint8_t id{frag[0]};
+    const uint8_t index{static_cast<uint8_t>(frag[1] >> 4)};
+    const uint8_t count{static_cast<uint8_t>((frag[1] & 0x0F) + 1)};
+    const size_t chunk{len - FRAGMENT_HEADER_SIZE};
+    // 除最后一个分片外，其它分片必须是满长度
+    if (index >= count || (index + 1 < count && chunk != payload_size))
+    {
+      ++__stats.malformed;
+      return false;
+    }
+
+    expire(now_ms);
+    __Slot *slot{__find_slot(id, count, now_ms)};
+    const uint16_t bit{static_cast<uint16_t>(1U << index)};
+    if (slot->state == __SlotState::DONE || (slot->received & bit))
+    {
+      ++__stats.duplicates;
+      return false;
+    }
+    if (count == 1)
+    {
+      ++__stats.completed;
+      slot->state = __SlotState::DONE;
+      on_frame(frag + FRAGMENT_HEADER_SIZE, chunk); // 单分片帧不需要复制
+      return true;
+    }
+    memcpy(slot->data + index * payload_size, frag + FRAGMENT_HEADER_SIZE, chunk);
+    slot->received |= bit;
+    if (index + 1 == count)
+    {
+      slot->len = static_cast<uint16_t>(index * payload_size + chunk);
+    }
+    if (slot->received != static_cast<uint16_t>((1UL << count) - 1))
+    {
+      return false;
+    }
+    ++__stats.completed;
+    slot->state = __SlotState::DONE;
+    on_frame(slot->data, slot->len);
+    return true;
+  }
+
+  /// @brief 丢弃超时的帧，push时会自动调用
+  /// @param now_ms 当前时间，单位为毫秒
+  void expire(uint32_t now_ms)
+  {
+    for (auto &slot : __slots)
+    {
+      if (slot.state != __SlotState::FREE && (now_ms - slot.start_ms) > __timeout_ms)
+      {
+        if (slot.state == __SlotState::ASSEMBLING)
+        {
+          ++__stats.timeouts;
+        }
+        slot.state = __SlotState::FREE;
+      }
+    }
+  }
+
+  /// @brief 读取重组统计
+  const Stats &stats() const
+  {
+    return __stats;
+  }
+};
+
+#endif // __FRAGMENT_HPP__
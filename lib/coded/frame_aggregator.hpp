@@ -0,0 +1,140 @@
+/// @brief 将多个短记录合并到一个无线数据包中发送
+///        包内每条记录格式为：[长度(1字节)] [数据]，接收端使用aggregate_split拆分
+///        当包已满或第一条记录等待超过最大延迟时发送
+
+#ifndef __FRAME_AGGREGATOR_HPP__
+#define __FRAME_AGGREGATOR_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#define AGGREGATE_RECORD_HEADER_SIZE 1
+
+/// @brief 记录合并器
+/// @tparam _Mtu 无线单包最大长度
+template <size_t _Mtu>
+class FrameAggregator
+{
+  static_assert(_Mtu > AGGREGATE_RECORD_HEADER_SIZE && _Mtu <= 0xFF + AGGREGATE_RECORD_HEADER_SIZE, "invalid mtu");
+
+private:
+  uint8_t __buf[_Mtu];
+  size_t __len{0};
+  uint32_t __first_ms{0}; // 包内第一条记录的加入时间
+  uint32_t __max_latency_ms;
+
+public:
+  /// @brief 单条记录的最大长度
+  static constexpr size_t max_record_size{_Mtu - AGGREGATE_RECORD_HEADER_SIZE};
+
+  /// @param max_latency_ms 记录在合并器中的最长等待时间，单位为毫秒，0表示每条记录立即发送
+  explicit FrameAggregator(uint32_t max_latency_ms) : __max_latency_ms(max_latency_ms) {}
+
+  /// @brief 加入一条记录，剩余空间不足时先发送已合并的数据
+  /// @tparam _SendFun 形如 void(const uint8_t *data, size_t len) 的发送函数
+  /// @param record 记录数据
+  /// @param len 记录长度，不能超过max_record_size
+  /// @param now_ms 当前时间，单位为毫秒
+  /// @param send 发送函数
+  /// @return 记录过长返回false
+  template <typename _SendFun>
+  bool append(const uint8_t *record, size_t len, uint32_t now_ms, _SendFun &&send)
+  {
+    if (len == 0 || len > max_record_size)
+    {
+      return false;
+    }
+    if (__len + AGGREGATE_RECORD_HEADER_SIZE + len > _Mtu)
+    {
+      flush(send);
+    }
+    if (__len == 0)
+    {
+      __first_ms = now_ms;
+    }
+    __buf[__len] = static_cast<uint8_t>(len);
+    memcpy(__buf + __len + AGGREGATE_RECORD_HEADER_SIZE, record, len);
+    __len += AGGREGATE_RECORD_HEADER_SIZE + len;
+    // 剩余空间已经放不下最短的记录，或不允许等待时立即发送
+    if (__len + AGGREGATE_RECORD_HEADER_SIZE >= _Mtu || __max_latency_ms == 0)
+    {
+      flush(send);
+    }
+    return true;
+  }
+
+  /// @brief 检查发送期限，到期时发送已合并的数据
+  /// @tparam _SendFun 形如 void(const uint8_t *data, size_t len) 的发送函数
+  /// @param now_ms 当前时间，单位为毫秒
+  /// @param send 发送函数
+  /// @return 是否发送了数据
+  template <typename _SendFun>
+  bool poll(uint32_t now_ms, _SendFun &&send)
+  {
+    if (__len == 0 || (now_ms - __first_ms) < __max_latency_ms)
+    {
+      return false;
+    }
+    flush(send);
+    return true;
+  }
+
+  /// @brief 立即发送已合并的数据
+  /// @tparam _SendFun 形如 void(const uint8_t *data, size_t len) 的发送函数
+  /// @param send 发送函数
+  template <typename _SendFun>
+  void flush(_SendFun &&send)
+  {
+    if (__len)
+    {
+      send(__buf, __len);
+      __len = 0;
+    }
+  }
+
+  /// @brief 是否有等待发送的数据
+  bool pending() const
+  {
+    return __len != 0;
+  }
+
+  /// @brief 距离发送期限的剩余时间
+  /// @param now_ms 当前时间，单位为毫秒
+  /// @return 剩余时间，单位为毫秒，没有等待发送的数据时返回UINT32_MAX
+  uint32_t time_to_deadline(uint32_t now_ms) const
+  {
+    if (__len == 0)
+    {
+      return UINT32_MAX;
+    }
+    const uint32_t elapsed{now_ms - __first_ms};
+    return elapsed >= __max_latency_ms ? 0 : __max_latency_ms - elapsed;
+  }
+};
+
+/// @brief 拆分合并后的数据包
+/// @tparam _RecordFun 形如 void(const uint8_t *data, size_t len) 的回调
+/// @param payload 数据包
+/// @param len 数据包长度
+/// @param on_record 每拆出一条记录调用一次
+/// @return 数据包格式是否正确，格式错误时已经拆出的记录仍然有效
+template <typename _RecordFun>
+bool aggregate_split(const uint8_t *payload, size_t len, _RecordFun &&on_record)
+{
+  size_t pos{0};
+  while (pos < len)
+  {
+    const size_t record_len{payload[pos]};
+    pos += AGGREGATE_RECORD_HEADER_SIZE;
+    if (record_len == 0 || pos + record_len > len)
+    {
+      return false;
+    }
+    on_record(payload + pos, record_len);
+    pos += record_len;
+  }
+  return true;
+}
+
+#endif // __FRAME_AGGREGATOR_HPP__
@@ -0,0 +1,127 @@
+/// @brief 链路自适应的档位决策
+///        每个统计窗口输入一次丢包率和RSSI，输出建议档位（0为最稳健、速率最低的档位）：
+///        丢包率过高或RSSI低于当前档位门限时立即降一档；
+///        丢包率足够低且RSSI超过上一档门限加余量，并连续保持若干窗口后才升一档；
+///        升档后很快又降档视为升档失败，下一次升档需要等待的窗口数加倍，避免在两档之间反复切换
+
+#ifndef __LINK_ADAPT_HPP__
+#define __LINK_ADAPT_HPP__
+
+#include <cstdint>
+#include <cstddef>
+
+#define LINK_RSSI_UNKNOWN INT16_MIN // 设备不提供RSSI或窗口内没有收到数据包
+
+template <uint8_t _Levels>
+class LinkAdapter
+{
+  static_assert(_Levels > 0, "_Levels must be greater than 0");
+
+public:
+  struct Config
+  {
+    int16_t min_rssi_x10[_Levels];       // 维持各档位所需的RSSI，单位为0.1 dBm，为LINK_RSSI_UNKNOWN时不检查
+    int16_t up_margin_x10{30};           // 升档时RSSI需要超出上一档门限的余量
+    uint16_t down_loss_permille{150};    // 丢包率高于该值时降档
+    uint16_t up_loss_permille{20};       // 丢包率低于该值时才考虑升档
+    uint8_t up_windows{3};               // 连续满足升档条件的窗口数
+    uint8_t max_up_windows{48};          // 升档失败后等待窗口数的上限
+  };
+
+private:
+  Config __config;
+  uint8_t __level;
+  uint16_t __loss_permille{0};
+  int16_t __rssi_x10{LINK_RSSI_UNKNOWN};
+  uint8_t __good_windows{0};    // 连续满足升档条件的窗口数
+  uint8_t __up_wait;            // 当前升档需要的窗口数
+  uint8_t __windows_since_up{0}; // 上一次升档之后经过的窗口数，饱和计数
+
+public:
+  /// @param config 门限配置
+  /// @param level 初始档位
+  LinkAdapter(const Config &config, uint8_t level)
+      : __config(config), __level(level < _Levels ? level : _Levels - 1), __up_wait(config.up_windows) {}
+
+  /// @brief 当前档位
+  uint8_t level() const { return __level; }
+
+  /// @brief 平滑后的丢包率，单位为千分之一
+  uint16_t loss_permille() const { return __loss_permille; }
+
+  /// @brief 平滑后的RSSI，单位为0.1 dBm
+  int16_t rssi_x10() const { return __rssi_x10; }
+
+  /// @brief 档位已经切换（包括与对端协商后切换或回退），切换后重新统计
+  /// @param level 新档位
+  void on_switched(uint8_t level)
+  {
+    if (level >= _Levels || level == __level)
+    {
+      return;
+    }
+    if (level > __level)
+    {
+      __windows_since_up = 0;
+    }
+    else if (__windows_since_up < __up_wait)
+    {
+      // 升档后没多久又降档，加倍下一次升档前的等待
+      __up_wait = __up_wait * 2 < __config.max_up_windows ? __up_wait * 2 : __config.max_up_windows;
+    }
+    __level = level;
+    __loss_permille = 0;
+    __good_windows = 0;
+  }
+
+  /// @brief 统计窗口结束时调用
+  /// @param loss_permille 窗口内的丢包率，单位为千分之一
+  /// @param rssi_x10 窗口内的RSSI，单位为0.1 dBm，未知时为LINK_RSSI_UNKNOWN
+  /// @return 建议档位，需要调用者与对端协商后切换，再通过on_switched通知
+  uint8_t update(uint16_t loss_permille, int16_t rssi_x10 = LINK_RSSI_UNKNOWN)
+  {
+    __loss_permille = (__loss_permille * 3 + loss_permille) / 4;
+    if (rssi_x10 != LINK_RSSI_UNKNOWN)
+    {
+      __rssi_x10 = __rssi_x10 == LINK_RSSI_UNKNOWN ? rssi_x10 : static_cast<int16_t>((__rssi_x10 * 3 + rssi_x10) / 4);
+    }
+    if (__windows_since_up < UINT8_MAX)
+    {
+      ++__windows_since_up;
+    }
+    if (__windows_since_up >= __config.max_up_windows)
+    {
+      __up_wait = __config.up_windows; // 长时间稳定后恢复正常的升档速度
+    }
+
+    const auto rssi_below{[this](uint8_t level, int16_t margin_x10)
+                          {
+                            const int16_t threshold{__config.min_rssi_x10[level]};
+                            return threshold != LINK_RSSI_UNKNOWN && __rssi_x10 != LINK_RSSI_UNKNOWN &&
+                                   __rssi_x10 < threshold + margin_x10;
+                          }};
+    // 单个窗口的丢包率超限也立即降档，不等待平滑
+    if (__level > 0 && (loss_permille > __config.down_loss_permille || __loss_permille > __config.down_loss_permille ||
+                        rssi_below(__level, 0)))
+    {
+      __good_windows = 0;
+      return __level - 1;
+    }
+    if (__level + 1 < _Levels && __loss_permille < __config.up_loss_permille && !rssi_below(__level + 1, __config.up_margin_x10))
+    {
+      if (++__good_windows >= __up_wait)
+      {
+        // 保持建议，直到切换或条件不再满足，两端的建议不必在同一个窗口内达到升档条件
+        __good_windows = __up_wait;
+        return __level + 1;
+      }
+    }
+    else
+    {
+      __good_windows = 0;
+    }
+    return __level;
+  }
+};
+
+#endif // __LINK_ADAPT_HPP__
@@ -0,0 +1,270 @@
+/// @brief 运行时统计：计数器、测量值、固定分桶直方图和注册表
+///        计数器每个核心一个独占缓存行的原子单元，增加时只做一次relaxed的fetch_add，读取时求和；
+///        注册表在快照时读取所有指标，格式化为一行InfluxDB line protocol，便于上位机采集：
+///        bridge,node=a uptime_ms=1000i,nrf24_tx_sent=12i,nrf24_tx_latency_us_le_500=3i,...
+
+#ifndef __METRICS_HPP__
+#define __METRICS_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <atomic>
+
+#include "trace.hpp"
+
+#ifndef METRICS_LINE_SIZE
+#define METRICS_LINE_SIZE 512 // 快照的格式化缓存，单个指标的字段超过该长度时被丢弃
+#endif
+
+#define METRICS_CORES TRACE_CORES
+
+#ifndef METRICS_CACHE_LINE
+#define METRICS_CACHE_LINE 64 // 计数器单元的对齐，避免不同核心的单元位于同一缓存行
+#endif
+
+/// @brief 单调递增的计数器，每个核心写入自己的单元，不需要锁
+class Counter
+{
+private:
+  struct alignas(METRICS_CACHE_LINE) __Cell
+  {
+    std::atomic<uint32_t> value{0};
+  };
+
+  __Cell __cells[METRICS_CORES];
+
+public:
+  void inc(uint32_t n = 1)
+  {
+    __cells[trace_core_id() % METRICS_CORES].value.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  uint32_t value() const
+  {
+    uint32_t sum{0};
+    for (const auto &cell : __cells)
+    {
+      sum += cell.value.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+};
+
+/// @brief 当前值，例如队列深度、RSSI
+class Gauge
+{
+private:
+  std::atomic<int32_t> __value{0};
+
+public:
+  void set(int32_t value) { __value.store(value, std::memory_order_relaxed); }
+
+  void add(int32_t delta) { __value.fetch_add(delta, std::memory_order_relaxed); }
+
+  /// @brief 只在新值更大时更新，用于记录最大值
+  void update_max(int32_t value)
+  {
+    int32_t current{__value.load(std::memory_order_relaxed)};
+    while (value > current && !__value.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+  }
+
+  int32_t value() const { return __value.load(std::memory_order_relaxed); }
+};
+
+/// @brief 固定分桶的直方图，最后一个桶收集超过所有上界的值
+/// @tparam _Buckets 上界数量
+template <uint32_t _Buckets>
+class Histogram
+{
+  static_assert(_Buckets > 0, "_Buckets must be greater than 0");
+
+private:
+  uint32_t __bounds[_Buckets];
+  std::atomic<uint32_t> __counts[_Buckets + 1]{};
+  std::atomic<uint32_t> __sum{0};
+
+public:
+  /// @param bounds 各桶的上界（含），需要从小到大排列
+  explicit Histogram(const uint32_t (&bounds)[_Buckets])
+  {
+    for (uint32_t i = 0; i < _Buckets; ++i)
+    {
+      __bounds[i] = bounds[i];
+    }
+  }
+
+  void observe(uint32_t value)
+  {
+    uint32_t bucket{0};
+    while (bucket < _Buckets && value > __bounds[bucket])
+    {
+      ++bucket;
+    }
+    __counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    __sum.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  constexpr uint32_t buckets() const { return _Buckets; }
+
+  uint32_t bound(uint32_t bucket) const { return __bounds[bucket]; }
+
+  /// @brief 单个桶（不累计）的数量，bucket为_Buckets时返回超出所有上界的数量
+  uint32_t count(uint32_t bucket) const { return __counts[bucket].load(std::memory_order_relaxed); }
+
+  uint32_t sum() const { return __sum.load(std::memory_order_relaxed); }
+};
+
+/// @brief 指标注册表，只保存指标的地址，指标本身由使用者定义
+///        快照与指标的更新可以并发，各字段分别读取，不保证同一时刻的一致性
+/// @tparam _MaxMetrics 最多注册的指标数量
+template <size_t _MaxMetrics>
+class MetricsRegistry
+{
+public:
+  /// @brief 快照时调用的读取函数，用于导出已有的统计结构（如需要加锁读取的路由器统计）
+  using probe_t = int64_t (*)(void *ctx);
+
+private:
+  /// @brief 写入一个或多个字段，返回写入的字符数，空间不足时返回0
+  using format_t = int (*)(char *dst, size_t size, const char *name, void *ctx, probe_t probe);
+
+  struct __Entry
+  {
+    const char *name;
+    void *ctx;
+    probe_t probe;
+    format_t format;
+  };
+
+  const char *__measurement;
+  __Entry __entries[_MaxMetrics];
+  size_t __count{0};
+
+  static int __format_value(char *dst, size_t size, const char *name, void *ctx, probe_t probe)
+  {
+    const int len{snprintf(dst, size, ",%s=%lldi", name, static_cast<long long>(probe(ctx)))};
+    return len > 0 && static_cast<size_t>(len) < size ? len : 0;
+  }
+
+  template <uint32_t _Buckets>
+  static int __format_histogram(char *dst, size_t size, const char *name, void *ctx, probe_t)
+  {
+    const auto &histogram{*static_cast<const Histogram<_Buckets> *>(ctx)};
+    // 与Prometheus相同，各桶的数量为累计值
+    uint32_t cumulative{0};
+    int len{0};
+    for (uint32_t i = 0; i <= _Buckets; ++i)
+    {
+      cumulative += histogram.count(i);
+      const int n{i < _Buckets ? snprintf(dst + len, size - len, ",%s_le_%lu=%lui", name,
+                                          static_cast<unsigned long>(histogram.bound(i)), static_cast<unsigned long>(cumulative))
+                               : snprintf(dst + len, size - len, ",%s_le_inf=%lui,%s_count=%lui,%s_sum=%lui", name,
+                                          static_cast<unsigned long>(cumulative), name, static_cast<unsigned long>(cumulative),
+                                          name, static_cast<unsigned long>(histogram.sum()))};
+      if (n < 0 || static_cast<size_t>(n) >= size - len)
+      {
+        return 0;
+      }
+      len += n;
+    }
+    return len;
+  }
+
+  bool __add(const char *name, const void *ctx, probe_t probe, format_t format)
+  {
+    if (__count >= _MaxMetrics)
+    {
+      return false;
+    }
+    // 注册表只读取指标，去掉const以便与probe共用ctx
+    __entries[__count++] = {name, const_cast<void *>(ctx), probe, format};
+    return true;
+  }
+
+public:
+  /// @param measurement 行首的measurement和tag，如"bridge,node=a"
+  explicit MetricsRegistry(const char *measurement) : __measurement(measurement) {}
+
+  MetricsRegistry(const MetricsRegistry &) = delete;
+  MetricsRegistry &operator=(const MetricsRegistry &) = delete;
+
+  /// @brief 注册指标，名称需要在注册表的生命周期内有效
+  /// @return 注册表已满返回false
+  bool add(const char *name, const Counter &counter)
+  {
+    return __add(name, &counter, [](void *ctx) -> int64_t
+                 { return static_cast<const Counter *>(ctx)->value(); },
+                 __format_value);
+  }
+
+  bool add(const char *name, const Gauge &gauge)
+  {
+    return __add(name, &gauge, [](void *ctx) -> int64_t
+                 { return static_cast<const Gauge *>(ctx)->value(); },
+                 __format_value);
+  }
+
+  /// @brief 直接导出已有统计结构中的原子计数
+  bool add(const char *name, const std::atomic<uint32_t> &value)
+  {
+    return __add(name, &value, [](void *ctx) -> int64_t
+                 { return static_cast<const std::atomic<uint32_t> *>(ctx)->load(std::memory_order_relaxed); },
+                 __format_value);
+  }
+
+  bool add(const char *name, const std::atomic<int32_t> &value)
+  {
+    return __add(name, &value, [](void *ctx) -> int64_t
+                 { return static_cast<const std::atomic<int32_t> *>(ctx)->load(std::memory_order_relaxed); },
+                 __format_value);
+  }
+
+  template <uint32_t _Buckets>
+  bool add(const char *name, const Histogram<_Buckets> &histogram)
+  {
+    return __add(name, &histogram, nullptr, __format_histogram<_Buckets>);
+  }
+
+  /// @brief 注册在快照时调用的读取函数
+  bool add_probe(const char *name, void *ctx, probe_t probe)
+  {
+    return __add(name, ctx, probe, __format_value);
+  }
+
+  size_t size() const { return __count; }
+
+  /// @brief 读取所有指标并输出一行，行尾为'\n'
+  ///        缓存写满时先输出已经格式化的部分，因此一行可能分多次调用write
+  /// @tparam _WriteFun 形如 void(const char *data, size_t len) 的输出函数
+  /// @param uptime_ms 运行时间，作为第一个字段输出
+  template <typename _WriteFun>
+  void snapshot(_WriteFun &&write, uint32_t uptime_ms)
+  {
+    char buf[METRICS_LINE_SIZE];
+    int len{snprintf(buf, sizeof(buf), "%s uptime_ms=%lui", __measurement, static_cast<unsigned long>(uptime_ms))};
+    if (len < 0 || static_cast<size_t>(len) >= sizeof(buf) - 1)
+    {
+      return;
+    }
+    for (size_t i = 0; i < __count; ++i)
+    {
+      const auto &entry{__entries[i]};
+      // 留出行尾换行符的位置
+      int n{entry.format(buf + len, sizeof(buf) - 1 - len, entry.name, entry.ctx, entry.probe)};
+      if (n == 0)
+      {
+        write(buf, static_cast<size_t>(len));
+        len = 0;
+        n = entry.format(buf, sizeof(buf) - 1, entry.name, entry.ctx, entry.probe);
+      }
+      len += n;
+    }
+    buf[len++] = '\n';
+    write(buf, static_cast<size_t>(len));
+  }
+};
+
+#endif // __METRICS_HPP__
@@ -0,0 +1,103 @@
+/// @brief 多生产者/单消费者无锁有界队列
+///        每个槽位带序号，生产者用compare_exchange占用__tail位置后写入，再发布序号；
+///        消费者按顺序读取已发布的槽位。队列满时push直接返回false，不会阻塞或覆盖
+
+#ifndef __MPSC_QUEUE_HPP__
+#define __MPSC_QUEUE_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+#ifndef MPSC_CACHE_LINE_SIZE
+#define MPSC_CACHE_LINE_SIZE 64 // 读写索引之间的间隔，避免伪共享
+#endif
+
+template <typename _DataType, uint32_t _Capacity>
+class MpscRingQueue
+{
+  static_assert(_Capacity >= 2 && (_Capacity & (_Capacity - 1)) == 0, "capacity must be a power of two");
+
+private:
+  static constexpr uint32_t __size_end_pos{_Capacity - 1};
+
+  struct __Slot
+  {
+    std::atomic<uint32_t> seq; // 等于位置时可写，等于位置+1时可读
+    _DataType data;
+  };
+
+  alignas(MPSC_CACHE_LINE_SIZE) std::atomic<uint32_t> __tail{0}; // 所有生产者竞争写入
+  alignas(MPSC_CACHE_LINE_SIZE) uint32_t __head{0};              // 只有消费者访问
+
+  alignas(MPSC_CACHE_LINE_SIZE) __Slot __slots[_Capacity];
+
+public:
+  MpscRingQueue()
+  {
+    for (uint32_t i = 0; i < _Capacity; ++i)
+    {
+      __slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpscRingQueue(const MpscRingQueue &) = delete;
+  MpscRingQueue &operator=(const MpscRingQueue &) = delete;
+
+  /// @brief 写入一个元素，可以由多个任务同时调用
+  /// @param val 需要写入的值
+  /// @return 队列已满返回false
+  bool push(const _DataType &val)
+  {
+    uint32_t pos{__tail.load(std::memory_order_relaxed)};
+    while (1)
+    {
+      auto &slot{__slots[pos & __size_end_pos]};
+      const int32_t diff{static_cast<int32_t>(slot.seq.load(std::memory_order_acquire) - pos)};
+      if (diff == 0)
+      {
+        // 失败时pos被更新为最新的__tail
+        if (__tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        {
+          slot.data = val;
+          slot.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (diff < 0)
+      {
+        return false; // 槽位还没有被消费者读出
+      }
+      else
+      {
+        pos = __tail.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// @brief 取出一个元素，只能由消费者调用
+  /// @param val 取出的值
+  /// @return 队列为空（或最早的槽位仍在写入）返回false
+  bool pop(_DataType &val)
+  {
+    auto &slot{__slots[__head & __size_end_pos]};
+    if (slot.seq.load(std::memory_order_acquire) != __head + 1)
+    {
+      return false;
+    }
+    val = slot.data;
+    slot.seq.store(__head + _Capacity, std::memory_order_release);
+    ++__head;
+    return true;
+  }
+
+  /// @brief 当前元素数量的近似值，只能由消费者调用
+  uint32_t len() const
+  {
+    return __tail.load(std::memory_order_relaxed) - __head;
+  }
+
+  constexpr uint32_t capacity() const { return _Capacity; }
+};
+
+#endif // __MPSC_QUEUE_HPP__
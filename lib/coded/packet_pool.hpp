@@ -0,0 +1,101 @@
+/// @brief 固定槽位的数据包池
+///        所有缓存在编译期静态分配，通过句柄在生产者与消费者之间转移所有权，运行期不申请堆内存
+
+#ifndef __PACKET_POOL_HPP__
+#define __PACKET_POOL_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+template <size_t _SlotSize, size_t _SlotCount>
+class PacketPool
+{
+  static_assert(_SlotSize > 0 && _SlotSize <= 0xFF, "slot size must fit in uint8_t");
+  static_assert(_SlotCount > 0 && _SlotCount <= 32, "slot count must be in range [1, 32]");
+
+public:
+  using handle_t = uint8_t;
+
+  /// @brief 无效句柄，池已耗尽时由acquire返回
+  static constexpr handle_t invalid_handle{0xFF};
+
+  /// @brief 单个数据包槽位
+  struct Packet
+  {
+    uint8_t len{0};
+    uint8_t data[_SlotSize];
+    uint32_t trace_id{0}; // 数据包标识，见trace.hpp，未启用追踪时为0
+  };
+
+private:
+  static constexpr uint32_t __all_free{_SlotCount == 32 ? 0xFFFFFFFFUL : ((1UL << _SlotCount) - 1)};
+
+  Packet __slots[_SlotCount];
+  std::atomic<uint32_t> __free_mask{__all_free}; // 置位表示槽位空闲
+
+public:
+  /// @brief 申请一个空闲槽位，可在中断回调中调用（无锁）
+  /// @return 槽位句柄，池已耗尽时返回invalid_handle
+  handle_t acquire()
+  {
+    uint32_t mask{__free_mask.load(std::memory_order_relaxed)};
+    while (mask)
+    {
+      handle_t idx = static_cast<handle_t>(__builtin_ctz(mask));
+      if (__free_mask.compare_exchange_weak(mask, mask & ~(1UL << idx),
+                                            std::memory_order_acquire,
+                                            std::memory_order_relaxed))
+      {
+        __slots[idx].len = 0;
+        __slots[idx].trace_id = 0;
+        return idx;
+      }
+    }
+    return invalid_handle;
+  }
+
+  /// @brief 归还槽位，归还后不可再访问该句柄对应的数据
+  /// @param handle 由acquire得到的句柄
+  void release(handle_t handle)
+  {
+    if (handle < _SlotCount)
+    {
+      __free_mask.fetch_or(1UL << handle, std::memory_order_release);
+    }
+  }
+
+  /// @brief 通过句柄访问槽位
+  ///        注意：此功能不进行越界处理，需要使用者自行判断
+  /// @param handle 槽位句柄
+  /// @return 槽位的引用
+  inline Packet &operator[](const handle_t handle)
+  {
+    return __slots[handle];
+  }
+
+  /// @brief 查询当前空闲槽位数量
+  /// @return 空闲槽位数量
+  uint32_t available() const
+  {
+    return __builtin_popcount(__free_mask.load(std::memory_order_relaxed));
+  }
+
+  /// @brief 单个槽位可容纳的最大字节数
+  static constexpr size_t slot_size()
+  {
+    return _SlotSize;
+  }
+
+  /// @brief 槽位总数
+  static constexpr size_t capacity()
+  {
+    return _SlotCount;
+  }
+
+  PacketPool() = default;
+  PacketPool(const PacketPool &) = delete;
+  PacketPool &operator=(const PacketPool &) = delete;
+};
+
+#endif // __PACKET_POOL_HPP__
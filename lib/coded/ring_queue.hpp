@@ -1,82 +1,140 @@
-/// @brief 线程安全的环形队列
+/// @brief 环形队列
+///        注意：内部索引没有使用原子操作，跨任务/中断使用时需要外部加锁，
+///        单生产者/单消费者场景请使用spsc_queue.hpp中的SpscRingQueue
 
 #ifndef __RING_QUEUE_HPP__
 #define __RING_QUEUE_HPP__
 
 #include <cstdint>
+#include <algorithm>
 
+/// @brief 环形缓存中的一段连续区域，用于批量读写（memcpy/DMA）
 template <typename _DataType>
-class RingQueue
+struct RingRegion
+{
+  _DataType *data{nullptr};
+  uint32_t len{0};
+};
+
+/// @brief 基于write_regions/read_regions的批量读写，RingQueue、StaticRingQueue和SpscRingQueue共用
+/// @tparam _Derived 队列类型，需要提供write_regions/commit_write/read_regions/commit_read
+template <typename _Derived, typename _DataType>
+class RingBulkAccess
+{
+protected:
+  /// @brief 以环形缓存的回绕点为界，把从pos开始的total个元素分为两段
+  /// @param buf 缓存起始地址
+  /// @param capacity 缓存容量
+  /// @param pos 起始位置（已取模）
+  /// @param total 元素数量
+  /// @return total
+  static uint32_t __split(_DataType *buf, uint32_t capacity, uint32_t pos, uint32_t total,
+                          RingRegion<_DataType> &first, RingRegion<_DataType> &second)
+  {
+    const uint32_t first_len{std::min(total, capacity - pos)};
+    first = {&buf[pos], first_len};
+    second = {buf, total - first_len};
+    return total;
+  }
+
+public:
+  /// @brief 批量写入数据
+  /// @param src 数据源
+  /// @param count 数据数量
+  /// @return 实际写入的数量，缓存不足时小于count
+  uint32_t write(const _DataType *src, uint32_t count)
+  {
+    _Derived &queue{static_cast<_Derived &>(*this)};
+    RingRegion<_DataType> first, second;
+    count = std::min(count, queue.write_regions(first, second));
+    const uint32_t first_len{std::min(count, first.len)};
+    std::copy(src, src + first_len, first.data);
+    std::copy(src + first_len, src + count, second.data);
+    queue.commit_write(count);
+    return count;
+  }
+
+  /// @brief 批量读取数据
+  /// @param dst 目标缓存
+  /// @param count 需要读取的数量
+  /// @return 实际读取的数量，数据不足时小于count
+  uint32_t read(_DataType *dst, uint32_t count)
+  {
+    _Derived &queue{static_cast<_Derived &>(*this)};
+    RingRegion<_DataType> first, second;
+    count = std::min(count, queue.read_regions(first, second));
+    const uint32_t first_len{std::min(count, first.len)};
+    std::copy(first.data, first.data + first_len, dst);
+    std::copy(second.data, second.data + (count - first_len), dst + first_len);
+    queue.commit_read(count);
+    return count;
+  }
+};
+
+/// @brief 堆内存存储，容量在运行时通过RingQueue::allocate确定
+template <typename _DataType>
+struct RingHeapStorage
 {
-private:
   _DataType *__buf{nullptr};
   uint32_t __size{2};
+  uint32_t __size_end_pos{1}; // 数据总长度-1，__size-1
+};
+
+/// @brief 对象内部存储，容量为编译期常量，取模运算可折叠为常量掩码
+template <typename _DataType, uint32_t _Capacity>
+struct RingStaticStorage
+{
+  static_assert(_Capacity >= 2 && (_Capacity & (_Capacity - 1)) == 0, "capacity must be a power of two");
+
+  static constexpr uint32_t __size{_Capacity};
+  static constexpr uint32_t __size_end_pos{_Capacity - 1};
+  _DataType __buf[_Capacity];
+};
+
+/// @brief 环形队列的公共实现
+/// @tparam _Storage 存储策略，提供__buf、__size和__size_end_pos
+template <typename _DataType, typename _Storage>
+class RingQueueBase : protected _Storage, public RingBulkAccess<RingQueueBase<_DataType, _Storage>, _DataType>
+{
+protected:
   uint32_t __tail{0};
   uint32_t __head{0};
 
-  uint32_t __size_end_pos{1}; // 数据总长度-1，__size-1
-
   bool __push_lock{false}; // push锁定
 
   /// @brief 读取当前缓存指针所在位置
   /// @param pos 需要读取的值
   /// @return 在缓存中的位置
-  inline const uint32_t __mod(uint32_t pos) const
+  inline uint32_t __mod(uint32_t pos) const
   {
-    return (pos & __size_end_pos);
+    return (pos & this->__size_end_pos);
   }
 
-  inline const uint32_t __head_pos() const
+  inline uint32_t __head_pos() const
   {
     return __mod(__head);
   }
 
-  inline const uint32_t __tail_pos() const
+  inline uint32_t __tail_pos() const
   {
     return __mod(__tail);
   }
 
-  /// @brief 计算为2的平方数
-  /// @param num 需要判读的值
-  /// @return 返回是否成功
-  inline const int32_t __is_power_of_two(uint32_t num) const
-  {
-    if (num < 2)
-    {
-      return 0;
-    }
-    return (num & (num - 1)) == 0;
-  }
-
-  /// @brief 寻找最接近参数的2的平方数
-  /// @param num 需要处理的值
-  /// @return 2的平方数
-  inline uint32_t __roundup_power_of_two(uint32_t num)
-  {
-    if (num == 0)
-    {
-      return 2;
-    }
-    int32_t i = 0;
-    for (; num != 0; ++i)
-    {
-      num >>= 1;
-    }
-    return 1U << i;
-  }
+  RingQueueBase() = default;
+  ~RingQueueBase() = default;
 
 public:
   /// @brief 从队列可用的空间里面申请一块缓存，类型由push操作，此处由系统自行生成
   /// @param repush 是否允许重复push当前被锁定的数据
-  /// @return 返回可用的缓存，如果失败返回nullptr
+  /// @return 返回可用的缓存，如果失败（已锁定或队列已满）返回nullptr
   _DataType *pre_push(bool repush = false)
   {
-    if (__push_lock && !repush)
+    if ((__push_lock && !repush) || full())
     {
       return nullptr;
     }
     __push_lock = true;
-    return &__buf[__tail_pos()];
+    return &this->__buf[__tail_pos()];
   }
 
   /// @brief 从队列可用的空间里面申请一块缓存，并将缓存的内容使用dbuf进行替换
@@ -85,13 +143,8 @@ public:
   /// @return 返回可用的缓存，如果失败返回nullptr
   _DataType *pre_push(_DataType *dbuf, bool repush = false)
   {
-    if (__push_lock && !repush)
-    {
-      return nullptr;
-    }
-    __push_lock = true;
-    _DataType *result{&__buf[__tail_pos()]};
-    if (!__push_lock)
+    _DataType *result{pre_push(repush)};
+    if (result && dbuf)
     {
       *result = *dbuf;
     }
@@ -115,7 +168,7 @@ public:
 
   /// @brief 判断当前是否正在写入数据
   /// @return true/false 正在写入，空闲状态
-  const bool pushing() const
+  bool pushing() const
   {
     return __push_lock;
   }
@@ -137,18 +190,52 @@ public:
     {
       return nullptr;
     }
-    return &__buf[__head_pos()];
+    return &this->__buf[__head_pos()];
   }
 
-  /// @brief 判断队列是否为空
-  /// @return 返回头数据，空返回nullptr
+  /// @brief 访问队列尾部（最后写入）元素的值
+  /// @return 返回尾数据，空返回nullptr
   _DataType *back()
   {
     if (empty())
     {
       return nullptr;
     }
-    return &__buf[__tail_pos()];
+    return &this->__buf[__mod(__tail - 1)];
+  }
+
+  /// @brief 获取可写入的连续区域，以环形缓存的回绕点为界最多分为两段
+  ///        写入数据后需要调用commit_write确认
+  /// @param first 第一段区域（从当前尾部开始）
+  /// @param second 第二段区域（从缓存起始位置开始），不需要时长度为0
+  /// @return 可写入的总长度
+  uint32_t write_regions(RingRegion<_DataType> &first, RingRegion<_DataType> &second)
+  {
+    return this->__split(this->__buf, this->__size, __tail_pos(), remain(), first, second);
+  }
+
+  /// @brief 确认通过write_regions写入的数据
+  /// @param count 实际写入的数量，超出可写长度的部分会被忽略
+  void commit_write(uint32_t count)
+  {
+    __tail += std::min(count, remain());
+  }
+
+  /// @brief 获取可读取的连续区域，以环形缓存的回绕点为界最多分为两段
+  ///        读取数据后需要调用commit_read释放
+  /// @param first 第一段区域（从当前头部开始）
+  /// @param second 第二段区域（从缓存起始位置开始），不需要时长度为0
+  /// @return 可读取的总长度
+  uint32_t read_regions(RingRegion<_DataType> &first, RingRegion<_DataType> &second)
+  {
+    return this->__split(this->__buf, this->__size, __head_pos(), len(), first, second);
+  }
+
+  /// @brief 释放通过read_regions读取的数据
+  /// @param count 实际读取的数量，超出可读长度的部分会被忽略
+  void commit_read(uint32_t count)
+  {
+    __head += std::min(count, len());
   }
 
   /// @brief 清空数据
@@ -159,99 +246,144 @@ public:
 
   /// @brief 读取当前的缓存区域容量
   /// @return 数据最大长度，如果需要得到相关的字节数量，需要再乘以数据类型对应的字节长度
-  const uint32_t capacity() const
+  uint32_t capacity() const
   {
-    return __size;
+    return this->__size;
   }
 
   /// @brief 判断缓存是否为空
   /// @return 是否为空
-  const bool empty() const
+  bool empty() const
   {
     return __head == __tail;
   }
 
   /// @brief 判断缓存是否已经满了
   /// @return 是否已满
-  const bool full() const
+  bool full() const
   {
-    return __size == (__tail - __head);
+    return this->__size == (__tail - __head);
   }
 
   /// @brief 查询当前的数据长度
   /// @return 数据长度
-  const uint32_t len() const
+  uint32_t len() const
   {
     return __tail - __head;
   }
 
   /// @brief 查询可以使用的缓存长度
   /// @return 可用缓存长度
-  const uint32_t remain() const
+  uint32_t remain() const
+  {
+    return this->__size - __tail + __head;
+  }
+
+  /// @brief 通过[]来访问元素
+  ///        注意：此功能不进行越界处理，需要使用者自行判断
+  /// @param pos 读取数组位置
+  /// @return 返回指定地址的值的引用
+  template <typename _IdxType>
+  inline _DataType &operator[](const _IdxType pos)
+  {
+    return this->__buf[__mod(pos + __head)];
+  }
+
+  RingQueueBase(const RingQueueBase &) = delete;
+  RingQueueBase &operator=(const RingQueueBase &) = delete;
+};
+
+/// @brief 容量在运行时确定的环形队列，缓存从堆上申请
+template <typename _DataType>
+class RingQueue : public RingQueueBase<_DataType, RingHeapStorage<_DataType>>
+{
+private:
+  /// @brief 计算为2的平方数
+  /// @param num 需要判读的值
+  /// @return 返回是否成功
+  static bool __is_power_of_two(uint32_t num)
   {
-    return __size - __tail + __head;
+    if (num < 2)
+    {
+      return false;
+    }
+    return (num & (num - 1)) == 0;
   }
 
+  /// @brief 寻找最接近参数的2的平方数
+  /// @param num 需要处理的值
+  /// @return 2的平方数
+  static uint32_t __roundup_power_of_two(uint32_t num)
+  {
+    if (num == 0)
+    {
+      return 2;
+    }
+    int32_t i = 0;
+    for (; num != 0; ++i)
+    {
+      num >>= 1;
+    }
+    return 1U << i;
+  }
+
+  /// @brief 接管other的缓存和索引，other恢复为空状态
+  void __take(RingQueue &other)
+  {
+    this->__buf = other.__buf;
+    this->__size = other.__size;
+    this->__size_end_pos = other.__size_end_pos;
+    this->__tail = other.__tail;
+    this->__head = other.__head;
+    this->__push_lock = other.__push_lock;
+    // 删除原对象的值
+    other.__buf = nullptr;
+    other.__size = 0;
+    other.__size_end_pos = 0;
+    other.__tail = 0;
+    other.__head = 0;
+    other.__push_lock = false;
+  }
+
+public:
   /// @brief 手动分配内存空间
   /// @param capacity 容量
   /// @return 是否分配成功
   uint32_t allocate(const uint32_t capacity)
   {
-    __size = capacity;
-    if (!__is_power_of_two(__size))
+    this->__size = capacity;
+    if (!__is_power_of_two(this->__size))
     {
-      __size = __roundup_power_of_two(__size);
+      this->__size = __roundup_power_of_two(this->__size);
     }
-    __buf = new _DataType[__size];
-    __size_end_pos = __size - 1;
-    return __size;
+    this->__buf = new _DataType[this->__size];
+    this->__size_end_pos = this->__size - 1;
+    return this->__size;
   }
 
   /// @brief 释放缓存
   void delalloc()
   {
-    if (__buf)
+    if (this->__buf)
     {
-      delete[] __buf;
+      delete[] this->__buf;
+      this->__buf = nullptr;
     }
   }
 
-  /// @brief 通过[]来访问元素
-  ///        注意：此功能不进行越界处理，需要使用者自行判断
-  /// @param pos 读取数组位置
-  /// @return 返回指定地址的值的引用
-  template <typename _IdxType, typename = std::enable_if<
-                                   std::is_integral<_IdxType>::value ||
-                                   std::is_unsigned<_IdxType>::value>>
-  inline _DataType &operator[](const _IdxType pos)
-  {
-    return __buf[__mod(pos + __head)];
-  }
-
-  RingQueue(const RingQueue &) = delete;
-  RingQueue &operator=(const RingQueue &) = delete;
-
-  RingQueue(RingQueue &&other) : __buf(other.__buf), __size(other.__size), __tail(other.__tail), __head(other.__head), __size_end_pos(other.__size_end_pos)
+  RingQueue(RingQueue &&other)
   {
+    __take(other);
   }
 
   RingQueue &operator=(RingQueue &&other)
   {
-    if (__buf)
+    if (this != &other)
     {
-      delete[] __buf;
+      delalloc();
+      __take(other);
     }
-    __buf = other.__buf;
-    __size = other.__size;
-    __tail = other.__tail;
-    __head = other.__head;
-    __size_end_pos = other.__size_end_pos;
-    // 删除原对象的值
-    other.__buf = nullptr;
-    other.__size = 0;
-    other.__tail = 0;
-    other.__head = 0;
-    other.__size_end_pos = 0;
+    return *this;
   }
 
   RingQueue(const uint32_t capacity)
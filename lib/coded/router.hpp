@@ -0,0 +1,300 @@
+/// @brief 多端口帧路由器
+///        每个无线设备或串口作为一个端口，入口帧按路由表复制到各出口端口的队列中，
+///        每个出口端口按优先级分为多个有界队列：0号优先级为严格优先（控制帧），
+///        其余优先级之间按权重轮询，保证控制帧不会排在大量数据帧之后
+
+#ifndef __ROUTER_HPP__
+#define __ROUTER_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+
+#include "static_ring_queue.hpp"
+#include "trace.hpp"
+
+/// @brief 路由端口
+class RouterPort
+{
+public:
+  RouterPort() = default;
+  virtual ~RouterPort() = default;
+
+  /// @brief 发送一帧，不能阻塞
+  /// @param data 帧数据
+  /// @param len 帧长度
+  /// @return 端口忙时返回false，帧保留在队列头部，下一次调度时重试
+  virtual bool write(const uint8_t *data, size_t len) = 0;
+};
+
+/// @brief 不加锁，用于只在一个任务中使用路由器的场景
+struct RouterNullMutex
+{
+  void lock() {}
+  void unlock() {}
+};
+
+/// @brief 多端口帧路由器，队列在对象内静态分配
+/// @tparam _Ports 端口数量，不超过32
+/// @tparam _Classes 优先级数量，0号为严格优先
+/// @tparam _Mtu 单帧最大长度
+/// @tparam _Depth 每个出口每个优先级的队列长度，必须为2的幂
+/// @tparam _Mutex 锁类型，多个任务同时输入时使用std::mutex
+template <size_t _Ports, size_t _Classes, size_t _Mtu, uint32_t _Depth, typename _Mutex = RouterNullMutex>
+class Router
+{
+  static_assert(_Ports > 0 && _Ports <= 32, "port count must be in range [1, 32]");
+  static_assert(_Classes > 0 && _Classes <= 8, "class count must be in range [1, 8]");
+  static_assert(_Mtu > 0 && _Mtu <= 0xFF, "mtu must fit in uint8_t");
+
+public:
+  using port_t = uint8_t;
+  using class_t = uint8_t;
+
+  /// @brief 分类函数，返回帧的优先级，超出范围时按最低优先级处理
+  using classifier_t = class_t (*)(port_t ingress, const uint8_t *data, size_t len);
+
+  /// @brief 出口端口统计
+  struct Stats
+  {
+    uint32_t enqueued{0}; // 进入队列的帧数量
+    uint32_t sent{0};     // 发送成功的帧数量
+    uint32_t dropped{0};  // 队列已满而丢弃的帧数量
+    uint32_t busy{0};     // 端口忙而推迟发送的次数
+  };
+
+private:
+  struct __Frame
+  {
+    uint8_t len;
+    uint8_t data[_Mtu];
+    uint32_t trace_id; // 数据包标识，见trace.hpp
+  };
+
+  struct __Egress
+  {
+    RouterPort *port{nullptr};
+    StaticRingQueue<__Frame, _Depth> queues[_Classes];
+    class_t current{_Classes > 1 ? 1 : 0}; // 当前轮询到的优先级
+    uint8_t credit{0};                     // 当前优先级剩余的发送次数
+    Stats stats;
+  };
+
+  __Egress __egress[_Ports];
+  uint32_t __routes[_Ports]{}; // 每个入口端口对应的出口端口位图
+  uint8_t __weights[_Classes];
+  classifier_t __classifier{nullptr};
+  uint32_t __unrouted{0}; // 没有出口或格式错误的帧数量
+  _Mutex __lock;
+
+  /// @brief 选出下一个需要发送的优先级，调用前需要持有__lock
+  /// @return 所有队列为空时返回_Classes
+  class_t __pick(__Egress &egress)
+  {
+    if (!egress.queues[0].empty())
+    {
+      return 0;
+    }
+    // 加权轮询：每个优先级每轮最多连续发送weight个帧，空队列直接跳过
+    for (size_t i = 0; i < 2 * _Classes; ++i)
+    {
+      auto &queue{egress.queues[egress.current]};
+      if (egress.credit > 0 && !queue.empty())
+      {
+        return egress.current;
+      }
+      egress.current = egress.current + 1U < _Classes ? egress.current + 1 : (_Classes > 1 ? 1 : 0);
+      egress.credit = __weights[egress.current];
+    }
+    return _Classes;
+  }
+
+public:
+  Router()
+  {
+    for (auto &weight : __weights)
+    {
+      weight = 1;
+    }
+  }
+
+  Router(const Router &) = delete;
+  Router &operator=(const Router &) = delete;
+
+  /// @brief 注册端口
+  /// @param id 端口号
+  /// @param port 端口，nullptr表示移除
+  void attach(port_t id, RouterPort *port)
+  {
+    if (id < _Ports)
+    {
+      std::lock_guard<_Mutex> lock{__lock};
+      __egress[id].port = port;
+    }
+  }
+
+  /// @brief 设置路由
+  /// @param ingress 入口端口号
+  /// @param egress_mask 出口端口位图，入口端口自身的位会被忽略
+  void set_route(port_t ingress, uint32_t egress_mask)
+  {
+    if (ingress < _Ports)
+    {
+      std::lock_guard<_Mutex> lock{__lock};
+      __routes[ingress] = egress_mask & ~(1UL << ingress);
+    }
+  }
+
+  /// @brief 设置优先级的轮询权重，对0号优先级无效
+  /// @param cls 优先级
+  /// @param weight 每轮最多连续发送的帧数量，最小为1
+  void set_weight(class_t cls, uint8_t weight)
+  {
+    if (cls < _Classes)
+    {
+      std::lock_guard<_Mutex> lock{__lock};
+      __weights[cls] = weight > 0 ? weight : 1;
+    }
+  }
+
+  /// @brief 设置分类函数，未设置时所有帧使用最低优先级
+  void set_classifier(classifier_t classifier)
+  {
+    std::lock_guard<_Mutex> lock{__lock};
+    __classifier = classifier;
+  }
+
+  /// @brief 输入一帧，按路由表复制到各出口队列
+  /// @param ingress 入口端口号
+  /// @param data 帧数据
+  /// @param len 帧长度，不能超过_Mtu
+  /// @param trace_id 数据包标识，默认使用当前任务正在处理的数据包
+  /// @return 成功进入的出口队列数量
+  size_t input(port_t ingress, const uint8_t *data, size_t len, uint32_t trace_id = TRACE_CURRENT())
+  {
+    std::lock_guard<_Mutex> lock{__lock};
+    if (ingress >= _Ports || len == 0 || len > _Mtu || __routes[ingress] == 0)
+    {
+      ++__unrouted;
+      return 0;
+    }
+    class_t cls{__classifier ? __classifier(ingress, data, len) : static_cast<class_t>(_Classes - 1)};
+    if (cls >= _Classes)
+    {
+      cls = _Classes - 1;
+    }
+    size_t count{0};
+    uint32_t mask{__routes[ingress]};
+    while (mask)
+    {
+      auto &egress{__egress[__builtin_ctz(mask)]};
+      mask &= mask - 1;
+      __Frame *frame{egress.port ? egress.queues[cls].pre_push() : nullptr};
+      if (!frame)
+      {
+        ++egress.stats.dropped;
+        continue;
+      }
+      frame->len = static_cast<uint8_t>(len);
+      memcpy(frame->data, data, len);
+      frame->trace_id = trace_id;
+      egress.queues[cls].push();
+      ++egress.stats.enqueued;
+      ++count;
+    }
+    return count;
+  }
+
+  /// @brief 调度一个出口端口
+  /// @param id 出口端口号
+  /// @param budget 最多发送的帧数量
+  /// @return 发送成功的帧数量
+  size_t service(port_t id, size_t budget = SIZE_MAX)
+  {
+    if (id >= _Ports)
+    {
+      return 0;
+    }
+    auto &egress{__egress[id]};
+    size_t sent{0};
+    std::lock_guard<_Mutex> lock{__lock};
+    while (sent < budget && egress.port)
+    {
+      const class_t cls{__pick(egress)};
+      if (cls >= _Classes)
+      {
+        break;
+      }
+      auto &queue{egress.queues[cls]};
+      const __Frame *frame{queue.front()};
+      // 端口和其下的设备通过TRACE_CURRENT取得数据包标识
+      TRACE_SET_CURRENT(frame->trace_id);
+      const bool written{egress.port->write(frame->data, frame->len)};
+      TRACE_SET_CURRENT(0);
+      if (!written)
+      {
+        ++egress.stats.busy;
+        break;
+      }
+      TRACE_EVENT(PORT_WRITE, frame->trace_id);
+      queue.pop();
+      if (cls != 0)
+      {
+        --egress.credit;
+      }
+      ++egress.stats.sent;
+      ++sent;
+    }
+    return sent;
+  }
+
+  /// @brief 依次调度所有出口端口
+  /// @param budget 每个端口最多发送的帧数量
+  /// @return 发送成功的帧数量
+  size_t poll(size_t budget = SIZE_MAX)
+  {
+    size_t sent{0};
+    for (port_t id = 0; id < _Ports; ++id)
+    {
+      sent += service(id, budget);
+    }
+    return sent;
+  }
+
+  /// @brief 查询出口端口中等待发送的帧数量
+  /// @param id 出口端口号，超出范围时返回所有端口的总和
+  uint32_t pending(port_t id = _Ports)
+  {
+    std::lock_guard<_Mutex> lock{__lock};
+    uint32_t count{0};
+    for (port_t i = 0; i < _Ports; ++i)
+    {
+      if (id >= _Ports || id == i)
+      {
+        for (auto &queue : __egress[i].queues)
+        {
+          count += queue.len();
+        }
+      }
+    }
+    return count;
+  }
+
+  /// @brief 读取出口端口统计
+  /// @param id 出口端口号，必须小于_Ports
+  Stats stats(port_t id)
+  {
+    std::lock_guard<_Mutex> lock{__lock};
+    return __egress[id].stats;
+  }
+
+  /// @brief 没有出口或格式错误的帧数量
+  uint32_t unrouted()
+  {
+    std::lock_guard<_Mutex> lock{__lock};
+    return __unrouted;
+  }
+};
+
+#endif // __ROUTER_HPP__
@@ -0,0 +1,168 @@
+/// @brief 单生产者/单消费者无锁环形队列
+///        生产者只修改__tail，消费者只修改__head，两端通过acquire/release原子操作同步，
+///        适用于中断回调（或一个任务）写入、另一个任务读取的场景，不需要互斥锁
+///        批量读写write/read由RingBulkAccess提供：write只能由生产者调用，read只能由消费者调用
+
+#ifndef __SPSC_QUEUE_HPP__
+#define __SPSC_QUEUE_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+#include "ring_queue.hpp"
+
+#ifndef SPSC_CACHE_LINE_SIZE
+#define SPSC_CACHE_LINE_SIZE 64 // 读写索引之间的间隔，避免伪共享
+#endif
+
+template <typename _DataType, uint32_t _Capacity>
+class SpscRingQueue : public RingBulkAccess<SpscRingQueue<_DataType, _Capacity>, _DataType>
+{
+  static_assert(_Capacity >= 2 && (_Capacity & (_Capacity - 1)) == 0, "capacity must be a power of two");
+
+private:
+  static constexpr uint32_t __size_end_pos{_Capacity - 1};
+
+  alignas(SPSC_CACHE_LINE_SIZE) std::atomic<uint32_t> __head{0}; // 消费者写入
+  uint32_t __tail_cache{0};                                      // 消费者缓存的__tail，减少跨核读取
+
+  alignas(SPSC_CACHE_LINE_SIZE) std::atomic<uint32_t> __tail{0}; // 生产者写入
+  uint32_t __head_cache{0};                                      // 生产者缓存的__head
+
+  alignas(SPSC_CACHE_LINE_SIZE) _DataType __buf[_Capacity];
+
+public:
+  /// @brief 写入一个元素，只能由生产者调用
+  /// @param val 需要写入的值
+  /// @return 队列已满返回false
+  bool push(const _DataType &val)
+  {
+    const uint32_t tail{__tail.load(std::memory_order_relaxed)};
+    if (tail - __head_cache == _Capacity)
+    {
+      __head_cache = __head.load(std::memory_order_acquire);
+      if (tail - __head_cache == _Capacity)
+      {
+        return false;
+      }
+    }
+    __buf[tail & __size_end_pos] = val;
+    __tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// @brief 取出一个元素，只能由消费者调用
+  /// @param val 取出的值
+  /// @return 队列为空返回false
+  bool pop(_DataType &val)
+  {
+    const _DataType *ptr{front()};
+    if (!ptr)
+    {
+      return false;
+    }
+    val = *ptr;
+    pop();
+    return true;
+  }
+
+  /// @brief 访问队列头部元素，只能由消费者调用
+  /// @return 返回头数据，空返回nullptr
+  _DataType *front()
+  {
+    const uint32_t head{__head.load(std::memory_order_relaxed)};
+    if (head == __tail_cache)
+    {
+      __tail_cache = __tail.load(std::memory_order_acquire);
+      if (head == __tail_cache)
+      {
+        return nullptr;
+      }
+    }
+    return &__buf[head & __size_end_pos];
+  }
+
+  /// @brief 移除队列头部的元素，只能由消费者调用
+  void pop()
+  {
+    const uint32_t head{__head.load(std::memory_order_relaxed)};
+    if (head != __tail.load(std::memory_order_acquire))
+    {
+      __head.store(head + 1, std::memory_order_release);
+    }
+  }
+
+  /// @brief 获取可写入的连续区域，最多两段，只能由生产者调用
+  ///        写入数据后需要调用commit_write发布给消费者
+  /// @param first 第一段区域（从当前尾部开始）
+  /// @param second 第二段区域（从缓存起始位置开始），不需要时长度为0
+  /// @return 可写入的总长度
+  uint32_t write_regions(RingRegion<_DataType> &first, RingRegion<_DataType> &second)
+  {
+    const uint32_t tail{__tail.load(std::memory_order_relaxed)};
+    __head_cache = __head.load(std::memory_order_acquire);
+    return this->__split(__buf, _Capacity, tail & __size_end_pos, _Capacity - (tail - __head_cache), first, second);
+  }
+
+  /// @brief 发布通过write_regions写入的数据，只能由生产者调用
+  /// @param count 实际写入的数量，不能超过write_regions返回的长度
+  void commit_write(uint32_t count)
+  {
+    __tail.store(__tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+  }
+
+  /// @brief 获取可读取的连续区域，最多两段，只能由消费者调用
+  ///        读取数据后需要调用commit_read归还给生产者
+  /// @param first 第一段区域（从当前头部开始）
+  /// @param second 第二段区域（从缓存起始位置开始），不需要时长度为0
+  /// @return 可读取的总长度
+  uint32_t read_regions(RingRegion<_DataType> &first, RingRegion<_DataType> &second)
+  {
+    const uint32_t head{__head.load(std::memory_order_relaxed)};
+    __tail_cache = __tail.load(std::memory_order_acquire);
+    return this->__split(__buf, _Capacity, head & __size_end_pos, __tail_cache - head, first, second);
+  }
+
+  /// @brief 归还通过read_regions读取的数据，只能由消费者调用
+  /// @param count 实际读取的数量，不能超过read_regions返回的长度
+  void commit_read(uint32_t count)
+  {
+    __head.store(__head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+  }
+
+  /// @brief 判断队列是否为空
+  /// @return 是否为空
+  bool empty() const
+  {
+    return __head.load(std::memory_order_acquire) == __tail.load(std::memory_order_acquire);
+  }
+
+  /// @brief 判断队列是否已满
+  /// @return 是否已满
+  bool full() const
+  {
+    return len() == _Capacity;
+  }
+
+  /// @brief 查询当前的数据长度，在并发时只是一个近似值
+  /// @return 数据长度
+  uint32_t len() const
+  {
+    const uint32_t head{__head.load(std::memory_order_acquire)}; // 先读__head，保证结果不会下溢
+    return __tail.load(std::memory_order_acquire) - head;
+  }
+
+  /// @brief 读取队列容量
+  /// @return 数据最大长度
+  static constexpr uint32_t capacity()
+  {
+    return _Capacity;
+  }
+
+  SpscRingQueue() = default;
+  SpscRingQueue(const SpscRingQueue &) = delete;
+  SpscRingQueue &operator=(const SpscRingQueue &) = delete;
+};
+
+#endif // __SPSC_QUEUE_HPP__
@@ -0,0 +1,27 @@
+/// @brief 编译期固定容量的环形队列
+///        与RingQueue共用RingQueueBase的实现，只是存储策略不同：数据直接存放在对象内部，
+///        不申请堆内存，容量为编译期常量，取模运算可折叠为常量掩码
+///        注意：与RingQueue相同，内部索引没有使用原子操作，跨任务使用时需要外部加锁
+
+#ifndef __STATIC_RING_QUEUE_HPP__
+#define __STATIC_RING_QUEUE_HPP__
+
+#include <cstdint>
+
+#include "ring_queue.hpp"
+
+template <typename _DataType, uint32_t _Capacity>
+class StaticRingQueue : public RingQueueBase<_DataType, RingStaticStorage<_DataType, _Capacity>>
+{
+public:
+  /// @brief 读取队列容量
+  /// @return 数据最大长度
+  static constexpr uint32_t capacity()
+  {
+    return _Capacity;
+  }
+
+  StaticRingQueue() = default;
+};
+
+#endif // __STATIC_RING_QUEUE_HPP__
@@ -0,0 +1,222 @@
+/// @brief 数据包处理各阶段的时间戳追踪
+///        每个CPU核心一个环形缓存，写入只使用原子操作，可以在任务和回调中调用；
+///        缓存写满后覆盖最早的记录，导出为Chrome trace JSON（chrome://tracing或Perfetto打开）
+///        同一数据包的各阶段使用同一个数据包标识：串口读入或射频收到时由TRACE_NEW_ID分配，
+///        随数据包池槽位、路由器队列和射频发送队列的元素传递；经过只传递数据和长度的接口
+///        （RouterPort::write、RadioDevice::send_async、链路层回调）时，调用方用TRACE_SET_CURRENT
+///        设置当前任务正在处理的数据包，被调用方用TRACE_CURRENT读取
+///        TRACE_ENABLED为0（默认）时各宏展开为空语句或0，追踪缓存不占用内存也不产生代码
+
+#ifndef __TRACE_HPP__
+#define __TRACE_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <atomic>
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 0
+#endif
+
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE 256 // 每个核心的记录数量，必须为2的幂
+#endif
+
+#if defined(ESP_PLATFORM)
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#define TRACE_CORES portNUM_PROCESSORS
+#else
+#include <chrono>
+#define TRACE_CORES 1
+#endif
+
+/// @brief 追踪阶段
+enum class TraceStage : uint16_t
+{
+  UART_INGEST, // 串口数据读入数据包池
+  DEQUEUE,     // 转发任务取出数据包
+  PORT_WRITE,  // 路由器把帧交给出口端口
+  SPI_START,   // 开始通过SPI写入射频芯片并启动发送
+  AIR_DONE,    // 发送完成中断（或超时）
+  RX_READ,     // 从射频芯片读出数据包
+  UART_WRITE,  // 写入串口
+  COUNT,
+};
+
+/// @brief 阶段名称，用于导出
+constexpr const char *trace_stage_name(TraceStage stage)
+{
+  constexpr const char *names[]{"uart_ingest", "dequeue", "port_write", "spi_start", "air_done", "rx_read", "uart_write"};
+  return static_cast<size_t>(stage) < static_cast<size_t>(TraceStage::COUNT) ? names[static_cast<size_t>(stage)] : "unknown";
+}
+
+/// @brief 当前时间，单位为微秒
+inline uint64_t trace_now_us()
+{
+#if defined(ESP_PLATFORM)
+  return static_cast<uint64_t>(esp_timer_get_time());
+#else
+  static const auto start{std::chrono::steady_clock::now()};
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+#endif
+}
+
+/// @brief 当前核心编号
+inline uint32_t trace_core_id()
+{
+#if defined(ESP_PLATFORM)
+  return xPortGetCoreID();
+#else
+  return 0;
+#endif
+}
+
+/// @brief 单个核心的追踪缓存
+///        同一核心上的任务可能互相抢占，因此用fetch_add分配槽位，
+///        每个槽位带序号（写入中为奇数），导出时丢弃正在写入或已被覆盖的记录
+template <uint32_t _Capacity>
+class TraceRing
+{
+  static_assert(_Capacity >= 2 && (_Capacity & (_Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+  struct Event
+  {
+    uint64_t ts_us;
+    uint32_t id;
+    TraceStage stage;
+  };
+
+private:
+  struct __Slot
+  {
+    std::atomic<uint32_t> seq{0};
+    Event event;
+  };
+
+  std::atomic<uint32_t> __head{0};
+  __Slot __slots[_Capacity];
+
+public:
+  /// @brief 写入一条记录
+  void record(TraceStage stage, uint32_t id, uint64_t ts_us)
+  {
+    const uint32_t pos{__head.fetch_add(1, std::memory_order_relaxed)};
+    auto &slot{__slots[pos & (_Capacity - 1)]};
+    slot.seq.store(pos * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.event = {ts_us, id, stage};
+    slot.seq.store(pos * 2 + 2, std::memory_order_release);
+  }
+
+  /// @brief 遍历缓存中完整的记录，从最早到最新
+  /// @tparam _EventFun 形如 void(const Event &) 的回调
+  template <typename _EventFun>
+  void for_each(_EventFun &&on_event) const
+  {
+    const uint32_t head{__head.load(std::memory_order_acquire)};
+    const uint32_t begin{head > _Capacity ? head - _Capacity : 0};
+    for (uint32_t pos = begin; pos != head; ++pos)
+    {
+      const auto &slot{__slots[pos & (_Capacity - 1)]};
+      if (slot.seq.load(std::memory_order_acquire) != pos * 2 + 2)
+      {
+        continue;
+      }
+      const Event event{slot.event};
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.seq.load(std::memory_order_relaxed) == pos * 2 + 2)
+      {
+        on_event(event);
+      }
+    }
+  }
+
+  /// @brief 清空缓存，导出后调用，不能与record并发
+  void clear()
+  {
+    for (auto &slot : __slots)
+    {
+      slot.seq.store(0, std::memory_order_relaxed);
+    }
+    __head.store(0, std::memory_order_release);
+  }
+};
+
+#if TRACE_ENABLED
+
+inline TraceRing<TRACE_RING_SIZE> trace_rings[TRACE_CORES];
+
+/// @brief 在当前核心的缓存中记录一个阶段
+/// @param stage 阶段
+/// @param id 数据包标识，用于关联同一数据包的各阶段
+inline void trace_record(TraceStage stage, uint32_t id)
+{
+  trace_rings[trace_core_id() % TRACE_CORES].record(stage, id, trace_now_us());
+}
+
+/// @brief 导出为Chrome trace JSON，每条记录为一个瞬时事件，tid为核心编号
+/// @tparam _WriteFun 形如 void(const char *data, size_t len) 的输出函数
+template <typename _WriteFun>
+void trace_export_chrome(_WriteFun &&write)
+{
+  char line[128];
+  bool first{true};
+  write("{\"traceEvents\":[\n", 17);
+  for (uint32_t core = 0; core < TRACE_CORES; ++core)
+  {
+    trace_rings[core].for_each([&](const TraceRing<TRACE_RING_SIZE>::Event &event)
+                               {
+                                 const int len{snprintf(line, sizeof(line),
+                                                        "%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%llu,\"pid\":0,\"tid\":%u,\"args\":{\"id\":%u}}",
+                                                        first ? "" : ",\n", trace_stage_name(event.stage),
+                                                        static_cast<unsigned long long>(event.ts_us),
+                                                        static_cast<unsigned>(core), static_cast<unsigned>(event.id))};
+                                 if (len > 0)
+                                 {
+                                   write(line, static_cast<size_t>(len) < sizeof(line) ? static_cast<size_t>(len) : sizeof(line) - 1);
+                                   first = false;
+                                 }
+                               });
+  }
+  write("\n]}\n", 4);
+}
+
+/// @brief 清空所有核心的缓存
+inline void trace_clear()
+{
+  for (auto &ring : trace_rings)
+  {
+    ring.clear();
+  }
+}
+
+inline std::atomic<uint32_t> trace_last_id{0};
+inline thread_local uint32_t trace_current_id{0}; // 当前任务正在处理的数据包，0表示没有
+
+/// @brief 分配新的数据包标识，跳过表示没有数据包的0
+inline uint32_t trace_new_id()
+{
+  uint32_t id{0};
+  while (id == 0)
+  {
+    id = trace_last_id.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+  return id;
+}
+
+#define TRACE_EVENT(stage, id) trace_record(TraceStage::stage, static_cast<uint32_t>(id))
+#define TRACE_NEW_ID() trace_new_id()
+#define TRACE_CURRENT() trace_current_id
+#define TRACE_SET_CURRENT(id) (trace_current_id = static_cast<uint32_t>(id))
+#else
+#define TRACE_EVENT(stage, id) ((void)0)
+#define TRACE_NEW_ID() 0U
+#define TRACE_CURRENT() 0U
+#define TRACE_SET_CURRENT(id) ((void)0)
+#endif
+
+#endif // __TRACE_HPP__
@@ -23,8 +23,47 @@
 #include <RadioLib.h>
 #include "bytes_string.hpp"
 #include "nrf24_device.h"
+#include "rate_control.h"
+#include "nrf24_profiles.h"
+
+#ifndef NRF24_RATE_CONTROL
+#define NRF24_RATE_CONTROL 0 // 是否根据丢包率自动切换数据速率和输出功率，两端都需要启用
+#endif
+#ifndef NRF24_RATE_INITIATOR
+#define NRF24_RATE_INITIATOR 0 // 是否由本端发起档位切换，两端的设置必须不同
+#endif
+
 nRF24Device __nrf24_a{FSPI, 4, 6, 5, 3, 7, 2};
 
+#if NRF24_RATE_CONTROL
+using Nrf24RateControl = RateControl<NRF24_PROFILE_COUNT>;
+
+static Nrf24RateControl::Config nrf24_rate_config()
+{
+    Nrf24RateControl::Config config;
+    config.adapt = nrf24_adapt_config();
+    config.home_level = NRF24_PROFILE_HOME;
+    config.initiator = NRF24_RATE_INITIATOR;
+    return config;
+}
+
+// 发送队列只有一个生产者，心跳和协商帧由loop任务发送和处理
+Nrf24RateControl nrf24_rate{
+    __nrf24_a, nrf24_rate_config(),
+    [](void *, uint8_t level)
+    {
+        return __nrf24_a.set_link_profile(nrf24_profiles[level].data_rate_kbps, nrf24_profiles[level].power_dbm);
+    },
+    [](void *)
+    {
+        // 未开启自动应答，丢包只能通过对端的发送计数发现；nRF24没有RSSI
+        const auto &tx{__nrf24_a.tx_stats()};
+        const auto &rx{__nrf24_a.rx_stats()};
+        return LinkSample{tx.sent.load(std::memory_order_relaxed), rx.received.load(std::memory_order_relaxed),
+                          rx.failed.load(std::memory_order_relaxed), LINK_RSSI_UNKNOWN};
+    }};
+#endif
+
 // enum Mode
 // {
 //     RECEIVING,
@@ -56,7 +95,12 @@ void LoRa_24G_init()
 {
     byte addr_rvf[] = {0x02, 0x24, 0x46, 0x68, 0x90};
     byte addr_pcie[] = {0x01, 0x23, 0x45, 0x67, 0x89};
+#if NRF24_RATE_CONTROL
+    const auto &profile{nrf24_profiles[NRF24_PROFILE_HOME]};
+    __nrf24_a.init(2402, profile.data_rate_kbps, profile.power_dbm, 5);
+#else
     __nrf24_a.init(2402, 1000, 0, 5);
+#endif
     __nrf24_a.set_transmit_addr(addr_pcie);
     __nrf24_a.set_receive_addr(0, addr_rvf);
 }
@@ -10,19 +10,15 @@
 
 #include "bytes_string.hpp"
 #include "nrf24_device.h"
+#include "sx1262_device.h"
+#include "control_protocol.h"
+#include "rate_control.h"
+#include "fsk_profiles.h"
 #include "utools.h"
 #include "LoRa_24G.hpp"
 
-auto sync_partner_900M{utools::collab::freertos::make_sync_partner<false, true>()};
-
-ICACHE_RAM_ATTR void setFlag(void)
-{
-    sync_partner_900M.notify();
-}
-
-static uint8_t parseProtocol(uint8_t *data, size_t length);
+static uint8_t parseProtocol(const uint8_t *data, size_t length);
 void LoRa_900M_init();
-void LoRa_900M_rx(void *pvParameters);
 
 // SX1262 has the following connections:
 // NSS pin:   10
@@ -36,229 +32,69 @@ void LoRa_900M_rx(void *pvParameters);
 
 #define IRQ_900 12
 #define RST_900 15
-#define TX_900 -1
+#define TX_900 RADIOLIB_NC
 #define RX_900 14
 #define BUSY_900 13
 
-SPIClass radio_spi_900M(HSPI);
-SPISettings spiSettings_900M(2000000, MSBFIRST, SPI_MODE0);
-Module *modeuld_900M = new Module(NSS_900, IRQ_900, RST_900, BUSY_900, radio_spi_900M, spiSettings_900M);
-SX1262 radio_900M = SX1262(modeuld_900M);
-
-void LoRa_900M_init()
-{
-    radio_spi_900M.begin(SCK_900, MISO_900, MOSI_900, NSS_900);
-    // 使用温度补偿晶振
-    radio_900M.XTAL = true;
-    // initialize SX1262 with default settings
-    utools::logger_info("Initializing SX1262");
-    // int state = radio_900M.begin(915.0, 125.0, 9, 7, 0x12, 10, 8, 1.6, false);
-    int state = radio_900M.beginFSK(915.0, 30.0, 5.0, 156.2, 22);
-    if (state == RADIOLIB_ERR_NONE)
-    {
-        utools::logger_info("SX1262 Module init success!");
-    }
-    else
-    {
-        utools::logger_error("SX1262 Module init failed, code:", state);
-        return;
-    }
+#ifndef SX1262_RATE_CONTROL
+#define SX1262_RATE_CONTROL 0 // 是否根据链路质量自动切换FSK档位，两端都需要启用
+#endif
+#ifndef SX1262_RATE_INITIATOR
+#define SX1262_RATE_INITIATOR 0 // 是否由本端发起档位切换，两端的设置必须不同
+#endif
 
-    // radio_900M.setPacketReceivedAction(setFlag);
-    radio_900M.setDio1Action(setFlag);
+SX1262Device __sx1262_a{HSPI, SCK_900, MISO_900, MOSI_900, NSS_900, IRQ_900, RST_900, BUSY_900, RX_900, TX_900};
 
-    // some modules have an external RF switch
-    // controlled via two pins (RX enable, TX enable)
-    // to enable automatic control of the switch,
-    // call the following method
-    // RX enable:   4
-    // TX enable:   5
-    radio_900M.setRfSwitchPins(RX_900, TX_900);
-    utools::logger_info("SX1262 Starting to listen ... ");
-    state = radio_900M.startReceive();
-    if (state == RADIOLIB_ERR_NONE)
-    {
-        utools::logger_info("SX1262 Start to listen success!");
-    }
-    else
-    {
-        utools::logger_error("SX1262 Start to listen failed, code:", state);
-    }
+#if SX1262_RATE_CONTROL
+using SX1262RateControl = RateControl<FSK_PROFILE_COUNT>;
 
-    xTaskCreate(LoRa_900M_rx, "LoRa_900M_rx", 1024 * 10, NULL, 1, NULL); // 启动接收任务
+static SX1262RateControl::Config sx1262_rate_config()
+{
+    SX1262RateControl::Config config;
+    config.adapt = fsk_adapt_config();
+    config.home_level = FSK_PROFILE_HOME;
+    config.initiator = SX1262_RATE_INITIATOR;
+    return config;
 }
 
-#if defined(ESP8266) || defined(ESP32)
-ICACHE_RAM_ATTR
+// 心跳和协商帧由SX1262接收任务发送和处理
+SX1262RateControl sx1262_rate{
+    __sx1262_a, sx1262_rate_config(),
+    [](void *, uint8_t level)
+    {
+        const auto &profile{fsk_profiles[level]};
+        return __sx1262_a.set_fsk_profile(profile.bitrate_kbps, profile.freq_dev_khz, profile.rx_bw_khz);
+    },
+    [](void *)
+    {
+        const auto &tx{__sx1262_a.tx_stats()};
+        const auto &rx{__sx1262_a.rx_stats()};
+        const uint32_t received{rx.received.load(std::memory_order_relaxed)};
+        return LinkSample{tx.sent.load(std::memory_order_relaxed), received,
+                          rx.crc_errors.load(std::memory_order_relaxed) + rx.failed.load(std::memory_order_relaxed),
+                          static_cast<int16_t>(received ? rx.rssi_x10.load(std::memory_order_relaxed) : LINK_RSSI_UNKNOWN)};
+    }};
 #endif
 
-// counter to keep track of transmitted packets
-int count_900M = 0;
-
-void LoRa_900M_tx()
+void LoRa_900M_init()
 {
-    while (1)
-    {
-        Serial.print(F("[SX1262] Transmitting packet ... "));
-
-        // you can transmit C-string or Arduino string up to
-        // 256 characters long
-        String str = "Hello World! #" + String(count_900M++);
-        int state = radio_900M.transmit(str);
-
-        // you can also transmit byte array up to 256 bytes long
-        /*
-          byte byteArr[] = {0x01, 0x23, 0x45, 0x56, 0x78, 0xAB, 0xCD, 0xEF};
-          int state = radio_900M.transmit(byteArr, 8);
-        */
-
-        if (state == RADIOLIB_ERR_NONE)
-        {
-            // the packet was successfully transmitted
-            Serial.println(F("success!"));
-
-            // print measured data rate
-            Serial.print(F("[SX1262] Datarate:\t"));
-            Serial.print(radio_900M.getDataRate());
-            Serial.println(F(" bps"));
-        }
-        else if (state == RADIOLIB_ERR_PACKET_TOO_LONG)
-        {
-            // the supplied packet was longer than 256 bytes
-            Serial.println(F("too long!"));
-        }
-        else if (state == RADIOLIB_ERR_TX_TIMEOUT)
-        {
-            // timeout occured while transmitting packet
-            Serial.println(F("timeout!"));
-        }
-        else
-        {
-            // some other error occurred
-            Serial.print(F("send failed, code "));
-            Serial.println(state);
-        }
-
-        // wait for a second before transmitting again
-        delay(1000);
-    }
+    // int state = radio_900M.begin(915.0, 125.0, 9, 7, 0x12, 10, 8, 1.6, false);
+    // 初始化成功后由收发任务进入连续接收，收到的数据包通过rx_front读取
+#if SX1262_RATE_CONTROL
+    const auto &profile{fsk_profiles[FSK_PROFILE_HOME]};
+    __sx1262_a.init(915.0, profile.bitrate_kbps, profile.freq_dev_khz, profile.rx_bw_khz, 22);
+#else
+    __sx1262_a.init(915.0, 30.0, 5.0, 156.2, 22);
+#endif
 }
 
-void LoRa_900M_rx(void *pvParameters)
+uint8_t parseProtocol(const uint8_t *data, size_t length)
 {
-    uint8_t buffer[128];
-
-    while (1)
+    /// TODO: 使用原本频率通知电机和电脑板 等待返回以后修改频率
+    auto result{control_dispatch(__nrf24_a, data, length)};
+    if (result == CmdResult::FAILED)
     {
-        sync_partner_900M.wait(); // 等待同步信号，会在此处理一直等待
-        size_t len = radio_900M.getPacketLength();
-        int state = radio_900M.readData(buffer, 0);
-        if (state == RADIOLIB_ERR_NONE)
-        {
-            // utools::logger_info("recieve form 9xx:", utools::code::to_hex(buffer, len));
-            if (parseProtocol(buffer, len))
-            {
-                utools::logger_info("change channle suss");
-                ESP.restart();
-            }
-            else
-            {
-                Serial1.write(buffer, len);
-                // utools::logger_trace("send to serial1:", utools::code::to_hex(buffer, len));
-            }
-        }
-        else if (state == RADIOLIB_ERR_CRC_MISMATCH)
-        {
-            utools::logger_error("crc error, data:", utools::code::to_hex(buffer, len));
-        }
-        else
-        {
-            utools::logger_error("recieve failed code:", state);
-        }
+        utools::logger_error("control frame failed, data:", utools::code::to_hex(data, length));
     }
+    return result == CmdResult::SUCCESS;
 }
-
-uint8_t parseProtocol(uint8_t *data, size_t length)
-{
-    // 检查数据长度
-    if (length != 11)
-    {
-        // Serial.println("Invalid data length");
-        return 0;
-    }
-
-    // 检查前7个字节和最后3个字节是否符合特定模式
-    if (memcmp(data, (const uint8_t[]){0xc0, 0x00, 0x08, 0x00, 0x00, 0xe7, 0x80}, 7) == 0 && memcmp(data + 8, (const uint8_t[]){0x00, 0x00, 0x00}, 3) == 0)
-    {
-        /// TODO: 使用原本频率通知电机和电脑板 等待返回以后修改频率
-        int state;
-        Serial.print("data:");
-        Serial.println(data[7], HEX);
-        auto nrf24_dev = static_cast<nRF24 *>(__nrf24_a.device());
-        state = nrf24_dev->sleep();
-        Serial.print("state:");
-        Serial.println(state);
-        switch (data[7])
-        {
-        case 0x00:
-            state = nrf24_dev->setFrequency(2402);
-            break;
-        case 0x05:
-            state = nrf24_dev->setFrequency(2409);
-            break;
-        case 0x0a:
-            state = nrf24_dev->setFrequency(2416);
-            break;
-        case 0x0f:
-            state = nrf24_dev->setFrequency(2423);
-            break;
-        case 0x14:
-            state = nrf24_dev->setFrequency(2430);
-            break;
-        case 0x19:
-            state = nrf24_dev->setFrequency(2437);
-            break;
-        case 0x1e:
-            state = nrf24_dev->setFrequency(2444);
-            break;
-        case 0x23:
-            state = nrf24_dev->setFrequency(2451);
-            break;
-        case 0x28:
-            state = nrf24_dev->setFrequency(2458);
-            break;
-        case 0x2d:
-            state = nrf24_dev->setFrequency(2465);
-            break;
-        case 0x32:
-            state = nrf24_dev->setFrequency(2472);
-            break;
-        case 0x37:
-            state = nrf24_dev->setFrequency(2479);
-            break;
-        case 0x3c:
-            state = nrf24_dev->setFrequency(2486);
-            break;
-        case 0x41:
-            state = nrf24_dev->setFrequency(2493);
-            break;
-        case 0x46:
-            state = nrf24_dev->setFrequency(2500);
-            break;
-        case 0x4b:
-            state = nrf24_dev->setFrequency(2507);
-            break;
-
-        default:
-            break;
-        }
-        state = nrf24_dev->standby();
-        if (state == RADIOLIB_ERR_NONE)
-        {
-            return 1;
-        }
-    }
-    // 数据不匹配
-    Serial.println("Data does not match the expected pattern.");
-    return 0;
-}
\ No newline at end of file
@@ -1,47 +1,312 @@
 #include <Arduino.h>
 #include "LoRa_900M.hpp"
 #include "LoRa_24G.hpp"
-#include <memory>
 #include <vector>
 #include <thread>
+#include <mutex>
+#include <atomic>
 #include <queue>
+#include <algorithm>
 
 #include "utools.h"
 
-#define BUFFER_SIZE 10
-std::unique_ptr<unsigned char[]> rxBuffer;
-volatile size_t rxLength = 0;
-volatile bool dataAvailable = false;
-TaskHandle_t Task1Handle = NULL;
-
 #include "ring_queue.hpp"
+#include "packet_pool.hpp"
+#include "spsc_queue.hpp"
+#include "frame_aggregator.hpp"
+#include "uart_ingest.h"
+#include "router_ports.h"
+#include "trace.hpp"
+#include "deferred_log.hpp"
+#include "metrics.hpp"
+#include "arq.hpp"
+#include "fragment_link.h"
+
+#define RADIO_PAYLOAD_SIZE 32 // nRF24单包最大长度
+#define PACKET_POOL_SLOTS 16  // 数据包池槽位数量
+#define DLOG_DRAIN_INTERVAL_MS 50 // 延迟日志的输出周期
+#define METRICS_INTERVAL_MS 1000  // 统计快照的输出周期
+#define SX1262_RATE_POLL_MS 50    // 启用速率自适应时SX1262接收任务的最长等待时间
+#define NRF24_RATE_POLL_MS 50     // 启用速率自适应时loop任务的最长等待时间
+
+#ifndef BRIDGE_AGGREGATION
+#define BRIDGE_AGGREGATION 0 // 是否将多个短串口帧合并到一个无线包中，对端需要使用aggregate_split拆分
+#endif
+#define AGGREGATION_MAX_LATENCY_MS 5 // 串口帧在合并器中的最长等待时间
+
+#ifndef BRIDGE_ARQ
+#define BRIDGE_ARQ 0 // 是否通过选择重传ARQ在nRF24上可靠传输，两端都需要启用
+#endif
+
+#ifndef BRIDGE_FRAGMENT
+#define BRIDGE_FRAGMENT 0 // 是否将长串口帧分片后经nRF24发送，对端重组为完整的帧后再输出，两端都需要启用
+#endif
+
+#if BRIDGE_FRAGMENT && (BRIDGE_ARQ || BRIDGE_AGGREGATION)
+#error "BRIDGE_FRAGMENT cannot be combined with BRIDGE_ARQ or BRIDGE_AGGREGATION"
+#endif
+
+#if BRIDGE_FRAGMENT
+#define BRIDGE_FRAME_SIZE 128 // 串口帧、数据包池槽位和路由器帧的最大长度，不超过FragmentLink::max_frame_size
+#else
+#define BRIDGE_FRAME_SIZE RADIO_PAYLOAD_SIZE
+#endif
+
+#if BRIDGE_ARQ
+#define RADIO_FRAME_SIZE (RADIO_PAYLOAD_SIZE - ARQ_HEADER_SIZE) // 预留ARQ头
+ArqLink<RADIO_PAYLOAD_SIZE> nrf24_arq; // 只在loop任务中使用
+
+/// @brief ArqLink的统计不是原子量，由loop任务复制到这里，统计快照在其它任务中读取
+struct ArqMetrics
+{
+  std::atomic<uint32_t> sent{0};
+  std::atomic<uint32_t> retransmits{0};
+  std::atomic<uint32_t> expired{0};
+  std::atomic<uint32_t> duplicates{0};
+  std::atomic<uint32_t> srtt_us{0};
+  std::atomic<uint32_t> rto_us{0};
+} nrf24_arq_metrics;
+#else
+#define RADIO_FRAME_SIZE BRIDGE_FRAME_SIZE
+#endif
+
+#if BRIDGE_FRAGMENT
+// 路由器在loop任务中发送分片，nRF24接收任务重组
+FragmentLink<RADIO_PAYLOAD_SIZE> nrf24_fragments{__nrf24_a};
+static_assert(BRIDGE_FRAME_SIZE <= decltype(nrf24_fragments)::max_frame_size, "frame does not fit in FRAGMENT_MAX_COUNT fragments");
+#endif
+
+#if BRIDGE_AGGREGATION
+#define UART_CHUNK_SIZE (RADIO_FRAME_SIZE - AGGREGATE_RECORD_HEADER_SIZE) // 预留记录长度字节
+FrameAggregator<RADIO_FRAME_SIZE> tx_aggregator{AGGREGATION_MAX_LATENCY_MS};
+#else
+#define UART_CHUNK_SIZE RADIO_FRAME_SIZE
+#endif
+
+using RadioPacketPool = PacketPool<BRIDGE_FRAME_SIZE, PACKET_POOL_SLOTS>;
+RadioPacketPool tx_pool;
+
+// 队列中只传递数据包句柄，句柄总数受数据包池限制，因此队列不会溢出
+// 串口数据由loop任务读入并转发，loop任务既是唯一的生产者也是唯一的消费者
+SpscRingQueue<RadioPacketPool::handle_t, PACKET_POOL_SLOTS> rx_queue;
+TaskHandle_t loop_task_handle = NULL; // 有新数据时通知loop任务
+
+#define UART_RX_BUFFER_SIZE 1024 // 串口驱动接收缓存，数据包池耗尽时由此缓冲
+
+SerialByteSource uart_source{Serial1};
+UartIngest<RadioPacketPool, decltype(rx_queue)> uart_ingest{uart_source, tx_pool, rx_queue, UART_CHUNK_SIZE};
+
+#define ROUTER_QUEUE_DEPTH 8 // 每个出口端口每个优先级的队列长度
+
+/// @brief 路由端口
+enum BridgePort : uint8_t
+{
+  PORT_UART,
+  PORT_NRF24,
+  PORT_SX1262,
+  PORT_COUNT,
+};
+
+/// @brief 路由优先级，控制帧严格优先于数据帧
+enum BridgeClass : uint8_t
+{
+  CLASS_CONTROL,
+  CLASS_BULK,
+  CLASS_COUNT,
+};
 
-// 定义队列长度
-#define QUEUE_CAPACITY 128
-#define LENGTH_QUEUE_CAPACITY 32
+// 串口和各射频接收任务同时输入，loop任务负责调度
+Router<PORT_COUNT, CLASS_COUNT, BRIDGE_FRAME_SIZE, ROUTER_QUEUE_DEPTH, std::mutex> router;
+SerialPort uart_port{Serial1};
+#if BRIDGE_ARQ
+LinkPort<decltype(nrf24_arq)> nrf24_port{nrf24_arq};
+#elif BRIDGE_FRAGMENT
+LinkPort<decltype(nrf24_fragments)> nrf24_port{nrf24_fragments};
+#else
+RadioPort nrf24_port{__nrf24_a};
+#endif
+RadioPort sx1262_port{__sx1262_a};
 
-utools::collab::SyncQueue<std::vector<uint8_t>, 3> rx_queue;
+// 统计快照通过USB CDC输出，每行一个InfluxDB line protocol记录
+MetricsRegistry<48> metrics{"bridge"};
+Gauge uart_queue_hwm;                          // 串口数据包队列深度的最大值
+Histogram<4> uart_frame_size{{8, 16, 24, 32}}; // 串口数据包长度分布
+
+#if NRF24_RATE_CONTROL
+/// @brief nRF24收到的速率控制帧，接收任务写入，loop任务处理（loop任务是nRF24发送队列唯一的生产者）
+struct RateFrame
+{
+  uint8_t data[RATE_CONTROL_FRAME_LEN];
+};
+SpscRingQueue<RateFrame, 4> nrf24_rate_frames;
+#endif
+
+TaskHandle_t radio_rx_task_handle = NULL;  // nRF24收到数据时通知接收任务
+TaskHandle_t sx1262_rx_task_handle = NULL; // SX1262收到数据时通知接收任务
+
+static uint8_t classify_frame(uint8_t, const uint8_t *data, size_t len)
+{
+  return control_match(data, len) ? CLASS_CONTROL : CLASS_BULK;
+}
 
 uint8_t parseProtocol(const uint8_t *data, size_t length);
-void handle_receive();
-// 串口1数据接收中断处理函数
-void IRAM_ATTR onReceive()
+#if !BRIDGE_ARQ
+static void radio_rx_task(void *);
+#endif
+static void sx1262_rx_task(void *);
+
+/// @brief 路由器统计需要加锁读取，在快照时调用
+template <BridgePort _Port>
+static int64_t router_dropped(void *)
+{
+  return router.stats(_Port).dropped;
+}
+
+template <BridgePort _Port>
+static int64_t router_pending(void *)
 {
-  size_t len = Serial1.available();
-  uint8_t buffer[128];
-  if (len > 0)
+  return router.pending(_Port);
+}
+
+/// @brief 注册需要导出的统计
+static void register_metrics()
+{
+  const auto &uart{uart_ingest.stats()};
+  metrics.add("uart_bytes", uart.bytes);
+  metrics.add("uart_packets", uart.packets);
+  metrics.add("uart_pool_exhausted", uart.pool_exhausted);
+  metrics.add("uart_overflows", uart.overflows);
+  metrics.add("uart_queue_hwm", uart_queue_hwm);
+  metrics.add("uart_frame_size", uart_frame_size);
+
+  const auto &nrf24_tx{__nrf24_a.tx_stats()};
+  const auto &nrf24_rx{__nrf24_a.rx_stats()};
+  metrics.add("nrf24_tx_queued", nrf24_tx.queued);
+  metrics.add("nrf24_tx_sent", nrf24_tx.sent);
+  metrics.add("nrf24_tx_failed", nrf24_tx.failed);
+  metrics.add("nrf24_tx_queue_hwm", nrf24_tx.max_depth);
+  metrics.add("nrf24_tx_latency_us", __nrf24_a.tx_latency());
+  metrics.add("nrf24_rx_received", nrf24_rx.received);
+  metrics.add("nrf24_rx_dropped", nrf24_rx.dropped);
+  metrics.add("nrf24_rx_failed", nrf24_rx.failed);
+#if NRF24_RATE_CONTROL
+  metrics.add_probe("nrf24_rate_level", nullptr, [](void *) -> int64_t
+                    { return nrf24_rate.level(); });
+  metrics.add_probe("nrf24_rate_loss_permille", nullptr, [](void *) -> int64_t
+                    { return nrf24_rate.loss_permille(); });
+  metrics.add_probe("nrf24_rate_switches", nullptr, [](void *) -> int64_t
+                    { return nrf24_rate.stats().switches; });
+  metrics.add_probe("nrf24_rate_reverts", nullptr, [](void *) -> int64_t
+                    { return nrf24_rate.stats().reverts; });
+#endif
+#if BRIDGE_ARQ
+  metrics.add("nrf24_arq_sent", nrf24_arq_metrics.sent);
+  metrics.add("nrf24_arq_retransmits", nrf24_arq_metrics.retransmits);
+  metrics.add("nrf24_arq_expired", nrf24_arq_metrics.expired);
+  metrics.add("nrf24_arq_duplicates", nrf24_arq_metrics.duplicates);
+  metrics.add("nrf24_arq_srtt_us", nrf24_arq_metrics.srtt_us);
+  metrics.add("nrf24_arq_rto_us", nrf24_arq_metrics.rto_us);
+#endif
+
+  const auto &sx1262_tx{__sx1262_a.tx_stats()};
+  const auto &sx1262_rx{__sx1262_a.rx_stats()};
+  metrics.add("sx1262_tx_queued", sx1262_tx.queued);
+  metrics.add("sx1262_tx_sent", sx1262_tx.sent);
+  metrics.add("sx1262_tx_failed", sx1262_tx.failed);
+  metrics.add("sx1262_tx_latency_us", __sx1262_a.tx_latency());
+  metrics.add("sx1262_rx_received", sx1262_rx.received);
+  metrics.add("sx1262_rx_dropped", sx1262_rx.dropped);
+  metrics.add("sx1262_rx_crc_errors", sx1262_rx.crc_errors);
+  metrics.add("sx1262_rx_failed", sx1262_rx.failed);
+  metrics.add("sx1262_rssi_x10", sx1262_rx.rssi_x10);
+#if SX1262_RATE_CONTROL
+  metrics.add_probe("sx1262_rate_level", nullptr, [](void *) -> int64_t
+                    { return sx1262_rate.level(); });
+  metrics.add_probe("sx1262_rate_loss_permille", nullptr, [](void *) -> int64_t
+                    { return sx1262_rate.loss_permille(); });
+  metrics.add_probe("sx1262_rate_switches", nullptr, [](void *) -> int64_t
+                    { return sx1262_rate.stats().switches; });
+  metrics.add_probe("sx1262_rate_reverts", nullptr, [](void *) -> int64_t
+                    { return sx1262_rate.stats().reverts; });
+#endif
+
+  metrics.add_probe("router_uart_pending", nullptr, router_pending<PORT_UART>);
+  metrics.add_probe("router_uart_dropped", nullptr, router_dropped<PORT_UART>);
+  metrics.add_probe("router_nrf24_pending", nullptr, router_pending<PORT_NRF24>);
+  metrics.add_probe("router_nrf24_dropped", nullptr, router_dropped<PORT_NRF24>);
+  metrics.add_probe("router_unrouted", nullptr, [](void *) -> int64_t
+                    { return router.unrouted(); });
+  metrics.add_probe("dlog_dropped", nullptr, [](void *) -> int64_t
+                    { return dlog.dropped(); });
+}
+
+// USB CDC由日志、延迟日志、统计快照和追踪导出共用，每次完整的输出期间持有此锁，不同来源的输出不会交错
+std::mutex usb_serial_lock;
+
+/// @brief 写入USB CDC，调用者需要持有usb_serial_lock
+static void usb_serial_write(const char *data, size_t len)
+{
+  Serial.write(reinterpret_cast<const uint8_t *>(data), len);
+}
+
+/// @brief 低优先级任务，格式化延迟日志并周期输出统计快照，两者都通过USB CDC输出
+static void telemetry_task(void *)
+{
+  TickType_t last_snapshot{xTaskGetTickCount()};
+  while (1)
+  {
+    {
+      std::lock_guard<std::mutex> lock{usb_serial_lock};
+      dlog_drain(usb_serial_write);
+    }
+    if (xTaskGetTickCount() - last_snapshot >= pdMS_TO_TICKS(METRICS_INTERVAL_MS))
+    {
+      last_snapshot += pdMS_TO_TICKS(METRICS_INTERVAL_MS);
+      std::lock_guard<std::mutex> lock{usb_serial_lock};
+      metrics.snapshot(usb_serial_write, millis());
+    }
+    vTaskDelay(pdMS_TO_TICKS(DLOG_DRAIN_INTERVAL_MS));
+  }
+}
+
+#if TRACE_ENABLED
+/// @brief 通过USB CDC导出追踪记录：收到'T'时输出Chrome trace JSON，收到'C'时清空
+static void trace_export_task(void *)
+{
+  while (1)
   {
-    size_t bytesRead = Serial1.read(buffer, len);
-    rx_queue.emplace(buffer, buffer + bytesRead); // 预先确认队列中有足够的空间存储数据
+    switch (Serial.read())
+    {
+    case 'T':
+    {
+      std::lock_guard<std::mutex> lock{usb_serial_lock};
+      trace_export_chrome(usb_serial_write);
+      break;
+    }
+    case 'C':
+      trace_clear();
+      break;
+    default:
+      vTaskDelay(pdMS_TO_TICKS(100));
+      break;
+    }
   }
 }
+#endif
+// 串口1数据接收回调，只通知loop任务读取：数据包池耗尽时loop任务释放槽位后可以立即继续读取
+void IRAM_ATTR onReceive()
+{
+  xTaskNotifyGive(loop_task_handle);
+}
 
 void setup()
 {
   Serial.begin(115200);
 
   utools::logger::set_log_fun([](const char *msg) -> void
-                              { Serial.print(msg); });
+                              {
+                                std::lock_guard<std::mutex> lock{usb_serial_lock};
+                                Serial.print(msg); });
   utools::logger::set_log_levels({utools::logger::level::INFO,
                                   utools::logger::level::TRACE,
                                   utools::logger::level::DEBUG,
@@ -50,34 +315,243 @@ void setup()
                                   utools::logger::level::FATAL});
   utools::logger_trace("utools configured.");
 
+  loop_task_handle = xTaskGetCurrentTaskHandle();
+  Serial1.setRxBufferSize(UART_RX_BUFFER_SIZE); // 需要在begin之前设置
   Serial1.begin(115200, SERIAL_8N1, 18, 17);
   Serial1.setRxTimeout(10);
   Serial1.onReceive(onReceive);
+  Serial1.onReceiveError([](hardwareSerial_error_t error)
+                         {
+                           if (error == UART_BUFFER_FULL_ERROR || error == UART_FIFO_OVF_ERROR)
+                           {
+                             uart_ingest.report_overflow();
+                           } });
+
+  router.attach(PORT_UART, &uart_port);
+  router.attach(PORT_NRF24, &nrf24_port);
+  router.attach(PORT_SX1262, &sx1262_port);
+  router.set_route(PORT_UART, 1UL << PORT_NRF24);
+  router.set_route(PORT_NRF24, 1UL << PORT_UART);
+  router.set_route(PORT_SX1262, 1UL << PORT_UART);
+  router.set_classifier(classify_frame);
+
+  register_metrics();
+  xTaskCreate(telemetry_task, "telemetry", 1024 * 4, NULL, 0, NULL);
+#if TRACE_ENABLED
+  xTaskCreate(trace_export_task, "trace_export", 1024 * 4, NULL, 0, NULL);
+#endif
 
   // 初始化 LoRa_24G
+#if BRIDGE_ARQ
+  // ARQ的收发和重发定时器都在loop任务中处理
+  __nrf24_a.set_rx_callback([]()
+                            { xTaskNotifyGive(loop_task_handle); });
+#else
+  xTaskCreate(radio_rx_task, "nRF24_rx", 1024 * 4, NULL, 2, &radio_rx_task_handle);
+  __nrf24_a.set_rx_callback([]()
+                            { xTaskNotifyGive(radio_rx_task_handle); });
+#endif
+  __nrf24_a.set_tx_callback([](bool, size_t)
+                            { xTaskNotifyGive(loop_task_handle); }); // 发送队列有空位时继续调度
   LoRa_24G_init();
   // 初始化 LoRa_900M
+  xTaskCreate(sx1262_rx_task, "SX1262_rx", 1024 * 4, NULL, 1, &sx1262_rx_task_handle);
+  __sx1262_a.set_rx_callback([]()
+                             { xTaskNotifyGive(sx1262_rx_task_handle); });
   LoRa_900M_init();
 }
 
-uint64_t receive_times = 0;
-void handle_receive()
+/// @brief 处理nRF24收到的一个数据包（启用ARQ时为按序交付的数据帧）：速率控制帧交给loop任务，其它数据交给路由器
+static void nrf24_input(const uint8_t *data, size_t len)
+{
+#if NRF24_RATE_CONTROL
+  if (Nrf24RateControl::match(data, len))
+  {
+    // 队列已满时丢弃，协商超时后对端会重发
+    RateFrame frame;
+    memcpy(frame.data, data, RATE_CONTROL_FRAME_LEN);
+    nrf24_rate_frames.push(frame);
+    return;
+  }
+#endif
+#if BRIDGE_FRAGMENT
+  nrf24_fragments.receive(data, len, millis(), [](const uint8_t *data, size_t len)
+                          { router.input(PORT_NRF24, data, len); });
+#elif BRIDGE_AGGREGATION
+  aggregate_split(data, len, [](const uint8_t *data, size_t len)
+                  { router.input(PORT_NRF24, data, len); });
+#else
+  router.input(PORT_NRF24, data, len);
+#endif
+}
+
+#if BRIDGE_ARQ
+/// @brief 在loop任务中处理nRF24收到的数据包，再发送ACK、重发和新的数据帧
+///        等待路由器出口队列时也需要调用，否则发送窗口满后不会再腾出空间
+static void nrf24_arq_service()
+{
+  const nRF24Device::RxPacket *packet{nullptr};
+  while ((packet = __nrf24_a.rx_front()) != nullptr)
+  {
+    TRACE_SET_CURRENT(packet->trace_id); // 按序交付的帧使用完成交付的数据包的标识
+    if (!nrf24_arq.receive(packet->data, packet->len, micros(), nrf24_input))
+    {
+      nrf24_input(packet->data, packet->len); // 速率控制帧不经过ARQ
+    }
+    __nrf24_a.rx_pop();
+  }
+  TRACE_SET_CURRENT(0);
+  nrf24_arq.poll(micros(), [](const uint8_t *data, size_t len)
+                 { return __nrf24_a.send_async(data, len); });
+
+  const auto &stats{nrf24_arq.stats()};
+  nrf24_arq_metrics.sent.store(stats.sent, std::memory_order_relaxed);
+  nrf24_arq_metrics.retransmits.store(stats.retransmits, std::memory_order_relaxed);
+  nrf24_arq_metrics.expired.store(stats.expired, std::memory_order_relaxed);
+  nrf24_arq_metrics.duplicates.store(stats.duplicates, std::memory_order_relaxed);
+  nrf24_arq_metrics.srtt_us.store(nrf24_arq.srtt_us(), std::memory_order_relaxed);
+  nrf24_arq_metrics.rto_us.store(nrf24_arq.rto_us(), std::memory_order_relaxed);
+}
+#else
+/// @brief 将nRF24收到的数据包交给路由器，数据直接从接收数据包池读取
+static void radio_rx_task(void *)
+{
+  while (1)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    const nRF24Device::RxPacket *packet{nullptr};
+    while ((packet = __nrf24_a.rx_front()) != nullptr)
+    {
+      TRACE_SET_CURRENT(packet->trace_id);
+      nrf24_input(packet->data, packet->len);
+      __nrf24_a.rx_pop();
+    }
+    TRACE_SET_CURRENT(0);
+    xTaskNotifyGive(loop_task_handle);
+  }
+}
+#endif
+
+/// @brief 处理SX1262收到的数据包：控制帧和速率控制帧在本地执行，其它数据按路由器的帧长度拆分后转发
+///        启用速率自适应时周期唤醒，发送心跳并处理协商超时
+static void sx1262_rx_task(void *)
 {
-  uint8_t *recv_buf{new uint8_t[128]{0}};
-  size_t recv_len{0};
+  while (1)
+  {
+#if SX1262_RATE_CONTROL
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SX1262_RATE_POLL_MS));
+#else
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+#endif
+    const SX1262Device::RxPacket *packet{nullptr};
+    while ((packet = __sx1262_a.rx_front()) != nullptr)
+    {
+#if SX1262_RATE_CONTROL
+      if (sx1262_rate.handle(packet->data, packet->len, millis()))
+      {
+        // 速率控制帧只在本地处理
+      }
+      else
+#endif
+      if (parseProtocol(packet->data, packet->len))
+      {
+        utools::logger_info("change channel success");
+      }
+      else
+      {
+        for (size_t offset = 0; offset < packet->len; offset += BRIDGE_FRAME_SIZE)
+        {
+          router.input(PORT_SX1262, packet->data + offset, std::min<size_t>(packet->len - offset, BRIDGE_FRAME_SIZE), packet->trace_id);
+        }
+      }
+      __sx1262_a.rx_pop();
+    }
+#if SX1262_RATE_CONTROL
+    sx1262_rate.poll(millis());
+#endif
+    xTaskNotifyGive(loop_task_handle);
+  }
+}
 
-  if (__nrf24_a.recv(recv_buf, recv_len))
+/// @brief 将串口数据交给路由器，nRF24出口队列已满时等待
+static void radio_send(const uint8_t *data, size_t len)
+{
+  const uint32_t trace_id{TRACE_CURRENT()}; // 等待时调度路由器会清除当前数据包
+  while (router.pending(PORT_NRF24) >= ROUTER_QUEUE_DEPTH)
   {
-    // 如果接收成功，则处理数据
-    Serial.println(receive_times++);
-    Serial.print("\t");
-    Serial.println(to_hex_str(recv_buf, recv_len).c_str());
+    if (router.service(PORT_NRF24) == 0)
+    {
+#if BRIDGE_ARQ
+      nrf24_arq_service(); // 收到ACK后发送窗口才有空间
+#endif
+      vTaskDelay(1); // 发送队列已满，等待收发任务腾出空间
+    }
   }
-  delete recv_buf;
+  router.input(PORT_UART, data, len, trace_id);
 }
 
 void loop()
 {
-  auto rx_data = rx_queue.pop_wait();
-  __nrf24_a.send(rx_data.data(), rx_data.size());
+  // 端口忙导致有帧未发出时，下一个tick重试
+  TickType_t wait_ticks{router.pending() > 0 ? 1 : portMAX_DELAY};
+#if BRIDGE_AGGREGATION
+  // 有未发送的合并数据时，最多等待到发送期限
+  auto wait_ms{tx_aggregator.time_to_deadline(millis())};
+  if (wait_ms != UINT32_MAX)
+  {
+    wait_ticks = std::min<TickType_t>(wait_ticks, pdMS_TO_TICKS(wait_ms));
+  }
+#endif
+#if NRF24_RATE_CONTROL
+  // 周期发送心跳并处理协商超时
+  wait_ticks = std::min<TickType_t>(wait_ticks, pdMS_TO_TICKS(NRF24_RATE_POLL_MS));
+#endif
+#if BRIDGE_ARQ
+  // 最多等待到下一个重发定时器到期，向上取整到tick
+  const auto arq_wait_us{nrf24_arq.time_to_next_us(micros())};
+  if (arq_wait_us != UINT32_MAX)
+  {
+    wait_ticks = std::min<TickType_t>(wait_ticks, pdMS_TO_TICKS(arq_wait_us / 1000 + 1));
+  }
+#endif
+  ulTaskNotifyTake(pdTRUE, wait_ticks);
+#if BRIDGE_ARQ
+  nrf24_arq_service();
+#endif
+  // 数据包池耗尽时剩余数据留在驱动缓存中，转发并释放槽位后继续读取，不等待下一次串口回调
+  do
+  {
+    uart_ingest.poll();
+    uart_queue_hwm.update_max(rx_queue.len());
+    RadioPacketPool::handle_t handle;
+    while (rx_queue.pop(handle))
+    {
+      auto &packet = tx_pool[handle];
+      TRACE_EVENT(DEQUEUE, packet.trace_id);
+      TRACE_SET_CURRENT(packet.trace_id); // radio_send通过路由器的默认参数取得标识
+      uart_frame_size.observe(packet.len);
+#if BRIDGE_AGGREGATION
+      tx_aggregator.append(packet.data, packet.len, millis(), radio_send);
+#else
+      radio_send(packet.data, packet.len);
+#endif
+      tx_pool.release(handle);
+    }
+    TRACE_SET_CURRENT(0);
+  } while (uart_ingest.stalled());
+#if BRIDGE_AGGREGATION
+  tx_aggregator.poll(millis(), radio_send);
+#endif
+#if NRF24_RATE_CONTROL
+  RateFrame frame;
+  while (nrf24_rate_frames.pop(frame))
+  {
+    nrf24_rate.handle(frame.data, sizeof(frame.data), millis());
+  }
+  nrf24_rate.poll(millis());
+#endif
+  router.poll();
+#if BRIDGE_ARQ
+  nrf24_arq_service(); // 发送路由器刚加入发送窗口的数据帧
+#endif
 }
@@ -4,14 +4,20 @@
 #include <mutex>
 #include <thread>
 #include <atomic>
+#include <cstring>
 
 #include "utools.h"
+#include "trace.hpp"
+#include "deferred_log.hpp"
+
+nRF24Device *nRF24Device::__irq_owner{nullptr};
 
 nRF24Device::nRF24Device(uint8_t spi_bus, int8_t sck, int8_t miso, int8_t mosi, int8_t ss, uint32_t irq, uint32_t rst)
 {
     __radio_spi = new SPIClass(spi_bus);
     __radio_spi->begin(sck, miso, mosi, ss);
-    __radio = new nRF24{new Module{static_cast<uint32_t>(ss), irq, rst, RADIOLIB_NC, *__radio_spi, __spi_setting}};
+    __radio_mod = new Module{static_cast<uint32_t>(ss), irq, rst, RADIOLIB_NC, *__radio_spi, __spi_setting};
+    __radio = new nRF24{__radio_mod};
 }
 
 nRF24Device::~nRF24Device()
@@ -20,6 +26,10 @@ nRF24Device::~nRF24Device()
     {
         delete __radio;
     }
+    if (__radio_mod)
+    {
+        delete __radio_mod;
+    }
     if (__radio_spi)
     {
         delete __radio_spi;
@@ -36,7 +46,7 @@ bool nRF24Device::init(int16_t freq, int16_t dr, int8_t pwr, uint8_t addrWidth)
         __radio->setCrcFiltering(false);
         __radio->setAutoAck(false);
         utools::logger_info("nRF24 device init success");
-        return true;
+        return __start_trx_engine();
     }
     utools::logger_error("nRF24 device init failed. error code:", status);
     return false;
@@ -44,65 +54,493 @@ bool nRF24Device::init(int16_t freq, int16_t dr, int8_t pwr, uint8_t addrWidth)
 
 bool nRF24Device::set_transmit_addr(uint8_t *addr)
 {
-    auto status{__radio->setTransmitPipe(addr)};
+    int16_t status;
+    {
+        std::lock_guard<std::mutex> lock{__lock};
+        status = __radio->setTransmitPipe(addr);
+    }
     utools::logger_info("set transmit addr:", utools::code::to_hex(addr, 5), "status:", status);
     return RADIOLIB_ERR_NONE == status;
 }
 
 bool nRF24Device::set_receive_addr(uint8_t pipe_num, uint8_t *addr)
 {
-    auto status{__radio->setReceivePipe(pipe_num, addr)};
+    int16_t status;
+    {
+        std::lock_guard<std::mutex> lock{__lock};
+        status = __radio->setReceivePipe(pipe_num, addr);
+        __rx_armed = false; // 使用新地址重新进入接收
+    }
+    __wake();
     utools::logger_info("set receive addr:pipe:", utools::code::to_hex(addr, 5), ":", pipe_num, "status:", status);
     return RADIOLIB_ERR_NONE == status;
 }
 
 bool nRF24Device::send(uint8_t *message, size_t size)
 {
-    auto status{__radio->transmit(message, size, 0)};
-    if (status == RADIOLIB_ERR_ACK_NOT_RECEIVED)
+    int16_t status;
     {
-        // static_cast<nRF24 *>(__radio)->clearIRQ();
-        ESP.restart();
+        std::lock_guard<std::mutex> lock{__lock};
+        status = __radio->transmit(message, size, 0);
+        if (status == RADIOLIB_ERR_ACK_NOT_RECEIVED)
+        {
+            // 达到最大重发次数，回到待机状态，下一次发送会重新清除中断标志
+            __radio->standby();
+        }
+        __rx_armed = false;
     }
-    utools::logger_info("send message:", utools::code::to_hex(message, size), "status:", status);
+    __wake();
+    DLOG_INFO_HEX("send message: status %d", message, size, status); // 由日志任务格式化，不阻塞发送
     return RADIOLIB_ERR_NONE == status;
 }
 
+bool nRF24Device::__start_trx_engine()
+{
+    if (__trx_task)
+    {
+        return true;
+    }
+    __irq_owner = this;
+    __radio->setIrqAction(__on_irq);
+    if (xTaskCreate(__trx_task_entry, "nRF24_trx", 1024 * 4, this, 2, &__trx_task) != pdPASS)
+    {
+        utools::logger_error("nRF24 trx engine: create task failed");
+        return false;
+    }
+    return true;
+}
+
+void IRAM_ATTR nRF24Device::__on_irq()
+{
+    BaseType_t woken{pdFALSE};
+    if (__irq_owner && __irq_owner->__trx_task)
+    {
+        xTaskNotifyFromISR(__irq_owner->__trx_task, __NOTIFY_IRQ, eSetBits, &woken);
+    }
+    portYIELD_FROM_ISR(woken);
+}
+
+void nRF24Device::__trx_task_entry(void *arg)
+{
+    static_cast<nRF24Device *>(arg)->__trx_loop();
+}
+
+void nRF24Device::__wake()
+{
+    if (__trx_task)
+    {
+        xTaskNotify(__trx_task, __NOTIFY_WAKE, eSetBits);
+    }
+}
+
+void nRF24Device::__clear_irq()
+{
+    // 不论是否有未处理的通知，进入和退出时都会清除IRQ位
+    xTaskNotifyWait(__NOTIFY_IRQ, __NOTIFY_IRQ, nullptr, 0);
+}
+
+bool nRF24Device::__wait_irq(TickType_t timeout)
+{
+    const TickType_t start{xTaskGetTickCount()};
+    uint32_t events{0};
+    while (!(events & __NOTIFY_IRQ))
+    {
+        const TickType_t elapsed{xTaskGetTickCount() - start};
+        // 只清除IRQ位，等待期间到达的唤醒通知保留到下一次等待
+        if (elapsed >= timeout || xTaskNotifyWait(0, __NOTIFY_IRQ, &events, timeout - elapsed) != pdTRUE)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void nRF24Device::__trx_loop()
+{
+    // 半双工调度：发送优先，发送队列为空时立即回到接收状态，
+    // 接收期间有新的发送请求时在两个数据包之间切换到发送
+    while (1)
+    {
+        __transmit_pending();
+        __receive_once();
+    }
+}
+
+void nRF24Device::__transmit_pending()
+{
+    if (__tx_queue.empty())
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock{__lock}; // 换频时等待这一批数据包发送完成
+    __drain_rx(); // startTransmit会清除RX_DR，先取出已经收到的数据包
+    __rx_armed = false;
+    // 已写入TX FIFO、等待TX_DS的数据包仍留在发送队列头部，完成后按顺序移除
+    uint32_t in_fifo{0};
+    bool started{false};
+    RingRegion<__TxPacket> first, second;
+    while (1)
+    {
+        const uint32_t queued{__tx_queue.read_regions(first, second)};
+        bool refused{false};
+        while (in_fifo < __FIFO_DEPTH && in_fifo < queued)
+        {
+            __TxPacket &packet{in_fifo < first.len ? first.data[in_fifo] : second.data[in_fifo - first.len]};
+            TRACE_EVENT(SPI_START, packet.trace_id);
+            if (started)
+            {
+                // CE保持高电平，芯片发完当前数据包后紧接着发送FIFO中的下一个
+                __radio_mod->SPIwriteStream(__CMD_W_TX_PAYLOAD, packet.data, packet.len, false, false);
+            }
+            else
+            {
+                __clear_irq(); // 清除上一次残留的中断
+                // 切换到发送状态、清空TX FIFO并拉高CE
+                if (__radio->startTransmit(packet.data, packet.len, 0) != RADIOLIB_ERR_NONE)
+                {
+                    __retire_tx(false);
+                    refused = true;
+                    break;
+                }
+                started = true;
+            }
+            ++in_fifo;
+        }
+        if (refused)
+        {
+            continue; // 发送队列头部已改变，重新获取读取区域
+        }
+        if (in_fifo == 0)
+        {
+            break;
+        }
+        // 未开启自动应答，TX_DS即表示数据已经发出
+        if (!__wait_irq(pdMS_TO_TICKS(NRF24_TX_TIMEOUT_MS)))
+        {
+            __radio_mod->SPIwriteStream(__CMD_FLUSH_TX, nullptr, 0, false, false);
+            for (; in_fifo > 0; --in_fifo)
+            {
+                __retire_tx(false);
+            }
+            continue;
+        }
+        // 先清除TX_DS再读FIFO_STATUS，清除之后发完的数据包会重新触发中断，不会漏计
+        const uint8_t status{__radio_mod->SPIreadRegister(__REG_STATUS)};
+        __radio_mod->SPIwriteRegister(__REG_STATUS, __STATUS_TX_DS | __STATUS_MAX_RT);
+        const uint8_t fifo_status{__radio_mod->SPIreadRegister(__REG_FIFO_STATUS)};
+        // 处理中断前连续发完的多个数据包只产生一次TX_DS，FIFO为空时全部完成；
+        // 上一批残留的中断通知没有对应的TX_DS，不移除数据包
+        uint32_t done{(status & __STATUS_TX_DS) ? 1U : 0U};
+        if (fifo_status & __FIFO_TX_EMPTY)
+        {
+            done = in_fifo;
+        }
+        for (; done > 0; --done, --in_fifo)
+        {
+            __retire_tx(true);
+        }
+    }
+    if (started)
+    {
+        __radio->finishTransmit();
+        __rx_stats.turnarounds.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void nRF24Device::__retire_tx(bool success)
+{
+    auto *packet{__tx_queue.front()};
+    TRACE_EVENT(AIR_DONE, packet->trace_id);
+    auto size{packet->len};
+    if (success)
+    {
+        __tx_latency.observe(micros() - packet->queued_us);
+    }
+    __tx_queue.pop();
+    (success ? __tx_stats.sent : __tx_stats.failed).fetch_add(1, std::memory_order_relaxed);
+    if (__tx_callback)
+    {
+        __tx_callback(success, size);
+    }
+}
+
+void nRF24Device::__receive_once()
+{
+    {
+        std::lock_guard<std::mutex> lock{__lock};
+        if (!__rx_armed)
+        {
+            __drain_rx(); // startReceive会清空RX FIFO，先取出换频等操作之前收到的数据包
+            auto status{__radio->startReceive()};
+            if (status != RADIOLIB_ERR_NONE)
+            {
+                utools::logger_error("nRF24 start receive failed. status:", status);
+                vTaskDelay(1);
+                return;
+            }
+            __rx_armed = true;
+        }
+    }
+    if (!__tx_queue.empty())
+    {
+        return; // 在进入接收期间有新的发送请求
+    }
+    // send_async在检查之后写入的数据包会留下未处理的通知，不会错过
+    uint32_t events{0};
+    xTaskNotifyWait(0, __NOTIFY_IRQ, &events, portMAX_DELAY);
+    if (events & __NOTIFY_IRQ)
+    {
+        std::lock_guard<std::mutex> lock{__lock};
+        if (__rx_armed)
+        {
+            __drain_rx();
+        }
+    }
+}
+
+void nRF24Device::__drain_rx()
+{
+    // readData之后芯片回到待机状态，不会再收到新的数据包，最多读取FIFO深度次
+    for (uint32_t i = 0; i < __FIFO_DEPTH; ++i)
+    {
+        if (__radio_mod->SPIreadRegister(__REG_FIFO_STATUS) & __FIFO_RX_EMPTY)
+        {
+            break;
+        }
+        __read_packet();
+    }
+    __clear_irq();
+}
+
+void nRF24Device::__read_packet()
+{
+    __rx_armed = false; // 读取数据时芯片回到待机状态
+    uint8_t discard[RADIOLIB_NRF24_MAX_PACKET_LENGTH];
+    auto handle{__rx_pool.acquire()};
+    auto *buffer{handle == RxPacketPool::invalid_handle ? discard : __rx_pool[handle].data};
+    size_t size{__radio->getPacketLength()};
+    if (size > RADIOLIB_NRF24_MAX_PACKET_LENGTH)
+    {
+        size = RADIOLIB_NRF24_MAX_PACKET_LENGTH;
+    }
+    // 数据包池耗尽时同样需要读出数据以清除RX_DR
+    auto status{__radio->readData(buffer, size)};
+    if (status != RADIOLIB_ERR_NONE || size == 0)
+    {
+        __rx_stats.failed.fetch_add(1, std::memory_order_relaxed);
+        __rx_pool.release(handle);
+        return;
+    }
+    if (handle == RxPacketPool::invalid_handle)
+    {
+        __rx_stats.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    __rx_pool[handle].trace_id = TRACE_NEW_ID();
+    TRACE_EVENT(RX_READ, __rx_pool[handle].trace_id);
+    __rx_pool[handle].len = static_cast<uint8_t>(size);
+    __rx_queue.push(handle);
+    __rx_stats.received.fetch_add(1, std::memory_order_relaxed);
+    if (__rx_callback)
+    {
+        __rx_callback();
+    }
+}
+
+bool nRF24Device::send_async(const uint8_t *message, size_t size)
+{
+    if (!__trx_task || size > RADIOLIB_NRF24_MAX_PACKET_LENGTH)
+    {
+        return false;
+    }
+    RingRegion<__TxPacket> first, second;
+    if (__tx_queue.write_regions(first, second) == 0)
+    {
+        return false;
+    }
+    first.data->queued_us = micros();
+    first.data->trace_id = TRACE_CURRENT();
+    first.data->len = static_cast<uint8_t>(size);
+    memcpy(first.data->data, message, size);
+    __tx_queue.commit_write(1);
+
+    __tx_stats.queued.fetch_add(1, std::memory_order_relaxed);
+    auto depth{__tx_queue.len()};
+    auto max_depth{__tx_stats.max_depth.load(std::memory_order_relaxed)};
+    if (depth > max_depth)
+    {
+        __tx_stats.max_depth.store(depth, std::memory_order_relaxed);
+    }
+    __wake();
+    return true;
+}
+
+const nRF24Device::RxPacket *nRF24Device::rx_front()
+{
+    auto *handle{__rx_queue.front()};
+    return handle ? &__rx_pool[*handle] : nullptr;
+}
+
+void nRF24Device::rx_pop()
+{
+    RxPacketPool::handle_t handle;
+    if (__rx_queue.pop(handle))
+    {
+        __rx_pool.release(handle);
+    }
+}
+
 bool nRF24Device::recv(uint8_t *buffer, size_t &size)
 {
-    size = __radio->getPacketLength(); // 最大数据包长度
-    int status = __radio->receive(buffer, size);
+    auto *packet{rx_front()};
+    if (!packet)
+    {
+        size = 0;
+        return false;
+    }
+    size = packet->len;
+    memcpy(buffer, packet->data, size);
+    rx_pop();
+    return true;
+}
 
-    if (status == RADIOLIB_ERR_NONE)
+uint32_t nRF24Device::set_frequency(uint32_t frequency)
+{
+    uint32_t result;
     {
-        return true;
+        std::lock_guard<std::mutex> lock{__lock};
+        result = __set_frequency(frequency);
     }
-    return false;
+    __wake();
+    return result;
+}
+
+uint32_t nRF24Device::retune(uint32_t frequency_hz)
+{
+    auto start{micros()};
+    decltype(start) locked, done;
+    uint32_t result;
+    {
+        std::lock_guard<std::mutex> lock{__lock}; // 等待正在进行的发送完成后暂停收发
+        locked = micros();
+        result = __set_frequency(frequency_hz);
+        done = micros();
+    }
+    __wake();
+    utools::logger_info("retune:", frequency_hz, "wait tx(us):", locked - start, "outage(us):", done - locked);
+    return result;
 }
 
-int32_t nRF24Device::set_frequency(uint32_t frequency)
+uint32_t nRF24Device::__set_frequency(uint32_t frequency)
 {
-    return __radio->setFrequency(frequency / 1000000);
+    // 在待机状态下修改RF_CH即可生效，不进入掉电模式，避免约1.5ms的晶振重新起振时间
+    auto status{__radio->standby()};
+    __rx_armed = false; // 由收发任务在新信道上重新进入接收
+    if (status == RADIOLIB_ERR_NONE)
+    {
+        status = __radio->setFrequency(frequency / 1000000);
+    }
+    if (status != RADIOLIB_ERR_NONE)
+    {
+        utools::logger_error("set frequency failed:", frequency, "status:", status);
+        return 0;
+    }
+    return frequency / 1000000 * 1000000;
 }
 
 uint8_t nRF24Device::set_power(uint8_t power)
 {
-    return 0;
+    int16_t status;
+    {
+        std::lock_guard<std::mutex> lock{__lock};
+        // 写RF_SETUP前回到待机状态，由收发任务重新进入接收
+        status = __radio->standby();
+        __rx_armed = false;
+        if (status == RADIOLIB_ERR_NONE)
+        {
+            status = __radio->setOutputPower(static_cast<int8_t>(power));
+        }
+    }
+    __wake();
+    if (status != RADIOLIB_ERR_NONE)
+    {
+        utools::logger_error("nRF24 set power failed:", static_cast<int8_t>(power), "status:", status);
+        return 0;
+    }
+    return power;
 }
 
 uint32_t nRF24Device::set_data_rate(uint32_t rate)
 {
-    // return __radio->setDataRate(rate);
-    return 0;
+    int16_t status;
+    {
+        std::lock_guard<std::mutex> lock{__lock};
+        status = __radio->standby();
+        __rx_armed = false;
+        if (status == RADIOLIB_ERR_NONE)
+        {
+            status = __radio->setDataRate(static_cast<int16_t>(rate));
+        }
+    }
+    __wake();
+    if (status != RADIOLIB_ERR_NONE)
+    {
+        utools::logger_error("nRF24 set data rate failed:", rate, "status:", status);
+        return 0;
+    }
+    return rate;
 }
 
 uint8_t nRF24Device::set_addr_width(uint8_t addr_width)
 {
-    return 0;
+    int16_t status;
+    {
+        std::lock_guard<std::mutex> lock{__lock};
+        status = __radio->standby();
+        __rx_armed = false;
+        if (status == RADIOLIB_ERR_NONE)
+        {
+            status = __radio->setAddressWidth(addr_width);
+        }
+    }
+    __wake();
+    if (status != RADIOLIB_ERR_NONE)
+    {
+        utools::logger_error("nRF24 set address width failed:", addr_width, "status:", status);
+        return 0;
+    }
+    return addr_width;
+}
+
+bool nRF24Device::set_link_profile(uint16_t data_rate_kbps, int8_t power_dbm)
+{
+    int16_t status;
+    {
+        std::lock_guard<std::mutex> lock{__lock}; // 等待正在进行的发送完成
+        status = __radio->standby();
+        __rx_armed = false;
+        if (status == RADIOLIB_ERR_NONE)
+        {
+            status = __radio->setDataRate(static_cast<int16_t>(data_rate_kbps));
+        }
+        if (status == RADIOLIB_ERR_NONE)
+        {
+            status = __radio->setOutputPower(power_dbm);
+        }
+    }
+    __wake();
+    if (status != RADIOLIB_ERR_NONE)
+    {
+        utools::logger_error("nRF24 set link profile failed. status:", status);
+        return false;
+    }
+    return true;
 }
 
 bool nRF24Device::shutdown()
 {
+    std::lock_guard<std::mutex> lock{__lock};
+    __rx_armed = false;
     return RADIOLIB_ERR_NONE == __radio->sleep();
 }
 
@@ -0,0 +1,297 @@
+/// @brief Linux上运行的转发程序：两个节点分别通过伪终端收发串口数据，经模拟信道互相转发
+///        串口 A <-> 节点A <-> SimRadio A ~~ 模拟信道 ~~ SimRadio B <-> 节点B <-> 串口 B
+///        使用串口工具打开输出的两个从设备即可测量端到端吞吐量和时延
+
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <thread>
+
+#include "sim_bridge.h"
+
+#define POLL_INTERVAL_US 100
+
+#ifndef PIO_UNIT_TESTING // pio test编译src时由test/中的测试程序提供main
+static volatile std::sig_atomic_t running{1};
+
+static const char *const known_options[]{
+    "--radio", "--bitrate", "--loss", "--latency-us", "--mtu", "--seed", "--trace",
+    "--distance", "--distance-end", "--sweep-s", "--path-loss-exp", "--fading-db", "--tx-power",
+    "--rate-control", "--arq", "--goodput", "--goodput-timeout-s",
+    "--loopback", "--loopback-interval-ms", "--loopback-timeout-ms",
+    "--hop-ms", "--hop-skew-us", "--hop-deadline-us", "--hop-duration-s",
+};
+
+/// @brief 检查所有参数都是形如--name=value的已知参数，拼错的参数不会被静默忽略
+static bool options_valid(int argc, char **argv)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    const char *equal{strchr(argv[i], '=')};
+    bool known{false};
+    for (const char *name : known_options)
+    {
+      known = known || (equal && strncmp(argv[i], name, equal - argv[i]) == 0 && name[equal - argv[i]] == '\0');
+    }
+    if (!known)
+    {
+      fprintf(stderr, "unknown option: %s\n", argv[i]);
+      return false;
+    }
+  }
+  return true;
+}
+
+/// @brief 解析形如--name=value的参数
+static const char *option(int argc, char **argv, const char *name)
+{
+  const size_t len{strlen(name)};
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strncmp(argv[i], name, len) == 0 && argv[i][len] == '=')
+    {
+      return argv[i] + len + 1;
+    }
+  }
+  return nullptr;
+}
+
+int main(int argc, char **argv)
+{
+  SimRadio::Config config;
+  uint32_t seed{1};
+  if (auto value = option(argc, argv, "--bitrate"))
+  {
+    config.bitrate_bps = strtoul(value, nullptr, 10);
+  }
+  if (auto value = option(argc, argv, "--loss"))
+  {
+    config.loss = strtod(value, nullptr);
+  }
+  if (auto value = option(argc, argv, "--latency-us"))
+  {
+    config.latency_us = strtoul(value, nullptr, 10);
+  }
+  if (auto value = option(argc, argv, "--mtu"))
+  {
+    config.mtu = strtoul(value, nullptr, 10);
+  }
+  if (auto value = option(argc, argv, "--seed"))
+  {
+    seed = strtoul(value, nullptr, 10);
+  }
+  const char *trace_path{option(argc, argv, "--trace")};
+  // nrf24：2.4 GHz路径损耗，0 dBm发射功率，噪声系数按数据手册的灵敏度（1 Mbps时-85 dBm）折算
+  const char *radio_value{option(argc, argv, "--radio")};
+  const bool nrf24{radio_value && strcmp(radio_value, "nrf24") == 0};
+  if (nrf24)
+  {
+    config.tx_power_dbm = 0.0;
+    config.noise_figure_db = 16.0;
+  }
+  const double frequency_mhz{nrf24 ? 2402.0 : 915.0};
+  // 路径损耗模型：距离在distance和distance-end之间按对数刻度往返变化，一个单程为sweep-s秒
+  const char *distance_value{option(argc, argv, "--distance")};
+  const double distance{distance_value ? strtod(distance_value, nullptr) : 0.0};
+  const char *distance_end_value{option(argc, argv, "--distance-end")};
+  const double distance_end{distance_end_value ? strtod(distance_end_value, nullptr) : distance};
+  const char *sweep_value{option(argc, argv, "--sweep-s")};
+  const double sweep_s{sweep_value ? strtod(sweep_value, nullptr) : 60.0};
+  const char *exponent_value{option(argc, argv, "--path-loss-exp")};
+  const double exponent{exponent_value ? strtod(exponent_value, nullptr) : 2.7};
+  const char *fading_value{option(argc, argv, "--fading-db")};
+  const double fading_db{fading_value ? strtod(fading_value, nullptr) : 0.0};
+  if (auto value = option(argc, argv, "--tx-power"))
+  {
+    config.tx_power_dbm = strtod(value, nullptr);
+  }
+  const char *rate_control_value{option(argc, argv, "--rate-control")};
+  const bool rate_control{rate_control_value && strtoul(rate_control_value, nullptr, 10) != 0};
+  const char *arq_value{option(argc, argv, "--arq")};
+  const bool arq{arq_value && strtoul(arq_value, nullptr, 10) != 0};
+  // 吞吐量测试：从串口A写入指定字节数，串口B全部收到或超时后输出结果并退出
+  const char *goodput_value{option(argc, argv, "--goodput")};
+  const size_t goodput_bytes{goodput_value ? strtoul(goodput_value, nullptr, 10) : 0};
+  const char *goodput_timeout_value{option(argc, argv, "--goodput-timeout-s")};
+  const double goodput_timeout_s{goodput_timeout_value ? strtod(goodput_timeout_value, nullptr) : 60.0};
+  // 环回时延测试：串口B把收到的数据写回，从串口A发送count个探测帧，全部返回或超时后输出往返时延并退出
+  const char *loopback_value{option(argc, argv, "--loopback")};
+  const uint32_t loopback_count{loopback_value ? static_cast<uint32_t>(strtoul(loopback_value, nullptr, 10)) : 0};
+  const char *loopback_interval_value{option(argc, argv, "--loopback-interval-ms")};
+  const uint32_t loopback_interval_ms{loopback_interval_value ? static_cast<uint32_t>(strtoul(loopback_interval_value, nullptr, 10)) : 10};
+  const char *loopback_timeout_value{option(argc, argv, "--loopback-timeout-ms")};
+  const uint32_t loopback_timeout_ms{loopback_timeout_value ? static_cast<uint32_t>(strtoul(loopback_timeout_value, nullptr, 10)) : 500};
+  // 跳频测试：不启动转发节点，两个设备按hop-ms跳频，运行hop-duration-s秒后输出丢失和迟到的帧数并退出
+  const char *hop_value{option(argc, argv, "--hop-ms")};
+  HopTest::Config hop_config;
+  hop_config.hop_interval_us = hop_value ? strtoul(hop_value, nullptr, 10) * 1000 : 0;
+  if (auto value = option(argc, argv, "--hop-skew-us"))
+  {
+    hop_config.skew_us = strtoul(value, nullptr, 10);
+  }
+  if (auto value = option(argc, argv, "--hop-deadline-us"))
+  {
+    hop_config.deadline_us = strtoul(value, nullptr, 10);
+  }
+  const char *hop_duration_value{option(argc, argv, "--hop-duration-s")};
+  const double hop_duration_s{hop_duration_value ? strtod(hop_duration_value, nullptr) : 10.0};
+  if (!options_valid(argc, argv) || config.bitrate_bps == 0 || config.mtu == 0 || config.mtu > RADIO_PAYLOAD_SIZE || (arq && config.mtu < ARQ_ACK_SIZE) ||
+      (goodput_value && (goodput_bytes == 0 || goodput_timeout_s <= 0.0)) ||
+      (loopback_value && (loopback_count == 0 || loopback_timeout_ms == 0 || goodput_value)) ||
+      (hop_value && (hop_config.hop_interval_us == 0 || hop_duration_s <= 0.0)) ||
+      (distance_value && (distance < 1.0 || distance_end < 1.0 || sweep_s <= 0.0)) ||
+      (radio_value && !nrf24 && strcmp(radio_value, "sx1262") != 0))
+  {
+    fprintf(stderr, "usage: %s [--radio=sx1262|nrf24] [--bitrate=bps] [--loss=0..1] [--latency-us=us] [--mtu=1..%d] [--seed=n] [--trace=file]\n"
+                    "          [--distance=m [--distance-end=m] [--sweep-s=s] [--path-loss-exp=n] [--fading-db=db] [--tx-power=dBm]]\n"
+                    "          [--rate-control=1] [--arq=1] [--goodput=bytes [--goodput-timeout-s=s]]\n"
+                    "          [--loopback=count [--loopback-interval-ms=ms] [--loopback-timeout-ms=ms]]\n"
+                    "          [--hop-ms=ms [--hop-skew-us=us] [--hop-deadline-us=us] [--hop-duration-s=s]]\n",
+            argv[0], RADIO_PAYLOAD_SIZE);
+    return 1;
+  }
+
+  SimMedium medium{seed};
+  if (hop_value)
+  {
+    hop_config.frame_size = config.mtu;
+    HopTest hop{medium, config, hop_config};
+    const auto start{std::chrono::steady_clock::now()};
+    double elapsed_s{0.0};
+    while ((elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()) < hop_duration_s + 0.05)
+    {
+      hop.poll(static_cast<uint32_t>(elapsed_s * 1000000), elapsed_s < hop_duration_s); // 最后50ms只接收
+      std::this_thread::sleep_for(std::chrono::microseconds(POLL_INTERVAL_US));
+    }
+    const auto report{hop.report()};
+    printf("hop interval_ms=%lu,skew_us=%lu,hops=%lu,sent=%lu,received=%lu,dropped=%lu,retune_dropped=%lu,late=%lu,max_latency_us=%lu\n",
+           static_cast<unsigned long>(hop_config.hop_interval_us / 1000), static_cast<unsigned long>(hop_config.skew_us),
+           static_cast<unsigned long>(report.hops), static_cast<unsigned long>(report.sent), static_cast<unsigned long>(report.received),
+           static_cast<unsigned long>(report.dropped), static_cast<unsigned long>(report.retune_dropped),
+           static_cast<unsigned long>(report.late), static_cast<unsigned long>(report.max_latency_us));
+    return 0;
+  }
+  SimBridge node_a{"A", medium, config, arq};
+  SimBridge node_b{"B", medium, config, arq};
+  if (!node_a.open() || !node_b.open())
+  {
+    perror("open pty");
+    return 1;
+  }
+  std::optional<GoodputTest> goodput;
+  if (goodput_value)
+  {
+    goodput.emplace(goodput_bytes, seed);
+    if (!goodput->open(node_a.serial_name(), node_b.serial_name()))
+    {
+      perror("open goodput pty");
+      return 1;
+    }
+  }
+  std::optional<LoopbackTest> loopback;
+  if (loopback_value)
+  {
+    loopback.emplace(loopback_count, loopback_interval_ms * 1000, loopback_timeout_ms * 1000);
+    if (!loopback->open(node_a.serial_name(), node_b.serial_name()))
+    {
+      perror("open loopback pty");
+      return 1;
+    }
+  }
+  if (rate_control)
+  {
+    if (nrf24)
+    {
+      node_a.enable_nrf24_rate_control(true);
+      node_b.enable_nrf24_rate_control(false);
+    }
+    else
+    {
+      node_a.enable_fsk_rate_control(true);
+      node_b.enable_fsk_rate_control(false);
+    }
+  }
+  fflush(stdout);
+  signal(SIGINT, [](int)
+         { running = 0; });
+
+  const auto start{std::chrono::steady_clock::now()};
+  auto next_report{start + std::chrono::seconds(1)};
+  double distance_now{distance};
+  int status{0};
+  while (running)
+  {
+    const auto now{std::chrono::steady_clock::now()};
+    const double elapsed_s{std::chrono::duration<double>(now - start).count()};
+    if (distance_value)
+    {
+      const double phase{std::fmod(elapsed_s / sweep_s, 2.0)};
+      distance_now = distance * std::pow(distance_end / distance, phase < 1.0 ? phase : 2.0 - phase);
+      medium.set_path_loss(sim_path_loss_db(distance_now, exponent, frequency_mhz), fading_db);
+    }
+    const uint32_t now_ms{static_cast<uint32_t>(elapsed_s * 1000)};
+    const uint32_t now_us{static_cast<uint32_t>(elapsed_s * 1000000)};
+    node_a.poll(now_ms, now_us);
+    node_b.poll(now_ms, now_us);
+    if (goodput)
+    {
+      goodput->poll();
+      if (goodput->done() || elapsed_s >= goodput_timeout_s)
+      {
+        // 统计包括伪终端的缓存时间，与串口工具测得的端到端吞吐量一致
+        printf("goodput bytes=%zu,received=%zu,intact=%d,elapsed_ms=%.0f,goodput_bps=%.0f\n", goodput_bytes,
+               goodput->received(), goodput->intact(), elapsed_s * 1000, goodput->received() * 8 / elapsed_s);
+        status = goodput->intact() ? 0 : 2;
+        running = 0;
+      }
+    }
+    if (loopback)
+    {
+      loopback->poll(now_us);
+      if (loopback->done())
+      {
+        const auto report{loopback->report()};
+        printf("loopback sent=%lu,received=%lu,lost=%lu,min_us=%lu,mean_us=%lu,p99_us=%lu,max_us=%lu\n",
+               static_cast<unsigned long>(report.sent), static_cast<unsigned long>(report.received),
+               static_cast<unsigned long>(report.lost), static_cast<unsigned long>(report.min_us),
+               static_cast<unsigned long>(report.mean_us), static_cast<unsigned long>(report.p99_us),
+               static_cast<unsigned long>(report.max_us));
+        status = report.received ? 0 : 2;
+        running = 0;
+      }
+    }
+    if (now >= next_report)
+    {
+      if (distance_value)
+      {
+        fprintf(stderr, "medium distance_m=%.0f,path_loss_db=%.1f\n", distance_now, sim_path_loss_db(distance_now, exponent, frequency_mhz));
+      }
+      const auto uptime{std::chrono::duration_cast<std::chrono::milliseconds>(next_report - start).count()};
+      node_a.print_stats(static_cast<uint32_t>(uptime));
+      node_b.print_stats(static_cast<uint32_t>(uptime));
+      next_report += std::chrono::seconds(1);
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(POLL_INTERVAL_US));
+  }
+
+#if TRACE_ENABLED
+  // 退出时把追踪记录写入文件，用chrome://tracing或Perfetto打开
+  if (trace_path)
+  {
+    if (FILE *file = fopen(trace_path, "w"))
+    {
+      trace_export_chrome([file](const char *data, size_t len)
+                          { fwrite(data, 1, len, file); });
+      fclose(file);
+    }
+  }
+#else
+  (void)trace_path;
+#endif
+  return status;
+}
+#endif // PIO_UNIT_TESTING
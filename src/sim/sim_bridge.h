@@ -0,0 +1,703 @@
+/// @brief 模拟转发节点、吞吐量测试、环回时延测试和跳频测试，由Linux上的转发程序和host测试共用
+
+#ifndef __SIM_BRIDGE_H__
+#define __SIM_BRIDGE_H__
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+#include "packet_pool.hpp"
+#include "spsc_queue.hpp"
+#include "router.hpp"
+#include "uart_ingest.h"
+#include "router_ports.h"
+#include "control_protocol.h"
+#include "pty_serial.h"
+#include "sim_radio.h"
+#include "trace.hpp"
+#include "metrics.hpp"
+#include "rate_control.h"
+#include "fsk_profiles.h"
+#include "nrf24_profiles.h"
+#include "arq.hpp"
+
+#define RADIO_PAYLOAD_SIZE 32 // 与nRF24单包最大长度一致
+#define PACKET_POOL_SLOTS 16
+#define ROUTER_QUEUE_DEPTH 8
+
+enum BridgePort : uint8_t
+{
+  PORT_UART,
+  PORT_RADIO,
+  PORT_COUNT,
+};
+
+enum BridgeClass : uint8_t
+{
+  CLASS_CONTROL,
+  CLASS_BULK,
+  CLASS_COUNT,
+};
+
+inline uint8_t classify_frame(uint8_t, const uint8_t *data, size_t len)
+{
+  return control_match(data, len) ? CLASS_CONTROL : CLASS_BULK;
+}
+
+/// @brief 一个转发节点，与main.cpp中的串口/nRF24转发使用相同的组件，在单个线程中轮询
+class SimBridge
+{
+private:
+  using Pool = PacketPool<RADIO_PAYLOAD_SIZE, PACKET_POOL_SLOTS>;
+  using Queue = SpscRingQueue<Pool::handle_t, PACKET_POOL_SLOTS>;
+  using FskRate = RateControl<FSK_PROFILE_COUNT>;
+  using Nrf24Rate = RateControl<NRF24_PROFILE_COUNT>;
+  using Arq = ArqLink<RADIO_PAYLOAD_SIZE>;
+
+  PtySerial __uart;
+  SimRadio __radio;
+  Pool __pool;
+  Queue __queue;
+  FdByteSource __source;
+  UartIngest<Pool, Queue> __ingest;
+  Router<PORT_COUNT, CLASS_COUNT, RADIO_PAYLOAD_SIZE, ROUTER_QUEUE_DEPTH> __router;
+  FdPort __uart_port;
+  RadioPort __radio_port;
+  std::optional<Arq> __arq;
+  std::optional<LinkPort<Arq>> __arq_port;
+  const char *__name;
+  char __measurement[32];
+  MetricsRegistry<40> __metrics;
+  Gauge __uart_queue_hwm;
+  Histogram<4> __uart_frame_size{{8, 16, 24, 32}};
+  std::optional<FskRate> __fsk_rate;
+  std::optional<Nrf24Rate> __nrf24_rate;
+
+  /// @brief 在构造__metrics之前格式化measurement，注册表只保存其地址
+  static const char *__format_measurement(char (&dst)[sizeof(__measurement)], const char *name)
+  {
+    snprintf(dst, sizeof(dst), "bridge,node=%s", name);
+    return dst;
+  }
+
+  static uint32_t __fsk_bps(uint8_t level)
+  {
+    return static_cast<uint32_t>(fsk_profiles[level].bitrate_kbps * 1000);
+  }
+
+  /// @brief 与设备相同，nRF24通过set_data_rate和set_power切换档位
+  static void __apply_nrf24(SimRadio &radio, uint8_t level)
+  {
+    radio.set_data_rate(nrf24_profiles[level].data_rate_kbps);
+    radio.set_power(static_cast<uint8_t>(nrf24_profiles[level].power_dbm));
+  }
+
+  /// @brief 两种射频使用相同的指标名称
+  template <typename _Rate>
+  void __register_rate_metrics(_Rate &rate)
+  {
+    __metrics.add_probe("rate_level", &rate, [](void *ctx) -> int64_t
+                        { return static_cast<_Rate *>(ctx)->level(); });
+    __metrics.add_probe("rate_recommend", &rate, [](void *ctx) -> int64_t
+                        { return static_cast<_Rate *>(ctx)->recommend(); });
+    __metrics.add_probe("rate_loss_permille", &rate, [](void *ctx) -> int64_t
+                        { return static_cast<_Rate *>(ctx)->loss_permille(); });
+    __metrics.add_probe("rate_rssi_x10", &rate, [](void *ctx) -> int64_t
+                        { return static_cast<_Rate *>(ctx)->rssi_x10(); });
+    __metrics.add_probe("rate_switches", &rate, [](void *ctx) -> int64_t
+                        { return static_cast<_Rate *>(ctx)->stats().switches; });
+    __metrics.add_probe("radio_rx_crc_errors", this, [](void *ctx) -> int64_t
+                        { return static_cast<SimBridge *>(ctx)->__radio.stats().crc_errors; });
+    __metrics.add_probe("radio_bitrate_bps", this, [](void *ctx) -> int64_t
+                        { return static_cast<SimBridge *>(ctx)->__radio.bitrate_bps(); });
+    __metrics.add_probe("radio_tx_power_dbm", this, [](void *ctx) -> int64_t
+                        { return std::lround(static_cast<SimBridge *>(ctx)->__radio.tx_power_dbm()); });
+  }
+
+  void __register_arq_metrics()
+  {
+    __metrics.add_probe("arq_sent", this, [](void *ctx) -> int64_t
+                        { return static_cast<SimBridge *>(ctx)->__arq->stats().sent; });
+    __metrics.add_probe("arq_retransmits", this, [](void *ctx) -> int64_t
+                        { return static_cast<SimBridge *>(ctx)->__arq->stats().retransmits; });
+    __metrics.add_probe("arq_fast_retransmits", this, [](void *ctx) -> int64_t
+                        { return static_cast<SimBridge *>(ctx)->__arq->stats().fast_retransmits; });
+    __metrics.add_probe("arq_expired", this, [](void *ctx) -> int64_t
+                        { return static_cast<SimBridge *>(ctx)->__arq->stats().expired; });
+    __metrics.add_probe("arq_delivered", this, [](void *ctx) -> int64_t
+                        { return static_cast<SimBridge *>(ctx)->__arq->stats().delivered; });
+    __metrics.add_probe("arq_duplicates", this, [](void *ctx) -> int64_t
+                        { return static_cast<SimBridge *>(ctx)->__arq->stats().duplicates; });
+    __metrics.add_probe("arq_srtt_us", this, [](void *ctx) -> int64_t
+                        { return static_cast<SimBridge *>(ctx)->__arq->srtt_us(); });
+    __metrics.add_probe("arq_rto_us", this, [](void *ctx) -> int64_t
+                        { return static_cast<SimBridge *>(ctx)->__arq->rto_us(); });
+  }
+
+  /// @brief 与main.cpp使用相同的指标名称，射频统计来自SimRadio
+  void __register_metrics()
+  {
+    const auto &uart{__ingest.stats()};
+    __metrics.add("uart_bytes", uart.bytes);
+    __metrics.add("uart_packets", uart.packets);
+    __metrics.add("uart_pool_exhausted", uart.pool_exhausted);
+    __metrics.add("uart_queue_hwm", __uart_queue_hwm);
+    __metrics.add("uart_frame_size", __uart_frame_size);
+    __metrics.add_probe("radio_tx_sent", this, [](void *ctx) -> int64_t
+                        { return static_cast<SimBridge *>(ctx)->__radio.stats().sent; });
+    __metrics.add_probe("radio_tx_busy", this, [](void *ctx) -> int64_t
+                        { return static_cast<SimBridge *>(ctx)->__radio.stats().busy; });
+    __metrics.add_probe("radio_rx_received", this, [](void *ctx) -> int64_t
+                        { return static_cast<SimBridge *>(ctx)->__radio.stats().received; });
+    __metrics.add_probe("radio_rx_lost", this, [](void *ctx) -> int64_t
+                        { return static_cast<SimBridge *>(ctx)->__radio.stats().lost; });
+    __metrics.add_probe("radio_airtime_us", this, [](void *ctx) -> int64_t
+                        { return static_cast<SimBridge *>(ctx)->__radio.stats().airtime_us; });
+    __metrics.add_probe("router_uart_pending", this, [](void *ctx) -> int64_t
+                        { return static_cast<SimBridge *>(ctx)->__router.pending(PORT_UART); });
+    __metrics.add_probe("router_uart_dropped", this, [](void *ctx) -> int64_t
+                        { return static_cast<SimBridge *>(ctx)->__router.stats(PORT_UART).dropped; });
+    __metrics.add_probe("router_radio_pending", this, [](void *ctx) -> int64_t
+                        { return static_cast<SimBridge *>(ctx)->__router.pending(PORT_RADIO); });
+    __metrics.add_probe("router_radio_dropped", this, [](void *ctx) -> int64_t
+                        { return static_cast<SimBridge *>(ctx)->__router.stats(PORT_RADIO).dropped; });
+    __metrics.add_probe("router_unrouted", this, [](void *ctx) -> int64_t
+                        { return static_cast<SimBridge *>(ctx)->__router.unrouted(); });
+  }
+
+public:
+  /// @param arq 是否通过ArqLink可靠传输，两个节点必须相同；启用时每包的数据减少ARQ_HEADER_SIZE字节
+  SimBridge(const char *name, SimMedium &medium, const SimRadio::Config &config, bool arq = false)
+      : __radio(medium, config), __source(-1), __ingest(__source, __pool, __queue, arq ? config.mtu - ARQ_HEADER_SIZE : config.mtu),
+        __uart_port(-1), __radio_port(__radio), __name(name),
+        __metrics(__format_measurement(__measurement, name))
+  {
+    __register_metrics();
+    if (arq)
+    {
+      __arq.emplace();
+      __arq_port.emplace(*__arq);
+      __register_arq_metrics();
+    }
+  }
+
+  bool open()
+  {
+    if (!__uart.open())
+    {
+      return false;
+    }
+    __source = FdByteSource{__uart.fd()};
+    __uart_port = FdPort{__uart.fd()};
+    __router.attach(PORT_UART, &__uart_port);
+    __router.attach(PORT_RADIO, __arq_port ? static_cast<RouterPort *>(&*__arq_port) : &__radio_port);
+    __router.set_route(PORT_UART, 1UL << PORT_RADIO);
+    __router.set_route(PORT_RADIO, 1UL << PORT_UART);
+    __router.set_classifier(classify_frame);
+    printf("%s: serial %s\n", __name, __uart.slave_name());
+    return true;
+  }
+
+  /// @brief 启用与SX1262相同的FSK速率自适应，使用fsk_profiles中各档位的比特率
+  /// @param initiator 是否由本节点发起切换，两个节点必须不同
+  void enable_fsk_rate_control(bool initiator)
+  {
+    FskRate::Config config;
+    config.adapt = fsk_adapt_config();
+    config.home_level = FSK_PROFILE_HOME;
+    config.initiator = initiator;
+    __radio.set_bitrate_bps(__fsk_bps(FSK_PROFILE_HOME));
+    __fsk_rate.emplace(
+        __radio, config,
+        [](void *ctx, uint8_t level)
+        {
+          static_cast<SimRadio *>(ctx)->set_bitrate_bps(__fsk_bps(level));
+          return true;
+        },
+        [](void *ctx)
+        {
+          auto *radio{static_cast<SimRadio *>(ctx)};
+          const auto stats{radio->stats()};
+          return LinkSample{stats.sent, stats.received, stats.crc_errors, radio->last_rssi_x10()};
+        },
+        &__radio);
+    __register_rate_metrics(*__fsk_rate);
+  }
+
+  /// @brief 启用与nRF24相同的数据速率/功率自适应，只按丢包率切换
+  /// @param initiator 是否由本节点发起切换，两个节点必须不同
+  void enable_nrf24_rate_control(bool initiator)
+  {
+    Nrf24Rate::Config config;
+    config.adapt = nrf24_adapt_config();
+    config.home_level = NRF24_PROFILE_HOME;
+    config.initiator = initiator;
+    __apply_nrf24(__radio, NRF24_PROFILE_HOME);
+    __nrf24_rate.emplace(
+        __radio, config,
+        [](void *ctx, uint8_t level)
+        {
+          __apply_nrf24(*static_cast<SimRadio *>(ctx), level);
+          return true;
+        },
+        [](void *ctx)
+        {
+          // nRF24没有RSSI，误包在芯片中被丢弃，只能通过发送计数发现
+          const auto stats{static_cast<SimRadio *>(ctx)->stats()};
+          return LinkSample{stats.sent, stats.received, 0, LINK_RSSI_UNKNOWN};
+        },
+        &__radio);
+    __register_rate_metrics(*__nrf24_rate);
+  }
+
+  /// @brief 轮询一次：串口 -> 路由器，射频 -> 路由器，再调度所有出口
+  /// @param now_ms 运行时间，用于速率自适应
+  /// @param now_us 运行时间，用于ARQ的重发定时器
+  void poll(uint32_t now_ms, uint32_t now_us)
+  {
+    __ingest.poll();
+    // 射频出口队列已满时数据留在数据包池和伪终端缓存中，与main.cpp中等待发送队列的效果相同
+    __uart_queue_hwm.update_max(__queue.len());
+    Pool::handle_t *handle{nullptr};
+    while (__router.pending(PORT_RADIO) < ROUTER_QUEUE_DEPTH && (handle = __queue.front()) != nullptr)
+    {
+      TRACE_EVENT(DEQUEUE, __pool[*handle].trace_id);
+      __uart_frame_size.observe(__pool[*handle].len);
+      __router.input(PORT_UART, __pool[*handle].data, __pool[*handle].len, __pool[*handle].trace_id);
+      __pool.release(*handle);
+      __queue.pop();
+    }
+    uint8_t buffer[SIM_RADIO_MAX_PACKET_LENGTH];
+    size_t size{0};
+    while (__radio.recv(buffer, size))
+    {
+      if ((__fsk_rate && __fsk_rate->handle(buffer, size, now_ms)) ||
+          (__nrf24_rate && __nrf24_rate->handle(buffer, size, now_ms)))
+      {
+        continue; // 速率控制帧在本地处理，不转发
+      }
+      if (__arq && __arq->receive(buffer, size, now_us, [this](const uint8_t *data, size_t len)
+                                  { __router.input(PORT_RADIO, data, len); }))
+      {
+        continue;
+      }
+      __router.input(PORT_RADIO, buffer, size);
+    }
+    if (__fsk_rate)
+    {
+      __fsk_rate->poll(now_ms);
+    }
+    if (__nrf24_rate)
+    {
+      __nrf24_rate->poll(now_ms);
+    }
+    // 伪终端缓存已满时留下的半帧在这里写出，不必等到下一帧
+    __uart_port.flush();
+    __router.poll();
+    if (__arq)
+    {
+      __arq->poll(now_us, [this](const uint8_t *data, size_t len)
+                  { return __radio.send_async(data, len); });
+    }
+  }
+
+  /// @brief 串口的从设备路径
+  const char *serial_name() const { return __uart.slave_name(); }
+
+  /// @brief 速率自适应的当前档位，未启用时为-1
+  int rate_level() const
+  {
+    return __fsk_rate ? __fsk_rate->level() : __nrf24_rate ? __nrf24_rate->level() : -1;
+  }
+
+  /// @brief 输出统计快照，格式与设备通过USB CDC输出的相同
+  void print_stats(uint32_t uptime_ms)
+  {
+    __metrics.snapshot([](const char *data, size_t len)
+                       { fwrite(data, 1, len, stderr); },
+                       uptime_ms);
+  }
+};
+
+/// @brief 以原始、非阻塞模式打开串口的从设备，测试程序代替外部串口工具读写
+inline int sim_open_raw(const char *path)
+{
+  const int fd{::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK)};
+  termios attr;
+  if (fd < 0 || tcgetattr(fd, &attr) != 0)
+  {
+    return -1;
+  }
+  cfmakeraw(&attr);
+  return tcsetattr(fd, TCSANOW, &attr) == 0 ? fd : -1;
+}
+
+/// @brief 吞吐量测试：向一个节点的串口写入伪随机数据，从另一个节点的串口读出并逐字节比较
+class GoodputTest
+{
+private:
+  int __tx_fd{-1};
+  int __rx_fd{-1};
+  size_t __total;
+  size_t __written{0};
+  size_t __received{0};
+  bool __intact{true};
+  uint32_t __tx_state;
+  uint32_t __rx_state;
+
+  /// @brief xorshift32，发送端和接收端各自从相同的种子生成相同的序列
+  static uint8_t __next(uint32_t &state)
+  {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return static_cast<uint8_t>(state);
+  }
+
+public:
+  GoodputTest(size_t total, uint32_t seed) : __total(total), __tx_state(seed ? seed : 1), __rx_state(__tx_state) {}
+  GoodputTest(const GoodputTest &) = delete;
+  GoodputTest &operator=(const GoodputTest &) = delete;
+
+  ~GoodputTest()
+  {
+    if (__tx_fd >= 0)
+    {
+      close(__tx_fd);
+    }
+    if (__rx_fd >= 0)
+    {
+      close(__rx_fd);
+    }
+  }
+
+  /// @param tx_path 写入数据的串口从设备
+  /// @param rx_path 读出数据的串口从设备
+  bool open(const char *tx_path, const char *rx_path)
+  {
+    __tx_fd = sim_open_raw(tx_path);
+    __rx_fd = sim_open_raw(rx_path);
+    return __tx_fd >= 0 && __rx_fd >= 0;
+  }
+
+  /// @brief 写入伪终端缓存能够接受的数据，读出已经到达的数据
+  void poll()
+  {
+    uint8_t buffer[256];
+    while (__written < __total)
+    {
+      // 写入失败时回退生成器状态，下一次重新生成相同的数据
+      const uint32_t state{__tx_state};
+      const size_t len{__total - __written < sizeof(buffer) ? __total - __written : sizeof(buffer)};
+      for (size_t i = 0; i < len; ++i)
+      {
+        buffer[i] = __next(__tx_state);
+      }
+      const ssize_t result{::write(__tx_fd, buffer, len)};
+      __tx_state = state;
+      if (result <= 0)
+      {
+        break;
+      }
+      for (ssize_t i = 0; i < result; ++i)
+      {
+        __next(__tx_state);
+      }
+      __written += static_cast<size_t>(result);
+    }
+    ssize_t result{0};
+    while ((result = ::read(__rx_fd, buffer, sizeof(buffer))) > 0)
+    {
+      for (ssize_t i = 0; i < result; ++i)
+      {
+        __intact = __intact && buffer[i] == __next(__rx_state);
+      }
+      __received += static_cast<size_t>(result);
+    }
+  }
+
+  bool done() const { return __received >= __total; }
+
+  size_t received() const { return __received; }
+
+  /// @brief 收到的数据与写入的完全相同且没有多余的数据
+  bool intact() const { return __intact && __received == __total; }
+};
+
+/// @brief 环回时延测试：从串口A写入带序号和发送时间的探测帧，串口B把收到的数据原样写回（相当于环回插头），
+///        探测帧经两次无线转发回到串口A时计算往返时延；每次只有一个探测帧在途，超时未返回计为丢失
+class LoopbackTest
+{
+public:
+  struct Report
+  {
+    uint32_t sent{0};
+    uint32_t received{0};
+    uint32_t lost{0};
+    uint32_t min_us{0};
+    uint32_t mean_us{0};
+    uint32_t p99_us{0};
+    uint32_t max_us{0};
+  };
+
+private:
+  static constexpr uint8_t __HEAD{0xA5};
+  static constexpr uint8_t __TAIL{0x5A};
+  static constexpr size_t __PROBE_SIZE{1 + sizeof(uint32_t) * 2 + 1}; // 帧头、序号、发送时间、帧尾
+
+  int __host_fd{-1};
+  int __echo_fd{-1};
+  uint32_t __count;
+  uint32_t __interval_us;
+  uint32_t __timeout_us;
+  uint32_t __sent{0};
+  uint32_t __lost{0};
+  uint32_t __next_send_us{0};
+  uint32_t __sent_us{0};
+  bool __waiting{false};
+  uint8_t __echo[256];
+  size_t __echo_len{0};
+  uint8_t __rx[64];
+  size_t __rx_len{0};
+  std::vector<uint32_t> __rtt_us;
+
+  /// @brief 从接收缓存中查找当前探测帧，跳过丢包造成的残缺数据和超时后迟到的探测帧
+  void __parse(uint32_t now_us)
+  {
+    size_t pos{0};
+    while (__rx_len - pos >= __PROBE_SIZE)
+    {
+      const uint8_t *probe{__rx + pos};
+      if (probe[0] != __HEAD || probe[__PROBE_SIZE - 1] != __TAIL)
+      {
+        ++pos;
+        continue;
+      }
+      uint32_t seq{0};
+      memcpy(&seq, probe + 1, sizeof(seq));
+      if (__waiting && seq + 1 == __sent)
+      {
+        __rtt_us.push_back(now_us - __sent_us);
+        __waiting = false;
+        __next_send_us = now_us + __interval_us;
+      }
+      pos += __PROBE_SIZE;
+    }
+    memmove(__rx, __rx + pos, __rx_len - pos);
+    __rx_len -= pos;
+  }
+
+public:
+  /// @param count 探测帧数量
+  /// @param interval_us 收到探测帧后到发送下一个探测帧的间隔
+  /// @param timeout_us 探测帧的超时时间
+  LoopbackTest(uint32_t count, uint32_t interval_us, uint32_t timeout_us)
+      : __count(count), __interval_us(interval_us), __timeout_us(timeout_us)
+  {
+    __rtt_us.reserve(count);
+  }
+
+  LoopbackTest(const LoopbackTest &) = delete;
+  LoopbackTest &operator=(const LoopbackTest &) = delete;
+
+  ~LoopbackTest()
+  {
+    if (__host_fd >= 0)
+    {
+      close(__host_fd);
+    }
+    if (__echo_fd >= 0)
+    {
+      close(__echo_fd);
+    }
+  }
+
+  /// @param host_path 发送探测帧并测量时延的串口从设备
+  /// @param echo_path 环回的串口从设备
+  bool open(const char *host_path, const char *echo_path)
+  {
+    __host_fd = sim_open_raw(host_path);
+    __echo_fd = sim_open_raw(echo_path);
+    return __host_fd >= 0 && __echo_fd >= 0;
+  }
+
+  /// @param now_us 运行时间
+  void poll(uint32_t now_us)
+  {
+    // 环回端：写不下的数据留到下一次轮询
+    ssize_t result{0};
+    if (__echo_len < sizeof(__echo) && (result = ::read(__echo_fd, __echo + __echo_len, sizeof(__echo) - __echo_len)) > 0)
+    {
+      __echo_len += static_cast<size_t>(result);
+    }
+    if (__echo_len && (result = ::write(__echo_fd, __echo, __echo_len)) > 0)
+    {
+      memmove(__echo, __echo + result, __echo_len - static_cast<size_t>(result));
+      __echo_len -= static_cast<size_t>(result);
+    }
+
+    while ((result = ::read(__host_fd, __rx + __rx_len, sizeof(__rx) - __rx_len)) > 0)
+    {
+      __rx_len += static_cast<size_t>(result);
+      __parse(now_us);
+    }
+    if (__waiting && now_us - __sent_us > __timeout_us)
+    {
+      ++__lost;
+      __waiting = false;
+      __next_send_us = now_us;
+    }
+    if (!__waiting && __sent < __count && static_cast<int32_t>(now_us - __next_send_us) >= 0)
+    {
+      uint8_t probe[__PROBE_SIZE]{__HEAD};
+      memcpy(probe + 1, &__sent, sizeof(uint32_t));
+      memcpy(probe + 1 + sizeof(uint32_t), &now_us, sizeof(uint32_t));
+      probe[__PROBE_SIZE - 1] = __TAIL;
+      if (::write(__host_fd, probe, sizeof(probe)) == static_cast<ssize_t>(sizeof(probe)))
+      {
+        ++__sent;
+        __sent_us = now_us;
+        __waiting = true;
+      }
+    }
+  }
+
+  bool done() const { return __sent >= __count && !__waiting; }
+
+  Report report() const
+  {
+    Report report;
+    report.sent = __sent;
+    report.received = static_cast<uint32_t>(__rtt_us.size());
+    report.lost = __lost;
+    if (__rtt_us.empty())
+    {
+      return report;
+    }
+    std::vector<uint32_t> sorted{__rtt_us};
+    std::sort(sorted.begin(), sorted.end());
+    uint64_t sum{0};
+    for (const auto rtt_us : sorted)
+    {
+      sum += rtt_us;
+    }
+    report.min_us = sorted.front();
+    report.mean_us = static_cast<uint32_t>(sum / sorted.size());
+    report.p99_us = sorted[(sorted.size() - 1) * 99 / 100];
+    report.max_us = sorted.back();
+    return report;
+  }
+};
+
+/// @brief 跳频测试：发送端按固定间隔发送带序号和计划时间的帧，并按跳频间隔通过控制帧换频，
+///        接收端比发送端晚skew_us收到换频命令，统计丢失的帧以及超过期限才到达的帧
+class HopTest
+{
+public:
+  struct Config
+  {
+    uint32_t frame_interval_us{1000}; // 发送间隔
+    uint32_t hop_interval_us{20000};  // 跳频间隔
+    uint32_t skew_us{200};            // 接收端相对发送端的换频延迟
+    uint32_t deadline_us{5000};       // 从计划发送时间起超过此时延到达的帧计为迟到
+    size_t frame_size{RADIO_PAYLOAD_SIZE};
+  };
+
+  struct Report
+  {
+    uint32_t hops{0};
+    uint32_t sent{0};
+    uint32_t received{0};
+    uint32_t dropped{0}; // 已发送但没有收到
+    uint32_t late{0};
+    uint32_t max_latency_us{0};
+    uint32_t retune_dropped{0}; // 接收端换频时丢弃的帧，包含在dropped中
+  };
+
+private:
+  SimRadio __tx;
+  SimRadio __rx;
+  Config __config;
+  Report __report;
+  uint32_t __next_frame_us{0};
+  uint32_t __next_hop_us;
+  uint32_t __rx_hop_us{0};
+  bool __rx_hop_pending{false};
+  uint8_t __channel{0};
+
+  /// @brief 与设备相同，通过control_dispatch执行换频控制帧
+  static bool __hop(SimRadio &radio, uint8_t channel)
+  {
+    uint8_t frame[CONTROL_FRAME_MAX_LEN]{0xc0, 0x00, 0x08, 0x00, 0x00, 0xe7, 0x80, static_cast<uint8_t>(channel * CHANNEL_CODE_STEP), 0x00, 0x00, 0x00};
+    return control_dispatch(radio, frame, sizeof(frame)) == CmdResult::SUCCESS;
+  }
+
+public:
+  HopTest(SimMedium &medium, const SimRadio::Config &radio_config, const Config &config)
+      : __tx(medium, radio_config), __rx(medium, radio_config), __config(config), __next_hop_us(config.hop_interval_us)
+  {
+    __config.frame_size = std::min(std::max(__config.frame_size, 2 * sizeof(uint32_t)), radio_config.mtu);
+    __hop(__tx, 0);
+    __hop(__rx, 0);
+  }
+
+  HopTest(const HopTest &) = delete;
+  HopTest &operator=(const HopTest &) = delete;
+
+  /// @param now_us 运行时间
+  /// @param sending 是否继续发送，结束前停止发送并继续轮询以收取空中的帧
+  void poll(uint32_t now_us, bool sending = true)
+  {
+    if (sending && now_us >= __next_hop_us)
+    {
+      __channel = (__channel + 1) % CHANNEL_COUNT;
+      __hop(__tx, __channel);
+      __rx_hop_us = now_us + __config.skew_us;
+      __rx_hop_pending = true;
+      __next_hop_us += __config.hop_interval_us;
+      ++__report.hops;
+    }
+    if (__rx_hop_pending && now_us >= __rx_hop_us)
+    {
+      __hop(__rx, __channel);
+      __rx_hop_pending = false;
+    }
+    // 设备忙时推迟发送，时间戳仍为计划时间，推迟的时间计入时延
+    if (sending && now_us >= __next_frame_us)
+    {
+      uint8_t frame[SIM_RADIO_MAX_PACKET_LENGTH]{};
+      memcpy(frame, &__report.sent, sizeof(uint32_t));
+      memcpy(frame + sizeof(uint32_t), &__next_frame_us, sizeof(uint32_t));
+      if (__tx.send_async(frame, __config.frame_size))
+      {
+        ++__report.sent;
+        __next_frame_us += __config.frame_interval_us;
+      }
+    }
+    uint8_t buffer[SIM_RADIO_MAX_PACKET_LENGTH];
+    size_t size{0};
+    while (__rx.recv(buffer, size))
+    {
+      uint32_t scheduled_us{0};
+      memcpy(&scheduled_us, buffer + sizeof(uint32_t), sizeof(uint32_t));
+      const uint32_t latency_us{now_us - scheduled_us};
+      __report.max_latency_us = std::max(__report.max_latency_us, latency_us);
+      __report.late += latency_us > __config.deadline_us;
+      ++__report.received;
+    }
+  }
+
+  Report report()
+  {
+    Report report{__report};
+    report.dropped = report.sent - report.received;
+    report.retune_dropped = __rx.stats().retune_dropped;
+    return report;
+  }
+};
+
+#endif // __SIM_BRIDGE_H__
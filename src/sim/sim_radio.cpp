@@ -0,0 +1,267 @@
+#include "sim_radio.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+double sim_path_loss_db(double distance_m, double exponent, double frequency_mhz)
+{
+    // 1米处的自由空间损耗：20lg(4π / λ)，915 MHz约为31.7 dB，2402 MHz约为40.1 dB
+    const double loss_at_1m_db{20.0 * std::log10(frequency_mhz) - 27.55};
+    return loss_at_1m_db + 10.0 * exponent * std::log10(std::max(distance_m, 1.0));
+}
+
+void SimMedium::attach(SimRadio *radio)
+{
+    std::lock_guard<std::mutex> lock{__lock};
+    __radios.push_back(radio);
+}
+
+void SimMedium::detach(SimRadio *radio)
+{
+    std::lock_guard<std::mutex> lock{__lock};
+    __radios.erase(std::remove(__radios.begin(), __radios.end(), radio), __radios.end());
+}
+
+void SimMedium::broadcast(SimRadio *from, const uint8_t *data, size_t size, std::chrono::steady_clock::time_point arrival)
+{
+    const uint32_t frequency{from->frequency()};
+    const uint32_t bitrate{from->bitrate_bps()};
+    const double tx_power_dbm{from->tx_power_dbm()};
+    std::lock_guard<std::mutex> lock{__lock};
+    for (auto *radio : __radios)
+    {
+        if (radio == from || radio->frequency() != frequency)
+        {
+            continue;
+        }
+        // 每个接收端独立决定是否丢包
+        bool lost{__uniform(__rng) < radio->__config.loss || radio->bitrate_bps() != bitrate};
+        bool crc_error{false};
+        int16_t rssi_x10{INT16_MIN};
+        if (__path_loss_enabled)
+        {
+            const double rssi{tx_power_dbm - __path_loss_db + __fading_db * __normal(__rng)};
+            rssi_x10 = static_cast<int16_t>(std::lround(std::max(rssi, -300.0) * 10));
+            // 误包率随RSSI余量按logistic曲线下降：余量0 dB时为50%，3 dB时约5%
+            const double margin{rssi - radio->sensitivity_dbm()};
+            if (!lost && __uniform(__rng) < 1.0 / (1.0 + std::exp(margin)))
+            {
+                lost = margin < -6.0; // 远低于灵敏度时检测不到信号，否则为CRC错误
+                crc_error = !lost;
+            }
+        }
+        radio->__deliver(data, size, arrival, lost, crc_error, rssi_x10);
+    }
+}
+
+void SimMedium::set_path_loss(double path_loss_db, double fading_db)
+{
+    std::lock_guard<std::mutex> lock{__lock};
+    __path_loss_enabled = true;
+    __path_loss_db = path_loss_db;
+    __fading_db = fading_db;
+}
+
+SimRadio::SimRadio(SimMedium &medium, const Config &config) : __medium(medium), __config(config)
+{
+    __config.mtu = std::min<size_t>(__config.mtu, SIM_RADIO_MAX_PACKET_LENGTH);
+    __medium.attach(this);
+}
+
+SimRadio::~SimRadio()
+{
+    __medium.detach(this);
+}
+
+uint32_t SimRadio::airtime_us(size_t size) const
+{
+    return static_cast<uint32_t>((size + __config.overhead_bytes) * 8ULL * 1000000ULL / __config.bitrate_bps);
+}
+
+void SimRadio::__deliver(const uint8_t *data, size_t size, clock::time_point arrival, bool lost, bool crc_error, int16_t rssi_x10)
+{
+    std::lock_guard<std::mutex> lock{__lock};
+    if (lost || crc_error || !__enabled || size > __config.mtu || arrival < __settled_at)
+    {
+        ++__stats.lost;
+        __stats.crc_errors += crc_error;
+        return;
+    }
+    __last_rssi_x10 = rssi_x10;
+    __Delivery delivery;
+    delivery.due = arrival;
+    delivery.len = static_cast<uint8_t>(size);
+    memcpy(delivery.data, data, size);
+    // 固定时延下到达时间单调递增，通常直接追加在末尾
+    auto pos{std::upper_bound(__inbox.begin(), __inbox.end(), arrival,
+                              [](clock::time_point due, const __Delivery &item)
+                              { return due < item.due; })};
+    __inbox.insert(pos, delivery);
+}
+
+bool SimRadio::send(uint8_t *message, size_t size)
+{
+    while (!send_async(message, size))
+    {
+        clock::time_point busy_until;
+        {
+            std::lock_guard<std::mutex> lock{__lock};
+            if (!__enabled || size == 0 || size > __config.mtu)
+            {
+                return false;
+            }
+            busy_until = __busy_until;
+        }
+        std::this_thread::sleep_until(busy_until);
+    }
+    return true;
+}
+
+bool SimRadio::send_async(const uint8_t *message, size_t size)
+{
+    clock::time_point arrival;
+    {
+        std::lock_guard<std::mutex> lock{__lock};
+        if (!__enabled || size == 0 || size > __config.mtu)
+        {
+            return false;
+        }
+        const auto now{clock::now()};
+        if (now < __busy_until)
+        {
+            ++__stats.busy;
+            return false;
+        }
+        const uint32_t airtime{airtime_us(size)};
+        __busy_until = now + std::chrono::microseconds(airtime);
+        arrival = __busy_until + std::chrono::microseconds(__config.latency_us);
+        ++__stats.sent;
+        __stats.airtime_us += airtime;
+    }
+    __medium.broadcast(this, message, size, arrival);
+    return true;
+}
+
+bool SimRadio::recv(uint8_t *buffer, size_t &size)
+{
+    std::lock_guard<std::mutex> lock{__lock};
+    if (__inbox.empty() || __inbox.front().due > clock::now())
+    {
+        size = 0;
+        return false;
+    }
+    const auto &delivery{__inbox.front()};
+    size = delivery.len;
+    memcpy(buffer, delivery.data, size);
+    __inbox.pop_front();
+    ++__stats.received;
+    return true;
+}
+
+uint32_t SimRadio::set_frequency(uint32_t frequency_hz)
+{
+    std::lock_guard<std::mutex> lock{__lock};
+    __frequency = frequency_hz;
+    __inbox.clear(); // 换频时丢弃尚未到达的数据包
+    return __frequency;
+}
+
+uint32_t SimRadio::retune(uint32_t frequency_hz)
+{
+    std::lock_guard<std::mutex> lock{__lock};
+    __frequency = frequency_hz;
+    __stats.retune_dropped += static_cast<uint32_t>(__inbox.size());
+    __inbox.clear();
+    __settled_at = std::max(__busy_until, clock::now()) + std::chrono::microseconds(__config.retune_us);
+    __busy_until = __settled_at;
+    return __frequency;
+}
+
+uint8_t SimRadio::set_power(uint8_t power)
+{
+    std::lock_guard<std::mutex> lock{__lock};
+    __config.tx_power_dbm = static_cast<int8_t>(power);
+    return power;
+}
+
+uint32_t SimRadio::set_data_rate(uint32_t rate)
+{
+    if (rate == 0)
+    {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock{__lock};
+    __config.bitrate_bps = rate * 1000;
+    return rate;
+}
+
+uint8_t SimRadio::set_addr_width(uint8_t addr_width)
+{
+    std::lock_guard<std::mutex> lock{__lock};
+    __addr_width = addr_width;
+    return __addr_width;
+}
+
+bool SimRadio::shutdown()
+{
+    std::lock_guard<std::mutex> lock{__lock};
+    __enabled = false;
+    __inbox.clear();
+    return true;
+}
+
+bool SimRadio::reboot()
+{
+    std::lock_guard<std::mutex> lock{__lock};
+    __enabled = true;
+    __busy_until = clock::time_point{};
+    return true;
+}
+
+uint32_t SimRadio::frequency()
+{
+    std::lock_guard<std::mutex> lock{__lock};
+    return __frequency;
+}
+
+void SimRadio::set_bitrate_bps(uint32_t bitrate_bps)
+{
+    if (bitrate_bps == 0)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock{__lock};
+    __config.bitrate_bps = bitrate_bps;
+}
+
+uint32_t SimRadio::bitrate_bps()
+{
+    std::lock_guard<std::mutex> lock{__lock};
+    return __config.bitrate_bps;
+}
+
+double SimRadio::tx_power_dbm()
+{
+    std::lock_guard<std::mutex> lock{__lock};
+    return __config.tx_power_dbm;
+}
+
+double SimRadio::sensitivity_dbm()
+{
+    std::lock_guard<std::mutex> lock{__lock};
+    return -174.0 + 10.0 * std::log10(2.5 * __config.bitrate_bps) + __config.noise_figure_db + __config.required_snr_db;
+}
+
+int16_t SimRadio::last_rssi_x10()
+{
+    std::lock_guard<std::mutex> lock{__lock};
+    return __last_rssi_x10;
+}
+
+SimRadio::Stats SimRadio::stats()
+{
+    std::lock_guard<std::mutex> lock{__lock};
+    return __stats;
+}
@@ -0,0 +1,420 @@
+#include "sx1262_device.h"
+
+#include <cstring>
+
+#include "utools.h"
+#include "trace.hpp"
+#include "deferred_log.hpp"
+
+SX1262Device *SX1262Device::__irq_owner{nullptr};
+
+SX1262Device::SX1262Device(uint8_t spi_bus, int8_t sck, int8_t miso, int8_t mosi, int8_t ss, uint32_t irq, uint32_t rst,
+                           uint32_t busy, uint32_t rx_en, uint32_t tx_en)
+    : __rx_en(rx_en), __tx_en(tx_en)
+{
+    __radio_spi = new SPIClass(spi_bus);
+    __radio_spi->begin(sck, miso, mosi, ss);
+    __radio = new SX1262{new Module{static_cast<uint32_t>(ss), irq, rst, busy, *__radio_spi, __spi_setting}};
+}
+
+SX1262Device::~SX1262Device()
+{
+    if (__radio)
+    {
+        delete __radio;
+    }
+    if (__radio_spi)
+    {
+        delete __radio_spi;
+    }
+}
+
+bool SX1262Device::init(float freq, float br, float freq_dev, float rx_bw, int8_t power)
+{
+    utools::logger_info("SX1262 device init");
+    __radio->XTAL = true; // 使用温度补偿晶振
+    auto status{__radio->beginFSK(freq, br, freq_dev, rx_bw, power)};
+    if (status != RADIOLIB_ERR_NONE)
+    {
+        utools::logger_error("SX1262 device init failed. error code:", status);
+        return false;
+    }
+    // 外部射频开关，由RadioLib在收发切换时自动控制
+    __radio->setRfSwitchPins(__rx_en, __tx_en);
+    utools::logger_info("SX1262 device init success");
+    return __start_trx_engine();
+}
+
+bool SX1262Device::__start_trx_engine()
+{
+    if (__trx_task)
+    {
+        return true;
+    }
+    __irq_owner = this;
+    __radio->setDio1Action(__on_irq);
+    if (xTaskCreate(__trx_task_entry, "SX1262_trx", 1024 * 4, this, 2, &__trx_task) != pdPASS)
+    {
+        utools::logger_error("SX1262 trx engine: create task failed");
+        return false;
+    }
+    return true;
+}
+
+void IRAM_ATTR SX1262Device::__on_irq()
+{
+    BaseType_t woken{pdFALSE};
+    if (__irq_owner && __irq_owner->__trx_task)
+    {
+        xTaskNotifyFromISR(__irq_owner->__trx_task, __NOTIFY_IRQ, eSetBits, &woken);
+    }
+    portYIELD_FROM_ISR(woken);
+}
+
+void SX1262Device::__trx_task_entry(void *arg)
+{
+    static_cast<SX1262Device *>(arg)->__trx_loop();
+}
+
+void SX1262Device::__wake()
+{
+    if (__trx_task)
+    {
+        xTaskNotify(__trx_task, __NOTIFY_WAKE, eSetBits);
+    }
+}
+
+void SX1262Device::__clear_irq()
+{
+    // 不论是否有未处理的通知，进入和退出时都会清除IRQ位
+    xTaskNotifyWait(__NOTIFY_IRQ, __NOTIFY_IRQ, nullptr, 0);
+}
+
+bool SX1262Device::__wait_irq(TickType_t timeout)
+{
+    const TickType_t start{xTaskGetTickCount()};
+    uint32_t events{0};
+    while (!(events & __NOTIFY_IRQ))
+    {
+        const TickType_t elapsed{xTaskGetTickCount() - start};
+        // 只清除IRQ位，等待期间到达的唤醒通知保留到下一次等待
+        if (elapsed >= timeout || xTaskNotifyWait(0, __NOTIFY_IRQ, &events, timeout - elapsed) != pdTRUE)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SX1262Device::__trx_loop()
+{
+    while (1)
+    {
+        __transmit_pending();
+        __receive_once();
+    }
+}
+
+bool SX1262Device::__arm_receive()
+{
+    if (__rx_armed)
+    {
+        return true;
+    }
+    __clear_irq();
+    auto status{__radio->startReceive()}; // 默认为连续接收，收到数据包后芯片保持接收状态
+    if (status != RADIOLIB_ERR_NONE)
+    {
+        utools::logger_error("SX1262 start receive failed. status:", status);
+        return false;
+    }
+    __rx_armed = true;
+    return true;
+}
+
+void SX1262Device::__transmit_pending()
+{
+    __TxPacket *packet{nullptr};
+    while ((packet = __tx_queue.front()) != nullptr)
+    {
+        bool success{false};
+        {
+            std::lock_guard<std::mutex> lock{__lock}; // 换频时在此暂停
+            if (__rx_armed)
+            {
+                __rx_stats.turnarounds.fetch_add(1, std::memory_order_relaxed);
+            }
+            __rx_armed = false;
+            __clear_irq(); // 清除接收阶段残留的中断
+            const TickType_t timeout{pdMS_TO_TICKS(__radio->getTimeOnAir(packet->len) / 1000 + SX1262_TX_TIMEOUT_MARGIN_MS)};
+            TRACE_EVENT(SPI_START, packet->trace_id);
+            auto status{__radio->startTransmit(packet->data, packet->len)};
+            if (status == RADIOLIB_ERR_NONE)
+            {
+                success = __wait_irq(timeout);
+            }
+            TRACE_EVENT(AIR_DONE, packet->trace_id);
+            __radio->finishTransmit();
+            // 队列中没有更多数据时立即回到接收，不释放锁，避免接收空档
+            if (__tx_queue.len() <= 1)
+            {
+                __arm_receive();
+            }
+        }
+        auto size{packet->len};
+        if (success)
+        {
+            __tx_latency.observe(micros() - packet->queued_us);
+        }
+        __tx_queue.pop();
+        (success ? __tx_stats.sent : __tx_stats.failed).fetch_add(1, std::memory_order_relaxed);
+        if (__tx_callback)
+        {
+            __tx_callback(success, size);
+        }
+    }
+}
+
+void SX1262Device::__receive_once()
+{
+    {
+        std::lock_guard<std::mutex> lock{__lock};
+        if (!__arm_receive())
+        {
+            vTaskDelay(1);
+            return;
+        }
+    }
+    if (!__tx_queue.empty())
+    {
+        return; // 在进入接收期间有新的发送请求
+    }
+    // send_async在检查之后写入的数据包会留下未处理的通知，不会错过
+    uint32_t events{0};
+    xTaskNotifyWait(0, __NOTIFY_IRQ, &events, portMAX_DELAY);
+    if (events & __NOTIFY_IRQ)
+    {
+        std::lock_guard<std::mutex> lock{__lock};
+        if (__rx_armed)
+        {
+            __read_packet();
+        }
+    }
+}
+
+void SX1262Device::__read_packet()
+{
+    uint8_t discard[SX1262_MAX_PACKET_LENGTH];
+    auto handle{__rx_pool.acquire()};
+    auto *buffer{handle == RxPacketPool::invalid_handle ? discard : __rx_pool[handle].data};
+    size_t size{__radio->getPacketLength()};
+    if (size > SX1262_MAX_PACKET_LENGTH)
+    {
+        size = SX1262_MAX_PACKET_LENGTH;
+    }
+    // 数据包池耗尽时同样需要读出数据以清除中断标志
+    auto status{__radio->readData(buffer, size)};
+    if (status != RADIOLIB_ERR_NONE || size == 0)
+    {
+        (status == RADIOLIB_ERR_CRC_MISMATCH ? __rx_stats.crc_errors : __rx_stats.failed).fetch_add(1, std::memory_order_relaxed);
+        __rx_pool.release(handle);
+        return;
+    }
+    if (handle == RxPacketPool::invalid_handle)
+    {
+        __rx_stats.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    __rx_pool[handle].trace_id = TRACE_NEW_ID();
+    TRACE_EVENT(RX_READ, __rx_pool[handle].trace_id);
+    __rx_stats.rssi_x10.store(static_cast<int32_t>(__radio->getRSSI() * 10), std::memory_order_relaxed);
+    __rx_pool[handle].len = static_cast<uint8_t>(size);
+    __rx_queue.push(handle);
+    __rx_stats.received.fetch_add(1, std::memory_order_relaxed);
+    if (__rx_callback)
+    {
+        __rx_callback();
+    }
+}
+
+bool SX1262Device::send(uint8_t *message, size_t size)
+{
+    int16_t status;
+    {
+        std::lock_guard<std::mutex> lock{__lock};
+        __rx_armed = false; // 发送完成的DIO1中断不会被当作接收完成
+        status = __radio->transmit(message, size);
+    }
+    __wake(); // 由收发任务重新进入接收
+    DLOG_INFO("SX1262 send %u bytes, status: %d", size, status);
+    return RADIOLIB_ERR_NONE == status;
+}
+
+bool SX1262Device::send_async(const uint8_t *message, size_t size)
+{
+    if (!__trx_task || size > SX1262_MAX_PACKET_LENGTH)
+    {
+        return false;
+    }
+    RingRegion<__TxPacket> first, second;
+    if (__tx_queue.write_regions(first, second) == 0)
+    {
+        return false;
+    }
+    first.data->queued_us = micros();
+    first.data->trace_id = TRACE_CURRENT();
+    first.data->len = static_cast<uint8_t>(size);
+    memcpy(first.data->data, message, size);
+    __tx_queue.commit_write(1);
+
+    __tx_stats.queued.fetch_add(1, std::memory_order_relaxed);
+    auto depth{__tx_queue.len()};
+    auto max_depth{__tx_stats.max_depth.load(std::memory_order_relaxed)};
+    if (depth > max_depth)
+    {
+        __tx_stats.max_depth.store(depth, std::memory_order_relaxed);
+    }
+    __wake();
+    return true;
+}
+
+const SX1262Device::RxPacket *SX1262Device::rx_front()
+{
+    auto *handle{__rx_queue.front()};
+    return handle ? &__rx_pool[*handle] : nullptr;
+}
+
+void SX1262Device::rx_pop()
+{
+    RxPacketPool::handle_t handle;
+    if (__rx_queue.pop(handle))
+    {
+        __rx_pool.release(handle);
+    }
+}
+
+bool SX1262Device::recv(uint8_t *buffer, size_t &size)
+{
+    auto *packet{rx_front()};
+    if (!packet)
+    {
+        size = 0;
+        return false;
+    }
+    size = packet->len;
+    memcpy(buffer, packet->data, size);
+    rx_pop();
+    return true;
+}
+
+uint32_t SX1262Device::set_frequency(uint32_t frequency)
+{
+    uint32_t result;
+    {
+        std::lock_guard<std::mutex> lock{__lock};
+        result = __set_frequency(frequency);
+    }
+    __wake();
+    return result;
+}
+
+uint32_t SX1262Device::retune(uint32_t frequency_hz)
+{
+    auto start{micros()};
+    decltype(start) locked, done;
+    uint32_t result;
+    {
+        std::lock_guard<std::mutex> lock{__lock}; // 等待正在进行的发送完成后暂停收发
+        locked = micros();
+        result = __set_frequency(frequency_hz);
+        done = micros();
+    }
+    __wake();
+    utools::logger_info("SX1262 retune:", frequency_hz, "wait tx(us):", locked - start, "outage(us):", done - locked);
+    return result;
+}
+
+uint32_t SX1262Device::__set_frequency(uint32_t frequency)
+{
+    auto status{__radio->standby()};
+    __rx_armed = false; // 由收发任务在新频率上重新进入接收
+    if (status == RADIOLIB_ERR_NONE)
+    {
+        status = __radio->setFrequency(frequency / 1000000.0f);
+    }
+    if (status != RADIOLIB_ERR_NONE)
+    {
+        utools::logger_error("SX1262 set frequency failed:", frequency, "status:", status);
+        return 0;
+    }
+    return frequency;
+}
+
+uint8_t SX1262Device::set_power(uint8_t power)
+{
+    std::lock_guard<std::mutex> lock{__lock};
+    return __radio->setOutputPower(static_cast<int8_t>(power)) == RADIOLIB_ERR_NONE ? power : 0;
+}
+
+uint32_t SX1262Device::set_data_rate(uint32_t rate)
+{
+    uint32_t result{0};
+    {
+        std::lock_guard<std::mutex> lock{__lock};
+        // FSK模式下修改比特率需要先退出接收
+        __radio->standby();
+        __rx_armed = false;
+        if (__radio->setBitRate(static_cast<float>(rate)) == RADIOLIB_ERR_NONE)
+        {
+            result = rate;
+        }
+    }
+    __wake();
+    return result;
+}
+
+bool SX1262Device::set_fsk_profile(float bitrate_kbps, float freq_dev_khz, float rx_bw_khz)
+{
+    int16_t status;
+    {
+        std::lock_guard<std::mutex> lock{__lock}; // 等待正在进行的发送完成
+        status = __radio->standby();
+        __rx_armed = false;
+        if (status == RADIOLIB_ERR_NONE)
+        {
+            status = __radio->setBitRate(bitrate_kbps);
+        }
+        if (status == RADIOLIB_ERR_NONE)
+        {
+            status = __radio->setFrequencyDeviation(freq_dev_khz);
+        }
+        if (status == RADIOLIB_ERR_NONE)
+        {
+            status = __radio->setRxBandwidth(rx_bw_khz);
+        }
+    }
+    __wake();
+    if (status != RADIOLIB_ERR_NONE)
+    {
+        utools::logger_error("SX1262 set fsk profile failed. status:", status);
+        return false;
+    }
+    return true;
+}
+
+uint8_t SX1262Device::set_addr_width(uint8_t)
+{
+    return 0; // FSK模式使用同步字，没有地址宽度
+}
+
+bool SX1262Device::shutdown()
+{
+    std::lock_guard<std::mutex> lock{__lock};
+    __rx_armed = false;
+    return RADIOLIB_ERR_NONE == __radio->sleep();
+}
+
+bool SX1262Device::reboot()
+{
+    return true;
+}
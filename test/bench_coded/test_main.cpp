@@ -0,0 +1,675 @@
+/// @brief lib/coded基础组件的基准测试：CRC、base64、十六进制格式化、字节序转换、队列、路由器和延迟日志
+///        每项测试在1 B～4 KB的负载长度下取多次重复中最快的一次（x86上同时给出时间戳计数器的周期数），
+///        结果以JSON写入BENCH_OUTPUT（默认bench_output.json），并与同目录下的baseline.json比较。
+///        基线的耗时先按参考测试reference_lcg在两台机器上的耗时之比换算到本机，
+///        单次耗时超过换算值(1 + BENCH_TOLERANCE)倍（默认0.5）时重新测量，重测后仍然超过时报告变慢
+///        pio test -e native_bench                          只报告变慢的测试
+///        BENCH_GATE=1 pio test -e native_bench             有测试变慢时失败
+///        BENCH_UPDATE_BASELINE=1 pio test -e native_bench  用本机结果重写基线
+
+#include <unity.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "crc.hpp"
+#include "crc16.h"
+#include "base64.h"
+#include "bytes_string.hpp"
+#include "endian.hpp"
+#include "ring_queue.hpp"
+#include "static_ring_queue.hpp"
+#include "spsc_queue.hpp"
+#include "mpsc_queue.hpp"
+#include "router.hpp"
+#include "deferred_log.hpp"
+
+#define BENCH_MIN_SAMPLE_NS 2000000 // 每次重复的最短时间
+#define BENCH_REPEATS 5
+#define BENCH_RETRIES 3     // 超过基线时重新测量的次数，排除其它进程造成的偶发抖动
+#define BENCH_SLACK_NS 1.0 // 比较基线时允许的绝对误差，避免纳秒级的测试因计时抖动失败
+#define BENCH_REFERENCE "reference_lcg"
+
+static const size_t payload_sizes[]{1, 16, 64, 256, 1024, 4096};
+
+struct BenchResult
+{
+  std::string name;
+  size_t bytes;
+  uint64_t iterations;
+  double ns_per_op;
+  double cycles_per_op; // 不支持时间戳计数器时为0
+};
+
+static std::vector<BenchResult> results;
+static std::vector<BenchResult> baseline;
+static double tolerance{0.5};
+static double machine_scale{1.0}; // 本机与记录基线的机器的速度之比，由参考测试得出
+
+static uint8_t input[4096];
+static char text[8192];
+static uint8_t output[8192];
+
+void setUp() {}
+
+void tearDown() {}
+
+/// @brief 阻止编译器把基准测试中的计算当作无用代码删除
+template <typename _Type>
+static inline void keep(const _Type &value)
+{
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+static const BenchResult *find_baseline(const std::string &name)
+{
+  const auto it{std::find_if(baseline.begin(), baseline.end(), [&](const BenchResult &base)
+                             { return base.name == name; })};
+  return it == baseline.end() ? nullptr : &*it;
+}
+
+/// @brief 基线耗时换算到本机后的值
+static double expected_ns(const BenchResult &base)
+{
+  return base.ns_per_op * machine_scale;
+}
+
+static bool regressed(double ns_per_op, const BenchResult *base)
+{
+  return base && ns_per_op > expected_ns(*base) * (1.0 + tolerance) + BENCH_SLACK_NS;
+}
+
+/// @brief 一次采样的耗时和周期数
+struct BenchSample
+{
+  double ns{0};
+  double cycles{0};
+};
+
+static uint64_t cycles_now()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+/// @brief 计时区间，构造时开始计时
+class BenchTimer
+{
+  using clock = std::chrono::steady_clock;
+
+public:
+  /// @brief 从开始计时到现在的耗时和周期数
+  BenchSample elapsed() const
+  {
+    const uint64_t cycles{cycles_now() - __start_cycles};
+    return {static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - __start).count()),
+            static_cast<double>(cycles)};
+  }
+
+private:
+  const clock::time_point __start{clock::now()};
+  const uint64_t __start_cycles{cycles_now()};
+};
+
+/// @brief 先按倍增确定每次重复的迭代次数，再取多次重复中最快的一次，超过基线时重新测量
+/// @tparam _SampleFun 形如 BenchSample(uint64_t iterations) 的函数，执行iterations次操作并返回计时部分的耗时
+/// @param name 测试名称，形如 crc16_modbus/64
+/// @param bytes 每次操作处理的字节数，用于计算吞吐量，0表示不计算
+template <typename _SampleFun>
+static void measure(const std::string &name, size_t bytes, _SampleFun &&sample)
+{
+  uint64_t iterations{1};
+  while (sample(iterations).ns < BENCH_MIN_SAMPLE_NS)
+  {
+    iterations *= 2;
+  }
+  BenchSample best{INFINITY, 0};
+  const BenchResult *base{find_baseline(name)};
+  for (int retry = 0; retry <= BENCH_RETRIES && (retry == 0 || regressed(best.ns, base)); ++retry)
+  {
+    for (int i = 0; i < BENCH_REPEATS; ++i)
+    {
+      const auto current{sample(iterations)};
+      if (current.ns / iterations < best.ns)
+      {
+        best = {current.ns / iterations, current.cycles / iterations};
+      }
+    }
+  }
+  results.push_back({name, bytes, iterations, best.ns, best.cycles});
+  printf("%-32s %12.1f ns", name.c_str(), best.ns);
+  if (best.cycles > 0)
+  {
+    printf(" %10.1f cycles", best.cycles);
+  }
+  if (bytes)
+  {
+    printf(" %10.1f MB/s", bytes * 1000.0 / best.ns);
+  }
+  printf("\n");
+}
+
+/// @brief 测量每次调用fun的耗时
+template <typename _Fun>
+static void bench(const std::string &name, size_t bytes, _Fun &&fun)
+{
+  measure(name, bytes, [&](uint64_t iterations)
+          {
+            const BenchTimer timer;
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+              fun();
+            }
+            return timer.elapsed(); });
+}
+
+static std::string sized(const char *name, size_t size)
+{
+  return std::string(name) + "/" + std::to_string(size);
+}
+
+/// @brief 只依赖整数乘加的参考测试，用于换算不同机器上的基线，必须最先运行
+static void bench_reference()
+{
+  uint64_t state{1};
+  bench(BENCH_REFERENCE, 0, [&state]
+        {
+          for (int i = 0; i < 64; ++i)
+          {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+          }
+          keep(state); });
+  const BenchResult *base{find_baseline(BENCH_REFERENCE)};
+  if (base && base->ns_per_op > 0)
+  {
+    machine_scale = results.back().ns_per_op / base->ns_per_op;
+    printf("machine scale %.2f (baseline %.1f ns)\n", machine_scale, base->ns_per_op);
+  }
+}
+
+/// @brief crc16_modbus为默认的slicing-by-8，另外给出逐字节查表和slicing-by-4作为对照
+static void bench_crc()
+{
+  using Crc16ModbusBytewise = Crc16<0x8005, 0xFFFF, true, 0x0000, 1>;
+  using Crc16ModbusSlice4 = Crc16<0x8005, 0xFFFF, true, 0x0000, 4>;
+  for (const auto size : payload_sizes)
+  {
+    bench(sized("crc16", size), size, [size]
+          { keep(crc16(input, size)); });
+    bench(sized("crc16_modbus_bytewise", size), size, [size]
+          { keep(Crc16ModbusBytewise::compute(input, size)); });
+    bench(sized("crc16_modbus_slice4", size), size, [size]
+          { keep(Crc16ModbusSlice4::compute(input, size)); });
+    bench(sized("crc16_modbus", size), size, [size]
+          { keep(Crc16Modbus::compute(input, size)); });
+    bench(sized("crc16_ccitt", size), size, [size]
+          { keep(Crc16Ccitt::compute(input, size)); });
+  }
+}
+
+/// @brief 优化前的base64实现，作为base64_encode/base64_decode的对照
+///        唯一的改动是输入按无符号字节读取：原实现对>=0x80的字节用负数下标查表
+static const char base64_ref_alphabet[]{"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"};
+
+static const std::array<uint8_t, 256> base64_ref_map{[]
+                                                     {
+                                                       std::array<uint8_t, 256> map;
+                                                       map.fill(255);
+                                                       for (uint8_t i = 0; i < 64; ++i)
+                                                       {
+                                                         map[static_cast<uint8_t>(base64_ref_alphabet[i])] = i;
+                                                       }
+                                                       map['\n'] = map['\r'] = map[' '] = 253;
+                                                       map['='] = 254;
+                                                       return map;
+                                                     }()};
+
+static char cmove_bits_ref(unsigned char src, unsigned lnum, unsigned rnum)
+{
+  src <<= lnum;
+  src >>= rnum;
+  return src;
+}
+
+static int base64_encode_ref(const void *indata, int inlen, char *outdata, int *outlen)
+{
+  const unsigned char *inbuf = (const unsigned char *)indata;
+  int pad_num = inlen % 3 != 0 ? 3 - inlen % 3 : 0;
+  int in_len = inlen + pad_num;
+  char *p = outdata;
+  for (int i = 0; i < in_len; i += 3)
+  {
+    *p = base64_ref_alphabet[*inbuf >> 2];
+    if (i == inlen + pad_num - 3 && pad_num != 0)
+    {
+      if (pad_num == 1)
+      {
+        *(p + 1) = base64_ref_alphabet[(int)(cmove_bits_ref(*inbuf, 6, 2) + cmove_bits_ref(*(inbuf + 1), 0, 4))];
+        *(p + 2) = base64_ref_alphabet[(int)cmove_bits_ref(*(inbuf + 1), 4, 2)];
+        *(p + 3) = '=';
+      }
+      else if (pad_num == 2)
+      {
+        *(p + 1) = base64_ref_alphabet[(int)cmove_bits_ref(*inbuf, 6, 2)];
+        *(p + 2) = '=';
+        *(p + 3) = '=';
+      }
+    }
+    else
+    {
+      *(p + 1) = base64_ref_alphabet[cmove_bits_ref(*inbuf, 6, 2) + cmove_bits_ref(*(inbuf + 1), 0, 4)];
+      *(p + 2) = base64_ref_alphabet[cmove_bits_ref(*(inbuf + 1), 4, 2) + cmove_bits_ref(*(inbuf + 2), 0, 6)];
+      *(p + 3) = base64_ref_alphabet[*(inbuf + 2) & 0x3f];
+    }
+    p += 4;
+    inbuf += 3;
+  }
+  *outlen = in_len * 8 / 6;
+  return 0;
+}
+
+static int base64_decode_ref(const char *indata, int, void *outdata, int *outlen)
+{
+  char *outbuf = (char *)outdata;
+  int t = 0, x = 0, y = 0, i = 0;
+  unsigned char c = 0;
+  int g = 3;
+  while (indata[x] != 0)
+  {
+    c = base64_ref_map[(unsigned char)indata[x++]];
+    if (c == 255)
+      return -1;
+    if (c == 253)
+      continue;
+    if (c == 254)
+    {
+      c = 0;
+      g--;
+    }
+    t = (t << 6) | c;
+    if (++y == 4)
+    {
+      outbuf[i++] = (unsigned char)((t >> 16) & 0xff);
+      if (g > 1)
+        outbuf[i++] = (unsigned char)((t >> 8) & 0xff);
+      if (g > 2)
+        outbuf[i++] = (unsigned char)(t & 0xff);
+      y = t = 0;
+    }
+  }
+  *outlen = i;
+  return 0;
+}
+
+/// @brief base64_encode/base64_decode与优化前的实现（_ref）比较，x86上包含SSSE3路径
+static void bench_base64()
+{
+  for (const auto size : payload_sizes)
+  {
+    int len{0};
+    base64_encode(input, static_cast<int>(size), text, &len);
+    const int text_len{len};
+    bench(sized("base64_encode", size), size, [size, &len]
+          { base64_encode(input, static_cast<int>(size), text, &len); keep(text); });
+    bench(sized("base64_decode", size), size, [text_len, &len]
+          { base64_decode(text, text_len, output, &len); keep(output); });
+    bench(sized("base64_encode_ref", size), size, [size, &len]
+          { base64_encode_ref(input, static_cast<int>(size), text, &len); keep(text); });
+    // 原实现读到结束符为止
+    text[text_len] = 0;
+    bench(sized("base64_decode_ref", size), size, [text_len, &len]
+          { base64_decode_ref(text, text_len, output, &len); keep(output); });
+  }
+}
+
+/// @brief 改为写入缓冲区之前的to_hex_str，逐字符push_back，作为to_hex_str和to_hex_buf的对照
+static std::string to_hex_str_old(const void *data_ptr, const size_t size, bool hex_uppercase = false)
+{
+  if (!data_ptr)
+  {
+    return "";
+  }
+  auto str_ptr = static_cast<const unsigned char *>(data_ptr);
+  auto hexme = hex_uppercase ? "0123456789ABCDEF" : "0123456789abcdef";
+  std::string result{};
+  size_t pos{0};
+  for (; pos < size - 1; ++pos)
+  {
+    result.push_back(hexme[(str_ptr[pos] & 0xF0) >> 4]);
+    result.push_back(hexme[str_ptr[pos] & 0x0F]);
+    result.push_back(' ');
+  }
+  result.push_back(hexme[(str_ptr[pos] & 0xF0) >> 4]);
+  result.push_back(hexme[str_ptr[pos] & 0x0F]);
+  return result;
+}
+
+static void bench_hex()
+{
+  for (const auto size : payload_sizes)
+  {
+    bench(sized("to_hex_buf", size), size, [size]
+          { keep(to_hex_buf(text, sizeof(text), input, std::min(size, sizeof(text) / 2 - 1))); keep(text); });
+    bench(sized("to_hex_str", size), size, [size]
+          { keep(to_hex_str(input, size)); });
+    bench(sized("to_hex_str_old", size), size, [size]
+          { keep(to_hex_str_old(input, size)); });
+  }
+}
+
+/// @brief 改用字节交换指令之前的endian_reverse，逐字节倒序复制，作为endian_reverse的对照
+template <typename _InputType>
+static _InputType endian_reverse_bytewise(const _InputType *val)
+{
+  _InputType result{0};
+  auto len = sizeof(_InputType);
+  unsigned char *rptr{reinterpret_cast<unsigned char *>(&result)};
+  const unsigned char *vptr{reinterpret_cast<const unsigned char *>(val)};
+  for (decltype(len) i = 0; i < len; i++)
+  {
+    rptr[i] = vptr[len - i - 1];
+  }
+  return result;
+}
+
+static void bench_endian()
+{
+  for (const auto size : payload_sizes)
+  {
+    const size_t count{size >= sizeof(uint32_t) ? size / sizeof(uint32_t) : 1};
+    bench(sized("endian_reverse_u32", size), count * sizeof(uint32_t), [count]
+          {
+            const auto *src{reinterpret_cast<const uint32_t *>(input)};
+            auto *dst{reinterpret_cast<uint32_t *>(output)};
+            for (size_t i = 0; i < count; ++i)
+            {
+              dst[i] = endian_reverse(src + i);
+            }
+            keep(output); });
+    bench(sized("endian_reverse_u32_bytewise", size), count * sizeof(uint32_t), [count]
+          {
+            const auto *src{reinterpret_cast<const uint32_t *>(input)};
+            auto *dst{reinterpret_cast<uint32_t *>(output)};
+            for (size_t i = 0; i < count; ++i)
+            {
+              dst[i] = endian_reverse_bytewise(src + i);
+            }
+            keep(output); });
+  }
+  double value{1.5};
+  bench("endian_reverse_double", sizeof(double), [&value]
+        { value = endian_reverse(&value); keep(value); });
+  bench("endian_reverse_double_bytewise", sizeof(double), [&value]
+        { value = endian_reverse_bytewise(&value); keep(value); });
+}
+
+/// @brief 每种队列按字节写入再读出，单线程测量每次操作的固定开销
+static void bench_queues()
+{
+  RingQueue<uint8_t> heap{8192};
+  StaticRingQueue<uint8_t, 8192> fixed;
+  static SpscRingQueue<uint8_t, 8192> spsc;
+  for (const auto size : payload_sizes)
+  {
+    bench(sized("ring_queue_write_read", size), size, [&heap, size]
+          { heap.write(input, size); keep(heap.read(output, size)); });
+    bench(sized("static_ring_queue_write_read", size), size, [&fixed, size]
+          { fixed.write(input, size); keep(fixed.read(output, size)); });
+    bench(sized("spsc_queue_write_read", size), size, [size]
+          { spsc.write(input, size); keep(spsc.read(output, size)); });
+  }
+
+  // 单个元素：无锁队列与加锁的RingQueue
+  static SpscRingQueue<uint32_t, 1024> spsc_words;
+  static MpscRingQueue<uint32_t, 1024> mpsc_words;
+  RingQueue<uint32_t> locked_words{1024};
+  std::mutex lock;
+  uint32_t word{0};
+  bench("spsc_queue_push_pop", 0, [&word]
+        { spsc_words.push(word); spsc_words.pop(word); keep(word); });
+  bench("mpsc_queue_push_pop", 0, [&word]
+        { mpsc_words.push(word); mpsc_words.pop(word); keep(word); });
+  bench("mutex_ring_queue_push_pop", 0, [&]
+        {
+          {
+            std::lock_guard<std::mutex> guard{lock};
+            locked_words.write(&word, 1);
+          }
+          std::lock_guard<std::mutex> guard{lock};
+          locked_words.read(&word, 1);
+          keep(word); });
+}
+
+/// @brief 不做任何事的出口端口，只测量路由器本身
+class NullPort : public RouterPort
+{
+public:
+  bool write(const uint8_t *data, size_t) override
+  {
+    keep(data);
+    return true;
+  }
+};
+
+static uint8_t classify_first_byte(uint8_t, const uint8_t *data, size_t)
+{
+  return data[0] & 1;
+}
+
+/// @brief 单帧从输入到发送的开销；数据队列积压时控制帧从进入到发送的调度时延
+static void bench_router()
+{
+  static Router<2, 2, 255, 16> router;
+  NullPort port;
+  router.attach(1, &port);
+  router.set_route(0, 1UL << 1);
+  router.set_classifier(classify_first_byte);
+  const size_t frame_sizes[]{1, 16, 64, 255};
+  for (const auto size : frame_sizes)
+  {
+    bench(sized("router_input_service", size), size, [size]
+          { router.input(0, input, size); keep(router.service(1)); });
+  }
+
+  // 控制帧进入时数据队列已满，测量控制帧进入到发送的时间
+  static Router<2, 2, 32, 16> backlog;
+  backlog.attach(1, &port);
+  backlog.set_route(0, 1UL << 1);
+  backlog.set_classifier(classify_first_byte);
+  const uint8_t bulk[32]{1};
+  const uint8_t control[8]{0};
+  while (backlog.input(0, bulk, sizeof(bulk)))
+  {
+  }
+  bench("router_control_latency", 0, [&]
+        {
+          backlog.input(0, control, sizeof(control));
+          keep(backlog.service(1, 1));
+          backlog.input(0, bulk, sizeof(bulk)); });
+}
+
+/// @brief 记录点的开销：每批写满队列后在计时之外格式化输出，与同步格式化一行日志比较
+static void bench_log()
+{
+  static DeferredLog<1024> log;
+  static constexpr DlogSite site{DLOG_LEVEL_INFO, "port %u sent %u bytes, queue %u/%u"};
+  static constexpr DlogSite hex_site{DLOG_LEVEL_INFO, "frame %u"};
+  auto discard = [](const char *data, size_t)
+  { keep(data); };
+  auto batched = [&](auto &&record)
+  {
+    return [&, record](uint64_t iterations)
+    {
+      BenchSample total;
+      for (uint64_t done = 0; done < iterations;)
+      {
+        const uint64_t batch{std::min<uint64_t>(iterations - done, 1024)};
+        const BenchTimer timer;
+        for (uint64_t i = 0; i < batch; ++i)
+        {
+          record(static_cast<uint32_t>(i));
+        }
+        const auto sample{timer.elapsed()};
+        total.ns += sample.ns;
+        total.cycles += sample.cycles;
+        log.drain(discard);
+        done += batch;
+      }
+      return total;
+    };
+  };
+  measure("dlog_record/4args", 0, batched([&](uint32_t i)
+                                          { log.record(&site, nullptr, 0, 1U, i, 16U, 64U); }));
+  measure("dlog_record_hex/32", 32, batched([&](uint32_t i)
+                                            { log.record(&hex_site, input, 32, i); }));
+  char line[160];
+  bench("snprintf_log_line", 0, [&line]
+        { keep(snprintf(line, sizeof(line), "[I][%lu.%03lu] port %u sent %u bytes, queue %u/%u\n",
+                        static_cast<unsigned long>(trace_now_us() / 1000000), static_cast<unsigned long>(trace_now_us() / 1000 % 1000),
+                        1U, 2U, 16U, 64U));
+          keep(line); });
+  bench("dlog_drain_line", 0, [&]
+        {
+          log.record(&site, nullptr, 0, 1U, 2U, 16U, 64U);
+          keep(log.drain(discard)); });
+}
+
+static std::string baseline_path()
+{
+  if (const char *path = getenv("BENCH_BASELINE"))
+  {
+    return path;
+  }
+  std::string path{__FILE__};
+  const auto slash{path.find_last_of('/')};
+  return (slash == std::string::npos ? std::string{"."} : path.substr(0, slash)) + "/baseline.json";
+}
+
+static bool write_results(const std::string &path)
+{
+  FILE *file{fopen(path.c_str(), "w")};
+  if (!file)
+  {
+    return false;
+  }
+  fprintf(file, "{\n  \"benchmarks\": [\n");
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    const auto &result{results[i]};
+    fprintf(file, "    {\"name\": \"%s\", \"bytes\": %zu, \"iterations\": %llu, \"ns_per_op\": %.2f, \"cycles_per_op\": %.1f}%s\n",
+            result.name.c_str(), result.bytes, static_cast<unsigned long long>(result.iterations), result.ns_per_op,
+            result.cycles_per_op, i + 1 < results.size() ? "," : "");
+  }
+  fprintf(file, "  ]\n}\n");
+  return fclose(file) == 0;
+}
+
+/// @brief 读取write_results写出的文件，只解析name、ns_per_op和cycles_per_op
+static std::vector<BenchResult> read_results(const std::string &path)
+{
+  std::vector<BenchResult> loaded;
+  FILE *file{fopen(path.c_str(), "r")};
+  if (!file)
+  {
+    return baseline;
+  }
+  char line[256];
+  while (fgets(line, sizeof(line), file))
+  {
+    const char *name{strstr(line, "\"name\": \"")};
+    const char *ns{strstr(line, "\"ns_per_op\": ")};
+    const char *cycles{strstr(line, "\"cycles_per_op\": ")};
+    if (!name || !ns)
+    {
+      continue;
+    }
+    name += strlen("\"name\": \"");
+    const char *end{strchr(name, '"')};
+    loaded.push_back({std::string(name, end ? end - name : 0), 0, 0, strtod(ns + strlen("\"ns_per_op\": "), nullptr),
+                      cycles ? strtod(cycles + strlen("\"cycles_per_op\": "), nullptr) : 0});
+  }
+  fclose(file);
+  return loaded;
+}
+
+/// @brief 写出结果并与基线比较，列出所有变慢超过容差的测试，设置BENCH_GATE时有变慢的测试则失败
+static void test_compare_baseline()
+{
+  const char *output_path{getenv("BENCH_OUTPUT")};
+  TEST_ASSERT_TRUE_MESSAGE(write_results(output_path ? output_path : "bench_output.json"), "cannot write benchmark results");
+
+  const char *update{getenv("BENCH_UPDATE_BASELINE")};
+  if (update && strcmp(update, "0") != 0)
+  {
+    TEST_ASSERT_TRUE_MESSAGE(write_results(baseline_path()), "cannot write baseline");
+    printf("baseline updated: %s\n", baseline_path().c_str());
+    return;
+  }
+  if (baseline.empty())
+  {
+    printf("no baseline at %s, run with BENCH_UPDATE_BASELINE=1 to create it\n", baseline_path().c_str());
+    return;
+  }
+  size_t regressions{0};
+  for (const auto &result : results)
+  {
+    const BenchResult *base{find_baseline(result.name)};
+    if (!base)
+    {
+      printf("%-32s not in baseline\n", result.name.c_str());
+    }
+    else if (regressed(result.ns_per_op, base))
+    {
+      printf("%-32s regressed: %.1f ns, baseline %.1f ns scaled to %.1f ns (+%.0f%%)\n", result.name.c_str(),
+             result.ns_per_op, base->ns_per_op, expected_ns(*base), (result.ns_per_op / expected_ns(*base) - 1.0) * 100);
+      ++regressions;
+    }
+  }
+  const char *gate{getenv("BENCH_GATE")};
+  if (!gate || strcmp(gate, "0") == 0)
+  {
+    printf("%zu benchmarks regressed beyond BENCH_TOLERANCE, set BENCH_GATE=1 to fail on regressions\n", regressions);
+    return;
+  }
+  TEST_ASSERT_EQUAL_MESSAGE(0, regressions, "benchmarks regressed beyond BENCH_TOLERANCE");
+}
+
+int main()
+{
+  baseline = read_results(baseline_path());
+  if (const char *value = getenv("BENCH_TOLERANCE"))
+  {
+    tolerance = strtod(value, nullptr);
+  }
+  for (size_t i = 0; i < sizeof(input); ++i)
+  {
+    input[i] = static_cast<uint8_t>(i * 131 + 7);
+  }
+  UNITY_BEGIN();
+  RUN_TEST(bench_reference);
+  RUN_TEST(bench_crc);
+  RUN_TEST(bench_base64);
+  RUN_TEST(bench_hex);
+  RUN_TEST(bench_endian);
+  RUN_TEST(bench_queues);
+  RUN_TEST(bench_router);
+  RUN_TEST(bench_log);
+  RUN_TEST(test_compare_baseline);
+  return UNITY_END();
+}
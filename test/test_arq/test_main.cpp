@@ -0,0 +1,396 @@
+/// @brief ARQ测试：按序交付、序号回绕、超时重发与退避、同一次poll发出的帧的快速重发、RTT估算、放弃重发后的跳过、对端重启后的重新同步
+///        0～30%随机丢包下的完整交付由test_sim_bridge覆盖
+
+#include <unity.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "arq.hpp"
+
+using Link = ArqLink<32, 8>;
+using Frame = std::vector<uint8_t>;
+
+void setUp() {}
+
+void tearDown() {}
+
+/// @brief 一端：ARQ、发出的帧和按序交付的数据
+struct Peer
+{
+  Link link;
+  std::vector<Frame> outbox;
+  std::vector<Frame> delivered;
+  bool busy{false}; // 模拟设备发送队列已满
+
+  Peer() = default;
+  explicit Peer(const Link::Config &config) : link(config) {}
+
+  void poll(uint32_t now_us)
+  {
+    link.poll(now_us, [this](const uint8_t *data, size_t len)
+              {
+                if (busy)
+                {
+                  return false;
+                }
+                outbox.emplace_back(data, data + len);
+                return true; });
+  }
+
+  void receive(const Frame &frame, uint32_t now_us)
+  {
+    TEST_ASSERT_TRUE(link.receive(frame.data(), frame.size(), now_us, [this](const uint8_t *data, size_t len)
+                                  { delivered.emplace_back(data, data + len); }));
+  }
+
+  bool send(uint8_t value)
+  {
+    const uint8_t data[]{value, static_cast<uint8_t>(~value)};
+    return link.send(data, sizeof(data));
+  }
+};
+
+/// @brief 把from发出的帧交给to，drop返回true的帧丢弃
+template <typename _DropFun>
+static void transfer(Peer &from, Peer &to, uint32_t now_us, _DropFun &&drop)
+{
+  auto frames{std::move(from.outbox)};
+  from.outbox.clear();
+  for (const auto &frame : frames)
+  {
+    if (!drop(frame))
+    {
+      to.receive(frame, now_us);
+    }
+  }
+}
+
+static void transfer(Peer &from, Peer &to, uint32_t now_us)
+{
+  transfer(from, to, now_us, [](const Frame &)
+           { return false; });
+}
+
+static bool is_data(const Frame &frame, uint8_t seq)
+{
+  return (frame[0] & 0xE0) == ARQ_TYPE_DATA && frame[1] == seq;
+}
+
+static void assert_delivered_in_order(const Peer &peer, uint32_t count)
+{
+  TEST_ASSERT_EQUAL(count, peer.delivered.size());
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    TEST_ASSERT_EQUAL(2, peer.delivered[i].size());
+    TEST_ASSERT_EQUAL(static_cast<uint8_t>(i), peer.delivered[i][0]);
+    TEST_ASSERT_EQUAL(static_cast<uint8_t>(~i), peer.delivered[i][1]);
+  }
+}
+
+/// @brief 只接受ARQ数据帧和长度正确的ACK，其它数据包由调用者处理
+static void test_match()
+{
+  const uint8_t data[]{ARQ_TYPE_DATA, 0, 1};
+  const uint8_t ack[]{ARQ_TYPE_ACK, 0, 0, 0, 0, 0};
+  const uint8_t short_ack[]{ARQ_TYPE_ACK, 0, 0};
+  const uint8_t control[]{0xc0, 0x00, 0x08};
+  TEST_ASSERT_TRUE(Link::match(data, sizeof(data)));
+  TEST_ASSERT_TRUE(Link::match(ack, sizeof(ack)));
+  TEST_ASSERT_FALSE(Link::match(data, ARQ_HEADER_SIZE));
+  TEST_ASSERT_FALSE(Link::match(short_ack, sizeof(short_ack)));
+  TEST_ASSERT_FALSE(Link::match(control, sizeof(control)));
+  Link link;
+  TEST_ASSERT_FALSE(link.receive(control, sizeof(control), 0, [](const uint8_t *, size_t) {}));
+}
+
+/// @brief 无丢包时按序交付，发送窗口满时拒绝新帧，收到确认后腾出空间
+static void test_in_order_without_loss()
+{
+  Peer a, b;
+  uint32_t now_us{0};
+  uint32_t next{0};
+  while (b.delivered.size() < 200)
+  {
+    while (next < 200 && a.send(static_cast<uint8_t>(next)))
+    {
+      ++next;
+    }
+    TEST_ASSERT_TRUE(a.link.in_flight() <= 8);
+    a.poll(now_us);
+    transfer(a, b, now_us);
+    b.poll(now_us);
+    transfer(b, a, now_us + 500);
+    now_us += 1000;
+  }
+  assert_delivered_in_order(b, 200);
+  TEST_ASSERT_EQUAL(200, a.link.stats().sent);
+  TEST_ASSERT_EQUAL(0, a.link.stats().retransmits);
+  TEST_ASSERT_EQUAL(0, a.link.in_flight());
+  TEST_ASSERT_EQUAL(UINT32_MAX, a.link.time_to_next_us(now_us));
+  const uint8_t too_long[Link::payload_size + 1]{};
+  TEST_ASSERT_FALSE(a.link.send(too_long, sizeof(too_long)));
+  TEST_ASSERT_FALSE(a.link.send(too_long, 0));
+}
+
+/// @brief 没有确认时按RTO重发，超时重发使RTO加倍
+static void test_timeout_retransmit_backs_off()
+{
+  Link::Config config;
+  config.initial_rto_us = 10000;
+  Peer a{config}, b;
+  a.send(0);
+  a.poll(0);
+  TEST_ASSERT_EQUAL(1, a.outbox.size());
+  a.outbox.clear(); // 丢失
+  TEST_ASSERT_EQUAL(10000, a.link.time_to_next_us(0));
+  a.poll(9999);
+  TEST_ASSERT_EQUAL(0, a.outbox.size());
+  a.poll(10000);
+  TEST_ASSERT_EQUAL(1, a.outbox.size());
+  TEST_ASSERT_EQUAL(1, a.link.stats().retransmits);
+  TEST_ASSERT_EQUAL(0, a.link.stats().fast_retransmits);
+  TEST_ASSERT_EQUAL(20000, a.link.rto_us());
+  transfer(a, b, 10000);
+  b.poll(10000);
+  transfer(b, a, 11000);
+  assert_delivered_in_order(b, 1);
+  // Karn算法：重发过的帧不采样
+  TEST_ASSERT_EQUAL(0, a.link.srtt_us());
+}
+
+/// @brief 同一次poll中发出的帧发送时间相同，选择确认显示后面的帧已经到达时仍然快速重发丢失的帧
+static void test_fast_retransmit_within_one_poll()
+{
+  Link::Config config;
+  config.initial_rto_us = 100000;
+  Peer a{config}, b;
+  for (uint8_t i = 0; i < 4; ++i)
+  {
+    a.send(i);
+  }
+  a.poll(0);
+  TEST_ASSERT_EQUAL(4, a.outbox.size());
+  transfer(a, b, 1000, [](const Frame &frame)
+           { return is_data(frame, 1); });
+  b.poll(1000);
+  transfer(b, a, 2000);
+  TEST_ASSERT_EQUAL(1, a.link.stats().fast_retransmits);
+  TEST_ASSERT_EQUAL(0, a.link.time_to_next_us(2000));
+  a.poll(2000);
+  TEST_ASSERT_EQUAL(1, a.outbox.size());
+  TEST_ASSERT_TRUE(is_data(a.outbox[0], 1));
+  TEST_ASSERT_EQUAL(1, a.link.stats().retransmits);
+  // 快速重发不退避
+  TEST_ASSERT_TRUE(a.link.rto_us() < config.initial_rto_us);
+  transfer(a, b, 3000);
+  assert_delivered_in_order(b, 4);
+  // 同一个ACK不会再次安排快速重发
+  b.poll(3000);
+  transfer(b, a, 4000);
+  TEST_ASSERT_EQUAL(1, a.link.stats().fast_retransmits);
+  TEST_ASSERT_EQUAL(0, a.link.in_flight());
+}
+
+/// @brief 快速重发的帧再次丢失时，更晚的确认可以再次安排快速重发
+static void test_fast_retransmit_after_retransmit_lost()
+{
+  Link::Config config;
+  config.initial_rto_us = 100000;
+  Peer a{config}, b;
+  for (uint8_t i = 0; i < 3; ++i)
+  {
+    a.send(i);
+  }
+  a.poll(0);
+  transfer(a, b, 100, [](const Frame &frame)
+           { return is_data(frame, 0); });
+  b.poll(100);
+  transfer(b, a, 200);
+  a.poll(200); // 快速重发0，再次丢失
+  a.outbox.clear();
+  a.send(3);
+  a.poll(300);
+  transfer(a, b, 400);
+  b.poll(400);
+  transfer(b, a, 500);
+  TEST_ASSERT_EQUAL(2, a.link.stats().fast_retransmits);
+  a.poll(500);
+  TEST_ASSERT_EQUAL(1, a.outbox.size());
+  TEST_ASSERT_TRUE(is_data(a.outbox[0], 0));
+  transfer(a, b, 600);
+  assert_delivered_in_order(b, 4);
+}
+
+/// @brief 固定往返时延下SRTT收敛到该值，RTO不低于下限
+static void test_rtt_estimate()
+{
+  Link::Config config;
+  config.min_rto_us = 2000;
+  Peer a{config}, b;
+  uint32_t now_us{0};
+  for (uint8_t i = 0; i < 50; ++i)
+  {
+    a.send(i);
+    a.poll(now_us);
+    transfer(a, b, now_us + 1500);
+    b.poll(now_us + 1500);
+    transfer(b, a, now_us + 3000);
+    now_us += 5000;
+  }
+  TEST_ASSERT_UINT32_WITHIN(100, 3000, a.link.srtt_us());
+  TEST_ASSERT_TRUE(a.link.rto_us() >= 3000 && a.link.rto_us() < 6000);
+}
+
+/// @brief 序号多次回绕后仍然按序交付，丢包时重发的帧与回绕后的新帧使用同一批窗口槽位
+static void test_sequence_wraps()
+{
+  Peer a, b;
+  uint32_t now_us{0};
+  uint32_t next{0}, frames{0};
+  auto drop_some = [&frames](const Frame &)
+  { return ++frames % 7 == 0; };
+  while (b.delivered.size() < 600)
+  {
+    TEST_ASSERT_TRUE(now_us < 10000000);
+    while (next < 600 && a.send(static_cast<uint8_t>(next)))
+    {
+      ++next;
+    }
+    a.poll(now_us);
+    transfer(a, b, now_us, drop_some);
+    b.poll(now_us);
+    transfer(b, a, now_us + 500, drop_some);
+    now_us += 1000;
+  }
+  assert_delivered_in_order(b, 600);
+  TEST_ASSERT_EQUAL(600, a.link.stats().sent);
+  TEST_ASSERT_TRUE(a.link.stats().retransmits > 0);
+  TEST_ASSERT_EQUAL(0, a.link.stats().expired);
+  TEST_ASSERT_EQUAL(0, b.link.stats().skipped);
+}
+
+/// @brief 超过最大重发次数后放弃，接收端根据数据帧中的窗口起点跳过空洞，不会永久阻塞
+static void test_expired_frame_is_skipped()
+{
+  Link::Config config;
+  config.initial_rto_us = 1000;
+  config.max_rto_us = 1000;
+  config.max_retries = 2;
+  Peer a{config}, b;
+  uint32_t now_us{0};
+  for (uint8_t i = 0; i < 6; ++i)
+  {
+    a.send(i);
+  }
+  for (int step = 0; step < 20; ++step)
+  {
+    a.poll(now_us);
+    transfer(a, b, now_us, [](const Frame &frame)
+             { return is_data(frame, 2); });
+    b.poll(now_us);
+    transfer(b, a, now_us);
+    now_us += 1000;
+  }
+  TEST_ASSERT_EQUAL(1, a.link.stats().expired);
+  TEST_ASSERT_EQUAL(0, a.link.in_flight());
+  // 放弃后的下一个新帧携带新的窗口起点
+  a.send(6);
+  a.poll(now_us);
+  transfer(a, b, now_us);
+  TEST_ASSERT_EQUAL(6, b.delivered.size());
+  TEST_ASSERT_EQUAL(1, b.link.stats().skipped);
+  for (uint32_t i = 0; i < 6; ++i)
+  {
+    TEST_ASSERT_EQUAL(i < 2 ? i : i + 1, b.delivered[i][0]);
+  }
+}
+
+/// @brief ACK丢失时发送端重发，接收端统计重复帧并再次确认
+static void test_lost_ack_duplicate()
+{
+  Link::Config config;
+  config.initial_rto_us = 5000;
+  Peer a{config}, b;
+  a.send(0);
+  a.poll(0);
+  transfer(a, b, 100);
+  b.poll(100);
+  b.outbox.clear(); // ACK丢失
+  a.poll(5000);
+  transfer(a, b, 5100);
+  TEST_ASSERT_EQUAL(1, b.link.stats().duplicates);
+  b.poll(5100);
+  transfer(b, a, 5200);
+  assert_delivered_in_order(b, 1);
+  TEST_ASSERT_EQUAL(0, a.link.in_flight());
+}
+
+/// @brief 设备忙时保留ACK和数据帧，下一次poll继续发送
+static void test_busy_device()
+{
+  Peer a, b;
+  a.send(0);
+  a.send(1);
+  a.busy = true;
+  a.poll(0);
+  TEST_ASSERT_EQUAL(0, a.outbox.size());
+  TEST_ASSERT_EQUAL(0, a.link.time_to_next_us(0));
+  a.busy = false;
+  a.poll(100);
+  TEST_ASSERT_EQUAL(2, a.outbox.size());
+  transfer(a, b, 200);
+  b.busy = true;
+  b.poll(200);
+  TEST_ASSERT_EQUAL(0, b.link.time_to_next_us(200));
+  b.busy = false;
+  b.poll(300);
+  TEST_ASSERT_EQUAL(1, b.outbox.size());
+  TEST_ASSERT_EQUAL(ARQ_TYPE_ACK, b.outbox[0][0]);
+  transfer(b, a, 400);
+  TEST_ASSERT_EQUAL(0, a.link.in_flight());
+}
+
+/// @brief 发送端重启后序号从0开始，接收端重新同步并继续交付
+static void test_sender_restart_resyncs()
+{
+  Peer b;
+  {
+    Peer a;
+    for (uint8_t i = 0; i < 100; ++i)
+    {
+      a.send(i);
+      a.poll(i * 1000U);
+      transfer(a, b, i * 1000U);
+      b.poll(i * 1000U);
+      transfer(b, a, i * 1000U);
+    }
+  }
+  assert_delivered_in_order(b, 100);
+  b.delivered.clear();
+  Peer a;
+  for (uint8_t i = 0; i < 3; ++i)
+  {
+    a.send(i);
+  }
+  a.poll(200000);
+  transfer(a, b, 200000);
+  assert_delivered_in_order(b, 3);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_match);
+  RUN_TEST(test_in_order_without_loss);
+  RUN_TEST(test_timeout_retransmit_backs_off);
+  RUN_TEST(test_fast_retransmit_within_one_poll);
+  RUN_TEST(test_fast_retransmit_after_retransmit_lost);
+  RUN_TEST(test_rtt_estimate);
+  RUN_TEST(test_sequence_wraps);
+  RUN_TEST(test_expired_frame_is_skipped);
+  RUN_TEST(test_lost_ack_duplicate);
+  RUN_TEST(test_busy_device);
+  RUN_TEST(test_sender_restart_resyncs);
+  return UNITY_END();
+}
@@ -0,0 +1,221 @@
+/// @brief base64测试：RFC 4648测试向量、1~3字节输入的穷举往返、流式接口的任意分段、错误输入以及较长输入中任意位置的任意字符
+
+#include <unity.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include "base64.h"
+
+void setUp() {}
+
+void tearDown() {}
+
+static void check_round_trip(const uint8_t *data, int length)
+{
+  char encoded[512];
+  uint8_t decoded[400];
+  int encoded_len{0}, decoded_len{0};
+  TEST_ASSERT_EQUAL(0, base64_encode(data, length, encoded, &encoded_len));
+  TEST_ASSERT_EQUAL((length + 2) / 3 * 4, encoded_len);
+  TEST_ASSERT_TRUE(encoded_len <= base64_encode_len(length));
+  TEST_ASSERT_EQUAL(0, base64_decode(encoded, encoded_len, decoded, &decoded_len));
+  TEST_ASSERT_EQUAL(length, decoded_len);
+  TEST_ASSERT_EQUAL_MEMORY(data, decoded, length);
+}
+
+static void test_rfc4648_vectors()
+{
+  static const char *const plain[]{"f", "fo", "foo", "foob", "fooba", "foobar"};
+  static const char *const encoded[]{"Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy"};
+  for (int i = 0; i < 6; ++i)
+  {
+    char out[16]{};
+    int out_len{0};
+    TEST_ASSERT_EQUAL(0, base64_encode(plain[i], static_cast<int>(strlen(plain[i])), out, &out_len));
+    TEST_ASSERT_EQUAL(static_cast<int>(strlen(encoded[i])), out_len);
+    TEST_ASSERT_EQUAL_MEMORY(encoded[i], out, out_len);
+
+    char decoded[16]{};
+    TEST_ASSERT_EQUAL(0, base64_decode(encoded[i], out_len, decoded, &out_len));
+    TEST_ASSERT_EQUAL(static_cast<int>(strlen(plain[i])), out_len);
+    TEST_ASSERT_EQUAL_MEMORY(plain[i], decoded, out_len);
+  }
+}
+
+/// @brief 所有1、2、3字节的输入，覆盖每种结尾补齐方式和字母表中的每个字符
+static void test_exhaustive_short_inputs()
+{
+  uint8_t data[3];
+  for (uint32_t v = 0; v < 0x100; ++v)
+  {
+    data[0] = static_cast<uint8_t>(v);
+    check_round_trip(data, 1);
+  }
+  for (uint32_t v = 0; v < 0x10000; ++v)
+  {
+    data[0] = static_cast<uint8_t>(v >> 8);
+    data[1] = static_cast<uint8_t>(v);
+    check_round_trip(data, 2);
+  }
+  for (uint32_t v = 0; v < 0x1000000; ++v)
+  {
+    data[0] = static_cast<uint8_t>(v >> 16);
+    data[1] = static_cast<uint8_t>(v >> 8);
+    data[2] = static_cast<uint8_t>(v);
+    char encoded[4];
+    uint8_t decoded[3];
+    int len{0};
+    base64_encode(data, 3, encoded, &len);
+    TEST_ASSERT_EQUAL(0, base64_decode(encoded, 4, decoded, &len));
+    TEST_ASSERT_EQUAL(3, len);
+    TEST_ASSERT_EQUAL_MEMORY(data, decoded, 3);
+  }
+}
+
+static void test_random_lengths()
+{
+  uint8_t data[300];
+  uint32_t seed{1};
+  for (int length = 1; length <= 300; ++length)
+  {
+    for (int i = 0; i < length; ++i)
+    {
+      seed = seed * 1103515245U + 12345U;
+      data[i] = static_cast<uint8_t>(seed >> 16);
+    }
+    check_round_trip(data, length);
+  }
+}
+
+/// @brief 流式接口按任意长度分段调用，结果与一次性调用相同；解码时忽略换行
+static void test_streaming_chunks()
+{
+  uint8_t data[200];
+  for (int i = 0; i < 200; ++i)
+  {
+    data[i] = static_cast<uint8_t>(i * 37 + 11);
+  }
+  char expected[300];
+  int expected_len{0};
+  base64_encode(data, sizeof(data), expected, &expected_len);
+
+  for (int chunk = 1; chunk <= 10; ++chunk)
+  {
+    char encoded[320];
+    int encoded_len{0};
+    base64_encode_state encoder;
+    base64_encode_begin(&encoder);
+    for (int offset = 0; offset < 200; offset += chunk)
+    {
+      const int n{offset + chunk > 200 ? 200 - offset : chunk};
+      encoded_len += base64_encode_update(&encoder, data + offset, n, encoded + encoded_len);
+    }
+    encoded_len += base64_encode_end(&encoder, encoded + encoded_len);
+    TEST_ASSERT_EQUAL(expected_len, encoded_len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, encoded, encoded_len);
+
+    // 每76个字符插入CRLF，模拟MIME格式
+    char wrapped[400];
+    int wrapped_len{0};
+    for (int i = 0; i < encoded_len; ++i)
+    {
+      if (i && i % 76 == 0)
+      {
+        wrapped[wrapped_len++] = '\r';
+        wrapped[wrapped_len++] = '\n';
+      }
+      wrapped[wrapped_len++] = encoded[i];
+    }
+    uint8_t decoded[220];
+    int decoded_len{0};
+    base64_decode_state decoder;
+    base64_decode_begin(&decoder);
+    for (int offset = 0; offset < wrapped_len; offset += chunk)
+    {
+      const int n{offset + chunk > wrapped_len ? wrapped_len - offset : chunk};
+      const int ret{base64_decode_update(&decoder, wrapped + offset, n, decoded + decoded_len)};
+      TEST_ASSERT_TRUE(ret >= 0);
+      decoded_len += ret;
+    }
+    TEST_ASSERT_EQUAL(0, base64_decode_end(&decoder));
+    TEST_ASSERT_EQUAL(200, decoded_len);
+    TEST_ASSERT_EQUAL_MEMORY(data, decoded, 200);
+  }
+}
+
+static void test_invalid_input()
+{
+  uint8_t out[16];
+  int out_len{0};
+  TEST_ASSERT_EQUAL(-1, base64_decode("Zm9*", 4, out, &out_len));
+  TEST_ASSERT_EQUAL(-2, base64_decode("Zm9vY", 5, out, &out_len));
+  // 长度是4的倍数，但换行或结束符使最后的分组不完整
+  TEST_ASSERT_EQUAL(-2, base64_decode("Zm9vYg=\n", 8, out, &out_len));
+  TEST_ASSERT_EQUAL(-2, base64_decode("Zm9vYg\0\0", 8, out, &out_len));
+  TEST_ASSERT_EQUAL(-1, base64_encode(nullptr, 3, reinterpret_cast<char *>(out), &out_len));
+
+  base64_decode_state state;
+  base64_decode_begin(&state);
+  TEST_ASSERT_EQUAL(3, base64_decode_update(&state, "Zm9vY", 5, out));
+  TEST_ASSERT_EQUAL(-2, base64_decode_end(&state));
+  TEST_ASSERT_EQUAL(0, base64_decode_end(&state)); // end会重置状态
+}
+
+/// @brief 较长输入的任意位置出现任意字符时，一次性解码（x86上经过SSSE3路径）与逐字符的流式解码结果相同
+static void test_any_character_in_long_input()
+{
+  char text[64];
+  uint8_t fast[48], slow[48];
+  for (int c = 1; c < 0x100; ++c)
+  {
+    for (size_t pos = 0; pos < sizeof(text); ++pos)
+    {
+      for (size_t i = 0; i < sizeof(text); ++i)
+      {
+        text[i] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[i];
+      }
+      text[pos] = static_cast<char>(c);
+      int fast_len{0};
+      const int fast_ret{base64_decode(text, sizeof(text), fast, &fast_len)};
+
+      base64_decode_state state;
+      base64_decode_begin(&state);
+      int slow_len{0}, slow_ret{0};
+      for (size_t i = 0; i < sizeof(text) && slow_ret == 0; ++i)
+      {
+        const int n{base64_decode_update(&state, text + i, 1, slow + slow_len)};
+        if (n < 0)
+        {
+          slow_ret = n;
+        }
+        else
+        {
+          slow_len += n;
+        }
+      }
+      if (slow_ret == 0)
+      {
+        slow_ret = base64_decode_end(&state);
+      }
+      TEST_ASSERT_EQUAL(slow_ret, fast_ret);
+      if (fast_ret == 0)
+      {
+        TEST_ASSERT_EQUAL(slow_len, fast_len);
+        TEST_ASSERT_EQUAL_MEMORY(slow, fast, slow_len);
+      }
+    }
+  }
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_rfc4648_vectors);
+  RUN_TEST(test_exhaustive_short_inputs);
+  RUN_TEST(test_random_lengths);
+  RUN_TEST(test_streaming_chunks);
+  RUN_TEST(test_invalid_input);
+  RUN_TEST(test_any_character_in_long_input);
+  return UNITY_END();
+}
@@ -0,0 +1,116 @@
+/// @brief 16进制格式化测试：缓存版本与std::string版本结果一致，缓存不足时的截断规则
+
+#include <unity.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "bytes_string.hpp"
+
+void setUp() {}
+
+void tearDown() {}
+
+static uint8_t all_bytes[256];
+
+/// @brief 每个字节值与snprintf("%02x")的结果一致，字节之间用空格分隔
+static void test_hex_matches_printf()
+{
+  std::string expected, expected_upper;
+  char pair[4];
+  for (int i = 0; i < 256; ++i)
+  {
+    snprintf(pair, sizeof(pair), i ? " %02x" : "%02x", i);
+    expected += pair;
+    snprintf(pair, sizeof(pair), i ? " %02X" : "%02X", i);
+    expected_upper += pair;
+  }
+  char buffer[hex_str_len(256) + 1];
+  TEST_ASSERT_EQUAL(hex_str_len(256), to_hex_buf(buffer, sizeof(buffer), all_bytes, 256));
+  TEST_ASSERT_EQUAL_STRING(expected.c_str(), buffer);
+  TEST_ASSERT_EQUAL(hex_str_len(256), to_hex_buf(buffer, sizeof(buffer), all_bytes, 256, true));
+  TEST_ASSERT_EQUAL_STRING(expected_upper.c_str(), buffer);
+  TEST_ASSERT_EQUAL_STRING(expected.c_str(), to_hex_str(all_bytes, 256).c_str());
+  TEST_ASSERT_EQUAL_STRING("7f", to_hex_str(static_cast<char>(0x7F)).c_str());
+  TEST_ASSERT_EQUAL_STRING("AB", to_hex_str(static_cast<char>(0xAB), true).c_str());
+}
+
+/// @brief 缓存不足时只输出完整的字节，并且始终以'\0'结尾
+static void test_hex_truncation()
+{
+  const uint8_t data[]{0x01, 0x23, 0x45, 0x67};
+  for (size_t dst_size = 1; dst_size <= hex_str_len(sizeof(data)) + 1; ++dst_size)
+  {
+    char buffer[16];
+    memset(buffer, 'x', sizeof(buffer));
+    const size_t written{to_hex_buf(buffer, dst_size, data, sizeof(data))};
+    const size_t whole{dst_size > hex_str_len(sizeof(data)) ? sizeof(data) : dst_size / 3};
+    TEST_ASSERT_EQUAL(hex_str_len(whole), written);
+    TEST_ASSERT_EQUAL('\0', buffer[written]);
+    TEST_ASSERT_EQUAL('x', buffer[dst_size]); // 不越界写入
+    TEST_ASSERT_EQUAL_MEMORY("01 23 45 67", buffer, written);
+  }
+  char buffer[4]{'x'};
+  TEST_ASSERT_EQUAL(0, to_hex_buf(buffer, sizeof(buffer), nullptr, 4));
+  TEST_ASSERT_EQUAL_STRING("", buffer);
+  TEST_ASSERT_EQUAL(0, to_hex_buf(nullptr, 4, all_bytes, 4));
+  TEST_ASSERT_EQUAL_STRING("", to_hex_str(all_bytes, 0).c_str());
+}
+
+/// @brief to_byte_buf/to_byte_vibuf与对应的std::string版本在所有字节值上一致
+static void test_escaped_matches_string()
+{
+  char buffer[256 * 4 + 1];
+  for (bool upper : {false, true})
+  {
+    const std::string plain{to_byte_str(all_bytes, 256, upper)};
+    TEST_ASSERT_EQUAL(plain.size(), to_byte_buf(buffer, sizeof(buffer), all_bytes, 256, upper));
+    TEST_ASSERT_EQUAL_STRING(plain.c_str(), buffer);
+    const std::string visible{to_byte_vistr(all_bytes, 256, upper)};
+    TEST_ASSERT_EQUAL(visible.size(), to_byte_vibuf(buffer, sizeof(buffer), all_bytes, 256, upper));
+    TEST_ASSERT_EQUAL_STRING(visible.c_str(), buffer);
+  }
+  const uint8_t data[]{'a', '\n', 0xFF, 'b'};
+  to_byte_buf(buffer, sizeof(buffer), data, sizeof(data));
+  TEST_ASSERT_EQUAL_STRING("a\n\\xffb", buffer);
+  to_byte_vibuf(buffer, sizeof(buffer), data, sizeof(data), true);
+  TEST_ASSERT_EQUAL_STRING("a\\x0A\\xFFb", buffer);
+}
+
+/// @brief 截断时不会输出半个转义序列
+static void test_escaped_truncation()
+{
+  const uint8_t data[]{'a', 0x00, 'b'};
+  const char *const expected[]{"", "a", "a", "a", "a", "a\\x00", "a\\x00b"};
+  for (size_t dst_size = 1; dst_size <= 7; ++dst_size)
+  {
+    char buffer[8];
+    memset(buffer, 'x', sizeof(buffer));
+    TEST_ASSERT_EQUAL(strlen(expected[dst_size - 1]), to_byte_vibuf(buffer, dst_size, data, sizeof(data)));
+    TEST_ASSERT_EQUAL_STRING(expected[dst_size - 1], buffer);
+    TEST_ASSERT_EQUAL('x', buffer[dst_size]);
+  }
+}
+
+static void test_hex_array()
+{
+  const uint8_t data[]{0xDE, 0xAD, 0xBE, 0xEF, 0x00};
+  TEST_ASSERT_EQUAL_STRING("de ad", to_hex_array<2>(data, sizeof(data)).data());
+  TEST_ASSERT_EQUAL_STRING("DE AD BE EF 00", to_hex_array<8>(data, sizeof(data), true).data());
+}
+
+int main()
+{
+  for (int i = 0; i < 256; ++i)
+  {
+    all_bytes[i] = static_cast<uint8_t>(i);
+  }
+  UNITY_BEGIN();
+  RUN_TEST(test_hex_matches_printf);
+  RUN_TEST(test_hex_truncation);
+  RUN_TEST(test_escaped_matches_string);
+  RUN_TEST(test_escaped_truncation);
+  RUN_TEST(test_hex_array);
+  return UNITY_END();
+}
@@ -0,0 +1,118 @@
+/// @brief 控制帧分发测试：使用模拟的RadioDevice记录换频请求
+
+#include <unity.h>
+
+#include <cstdint>
+
+#include "control_protocol.h"
+
+void setUp() {}
+
+void tearDown() {}
+
+/// @brief 只记录retune调用的设备
+class MockRadio : public RadioDevice
+{
+public:
+  uint32_t retune_calls{0};
+  uint32_t frequency_hz{0};
+  uint32_t offset_hz{0}; // 非0时模拟设备无法精确设置到目标频率
+
+  bool send(uint8_t *, size_t) override { return true; }
+  bool recv(uint8_t *, size_t &) override { return false; }
+  uint32_t set_frequency(uint32_t hz) override { return hz; }
+  uint32_t retune(uint32_t hz) override
+  {
+    ++retune_calls;
+    frequency_hz = hz;
+    return hz + offset_hz;
+  }
+  uint8_t set_power(uint8_t power) override { return power; }
+  uint32_t set_data_rate(uint32_t rate) override { return rate; }
+  uint8_t set_addr_width(uint8_t addr_width) override { return addr_width; }
+  bool shutdown() override { return true; }
+  bool reboot() override { return true; }
+  void *device() override { return nullptr; }
+};
+
+static uint8_t hop_frame[CONTROL_FRAME_MAX_LEN]{0xc0, 0x00, 0x08, 0x00, 0x00, 0xe7, 0x80, 0x00, 0x00, 0x00, 0x00};
+
+static void test_every_channel_retunes()
+{
+  for (uint8_t channel = 0; channel < CHANNEL_COUNT; ++channel)
+  {
+    MockRadio radio;
+    hop_frame[7] = channel * CHANNEL_CODE_STEP;
+    TEST_ASSERT_TRUE(control_match(hop_frame, sizeof(hop_frame)));
+    TEST_ASSERT_EQUAL(CmdResult::SUCCESS, control_dispatch(radio, hop_frame, sizeof(hop_frame)));
+    TEST_ASSERT_EQUAL(1, radio.retune_calls);
+    TEST_ASSERT_EQUAL((CHANNEL_BASE_MHZ + CHANNEL_STEP_MHZ * channel) * 1000000UL, radio.frequency_hz);
+  }
+}
+
+/// @brief 匹配签名但信道码非法时不换频，返回FAILED
+static void test_invalid_channel_code_fails()
+{
+  const uint8_t codes[]{1, 4, CHANNEL_COUNT * CHANNEL_CODE_STEP, 0xff};
+  for (uint8_t code : codes)
+  {
+    MockRadio radio;
+    hop_frame[7] = code;
+    TEST_ASSERT_EQUAL(CmdResult::FAILED, control_dispatch(radio, hop_frame, sizeof(hop_frame)));
+    TEST_ASSERT_EQUAL(0, radio.retune_calls);
+  }
+}
+
+/// @brief 设备返回的频率与目标不同时视为失败
+static void test_retune_mismatch_fails()
+{
+  MockRadio radio;
+  radio.offset_hz = 1000;
+  hop_frame[7] = 0;
+  TEST_ASSERT_EQUAL(CmdResult::FAILED, control_dispatch(radio, hop_frame, sizeof(hop_frame)));
+  TEST_ASSERT_EQUAL(1, radio.retune_calls);
+}
+
+/// @brief 长度不同或任意一个签名字节不同的帧都按普通数据处理
+static void test_non_control_frames()
+{
+  MockRadio radio;
+  hop_frame[7] = 0;
+  TEST_ASSERT_EQUAL(CmdResult::NO_MATCH, control_dispatch(radio, hop_frame, sizeof(hop_frame) - 1));
+  uint8_t longer[CONTROL_FRAME_MAX_LEN + 1]{};
+  for (size_t i = 0; i < sizeof(hop_frame); ++i)
+  {
+    longer[i] = hop_frame[i];
+  }
+  TEST_ASSERT_FALSE(control_match(longer, sizeof(longer)));
+  for (size_t i = 0; i < sizeof(hop_frame); ++i)
+  {
+    if (i == 7)
+    {
+      continue; // 信道码是参数
+    }
+    hop_frame[i] ^= 0x01;
+    TEST_ASSERT_EQUAL(CmdResult::NO_MATCH, control_dispatch(radio, hop_frame, sizeof(hop_frame)));
+    hop_frame[i] ^= 0x01;
+  }
+  TEST_ASSERT_EQUAL(0, radio.retune_calls);
+}
+
+static void test_channel_code_table()
+{
+  static_assert(channel_code_to_hz(0) == 2402000000UL, "first channel");
+  static_assert(channel_code_to_hz((CHANNEL_COUNT - 1) * CHANNEL_CODE_STEP) == (CHANNEL_BASE_MHZ + CHANNEL_STEP_MHZ * (CHANNEL_COUNT - 1)) * 1000000UL, "last channel");
+  static_assert(channel_code_to_hz(3) == 0, "not a multiple of the step");
+  TEST_ASSERT_EQUAL(0, channel_code_to_hz(CHANNEL_COUNT * CHANNEL_CODE_STEP));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_every_channel_retunes);
+  RUN_TEST(test_invalid_channel_code_fails);
+  RUN_TEST(test_retune_mismatch_fails);
+  RUN_TEST(test_non_control_frames);
+  RUN_TEST(test_channel_code_table);
+  return UNITY_END();
+}
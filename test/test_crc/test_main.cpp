@@ -0,0 +1,143 @@
+/// @brief CRC测试：标准校验值，以及查表/slicing实现、增量计算与逐位参考实现的一致性
+
+#include <unity.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include "crc.hpp"
+#include "crc16.h"
+
+void setUp() {}
+
+void tearDown() {}
+
+static const char CHECK_STRING[]{"123456789"};
+
+/// @brief 逐位计算的参考实现
+static uint16_t reference(uint16_t poly, uint16_t init, bool reflect, uint16_t xorout, const uint8_t *data, size_t length)
+{
+  uint16_t crc{init};
+  for (size_t i = 0; i < length; ++i)
+  {
+    uint8_t byte{data[i]};
+    if (reflect)
+    {
+      uint8_t reflected{0};
+      for (int bit = 0; bit < 8; ++bit)
+      {
+        if (byte & (1U << bit))
+        {
+          reflected |= static_cast<uint8_t>(0x80U >> bit);
+        }
+      }
+      byte = reflected;
+    }
+    crc ^= static_cast<uint16_t>(byte << 8);
+    for (int bit = 0; bit < 8; ++bit)
+    {
+      crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ poly) : static_cast<uint16_t>(crc << 1);
+    }
+  }
+  if (reflect)
+  {
+    uint16_t reflected{0};
+    for (int bit = 0; bit < 16; ++bit)
+    {
+      if (crc & (1U << bit))
+      {
+        reflected |= static_cast<uint16_t>(0x8000U >> bit);
+      }
+    }
+    crc = reflected;
+  }
+  return crc ^ xorout;
+}
+
+static void fill(uint8_t *data, size_t length)
+{
+  uint32_t seed{0x12345678};
+  for (size_t i = 0; i < length; ++i)
+  {
+    seed = seed * 1103515245U + 12345U;
+    data[i] = static_cast<uint8_t>(seed >> 16);
+  }
+}
+
+static void test_check_values()
+{
+  TEST_ASSERT_EQUAL_HEX16(0x4B37, Crc16Modbus::compute(CHECK_STRING, 9));
+  TEST_ASSERT_EQUAL_HEX16(0x29B1, Crc16Ccitt::compute(CHECK_STRING, 9));
+  // CRC-16/ARC和CRC-16/XMODEM，覆盖其他init/xorout组合
+  TEST_ASSERT_EQUAL_HEX16(0xBB3D, (Crc16<0x8005, 0x0000, true, 0x0000>::compute(CHECK_STRING, 9)));
+  TEST_ASSERT_EQUAL_HEX16(0x31C3, (Crc16<0x1021, 0x0000, false, 0x0000>::compute(CHECK_STRING, 9)));
+  TEST_ASSERT_EQUAL_HEX16(0xD64E, (Crc16<0x1021, 0xFFFF, false, 0xFFFF>::compute(CHECK_STRING, 9)));
+}
+
+/// @brief crc16()按帧中的字节顺序返回，与Crc16Modbus互为字节交换
+static void test_c_api_matches_template()
+{
+  char buffer[sizeof(CHECK_STRING)];
+  memcpy(buffer, CHECK_STRING, sizeof(buffer));
+  TEST_ASSERT_EQUAL_HEX16(0x374B, crc16(buffer, 9));
+
+  uint8_t data[300];
+  fill(data, sizeof(data));
+  for (size_t length = 0; length <= sizeof(data); ++length)
+  {
+    const uint16_t value{Crc16Modbus::compute(data, length)};
+    TEST_ASSERT_EQUAL_HEX16(static_cast<uint16_t>((value >> 8) | (value << 8)), crc16(data, length));
+  }
+}
+
+/// @brief 逐字节查表和不同的slices数量在所有长度（包含不足一组的尾部）上与逐位实现一致
+static void test_slices_match_reference()
+{
+  uint8_t data[100];
+  fill(data, sizeof(data));
+  for (size_t length = 0; length <= sizeof(data); ++length)
+  {
+    const uint16_t modbus{reference(0x8005, 0xFFFF, true, 0x0000, data, length)};
+    const uint16_t ccitt{reference(0x1021, 0xFFFF, false, 0x0000, data, length)};
+    TEST_ASSERT_EQUAL_HEX16(modbus, (Crc16<0x8005, 0xFFFF, true, 0x0000, 1>::compute(data, length)));
+    TEST_ASSERT_EQUAL_HEX16(modbus, (Crc16<0x8005, 0xFFFF, true, 0x0000, 2>::compute(data, length)));
+    TEST_ASSERT_EQUAL_HEX16(modbus, (Crc16<0x8005, 0xFFFF, true, 0x0000, 4>::compute(data, length)));
+    TEST_ASSERT_EQUAL_HEX16(modbus, Crc16Modbus::compute(data, length));
+    TEST_ASSERT_EQUAL_HEX16(modbus, (Crc16<0x8005, 0xFFFF, true, 0x0000, 16>::compute(data, length)));
+    TEST_ASSERT_EQUAL_HEX16(ccitt, (Crc16<0x1021, 0xFFFF, false, 0x0000, 1>::compute(data, length)));
+    TEST_ASSERT_EQUAL_HEX16(ccitt, (Crc16<0x1021, 0xFFFF, false, 0x0000, 2>::compute(data, length)));
+    TEST_ASSERT_EQUAL_HEX16(ccitt, Crc16Ccitt::compute(data, length));
+    TEST_ASSERT_EQUAL_HEX16(ccitt, (Crc16<0x1021, 0xFFFF, false, 0x0000, 16>::compute(data, length)));
+  }
+}
+
+/// @brief 在任意位置分段增量计算，结果与一次性计算相同
+static void test_incremental_split()
+{
+  uint8_t data[64];
+  fill(data, sizeof(data));
+  const uint16_t whole{crc16(data, sizeof(data))};
+  const uint16_t whole_ccitt{Crc16Ccitt::compute(data, sizeof(data))};
+  for (size_t split = 0; split <= sizeof(data); ++split)
+  {
+    unsigned short crc{crc16_init()};
+    crc = crc16_update(crc, data, split);
+    crc = crc16_update(crc, data + split, sizeof(data) - split);
+    TEST_ASSERT_EQUAL_HEX16(whole, crc16_final(crc));
+
+    uint16_t ccitt{Crc16Ccitt::init()};
+    ccitt = Crc16Ccitt::update(ccitt, data, split);
+    ccitt = Crc16Ccitt::update(ccitt, data + split, sizeof(data) - split);
+    TEST_ASSERT_EQUAL_HEX16(whole_ccitt, Crc16Ccitt::final(ccitt));
+  }
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_check_values);
+  RUN_TEST(test_c_api_matches_template);
+  RUN_TEST(test_slices_match_reference);
+  RUN_TEST(test_incremental_split);
+  return UNITY_END();
+}
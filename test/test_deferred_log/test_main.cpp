@@ -0,0 +1,219 @@
+/// @brief 延迟日志测试：格式化输出、附带数据的截断、队列满时的丢弃计数、分批输出、编译期删除的记录点以及多个线程同时写入
+
+#include <unity.h>
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "deferred_log.hpp"
+
+void setUp()
+{
+  dlog.drain([](const char *, size_t) {});
+}
+
+void tearDown() {}
+
+/// @brief 输出的所有行
+static std::vector<std::string> drain_lines(DeferredLog<8> &log, size_t max_records = 8)
+{
+  std::string text;
+  log.drain([&](const char *data, size_t len)
+            { text.append(data, len); },
+            max_records);
+  std::vector<std::string> lines;
+  for (size_t start = 0, end; (end = text.find('\n', start)) != std::string::npos; start = end + 1)
+  {
+    lines.push_back(text.substr(start, end - start));
+  }
+  return lines;
+}
+
+/// @brief 去掉等级和时间戳前缀，只保留格式化后的正文
+static std::string body(const std::string &line)
+{
+  const size_t pos{line.find("] ")};
+  return pos == std::string::npos ? line : line.substr(pos + 2);
+}
+
+/// @brief 每个等级使用对应的字符，时间戳为 秒.毫秒，参数按格式字符串格式化
+static void test_format_and_level()
+{
+  static DeferredLog<8> log;
+  static constexpr DlogSite info{DLOG_LEVEL_INFO, "port %u sent %d bytes"};
+  static constexpr DlogSite warn{DLOG_LEVEL_WARN, "addr %X char %c"};
+  static constexpr DlogSite error{DLOG_LEVEL_ERROR, "no args"};
+  log.record(&info, nullptr, 0, 3, 120U);
+  log.record(&warn, nullptr, 0, 0xBEEFU, 'k');
+  log.record(&error, nullptr, 0);
+  const auto lines{drain_lines(log)};
+  TEST_ASSERT_EQUAL(3, lines.size());
+  TEST_ASSERT_TRUE(lines[0].rfind("[I][", 0) == 0);
+  TEST_ASSERT_TRUE(lines[1].rfind("[W][", 0) == 0);
+  TEST_ASSERT_TRUE(lines[2].rfind("[E][", 0) == 0);
+  unsigned long seconds, millis;
+  TEST_ASSERT_EQUAL(2, sscanf(lines[0].c_str(), "[I][%lu.%lu] ", &seconds, &millis));
+  TEST_ASSERT_TRUE(millis < 1000);
+  TEST_ASSERT_EQUAL_STRING("port 3 sent 120 bytes", body(lines[0]).c_str());
+  TEST_ASSERT_EQUAL_STRING("addr BEEF char k", body(lines[1]).c_str());
+  TEST_ASSERT_EQUAL_STRING("no args", body(lines[2]).c_str());
+  TEST_ASSERT_EQUAL(0, log.drain([](const char *, size_t) {}));
+}
+
+/// @brief 附带数据以16进制追加在行尾，超过DLOG_MAX_BLOB的部分截断
+static void test_blob_hex_and_truncation()
+{
+  static DeferredLog<8> log;
+  static constexpr DlogSite site{DLOG_LEVEL_INFO, "frame %u"};
+  const uint8_t small[]{0x01, 0xAB, 0xFF};
+  uint8_t large[DLOG_MAX_BLOB + 8];
+  for (size_t i = 0; i < sizeof(large); ++i)
+  {
+    large[i] = static_cast<uint8_t>(i);
+  }
+  log.record(&site, small, sizeof(small), 1);
+  log.record(&site, large, sizeof(large), 2);
+  const auto lines{drain_lines(log)};
+  TEST_ASSERT_EQUAL(2, lines.size());
+  const std::string first{body(lines[0])};
+  std::string hex(hex_str_len(sizeof(small)) + 1, '\0');
+  hex.resize(to_hex_buf(hex.data(), hex.size(), small, sizeof(small)));
+  TEST_ASSERT_EQUAL_STRING(("frame 1 " + hex).c_str(), first.c_str());
+  hex.assign(hex_str_len(DLOG_MAX_BLOB) + 1, '\0');
+  hex.resize(to_hex_buf(hex.data(), hex.size(), large, DLOG_MAX_BLOB));
+  TEST_ASSERT_EQUAL_STRING(("frame 2 " + hex).c_str(), body(lines[1]).c_str());
+}
+
+/// @brief 队列满时丢弃新记录并计数，drain在输出后报告一次丢弃数量
+static void test_dropped_records()
+{
+  static DeferredLog<8> log;
+  static constexpr DlogSite site{DLOG_LEVEL_INFO, "record %u"};
+  for (uint32_t i = 0; i < 11; ++i)
+  {
+    log.record(&site, nullptr, 0, i);
+  }
+  TEST_ASSERT_EQUAL(3, log.dropped());
+  auto lines{drain_lines(log)};
+  TEST_ASSERT_EQUAL(9, lines.size());
+  TEST_ASSERT_EQUAL_STRING("record 0", body(lines[0]).c_str());
+  TEST_ASSERT_EQUAL_STRING("record 7", body(lines[7]).c_str());
+  TEST_ASSERT_EQUAL_STRING("[W] deferred log dropped 3 records", lines[8].c_str());
+  // 只报告新增的丢弃数量
+  TEST_ASSERT_EQUAL(0, drain_lines(log).size());
+  for (uint32_t i = 0; i < 9; ++i)
+  {
+    log.record(&site, nullptr, 0, i);
+  }
+  lines = drain_lines(log);
+  TEST_ASSERT_EQUAL(9, lines.size());
+  TEST_ASSERT_EQUAL_STRING("[W] deferred log dropped 1 records", lines[8].c_str());
+  TEST_ASSERT_EQUAL(4, log.dropped());
+}
+
+/// @brief 每次drain最多处理max_records条记录，剩余的记录留给下一次
+static void test_max_records()
+{
+  static DeferredLog<8> log;
+  static constexpr DlogSite site{DLOG_LEVEL_INFO, "record %u"};
+  for (uint32_t i = 0; i < 5; ++i)
+  {
+    log.record(&site, nullptr, 0, i);
+  }
+  auto lines{drain_lines(log, 2)};
+  TEST_ASSERT_EQUAL(2, lines.size());
+  TEST_ASSERT_EQUAL_STRING("record 1", body(lines[1]).c_str());
+  lines = drain_lines(log, 2);
+  TEST_ASSERT_EQUAL_STRING("record 2", body(lines[0]).c_str());
+  lines = drain_lines(log, 2);
+  TEST_ASSERT_EQUAL(1, lines.size());
+  TEST_ASSERT_EQUAL_STRING("record 4", body(lines[0]).c_str());
+}
+
+/// @brief 默认的DLOG_MIN_LEVEL为INFO，DEBUG和TRACE记录点在编译时删除，参数不会求值
+static void test_compiled_out_levels()
+{
+  TEST_ASSERT_EQUAL(DLOG_LEVEL_INFO, DLOG_MIN_LEVEL);
+  int evaluated{0};
+  DLOG_TRACE("trace %d", ++evaluated);
+  DLOG_DEBUG("debug %d", ++evaluated);
+  DLOG_DEBUG_HEX("debug %d", nullptr, 0, ++evaluated);
+  TEST_ASSERT_EQUAL(0, evaluated);
+  DLOG_INFO("info %d", ++evaluated);
+  DLOG_ERROR_HEX("error", "\x12", 1);
+  TEST_ASSERT_EQUAL(1, evaluated);
+  std::string text;
+  TEST_ASSERT_EQUAL(2, dlog_drain([&](const char *data, size_t len)
+                                  { text.append(data, len); }));
+  TEST_ASSERT_TRUE(text.find("[I][") == 0);
+  TEST_ASSERT_TRUE(text.find("] info 1\n") != std::string::npos);
+  TEST_ASSERT_TRUE(text.find("] error 12\n") != std::string::npos);
+}
+
+/// @brief 多个线程同时写入，输出端同时读取，每条记录完整输出一次，丢弃的数量计入统计
+static void test_concurrent_producers()
+{
+  static DeferredLog<64> log;
+  static constexpr DlogSite site{DLOG_LEVEL_INFO, "%u %u %u"};
+  constexpr uint32_t threads{3}, per_thread{2000};
+  std::atomic<uint32_t> finished{0};
+  std::thread producers[threads];
+  for (uint32_t t = 0; t < threads; ++t)
+  {
+    producers[t] = std::thread{[&, t]
+                               {
+                                 for (uint32_t i = 0; i < per_thread; ++i)
+                                 {
+                                   // 第三个参数用于检查记录是否完整
+                                   log.record(&site, nullptr, 0, t, i, t * per_thread + i);
+                                   if ((i & 0x1F) == 0)
+                                   {
+                                     std::this_thread::yield();
+                                   }
+                                 }
+                                 ++finished;
+                               }};
+  }
+  std::vector<int32_t> last(threads, -1);
+  uint32_t received{0};
+  auto check = [&](const char *data, size_t len)
+  {
+    unsigned t, i, sum;
+    if (sscanf(std::string(data, len).c_str(), "[I][%*u.%*u] %u %u %u", &t, &i, &sum) != 3)
+    {
+      return; // 丢弃报告
+    }
+    TEST_ASSERT_TRUE(t < threads);
+    TEST_ASSERT_EQUAL(t * per_thread + i, sum);
+    // 同一个线程的记录按写入顺序输出
+    TEST_ASSERT_TRUE(static_cast<int32_t>(i) > last[t]);
+    last[t] = static_cast<int32_t>(i);
+    ++received;
+  };
+  while (finished < threads)
+  {
+    log.drain(check);
+    std::this_thread::yield();
+  }
+  log.drain(check);
+  for (auto &producer : producers)
+  {
+    producer.join();
+  }
+  TEST_ASSERT_EQUAL(threads * per_thread, received + log.dropped());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_format_and_level);
+  RUN_TEST(test_blob_hex_and_truncation);
+  RUN_TEST(test_dropped_records);
+  RUN_TEST(test_max_records);
+  RUN_TEST(test_compiled_out_levels);
+  RUN_TEST(test_concurrent_producers);
+  return UNITY_END();
+}
@@ -0,0 +1,138 @@
+/// @brief 字节序测试：endian_reverse/byte_swap覆盖所有算术类型，以及EndianField和number_*辅助函数
+
+#include <unity.h>
+
+#include <cstdint>
+#include <cstring>
+#include <cfloat>
+
+#include "endian.hpp"
+
+void setUp() {}
+
+void tearDown() {}
+
+/// @brief 按值返回时能够保留的字节数
+///        x87扩展精度的long double只有前10字节有效，其余填充字节经过寄存器后不保证保留
+template <typename _Type>
+static constexpr size_t value_size()
+{
+#if LDBL_MANT_DIG == 64
+  if constexpr (std::is_same<_Type, long double>::value)
+  {
+    return 10;
+  }
+#endif
+  return sizeof(_Type);
+}
+
+/// @brief 用1, 2, 3...填充值的每个字节，反转后逐字节比较
+template <typename _Type>
+static void check_reverse()
+{
+  unsigned char bytes[sizeof(_Type)];
+  for (size_t i = 0; i < sizeof(_Type); ++i)
+  {
+    bytes[i] = static_cast<unsigned char>(i + 1);
+  }
+  _Type val;
+  std::memcpy(&val, bytes, sizeof(val));
+
+  const _Type reversed{endian_reverse(&val)};
+  unsigned char out[sizeof(_Type)];
+  std::memcpy(out, &reversed, sizeof(out));
+  for (size_t i = 0; i < value_size<_Type>(); ++i)
+  {
+    TEST_ASSERT_EQUAL(sizeof(_Type) - i, out[i]);
+  }
+
+  if (value_size<_Type>() == sizeof(_Type)) // 带填充字节的类型按值传入byte_swap时填充字节已经丢失
+  {
+    const _Type swapped{byte_swap(val)};
+    TEST_ASSERT_EQUAL_MEMORY(out, &swapped, sizeof(out));
+    const _Type restored{byte_swap(swapped)};
+    TEST_ASSERT_EQUAL_MEMORY(bytes, &restored, sizeof(bytes));
+  }
+}
+
+template <typename... _Types>
+static void check_reverse_all()
+{
+  (check_reverse<_Types>(), ...);
+}
+
+static void test_integer_types()
+{
+  check_reverse_all<char, signed char, unsigned char, wchar_t, char16_t, char32_t,
+                    short, unsigned short, int, unsigned int, long, unsigned long,
+                    long long, unsigned long long>();
+}
+
+/// @brief long double在x86-64上占16字节，按sizeof整体反转，在ESP32上与double相同
+static void test_floating_types()
+{
+  check_reverse_all<float, double, long double>();
+  const double value{1.5};
+  TEST_ASSERT_EQUAL_FLOAT(value, byte_swap(byte_swap(value)));
+}
+
+static void test_bool_is_unchanged()
+{
+  const bool t{true}, f{false};
+  TEST_ASSERT_TRUE(endian_reverse(&t));
+  TEST_ASSERT_FALSE(endian_reverse(&f));
+  TEST_ASSERT_TRUE(byte_swap(true));
+}
+
+/// @brief byte_swap对整数可以在编译期求值
+static void test_constexpr_swap()
+{
+  static_assert(byte_swap(static_cast<uint16_t>(0x1234)) == 0x3412, "uint16_t");
+  static_assert(byte_swap(static_cast<uint32_t>(0x12345678)) == 0x78563412, "uint32_t");
+  static_assert(byte_swap(static_cast<uint64_t>(0x0102030405060708ULL)) == 0x0807060504030201ULL, "uint64_t");
+  static_assert(byte_swap(static_cast<int16_t>(-2)) == static_cast<int16_t>(0xFEFF), "int16_t");
+  static_assert(byte_swap(static_cast<uint8_t>(0xAB)) == 0xAB, "uint8_t");
+  TEST_ASSERT_TRUE(endian_native_little() == (machine_endian() == 1));
+}
+
+/// @brief EndianField覆盖在未对齐的缓存上，按指定字节序读写
+static void test_endian_field()
+{
+  uint8_t buffer[1 + sizeof(be_u32) + sizeof(le_u16) + sizeof(be_f32)]{};
+  auto *big{reinterpret_cast<be_u32 *>(buffer + 1)};
+  auto *little{reinterpret_cast<le_u16 *>(buffer + 5)};
+  auto *real{reinterpret_cast<be_f32 *>(buffer + 7)};
+  *big = 0x11223344U;
+  *little = 0xA1B2;
+  *real = 1.0f;
+  const uint8_t expected[]{0x00, 0x11, 0x22, 0x33, 0x44, 0xB2, 0xA1, 0x3F, 0x80, 0x00, 0x00};
+  TEST_ASSERT_EQUAL_MEMORY(expected, buffer, sizeof(expected));
+  TEST_ASSERT_EQUAL_HEX32(0x11223344U, big->get());
+  TEST_ASSERT_EQUAL_HEX16(0xA1B2, static_cast<uint16_t>(*little));
+  TEST_ASSERT_EQUAL_FLOAT(1.0f, real->get());
+  static_assert(alignof(be_u64) == 1 && sizeof(be_u64) == 8, "EndianField must be packed");
+}
+
+static void test_number_helpers()
+{
+  uint8_t buffer[4];
+  number_fill_reverse(static_cast<uint32_t>(0x01020304), buffer);
+  const uint8_t expected[]{0x04, 0x03, 0x02, 0x01};
+  const uint8_t native[]{0x01, 0x02, 0x03, 0x04};
+  TEST_ASSERT_EQUAL_MEMORY(endian_native_little() ? native : expected, buffer, 4);
+  TEST_ASSERT_EQUAL_HEX32(endian_native_little() ? 0x01020304 : 0x04030201, (number_merge_reverse<uint8_t, uint32_t>(native, 4)));
+  TEST_ASSERT_EQUAL_HEX16(0x1234, (number_merge<uint8_t, uint16_t>({0x34, 0x12})));
+  TEST_ASSERT_EQUAL_HEX16(0x1234, (number_merge_reverse<uint8_t, uint16_t>({0x12, 0x34})));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_integer_types);
+  RUN_TEST(test_floating_types);
+  RUN_TEST(test_bool_is_unchanged);
+  RUN_TEST(test_constexpr_swap);
+  RUN_TEST(test_endian_field);
+  RUN_TEST(test_number_helpers);
+  return UNITY_END();
+}
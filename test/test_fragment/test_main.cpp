@@ -0,0 +1,260 @@
+/// @brief 分片与重组测试：分片丢失、乱序、重复和交错，以及FragmentLink在发送队列已满时的续发
+
+#include <unity.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "fragment_link.h"
+
+#define MTU 32
+
+using Packet = std::vector<uint8_t>;
+
+void setUp() {}
+
+void tearDown() {}
+
+/// @brief 发送队列长度有限的设备，send_async在队列满时返回false
+class MockRadio : public RadioDevice
+{
+public:
+  std::deque<Packet> queue;
+  size_t capacity{4};
+
+  bool send(uint8_t *message, size_t size) override { return send_async(message, size); }
+  bool send_async(const uint8_t *message, size_t size) override
+  {
+    if (queue.size() >= capacity)
+    {
+      return false;
+    }
+    queue.emplace_back(message, message + size);
+    return true;
+  }
+  bool recv(uint8_t *, size_t &) override { return false; }
+  uint32_t set_frequency(uint32_t hz) override { return hz; }
+  uint8_t set_power(uint8_t power) override { return power; }
+  uint32_t set_data_rate(uint32_t rate) override { return rate; }
+  uint8_t set_addr_width(uint8_t addr_width) override { return addr_width; }
+  bool shutdown() override { return true; }
+  bool reboot() override { return true; }
+  void *device() override { return nullptr; }
+};
+
+static std::vector<Packet> fragment(Fragmenter<MTU> &fragmenter, const uint8_t *data, size_t len)
+{
+  std::vector<Packet> packets;
+  auto cursor{fragmenter.begin(data, len)};
+  uint8_t packet[MTU];
+  while (size_t size = cursor.next(packet))
+  {
+    packets.emplace_back(packet, packet + size);
+  }
+  return packets;
+}
+
+static std::vector<uint8_t> make_frame(size_t len, uint8_t seed)
+{
+  std::vector<uint8_t> frame(len);
+  for (size_t i = 0; i < len; ++i)
+  {
+    frame[i] = static_cast<uint8_t>(seed + i * 13);
+  }
+  return frame;
+}
+
+/// @brief 收集重组完成的帧
+struct Collector
+{
+  std::vector<std::vector<uint8_t>> frames;
+
+  template <size_t _Slots>
+  bool push(Reassembler<MTU, _Slots> &reassembler, const Packet &packet, uint32_t now_ms = 0)
+  {
+    return reassembler.push(packet.data(), packet.size(), now_ms, [this](const uint8_t *data, size_t len)
+                            { frames.emplace_back(data, data + len); });
+  }
+};
+
+static void test_round_trip_every_length()
+{
+  Fragmenter<MTU> fragmenter;
+  Reassembler<MTU> reassembler;
+  Collector collector;
+  for (size_t len = 1; len <= Fragmenter<MTU>::max_frame_size; ++len)
+  {
+    const auto frame{make_frame(len, static_cast<uint8_t>(len))};
+    const auto packets{fragment(fragmenter, frame.data(), len)};
+    TEST_ASSERT_EQUAL((len + MTU - FRAGMENT_HEADER_SIZE - 1) / (MTU - FRAGMENT_HEADER_SIZE), packets.size());
+    for (const auto &packet : packets)
+    {
+      collector.push(reassembler, packet);
+    }
+    TEST_ASSERT_EQUAL(len, collector.frames.size());
+    TEST_ASSERT_TRUE(collector.frames.back() == frame);
+  }
+  TEST_ASSERT_EQUAL(0, fragment(fragmenter, nullptr, Fragmenter<MTU>::max_frame_size + 1).size());
+}
+
+/// @brief 任意顺序到达的分片都能重组
+static void test_reordered_fragments()
+{
+  Fragmenter<MTU> fragmenter;
+  Reassembler<MTU> reassembler;
+  Collector collector;
+  std::mt19937 rng{1};
+  for (int round = 0; round < 200; ++round)
+  {
+    const auto frame{make_frame(100 + round, static_cast<uint8_t>(round))};
+    auto packets{fragment(fragmenter, frame.data(), frame.size())};
+    std::shuffle(packets.begin(), packets.end(), rng);
+    for (const auto &packet : packets)
+    {
+      collector.push(reassembler, packet);
+    }
+    TEST_ASSERT_EQUAL(round + 1, collector.frames.size());
+    TEST_ASSERT_TRUE(collector.frames.back() == frame);
+  }
+  TEST_ASSERT_EQUAL(0, reassembler.stats().duplicates);
+}
+
+/// @brief 重复的分片（包括帧完成后迟到的重复分片）被丢弃，帧只交付一次
+static void test_duplicate_fragments()
+{
+  Fragmenter<MTU> fragmenter;
+  Reassembler<MTU> reassembler;
+  Collector collector;
+  const auto frame{make_frame(80, 7)};
+  const auto packets{fragment(fragmenter, frame.data(), frame.size())};
+  TEST_ASSERT_EQUAL(3, packets.size());
+  collector.push(reassembler, packets[0]);
+  collector.push(reassembler, packets[0]);
+  collector.push(reassembler, packets[1]);
+  TEST_ASSERT_TRUE(collector.push(reassembler, packets[2]));
+  for (const auto &packet : packets)
+  {
+    TEST_ASSERT_FALSE(collector.push(reassembler, packet));
+  }
+  TEST_ASSERT_EQUAL(1, collector.frames.size());
+  TEST_ASSERT_TRUE(collector.frames[0] == frame);
+  TEST_ASSERT_EQUAL(4, reassembler.stats().duplicates);
+}
+
+/// @brief 丢失分片的帧不会交付，超时后释放缓存，不影响后续的帧
+static void test_lost_fragment_times_out()
+{
+  Fragmenter<MTU> fragmenter;
+  Reassembler<MTU> reassembler{100};
+  Collector collector;
+  const auto lost{make_frame(90, 1)};
+  auto packets{fragment(fragmenter, lost.data(), lost.size())};
+  collector.push(reassembler, packets[0], 0);
+  collector.push(reassembler, packets[2], 10);
+  reassembler.expire(111);
+  TEST_ASSERT_EQUAL(1, reassembler.stats().timeouts);
+  TEST_ASSERT_EQUAL(0, collector.frames.size());
+  // 超时后迟到的分片开始一个新的重组，同样不会交付
+  collector.push(reassembler, packets[1], 120);
+  TEST_ASSERT_EQUAL(0, collector.frames.size());
+
+  const auto next{make_frame(60, 2)};
+  for (const auto &packet : fragment(fragmenter, next.data(), next.size()))
+  {
+    collector.push(reassembler, packet, 130);
+  }
+  TEST_ASSERT_EQUAL(1, collector.frames.size());
+  TEST_ASSERT_TRUE(collector.frames[0] == next);
+}
+
+/// @brief 长帧的分片之间插入短的控制帧，控制帧先完成，两个帧都完整
+static void test_interleaved_frames()
+{
+  Fragmenter<MTU> fragmenter;
+  Reassembler<MTU> reassembler;
+  Collector collector;
+  const auto bulk{make_frame(300, 3)};
+  const auto control{make_frame(11, 4)};
+  const auto bulk_packets{fragment(fragmenter, bulk.data(), bulk.size())};
+  const auto control_packets{fragment(fragmenter, control.data(), control.size())};
+  collector.push(reassembler, bulk_packets[0]);
+  collector.push(reassembler, control_packets[0]);
+  for (size_t i = 1; i < bulk_packets.size(); ++i)
+  {
+    collector.push(reassembler, bulk_packets[i]);
+  }
+  TEST_ASSERT_EQUAL(2, collector.frames.size());
+  TEST_ASSERT_TRUE(collector.frames[0] == control);
+  TEST_ASSERT_TRUE(collector.frames[1] == bulk);
+}
+
+/// @brief 格式错误的分片被丢弃：长度不足、序号越界、非最后一个分片不满长度
+static void test_malformed_fragments()
+{
+  Reassembler<MTU> reassembler;
+  Collector collector;
+  collector.push(reassembler, Packet{0x00, 0x00});
+  collector.push(reassembler, Packet{0x00, 0x21, 0xAA});
+  collector.push(reassembler, Packet{0x00, 0x01, 0xAA});
+  collector.push(reassembler, Packet(MTU + 1, 0));
+  TEST_ASSERT_EQUAL(4, reassembler.stats().malformed);
+  TEST_ASSERT_EQUAL(0, collector.frames.size());
+}
+
+/// @brief 设备发送队列已满时FragmentLink保存进度，重试时不丢失也不重复分片，期间可以插入其它帧
+static void test_link_resumes_when_queue_full()
+{
+  MockRadio radio;
+  radio.capacity = 2;
+  FragmentLink<MTU> sender{radio};
+  FragmentLink<MTU> receiver{radio};
+  Collector collector;
+  const auto bulk{make_frame(200, 5)}; // 7个分片
+  const auto control{make_frame(11, 6)};
+
+  auto drain = [&](size_t count)
+  {
+    for (size_t i = 0; i < count && !radio.queue.empty(); ++i)
+    {
+      const auto packet{radio.queue.front()};
+      radio.queue.pop_front();
+      receiver.receive(packet.data(), packet.size(), 0, [&](const uint8_t *data, size_t len)
+                       { collector.frames.emplace_back(data, data + len); });
+    }
+  };
+
+  TEST_ASSERT_FALSE(sender.send(bulk.data(), bulk.size()));
+  TEST_ASSERT_EQUAL(2, radio.queue.size());
+  drain(1);
+  TEST_ASSERT_TRUE(sender.send(control.data(), control.size())); // 控制帧插在长帧的分片之间
+  drain(2);
+  int attempts{0};
+  while (!sender.send(bulk.data(), bulk.size()))
+  {
+    drain(1);
+    TEST_ASSERT_TRUE(++attempts < 20);
+  }
+  drain(radio.queue.size());
+  TEST_ASSERT_EQUAL(2, collector.frames.size());
+  TEST_ASSERT_TRUE(collector.frames[0] == control);
+  TEST_ASSERT_TRUE(collector.frames[1] == bulk);
+  TEST_ASSERT_EQUAL(0, receiver.stats().duplicates);
+  TEST_ASSERT_FALSE(sender.send(bulk.data(), 0));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip_every_length);
+  RUN_TEST(test_reordered_fragments);
+  RUN_TEST(test_duplicate_fragments);
+  RUN_TEST(test_lost_fragment_times_out);
+  RUN_TEST(test_interleaved_frames);
+  RUN_TEST(test_malformed_fragments);
+  RUN_TEST(test_link_resumes_when_queue_full);
+  return UNITY_END();
+}
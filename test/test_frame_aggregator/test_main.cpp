@@ -0,0 +1,232 @@
+/// @brief FrameAggregator测试：合并与拆分、满包发送、延迟期限，以及不同串口到达速率下的有效载荷率与延迟
+
+#include <unity.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "frame_aggregator.hpp"
+
+#define MTU 32
+
+using Packet = std::vector<uint8_t>;
+
+void setUp() {}
+
+void tearDown() {}
+
+/// @brief 记录发送出去的数据包
+struct Sink
+{
+  std::vector<Packet> packets;
+
+  void operator()(const uint8_t *data, size_t len) { packets.emplace_back(data, data + len); }
+};
+
+static std::vector<Packet> split(const std::vector<Packet> &packets)
+{
+  std::vector<Packet> records;
+  for (const auto &packet : packets)
+  {
+    TEST_ASSERT_TRUE(aggregate_split(packet.data(), packet.size(), [&](const uint8_t *data, size_t len)
+                                     { records.emplace_back(data, data + len); }));
+  }
+  return records;
+}
+
+static Packet make_record(size_t len, uint8_t seed)
+{
+  Packet record(len);
+  for (size_t i = 0; i < len; ++i)
+  {
+    record[i] = static_cast<uint8_t>(seed + i);
+  }
+  return record;
+}
+
+/// @brief 记录按顺序合并，拆分后与原始记录一致，每个包都不超过MTU
+static void test_round_trip()
+{
+  FrameAggregator<MTU> aggregator{10};
+  Sink sink;
+  std::vector<Packet> records;
+  for (size_t i = 0; i < 100; ++i)
+  {
+    records.push_back(make_record(1 + i % FrameAggregator<MTU>::max_record_size, static_cast<uint8_t>(i)));
+    TEST_ASSERT_TRUE(aggregator.append(records.back().data(), records.back().size(), 0, sink));
+  }
+  aggregator.flush(sink);
+  TEST_ASSERT_FALSE(aggregator.pending());
+  for (const auto &packet : sink.packets)
+  {
+    TEST_ASSERT_TRUE(packet.size() <= MTU);
+  }
+  TEST_ASSERT_TRUE(split(sink.packets) == records);
+}
+
+/// @brief 空记录和超长记录被拒绝，不影响已合并的数据
+static void test_rejects_invalid_records()
+{
+  FrameAggregator<MTU> aggregator{10};
+  Sink sink;
+  const auto record{make_record(MTU, 0)};
+  TEST_ASSERT_FALSE(aggregator.append(record.data(), 0, 0, sink));
+  TEST_ASSERT_FALSE(aggregator.append(record.data(), MTU, 0, sink));
+  TEST_ASSERT_TRUE(aggregator.append(record.data(), FrameAggregator<MTU>::max_record_size, 0, sink));
+  TEST_ASSERT_EQUAL(1, sink.packets.size());
+  TEST_ASSERT_EQUAL(MTU, sink.packets[0].size());
+}
+
+/// @brief 剩余空间放不下新记录时先发送已合并的数据；放不下最短记录时立即发送
+static void test_sends_when_full()
+{
+  FrameAggregator<MTU> aggregator{1000};
+  Sink sink;
+  const auto record{make_record(14, 0)};
+  aggregator.append(record.data(), record.size(), 0, sink); // 15字节
+  aggregator.append(record.data(), record.size(), 0, sink); // 30字节
+  TEST_ASSERT_EQUAL(0, sink.packets.size());
+  aggregator.append(record.data(), record.size(), 0, sink);
+  TEST_ASSERT_EQUAL(1, sink.packets.size());
+  TEST_ASSERT_EQUAL(30, sink.packets[0].size());
+
+  const auto fill{make_record(MTU - 15 - 2, 0)}; // 加入后剩余1字节
+  aggregator.append(fill.data(), fill.size(), 0, sink);
+  TEST_ASSERT_EQUAL(2, sink.packets.size());
+  TEST_ASSERT_EQUAL(MTU - 1, sink.packets[1].size());
+  TEST_ASSERT_FALSE(aggregator.pending());
+}
+
+/// @brief 第一条记录等待达到最大延迟时poll发送，期限从第一条记录开始计算
+static void test_latency_deadline()
+{
+  FrameAggregator<MTU> aggregator{10};
+  Sink sink;
+  const auto record{make_record(3, 0)};
+  TEST_ASSERT_EQUAL(UINT32_MAX, aggregator.time_to_deadline(0));
+  aggregator.append(record.data(), record.size(), 100, sink);
+  aggregator.append(record.data(), record.size(), 105, sink);
+  TEST_ASSERT_EQUAL(5, aggregator.time_to_deadline(105));
+  TEST_ASSERT_FALSE(aggregator.poll(109, sink));
+  TEST_ASSERT_TRUE(aggregator.poll(110, sink));
+  TEST_ASSERT_EQUAL(1, sink.packets.size());
+  TEST_ASSERT_EQUAL(8, sink.packets[0].size());
+  TEST_ASSERT_FALSE(aggregator.poll(200, sink));
+
+  // 计时器回绕
+  aggregator.append(record.data(), record.size(), UINT32_MAX - 2, sink);
+  TEST_ASSERT_EQUAL(8, aggregator.time_to_deadline(UINT32_MAX));
+  TEST_ASSERT_FALSE(aggregator.poll(6, sink));
+  TEST_ASSERT_TRUE(aggregator.poll(7, sink));
+}
+
+/// @brief 最大延迟为0时每条记录立即发送
+static void test_zero_latency_sends_immediately()
+{
+  FrameAggregator<MTU> aggregator{0};
+  Sink sink;
+  const auto record{make_record(3, 0)};
+  aggregator.append(record.data(), record.size(), 0, sink);
+  aggregator.append(record.data(), record.size(), 0, sink);
+  TEST_ASSERT_EQUAL(2, sink.packets.size());
+  TEST_ASSERT_FALSE(aggregator.pending());
+}
+
+/// @brief 格式错误的数据包：零长度记录、记录越过包尾
+static void test_split_malformed()
+{
+  size_t records{0};
+  auto count = [&](const uint8_t *, size_t)
+  { ++records; };
+  const uint8_t zero_length[]{0x01, 0xAA, 0x00};
+  TEST_ASSERT_FALSE(aggregate_split(zero_length, sizeof(zero_length), count));
+  TEST_ASSERT_EQUAL(1, records);
+  const uint8_t truncated[]{0x01, 0xAA, 0x05, 0xBB};
+  TEST_ASSERT_FALSE(aggregate_split(truncated, sizeof(truncated), count));
+  TEST_ASSERT_EQUAL(2, records);
+  TEST_ASSERT_TRUE(aggregate_split(zero_length, 0, count));
+}
+
+/// @brief 固定间隔到达的串口记录经过合并后的有效载荷率和平均等待时间
+struct AggregationResult
+{
+  double goodput;     // 记录数据字节 / 发送包字节（发送包固定占用MTU）
+  double latency_ms;  // 记录从到达到发送的平均等待时间
+  uint32_t max_latency_ms;
+};
+
+static AggregationResult simulate(uint32_t interval_ms, uint32_t max_latency_ms, size_t record_len)
+{
+  FrameAggregator<MTU> aggregator{max_latency_ms};
+  std::vector<uint32_t> arrivals; // 当前包内记录的到达时间
+  uint64_t record_bytes{0}, packets{0}, latency_sum{0}, records{0};
+  uint32_t latency_max{0};
+  uint32_t now_ms{0};
+  auto send = [&](const uint8_t *, size_t)
+  {
+    ++packets;
+    for (const auto arrival : arrivals)
+    {
+      const uint32_t latency{now_ms - arrival};
+      latency_sum += latency;
+      latency_max = latency > latency_max ? latency : latency_max;
+      ++records;
+    }
+    arrivals.clear();
+  };
+  const auto record{make_record(record_len, 0)};
+  for (now_ms = 0; now_ms < 10000; ++now_ms)
+  {
+    aggregator.poll(now_ms, send);
+    if (now_ms % interval_ms == 0)
+    {
+      // 先发送已满的包，再登记新记录
+      if (aggregator.pending() && arrivals.size() * (record_len + AGGREGATE_RECORD_HEADER_SIZE) + record_len + AGGREGATE_RECORD_HEADER_SIZE > MTU)
+      {
+        aggregator.flush(send);
+      }
+      arrivals.push_back(now_ms);
+      aggregator.append(record.data(), record.size(), now_ms, send);
+      record_bytes += record_len;
+    }
+  }
+  aggregator.flush(send);
+  return {static_cast<double>(record_bytes) / (packets * MTU), static_cast<double>(latency_sum) / records, latency_max};
+}
+
+/// @brief 到达越密集合并的效果越好；任何到达速率下记录的等待时间都不超过最大延迟
+static void test_goodput_vs_latency()
+{
+  const uint32_t intervals[]{1, 2, 5, 10, 20};
+  const uint32_t latencies[]{0, 5, 20};
+  for (const auto max_latency_ms : latencies)
+  {
+    double last_goodput{1.0};
+    for (const auto interval_ms : intervals)
+    {
+      const auto result{simulate(interval_ms, max_latency_ms, 6)};
+      printf("interval %2u ms, max latency %2u ms: goodput %.2f, mean latency %.2f ms, max %u ms\n",
+             interval_ms, max_latency_ms, result.goodput, result.latency_ms, result.max_latency_ms);
+      TEST_ASSERT_TRUE(result.max_latency_ms <= max_latency_ms);
+      TEST_ASSERT_TRUE(result.goodput <= last_goodput + 1e-9);
+      last_goodput = result.goodput;
+    }
+  }
+  // 不合并时有效载荷率等于记录长度/MTU，合并后在密集到达时接近满包
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 6.0 / MTU, simulate(1, 0, 6).goodput);
+  TEST_ASSERT_TRUE(simulate(1, 20, 6).goodput > 0.7);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip);
+  RUN_TEST(test_rejects_invalid_records);
+  RUN_TEST(test_sends_when_full);
+  RUN_TEST(test_latency_deadline);
+  RUN_TEST(test_zero_latency_sends_immediately);
+  RUN_TEST(test_split_malformed);
+  RUN_TEST(test_goodput_vs_latency);
+  return UNITY_END();
+}
@@ -0,0 +1,77 @@
+/// @brief 跳频测试：与模拟转发程序的--hop-ms相同，输出每种配置下丢失和迟到的帧数
+
+#include <unity.h>
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "sim/sim_bridge.h"
+
+/// @brief 运行duration_s秒，最后50ms停止发送，只收取空中的帧
+static HopTest::Report run_hop(const HopTest::Config &config, double duration_s)
+{
+  SimMedium medium{1};
+  SimRadio::Config radio_config;
+  HopTest hop{medium, radio_config, config};
+  const auto start{std::chrono::steady_clock::now()};
+  double elapsed_s{0.0};
+  while ((elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()) < duration_s + 0.05)
+  {
+    hop.poll(static_cast<uint32_t>(elapsed_s * 1000000), elapsed_s < duration_s);
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  const auto report{hop.report()};
+  printf("hop interval_us=%u,skew_us=%u,hops=%u,sent=%u,received=%u,dropped=%u,retune_dropped=%u,late=%u,max_latency_us=%u\n",
+         config.hop_interval_us, config.skew_us, report.hops, report.sent, report.received, report.dropped,
+         report.retune_dropped, report.late, report.max_latency_us);
+  return report;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+/// @brief 不跳频时所有帧都按时到达
+static void test_no_hop_delivers_everything()
+{
+  HopTest::Config config;
+  config.hop_interval_us = 10000000;
+  config.deadline_us = 20000;
+  const auto report{run_hop(config, 1.0)};
+  TEST_ASSERT_EQUAL(0, report.hops);
+  TEST_ASSERT_TRUE(report.sent > 0);
+  TEST_ASSERT_EQUAL(0, report.dropped);
+  TEST_ASSERT_EQUAL(0, report.late);
+}
+
+/// @brief 两端同时换频时，每次跳频最多丢失换频瞬间还在空中的一帧
+static void test_synchronous_hop_loses_at_most_in_flight_frame()
+{
+  HopTest::Config config;
+  config.skew_us = 0;
+  const auto report{run_hop(config, 1.0)};
+  TEST_ASSERT_TRUE(report.hops >= 40);
+  TEST_ASSERT_TRUE(report.dropped <= report.hops);
+}
+
+/// @brief 接收端换频越晚，发送端在新信道上发出而无人接收的帧越多
+static void test_skew_drops_frames_on_new_channel()
+{
+  HopTest::Config config;
+  config.skew_us = 200;
+  const auto small{run_hop(config, 1.0)};
+  config.skew_us = 3000;
+  const auto large{run_hop(config, 1.0)};
+  TEST_ASSERT_TRUE(large.dropped > small.dropped);
+  TEST_ASSERT_TRUE(large.dropped >= large.hops * 2); // 1ms发送间隔下每次约丢失3帧
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_no_hop_delivers_everything);
+  RUN_TEST(test_synchronous_hop_loses_at_most_in_flight_frame);
+  RUN_TEST(test_skew_drops_frames_on_new_channel);
+  return UNITY_END();
+}
@@ -0,0 +1,230 @@
+/// @brief 运行时统计测试：计数器单元的对齐与并发累加、测量值的最大值更新、直方图分桶、注册表的行格式与缓存写满时的分段输出
+
+#include <unity.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "metrics.hpp"
+
+void setUp() {}
+
+void tearDown() {}
+
+/// @brief 输出完整的一行，同时记录write的调用次数
+struct LineWriter
+{
+  std::string line;
+  size_t writes{0};
+
+  void operator()(const char *data, size_t len)
+  {
+    line.append(data, len);
+    ++writes;
+  }
+};
+
+/// @brief 每个核心的单元独占一个缓存行
+static void test_counter_cells_aligned()
+{
+  TEST_ASSERT_EQUAL(METRICS_CACHE_LINE, alignof(Counter));
+  TEST_ASSERT_EQUAL(METRICS_CACHE_LINE * METRICS_CORES, sizeof(Counter));
+  Counter counters[2];
+  const auto distance{reinterpret_cast<uintptr_t>(&counters[1]) - reinterpret_cast<uintptr_t>(&counters[0])};
+  TEST_ASSERT_TRUE(distance >= METRICS_CACHE_LINE);
+}
+
+/// @brief 多个线程同时累加，读取的值为所有增量之和
+static void test_counter_concurrent_inc()
+{
+  static Counter counter;
+  constexpr uint32_t threads{4}, per_thread{100000};
+  std::thread workers[threads];
+  for (auto &worker : workers)
+  {
+    worker = std::thread{[]
+                         {
+                           for (uint32_t i = 0; i < per_thread; ++i)
+                           {
+                             counter.inc();
+                           }
+                         }};
+  }
+  for (auto &worker : workers)
+  {
+    worker.join();
+  }
+  counter.inc(5);
+  TEST_ASSERT_EQUAL(threads * per_thread + 5, counter.value());
+}
+
+/// @brief set和add修改当前值，update_max只在新值更大时更新，并发更新后为最大值
+static void test_gauge()
+{
+  Gauge gauge;
+  gauge.set(-3);
+  gauge.add(10);
+  TEST_ASSERT_EQUAL(7, gauge.value());
+  gauge.update_max(5);
+  TEST_ASSERT_EQUAL(7, gauge.value());
+  gauge.update_max(9);
+  TEST_ASSERT_EQUAL(9, gauge.value());
+
+  static Gauge hwm;
+  std::thread workers[4];
+  for (int32_t t = 0; t < 4; ++t)
+  {
+    workers[t] = std::thread{[t]
+                             {
+                               for (int32_t i = 0; i < 10000; ++i)
+                               {
+                                 hwm.update_max(i * 4 + t);
+                               }
+                             }};
+  }
+  for (auto &worker : workers)
+  {
+    worker.join();
+  }
+  TEST_ASSERT_EQUAL(9999 * 4 + 3, hwm.value());
+}
+
+/// @brief 上界为闭区间，超过所有上界的值进入最后一个桶，sum为所有观测值之和
+static void test_histogram_buckets()
+{
+  Histogram<3> histogram{{10, 100, 1000}};
+  for (const uint32_t value : {0U, 10U, 11U, 100U, 1000U, 1001U, 50000U})
+  {
+    histogram.observe(value);
+  }
+  TEST_ASSERT_EQUAL(3, histogram.buckets());
+  TEST_ASSERT_EQUAL(100, histogram.bound(1));
+  TEST_ASSERT_EQUAL(2, histogram.count(0));
+  TEST_ASSERT_EQUAL(2, histogram.count(1));
+  TEST_ASSERT_EQUAL(1, histogram.count(2));
+  TEST_ASSERT_EQUAL(2, histogram.count(3));
+  TEST_ASSERT_EQUAL(52122, histogram.sum());
+}
+
+/// @brief 一行以measurement和运行时间开头，各类指标按注册顺序输出，直方图的桶为累计值
+static void test_snapshot_line_protocol()
+{
+  MetricsRegistry<8> registry{"bridge,node=a"};
+  Counter sent;
+  Gauge depth;
+  std::atomic<uint32_t> dropped{4};
+  Histogram<2> latency{{500, 1000}};
+  sent.inc(12);
+  depth.set(-2);
+  latency.observe(100);
+  latency.observe(700);
+  latency.observe(5000);
+  int32_t probed{42};
+  TEST_ASSERT_TRUE(registry.add("sent", sent));
+  TEST_ASSERT_TRUE(registry.add("depth", depth));
+  TEST_ASSERT_TRUE(registry.add("dropped", dropped));
+  TEST_ASSERT_TRUE(registry.add_probe("probed", &probed, [](void *ctx) -> int64_t
+                                      { return *static_cast<int32_t *>(ctx); }));
+  TEST_ASSERT_TRUE(registry.add("lat", latency));
+  TEST_ASSERT_EQUAL(5, registry.size());
+
+  LineWriter first;
+  registry.snapshot(first, 1500);
+  LineWriter second;
+  registry.snapshot(second, 1500);
+  TEST_ASSERT_EQUAL_STRING(first.line.c_str(), second.line.c_str());
+  TEST_ASSERT_EQUAL_STRING("bridge,node=a uptime_ms=1500i,sent=12i,depth=-2i,dropped=4i,probed=42i,"
+                           "lat_le_500=1i,lat_le_1000=2i,lat_le_inf=3i,lat_count=3i,lat_sum=5800i\n",
+                           first.line.c_str());
+  TEST_ASSERT_EQUAL(1, first.writes);
+}
+
+/// @brief 超过METRICS_LINE_SIZE的行分多次输出，每次在指标之间断开，拼接后包含所有指标且只有一个换行符
+static void test_snapshot_split()
+{
+  static constexpr uint32_t bounds[4]{1, 2, 3, 4};
+  struct Named
+  {
+    Histogram<4> histogram{bounds};
+    char name[32];
+  };
+  static Named metrics[8];
+  MetricsRegistry<8> registry{"m"};
+  for (int i = 0; i < 8; ++i)
+  {
+    metrics[i].histogram.observe(i);
+    snprintf(metrics[i].name, sizeof(metrics[i].name), "histogram_with_long_name_%d", i);
+    TEST_ASSERT_TRUE(registry.add(metrics[i].name, metrics[i].histogram));
+  }
+  LineWriter writer;
+  registry.snapshot(writer, 0);
+  TEST_ASSERT_TRUE(writer.line.size() > METRICS_LINE_SIZE);
+  TEST_ASSERT_TRUE(writer.writes > 1);
+  TEST_ASSERT_EQUAL(writer.line.size() - 1, writer.line.find('\n'));
+  for (int i = 0; i < 8; ++i)
+  {
+    char field[48];
+    snprintf(field, sizeof(field), ",%s_sum=%di", metrics[i].name, i);
+    TEST_ASSERT_TRUE(writer.line.find(field) != std::string::npos);
+  }
+}
+
+/// @brief 注册表已满时拒绝新的指标，已注册的指标照常输出
+static void test_registry_full()
+{
+  MetricsRegistry<2> registry{"m"};
+  Gauge a, b, c;
+  a.set(1);
+  b.set(2);
+  TEST_ASSERT_TRUE(registry.add("a", a));
+  TEST_ASSERT_TRUE(registry.add("b", b));
+  TEST_ASSERT_FALSE(registry.add("c", c));
+  LineWriter writer;
+  registry.snapshot(writer, 0);
+  TEST_ASSERT_EQUAL_STRING("m uptime_ms=0i,a=1i,b=2i\n", writer.line.c_str());
+  TEST_ASSERT_EQUAL(1, writer.writes);
+}
+
+/// @brief 快照与更新并发时，每次输出都是完整的一行
+static void test_snapshot_concurrent_update()
+{
+  static Counter counter;
+  static MetricsRegistry<1> registry{"m"};
+  registry.add("n", counter);
+  std::atomic<bool> running{true};
+  std::thread writer{[&]
+                     {
+                       while (running)
+                       {
+                         counter.inc();
+                         std::this_thread::yield();
+                       }
+                     }};
+  unsigned long last{0};
+  for (int i = 0; i < 1000; ++i)
+  {
+    LineWriter line;
+    registry.snapshot(line, 0);
+    unsigned long value;
+    TEST_ASSERT_EQUAL(1, sscanf(line.line.c_str(), "m uptime_ms=0i,n=%lui\n", &value));
+    TEST_ASSERT_TRUE(value >= last);
+    last = value;
+  }
+  running = false;
+  writer.join();
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_counter_cells_aligned);
+  RUN_TEST(test_counter_concurrent_inc);
+  RUN_TEST(test_gauge);
+  RUN_TEST(test_histogram_buckets);
+  RUN_TEST(test_snapshot_line_protocol);
+  RUN_TEST(test_snapshot_split);
+  RUN_TEST(test_registry_full);
+  RUN_TEST(test_snapshot_concurrent_update);
+  return UNITY_END();
+}
@@ -0,0 +1,351 @@
+/// @brief 速率自适应测试：LinkAdapter的升降档与升档退避，RateControl两端的协商、回退、心跳丢失和控制帧的发送优先级
+
+#include <unity.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "rate_control.h"
+
+#define LEVELS 3
+
+void setUp() {}
+
+void tearDown() {}
+
+/// @brief 发出的帧保存在outbox中，由测试交给对端；full模拟发送队列已满
+class LoopRadio : public RadioDevice
+{
+public:
+  std::vector<std::vector<uint8_t>> outbox;
+  bool full{false};
+  uint32_t tx_sent{0};
+  uint32_t rx_received{0};
+
+  bool send_async(const uint8_t *message, size_t size) override
+  {
+    if (full)
+    {
+      return false;
+    }
+    outbox.emplace_back(message, message + size);
+    ++tx_sent;
+    return true;
+  }
+
+  bool send(uint8_t *message, size_t size) override { return send_async(message, size); }
+  bool recv(uint8_t *, size_t &) override { return false; }
+  uint32_t set_frequency(uint32_t hz) override { return hz; }
+  uint8_t set_power(uint8_t power) override { return power; }
+  uint32_t set_data_rate(uint32_t rate) override { return rate; }
+  uint8_t set_addr_width(uint8_t) override { return 0; }
+  bool shutdown() override { return true; }
+  bool reboot() override { return true; }
+  void *device() override { return nullptr; }
+};
+
+static LinkAdapter<LEVELS>::Config adapt_config()
+{
+  LinkAdapter<LEVELS>::Config config{};
+  for (auto &rssi : config.min_rssi_x10)
+  {
+    rssi = LINK_RSSI_UNKNOWN;
+  }
+  config.up_margin_x10 = 30;
+  config.down_loss_permille = 150;
+  config.up_loss_permille = 20;
+  config.up_windows = 3;
+  config.max_up_windows = 48;
+  return config;
+}
+
+/// @brief 一端：设备、当前生效的档位和速率控制
+struct Node
+{
+  LoopRadio radio;
+  uint8_t level;
+  uint32_t data_received{0};
+  uint32_t frames{0}; // 发出的帧数量，用于按比例丢包
+  RateControl<LEVELS> rate;
+
+  Node(uint8_t home, bool initiator)
+      : level(home), rate(radio, config(home, initiator), [](void *ctx, uint8_t level)
+                          {
+                            static_cast<Node *>(ctx)->level = level;
+                            return true; },
+                          [](void *ctx)
+                          {
+                            const auto &radio{static_cast<Node *>(ctx)->radio};
+                            return LinkSample{radio.tx_sent, radio.rx_received, 0, LINK_RSSI_UNKNOWN};
+                          },
+                          this) {}
+
+  static RateControl<LEVELS>::Config config(uint8_t home, bool initiator)
+  {
+    RateControl<LEVELS>::Config config;
+    config.adapt = adapt_config();
+    config.home_level = home;
+    config.initiator = initiator;
+    return config;
+  }
+};
+
+/// @brief 把from发出的帧交给to，两端档位不同时无法通信；drop_every不为0时每drop_every个帧丢弃一个
+static void deliver(Node &from, Node &to, uint32_t now_ms, uint32_t drop_every = 0)
+{
+  for (const auto &frame : from.radio.outbox)
+  {
+    if (from.level != to.level || (drop_every && ++from.frames % drop_every == 0))
+    {
+      continue;
+    }
+    ++to.radio.rx_received;
+    if (!to.rate.handle(frame.data(), frame.size(), now_ms))
+    {
+      ++to.data_received;
+    }
+  }
+  from.radio.outbox.clear();
+}
+
+/// @brief 以10 ms为步长运行两端，每一步双方各发送一个数据包
+static void run(Node &a, Node &b, uint32_t &now_ms, uint32_t duration_ms, uint32_t drop_every = 0)
+{
+  static const uint8_t data[]{0x01, 0x02, 0x03};
+  for (const uint32_t end{now_ms + duration_ms}; now_ms < end; now_ms += 10)
+  {
+    a.rate.poll(now_ms);
+    b.rate.poll(now_ms);
+    a.radio.send_async(data, sizeof(data));
+    b.radio.send_async(data, sizeof(data));
+    deliver(a, b, now_ms, drop_every);
+    deliver(b, a, now_ms, drop_every);
+  }
+}
+
+static std::vector<uint8_t> control_frame(uint8_t op, uint8_t level, uint8_t token, uint8_t recommend)
+{
+  return {0xc0, 0x00, 0x08, 0x00, 0x00, 0xe7, 0x81, op, level, token, recommend, 0x00, 0x00};
+}
+
+/// @brief 单个窗口的丢包率超过门限时立即建议降一档，切换前保持建议
+static void test_adapter_down_on_loss()
+{
+  LinkAdapter<LEVELS> adapter{adapt_config(), 2};
+  TEST_ASSERT_EQUAL(2, adapter.update(0));
+  TEST_ASSERT_EQUAL(1, adapter.update(200));
+  TEST_ASSERT_EQUAL(2, adapter.level());
+  adapter.on_switched(1);
+  TEST_ASSERT_EQUAL(0, adapter.loss_permille());
+  TEST_ASSERT_EQUAL(1, adapter.update(100));
+  LinkAdapter<LEVELS> lowest{adapt_config(), 0};
+  TEST_ASSERT_EQUAL(0, lowest.update(1000));
+}
+
+/// @brief 连续up_windows个窗口满足条件后才建议升档，中间有一个窗口不满足则重新计数
+static void test_adapter_up_after_windows()
+{
+  LinkAdapter<LEVELS> adapter{adapt_config(), 0};
+  TEST_ASSERT_EQUAL(0, adapter.update(0));
+  TEST_ASSERT_EQUAL(0, adapter.update(0));
+  TEST_ASSERT_EQUAL(0, adapter.update(100));
+  // 平滑后的丢包率需要降到up_loss_permille以下
+  uint32_t windows{0};
+  while (adapter.update(0) == 0)
+  {
+    ++windows;
+    TEST_ASSERT_TRUE(windows < 20);
+  }
+  TEST_ASSERT_TRUE(windows >= 2);
+  TEST_ASSERT_EQUAL(1, adapter.update(0));
+}
+
+/// @brief RSSI低于当前档位门限时降档，超过上一档门限加余量时才升档
+static void test_adapter_rssi_threshold()
+{
+  auto config{adapt_config()};
+  config.min_rssi_x10[1] = -900;
+  config.min_rssi_x10[2] = -800;
+  LinkAdapter<LEVELS> adapter{config, 1};
+  for (int i = 0; i < 5; ++i)
+  {
+    TEST_ASSERT_EQUAL(1, adapter.update(0, -780)); // 未超过-800 + 3 dB
+  }
+  uint8_t recommend{1};
+  for (int i = 0; i < 10 && recommend == 1; ++i)
+  {
+    recommend = adapter.update(0, -700);
+  }
+  TEST_ASSERT_EQUAL(2, recommend);
+
+  LinkAdapter<LEVELS> weak{config, 1};
+  TEST_ASSERT_EQUAL(0, weak.update(0, -950));
+}
+
+/// @brief 升档后很快又降档时，下一次升档需要的窗口数加倍
+static void test_adapter_up_backoff()
+{
+  LinkAdapter<LEVELS> adapter{adapt_config(), 0};
+  auto windows_to_up = [&adapter]
+  {
+    uint32_t windows{1};
+    while (adapter.update(0) == adapter.level())
+    {
+      ++windows;
+    }
+    return windows;
+  };
+  TEST_ASSERT_EQUAL(3, windows_to_up());
+  adapter.on_switched(1);
+  TEST_ASSERT_EQUAL(0, adapter.update(500));
+  adapter.on_switched(0);
+  TEST_ASSERT_EQUAL(6, windows_to_up());
+}
+
+/// @brief 链路良好时两端经过协商逐档升到最高档，每次切换后两端档位一致
+static void test_handshake_upgrade()
+{
+  Node initiator{0, true};
+  Node responder{0, false};
+  uint32_t now_ms{0};
+  run(initiator, responder, now_ms, 30000);
+  TEST_ASSERT_EQUAL(LEVELS - 1, initiator.level);
+  TEST_ASSERT_EQUAL(LEVELS - 1, responder.level);
+  TEST_ASSERT_EQUAL(LEVELS - 1, initiator.rate.level());
+  TEST_ASSERT_EQUAL(LEVELS - 1, initiator.rate.stats().switches);
+  TEST_ASSERT_EQUAL(LEVELS - 1, responder.rate.stats().switches);
+  TEST_ASSERT_EQUAL(0, initiator.rate.stats().reverts);
+  TEST_ASSERT_EQUAL(0, responder.rate.stats().reverts);
+  // 速率控制帧不转发给调用者
+  TEST_ASSERT_TRUE(initiator.data_received > 0);
+  TEST_ASSERT_TRUE(initiator.data_received < initiator.radio.rx_received);
+}
+
+/// @brief 丢包率过高时两端经过协商降到0档
+static void test_handshake_downgrade_on_loss()
+{
+  Node initiator{2, true};
+  Node responder{2, false};
+  uint32_t now_ms{0};
+  run(initiator, responder, now_ms, 30000, 2);
+  TEST_ASSERT_EQUAL(0, initiator.level);
+  TEST_ASSERT_EQUAL(0, responder.level);
+  // 经过协商逐档降低，不是因为链路中断
+  TEST_ASSERT_EQUAL(2, initiator.rate.stats().switches);
+  TEST_ASSERT_EQUAL(2, responder.rate.stats().switches);
+  TEST_ASSERT_EQUAL(0, initiator.rate.stats().lost);
+  TEST_ASSERT_EQUAL(0, responder.rate.stats().lost);
+  TEST_ASSERT_TRUE(initiator.rate.loss_permille() > 150);
+}
+
+/// @brief 应答方不接受超过自己建议档位的升档
+static void test_reject_upgrade_above_recommend()
+{
+  Node responder{0, false};
+  responder.rate.poll(0);
+  responder.radio.outbox.clear();
+  const auto propose{control_frame(1, 2, 7, 2)};
+  TEST_ASSERT_TRUE(RateControl<LEVELS>::match(propose.data(), propose.size()));
+  TEST_ASSERT_TRUE(responder.rate.handle(propose.data(), propose.size(), 10));
+  TEST_ASSERT_EQUAL(1, responder.radio.outbox.size());
+  TEST_ASSERT_EQUAL(3, responder.radio.outbox[0][7]); // REJECT
+  TEST_ASSERT_EQUAL(7, responder.radio.outbox[0][9]);
+  responder.rate.poll(1000);
+  TEST_ASSERT_EQUAL(0, responder.level);
+}
+
+/// @brief 发起方切换后对端没有切换（ACCEPT后应答方的数据全部丢失），试用期结束后回到原档位
+static void test_revert_after_probation()
+{
+  Node initiator{1, true};
+  initiator.rate.poll(0);
+  // 对端建议0档，发起方取两端建议的较小值
+  const auto keepalive{control_frame(0, 1, 0, 0)};
+  TEST_ASSERT_TRUE(initiator.rate.handle(keepalive.data(), keepalive.size(), 20));
+  const auto last{initiator.radio.outbox.back()};
+  TEST_ASSERT_EQUAL(1, last[7]); // PROPOSE
+  TEST_ASSERT_EQUAL(0, last[8]);
+  const auto accept{control_frame(2, 0, last[9], 0)};
+  TEST_ASSERT_TRUE(initiator.rate.handle(accept.data(), accept.size(), 30));
+  TEST_ASSERT_EQUAL(0, initiator.level);
+  initiator.rate.poll(3000);
+  TEST_ASSERT_EQUAL(0, initiator.level);
+  initiator.rate.poll(3040);
+  TEST_ASSERT_EQUAL(1, initiator.level);
+  TEST_ASSERT_EQUAL(1, initiator.rate.stats().reverts);
+}
+
+/// @brief 连续两个窗口收不到对端心跳时按整个窗口丢失统计，建议降档
+static void test_missed_keepalives()
+{
+  Node node{2, false};
+  node.rate.poll(0);
+  node.rate.poll(1000);
+  TEST_ASSERT_EQUAL(2, node.rate.recommend());
+  // 收到对端心跳后重新计时
+  const auto keepalive{control_frame(0, 2, 0, 2)};
+  node.rate.handle(keepalive.data(), keepalive.size(), 1500);
+  node.rate.poll(2000);
+  node.rate.poll(3000);
+  TEST_ASSERT_EQUAL(2, node.rate.recommend());
+  node.rate.poll(4000);
+  TEST_ASSERT_EQUAL(1, node.rate.recommend());
+}
+
+/// @brief 长时间收不到任何数据包时回到0档
+static void test_link_lost()
+{
+  Node node{2, false};
+  for (uint32_t now_ms = 0; now_ms <= 5000; now_ms += 100)
+  {
+    node.rate.poll(now_ms);
+  }
+  TEST_ASSERT_EQUAL(0, node.level);
+  TEST_ASSERT_EQUAL(1, node.rate.stats().lost);
+}
+
+/// @brief 发送队列已满时保存的ACCEPT不被心跳替换，队列恢复后先发出ACCEPT
+static void test_pending_accept_not_replaced()
+{
+  Node responder{2, false};
+  responder.rate.poll(0);
+  responder.radio.outbox.clear();
+  responder.radio.full = true;
+  const auto propose{control_frame(1, 1, 9, 1)};
+  TEST_ASSERT_TRUE(responder.rate.handle(propose.data(), propose.size(), 900));
+  responder.rate.poll(1000); // 心跳时间
+  TEST_ASSERT_EQUAL(0, responder.radio.outbox.size());
+  responder.radio.full = false;
+  responder.rate.poll(1010);
+  TEST_ASSERT_EQUAL(1, responder.radio.outbox.size());
+  TEST_ASSERT_EQUAL(2, responder.radio.outbox[0][7]); // ACCEPT
+  TEST_ASSERT_EQUAL(9, responder.radio.outbox[0][9]);
+  // 保存的心跳可以被后来的应答替换
+  Node other{2, false};
+  other.rate.poll(0);
+  other.radio.outbox.clear();
+  other.radio.full = true;
+  other.rate.poll(1000);
+  TEST_ASSERT_TRUE(other.rate.handle(propose.data(), propose.size(), 1010));
+  other.radio.full = false;
+  other.rate.poll(1020);
+  TEST_ASSERT_EQUAL(1, other.radio.outbox.size());
+  TEST_ASSERT_EQUAL(2, other.radio.outbox[0][7]);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_adapter_down_on_loss);
+  RUN_TEST(test_adapter_up_after_windows);
+  RUN_TEST(test_adapter_rssi_threshold);
+  RUN_TEST(test_adapter_up_backoff);
+  RUN_TEST(test_handshake_upgrade);
+  RUN_TEST(test_handshake_downgrade_on_loss);
+  RUN_TEST(test_reject_upgrade_above_recommend);
+  RUN_TEST(test_revert_after_probation);
+  RUN_TEST(test_missed_keepalives);
+  RUN_TEST(test_link_lost);
+  RUN_TEST(test_pending_accept_not_replaced);
+  return UNITY_END();
+}
@@ -0,0 +1,207 @@
+/// @brief RingQueue/StaticRingQueue测试：两种存储策略共用的接口、区域读写的回绕以及pre_push/back
+
+#include <unity.h>
+
+#include <utility>
+
+#include "ring_queue.hpp"
+#include "static_ring_queue.hpp"
+
+void setUp() {}
+
+void tearDown() {}
+
+/// @brief 空队列的头尾索引同时前进count步，便于构造回绕场景
+template <typename _Queue>
+static void advance(_Queue &queue, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    queue.pre_push();
+    queue.push();
+    queue.pop();
+  }
+}
+
+/// @brief 从任意起点开始写满再读空，写入和读取的区域都在回绕点处分为两段
+template <typename _Queue>
+static void check_regions_wrap(_Queue &queue)
+{
+  const uint32_t capacity{queue.capacity()};
+  for (uint32_t start = 0; start < capacity; ++start)
+  {
+    RingRegion<uint8_t> first, second;
+    queue.clear();
+    queue.write_regions(first, second);
+    advance(queue, (start + first.len) % capacity); // 空队列的第一段从当前位置延伸到缓存末尾
+
+    TEST_ASSERT_EQUAL(capacity, queue.write_regions(first, second));
+    TEST_ASSERT_EQUAL(capacity - start, first.len);
+    TEST_ASSERT_EQUAL(start, second.len);
+    uint8_t value{0};
+    for (uint32_t i = 0; i < first.len; ++i)
+    {
+      first.data[i] = value++;
+    }
+    for (uint32_t i = 0; i < second.len; ++i)
+    {
+      second.data[i] = value++;
+    }
+    queue.commit_write(capacity + 5); // 超出可写长度的部分被忽略
+    TEST_ASSERT_TRUE(queue.full());
+    TEST_ASSERT_EQUAL(0, queue.write_regions(first, second));
+
+    TEST_ASSERT_EQUAL(capacity, queue.read_regions(first, second));
+    TEST_ASSERT_EQUAL(capacity - start, first.len);
+    value = 0;
+    for (uint32_t i = 0; i < first.len; ++i)
+    {
+      TEST_ASSERT_EQUAL(value++, first.data[i]);
+    }
+    for (uint32_t i = 0; i < second.len; ++i)
+    {
+      TEST_ASSERT_EQUAL(value++, second.data[i]);
+    }
+    queue.commit_read(capacity + 5);
+    TEST_ASSERT_TRUE(queue.empty());
+  }
+}
+
+/// @brief write/read按任意长度分批进行，数据顺序保持不变
+template <typename _Queue>
+static void check_bulk_copy(_Queue &queue)
+{
+  uint8_t src[64], dst[64];
+  for (uint32_t i = 0; i < sizeof(src); ++i)
+  {
+    src[i] = static_cast<uint8_t>(i * 7 + 1);
+  }
+  uint8_t expected{1};
+  for (uint32_t round = 0; round < 200; ++round)
+  {
+    const uint32_t count{1 + round % 13};
+    uint32_t offset{0};
+    while (offset < count)
+    {
+      offset += queue.write(src + offset, count - offset);
+      const uint32_t got{queue.read(dst, 1 + round % 5)};
+      for (uint32_t i = 0; i < got; ++i)
+      {
+        TEST_ASSERT_EQUAL(expected, dst[i]);
+        expected = static_cast<uint8_t>(expected + 7);
+        if (expected == static_cast<uint8_t>(count * 7 + 1))
+        {
+          expected = 1;
+        }
+      }
+    }
+    while (uint32_t got = queue.read(dst, sizeof(dst)))
+    {
+      for (uint32_t i = 0; i < got; ++i)
+      {
+        TEST_ASSERT_EQUAL(expected, dst[i]);
+        expected = static_cast<uint8_t>(expected + 7);
+        if (expected == static_cast<uint8_t>(count * 7 + 1))
+        {
+          expected = 1;
+        }
+      }
+    }
+  }
+  TEST_ASSERT_TRUE(queue.empty());
+}
+
+/// @brief pre_push(dbuf)复制dbuf的内容，back指向最后写入的元素，满时pre_push失败
+template <typename _Queue>
+static void check_push_and_back(_Queue &queue)
+{
+  TEST_ASSERT_NULL(queue.back());
+  for (uint8_t i = 0; i < queue.capacity(); ++i)
+  {
+    uint8_t value{static_cast<uint8_t>(100 + i)};
+    uint8_t *slot{queue.pre_push(&value)};
+    TEST_ASSERT_NOT_NULL(slot);
+    TEST_ASSERT_EQUAL(value, *slot);
+    TEST_ASSERT_NULL(queue.pre_push()); // 已锁定
+    queue.push();
+    TEST_ASSERT_EQUAL(value, *queue.back());
+    TEST_ASSERT_EQUAL(100, *queue.front());
+    TEST_ASSERT_EQUAL(value, queue[i]);
+  }
+  TEST_ASSERT_TRUE(queue.full());
+  TEST_ASSERT_NULL(queue.pre_push());
+  queue.pop();
+  uint8_t value{200};
+  TEST_ASSERT_NOT_NULL(queue.pre_push(&value));
+  queue.push(false); // 放弃写入
+  TEST_ASSERT_EQUAL(queue.capacity() - 1, queue.len());
+  TEST_ASSERT_EQUAL(100 + queue.capacity() - 1, *queue.back());
+}
+
+static void test_dynamic_regions_wrap()
+{
+  RingQueue<uint8_t> queue(8);
+  check_regions_wrap(queue);
+}
+
+static void test_static_regions_wrap()
+{
+  StaticRingQueue<uint8_t, 8> queue;
+  check_regions_wrap(queue);
+}
+
+static void test_dynamic_bulk_copy()
+{
+  RingQueue<uint8_t> queue(16);
+  check_bulk_copy(queue);
+}
+
+static void test_static_bulk_copy()
+{
+  StaticRingQueue<uint8_t, 16> queue;
+  check_bulk_copy(queue);
+}
+
+static void test_dynamic_push_and_back()
+{
+  RingQueue<uint8_t> queue(4);
+  check_push_and_back(queue);
+}
+
+static void test_static_push_and_back()
+{
+  StaticRingQueue<uint8_t, 4> queue;
+  check_push_and_back(queue);
+}
+
+/// @brief 容量向上取整为2的幂，移动后原对象为空且不会重复释放缓存
+static void test_dynamic_allocate_and_move()
+{
+  RingQueue<uint8_t> queue(5);
+  TEST_ASSERT_EQUAL(8, queue.capacity());
+  const uint8_t data[3]{1, 2, 3};
+  queue.write(data, 3);
+
+  RingQueue<uint8_t> moved(std::move(queue));
+  TEST_ASSERT_EQUAL(0, queue.capacity());
+  TEST_ASSERT_EQUAL(3, moved.len());
+
+  RingQueue<uint8_t> assigned(2);
+  assigned = std::move(moved);
+  TEST_ASSERT_EQUAL(8, assigned.capacity());
+  TEST_ASSERT_EQUAL(1, *assigned.front());
+  TEST_ASSERT_EQUAL(3, *assigned.back());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_dynamic_regions_wrap);
+  RUN_TEST(test_static_regions_wrap);
+  RUN_TEST(test_dynamic_bulk_copy);
+  RUN_TEST(test_static_bulk_copy);
+  RUN_TEST(test_dynamic_push_and_back);
+  RUN_TEST(test_static_push_and_back);
+  RUN_TEST(test_dynamic_allocate_and_move);
+  return UNITY_END();
+}
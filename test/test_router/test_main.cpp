@@ -0,0 +1,382 @@
+/// @brief Router测试：路由表、有界队列、端口忙时重试、严格优先与加权轮询、调度时延，以及FdPort写入伪终端时的部分写入
+
+#include <unity.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "router.hpp"
+#include "router_ports.h"
+#include "pty_serial.h"
+
+#define MTU 32
+#define DEPTH 8
+
+using Packet = std::vector<uint8_t>;
+
+enum : uint8_t
+{
+  PORT_A,
+  PORT_B,
+  PORT_C,
+  PORT_COUNT,
+};
+
+enum : uint8_t
+{
+  CLASS_CONTROL,
+  CLASS_BULK,
+  CLASS_TELEMETRY,
+  CLASS_COUNT,
+};
+
+void setUp() {}
+
+void tearDown() {}
+
+/// @brief 内存中的端口，记录写入的帧，busy为true时拒绝写入
+class MockPort : public RouterPort
+{
+public:
+  std::vector<Packet> frames;
+  bool busy{false};
+
+  bool write(const uint8_t *data, size_t len) override
+  {
+    if (busy)
+    {
+      return false;
+    }
+    frames.emplace_back(data, data + len);
+    return true;
+  }
+};
+
+/// @brief 第一个字节为优先级
+static uint8_t classify_first_byte(uint8_t, const uint8_t *data, size_t)
+{
+  return data[0];
+}
+
+template <typename _Mutex = RouterNullMutex>
+using TestRouter = Router<PORT_COUNT, CLASS_COUNT, MTU, DEPTH, _Mutex>;
+
+static void input(TestRouter<> &router, uint8_t ingress, uint8_t cls, uint8_t seq)
+{
+  const uint8_t frame[]{cls, seq};
+  router.input(ingress, frame, sizeof(frame));
+}
+
+/// @brief 入口帧复制到路由表中的每个出口，入口自身被忽略，没有路由或长度错误的帧计入unrouted
+static void test_routing_table()
+{
+  TestRouter<> router;
+  MockPort ports[PORT_COUNT];
+  for (uint8_t id = 0; id < PORT_COUNT; ++id)
+  {
+    router.attach(id, &ports[id]);
+  }
+  router.set_route(PORT_A, 1UL << PORT_A | 1UL << PORT_B | 1UL << PORT_C);
+  router.set_route(PORT_B, 1UL << PORT_A);
+
+  const uint8_t frame[]{1, 2, 3};
+  TEST_ASSERT_EQUAL(2, router.input(PORT_A, frame, sizeof(frame)));
+  TEST_ASSERT_EQUAL(1, router.input(PORT_B, frame, sizeof(frame)));
+  TEST_ASSERT_EQUAL(0, router.input(PORT_C, frame, sizeof(frame)));
+  TEST_ASSERT_EQUAL(0, router.input(PORT_A, frame, 0));
+  uint8_t oversized[MTU + 1]{};
+  TEST_ASSERT_EQUAL(0, router.input(PORT_A, oversized, sizeof(oversized)));
+  TEST_ASSERT_EQUAL(0, router.input(PORT_COUNT, frame, sizeof(frame)));
+  TEST_ASSERT_EQUAL(4, router.unrouted());
+
+  TEST_ASSERT_EQUAL(3, router.pending());
+  TEST_ASSERT_EQUAL(3, router.poll());
+  TEST_ASSERT_EQUAL(1, ports[PORT_A].frames.size());
+  TEST_ASSERT_EQUAL(1, ports[PORT_B].frames.size());
+  TEST_ASSERT_EQUAL(1, ports[PORT_C].frames.size());
+  TEST_ASSERT_TRUE(ports[PORT_C].frames[0] == Packet(frame, frame + sizeof(frame)));
+}
+
+/// @brief 每个出口每个优先级的队列有界，已满时丢弃新帧；未注册的出口丢弃所有帧
+static void test_bounded_queues()
+{
+  TestRouter<> router;
+  MockPort port;
+  router.attach(PORT_B, &port);
+  router.set_route(PORT_A, 1UL << PORT_B | 1UL << PORT_C);
+  router.set_classifier(classify_first_byte);
+  for (uint8_t seq = 0; seq < DEPTH + 3; ++seq)
+  {
+    input(router, PORT_A, CLASS_BULK, seq);
+  }
+  input(router, PORT_A, CLASS_CONTROL, 0); // 其它优先级的队列不受影响
+  TEST_ASSERT_EQUAL(DEPTH + 1, router.stats(PORT_B).enqueued);
+  TEST_ASSERT_EQUAL(3, router.stats(PORT_B).dropped);
+  TEST_ASSERT_EQUAL(DEPTH + 4, router.stats(PORT_C).dropped);
+  TEST_ASSERT_EQUAL(0, router.pending(PORT_C));
+
+  TEST_ASSERT_EQUAL(DEPTH + 1, router.poll());
+  for (uint8_t seq = 0; seq < DEPTH; ++seq)
+  {
+    TEST_ASSERT_EQUAL(seq, port.frames[seq + 1][1]); // 丢弃的是最新的帧，已排队的帧按顺序发送
+  }
+}
+
+/// @brief 端口忙时帧保留在队列头部，恢复后按原顺序发送，不丢失也不重复
+static void test_busy_port_retries_head()
+{
+  TestRouter<> router;
+  MockPort port;
+  router.attach(PORT_B, &port);
+  router.set_route(PORT_A, 1UL << PORT_B);
+  for (uint8_t seq = 0; seq < 4; ++seq)
+  {
+    input(router, PORT_A, CLASS_BULK, seq);
+  }
+  TEST_ASSERT_EQUAL(1, router.service(PORT_B, 1));
+  port.busy = true;
+  TEST_ASSERT_EQUAL(0, router.poll());
+  TEST_ASSERT_EQUAL(0, router.poll());
+  TEST_ASSERT_EQUAL(2, router.stats(PORT_B).busy);
+  TEST_ASSERT_EQUAL(3, router.pending(PORT_B));
+  port.busy = false;
+  TEST_ASSERT_EQUAL(3, router.poll());
+  TEST_ASSERT_EQUAL(4, port.frames.size());
+  for (uint8_t seq = 0; seq < 4; ++seq)
+  {
+    TEST_ASSERT_EQUAL(seq, port.frames[seq][1]);
+  }
+  TEST_ASSERT_EQUAL(4, router.stats(PORT_B).sent);
+}
+
+/// @brief 控制帧严格优先：即使排在已满的数据队列之后进入，也在下一次发送
+static void test_control_frames_go_first()
+{
+  TestRouter<> router;
+  MockPort port;
+  router.attach(PORT_B, &port);
+  router.set_route(PORT_A, 1UL << PORT_B);
+  router.set_classifier(classify_first_byte);
+  for (uint8_t seq = 0; seq < DEPTH; ++seq)
+  {
+    input(router, PORT_A, CLASS_BULK, seq);
+    input(router, PORT_A, CLASS_TELEMETRY, seq);
+  }
+  TEST_ASSERT_EQUAL(2, router.service(PORT_B, 2));
+  input(router, PORT_A, CLASS_CONTROL, 0);
+  TEST_ASSERT_EQUAL(1, router.service(PORT_B, 1));
+  TEST_ASSERT_EQUAL(CLASS_CONTROL, port.frames.back()[0]);
+
+  // 控制帧遇到端口忙时同样保留在头部，恢复后先于数据帧发送
+  input(router, PORT_A, CLASS_CONTROL, 1);
+  port.busy = true;
+  router.poll();
+  port.busy = false;
+  router.service(PORT_B, 1);
+  TEST_ASSERT_EQUAL(CLASS_CONTROL, port.frames.back()[0]);
+  TEST_ASSERT_EQUAL(1, port.frames.back()[1]);
+}
+
+/// @brief 非0优先级之间按权重轮询，空队列的份额不会被保留
+static void test_weighted_round_robin()
+{
+  TestRouter<> router;
+  MockPort port;
+  router.attach(PORT_B, &port);
+  router.set_route(PORT_A, 1UL << PORT_B);
+  router.set_classifier(classify_first_byte);
+  router.set_weight(CLASS_BULK, 3);
+  router.set_weight(CLASS_TELEMETRY, 1);
+  for (uint8_t seq = 0; seq < DEPTH; ++seq)
+  {
+    input(router, PORT_A, CLASS_BULK, seq);
+    input(router, PORT_A, CLASS_TELEMETRY, seq);
+  }
+  router.service(PORT_B, 8);
+  size_t bulk{0};
+  for (const auto &frame : port.frames)
+  {
+    bulk += frame[0] == CLASS_BULK;
+  }
+  TEST_ASSERT_EQUAL(6, bulk);
+
+  router.poll();
+  TEST_ASSERT_EQUAL(2 * DEPTH, port.frames.size());
+  input(router, PORT_A, CLASS_TELEMETRY, 0);
+  TEST_ASSERT_EQUAL(1, router.poll()); // 只有遥测帧时不等待数据帧的份额
+}
+
+/// @brief 分类结果超出范围时按最低优先级处理；预算限制每次调度发送的帧数量
+static void test_classifier_range_and_budget()
+{
+  TestRouter<> router;
+  MockPort port;
+  router.attach(PORT_B, &port);
+  router.set_route(PORT_A, 1UL << PORT_B);
+  router.set_classifier(classify_first_byte);
+  input(router, PORT_A, 0xFF, 0);
+  input(router, PORT_A, CLASS_TELEMETRY, 1);
+  TEST_ASSERT_EQUAL(2, router.pending(PORT_B));
+  TEST_ASSERT_EQUAL(1, router.service(PORT_B, 1));
+  TEST_ASSERT_EQUAL(1, router.service(PORT_B, 1));
+  TEST_ASSERT_EQUAL(0, router.service(PORT_B, 1));
+  TEST_ASSERT_EQUAL(0, port.frames[0][1]);
+  TEST_ASSERT_EQUAL(1, port.frames[1][1]);
+  TEST_ASSERT_EQUAL(0, router.service(PORT_COUNT));
+}
+
+/// @brief 多个任务同时输入、另一个任务调度时，所有进入队列的帧都被发送，且各入口的帧保持顺序
+static void test_concurrent_input()
+{
+  static TestRouter<std::mutex> router;
+  MockPort port;
+  router.attach(PORT_C, &port);
+  router.set_route(PORT_A, 1UL << PORT_C);
+  router.set_route(PORT_B, 1UL << PORT_C);
+  std::atomic<int> producers{2};
+  auto produce = [&](uint8_t ingress)
+  {
+    for (uint32_t seq = 0; seq < 2000; ++seq)
+    {
+      const uint8_t frame[]{ingress, static_cast<uint8_t>(seq), static_cast<uint8_t>(seq >> 8)};
+      while (router.input(ingress, frame, sizeof(frame)) == 0)
+      {
+        std::this_thread::yield();
+      }
+    }
+    --producers;
+  };
+  std::thread a{produce, PORT_A};
+  std::thread b{produce, PORT_B};
+  while (producers > 0 || router.pending(PORT_C) > 0)
+  {
+    if (router.poll() == 0)
+    {
+      std::this_thread::yield();
+    }
+  }
+  a.join();
+  b.join();
+  TEST_ASSERT_EQUAL(4000, port.frames.size());
+  uint32_t next[PORT_COUNT]{};
+  for (const auto &frame : port.frames)
+  {
+    TEST_ASSERT_EQUAL(next[frame[0]]++, frame[1] | frame[2] << 8);
+  }
+}
+
+/// @brief 调度时延：数据队列积压时控制帧从进入到发送经过的帧数量和时间
+static void test_scheduling_latency()
+{
+  TestRouter<> router;
+  MockPort port;
+  router.attach(PORT_B, &port);
+  router.set_route(PORT_A, 1UL << PORT_B);
+  router.set_classifier(classify_first_byte);
+  port.frames.reserve(1 << 16);
+  constexpr int rounds{10000};
+  const uint8_t bulk[MTU]{CLASS_BULK};
+  uint64_t control_ns{0};
+  size_t frames_ahead{0};
+  const auto start{std::chrono::steady_clock::now()};
+  for (int round = 0; round < rounds; ++round)
+  {
+    while (router.input(PORT_A, bulk, sizeof(bulk)))
+    {
+    }
+    router.service(PORT_B, DEPTH / 2);
+    const size_t before{port.frames.size()};
+    const auto enqueued{std::chrono::steady_clock::now()};
+    input(router, PORT_A, CLASS_CONTROL, 0);
+    while (port.frames.size() == before || port.frames.back()[0] != CLASS_CONTROL)
+    {
+      router.service(PORT_B, 1);
+    }
+    control_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - enqueued).count();
+    frames_ahead += port.frames.size() - before - 1;
+    port.frames.clear();
+  }
+  const auto total_ns{std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()};
+  const auto frames{router.stats(PORT_B).sent};
+  printf("router frames=%lu,ns_per_frame=%.1f,control_latency_ns=%.1f,control_frames_ahead=%lu\n",
+         static_cast<unsigned long>(frames), static_cast<double>(total_ns) / frames,
+         static_cast<double>(control_ns) / rounds, static_cast<unsigned long>(frames_ahead));
+  TEST_ASSERT_EQUAL(0, frames_ahead);
+}
+
+/// @brief 伪终端缓存将满时FdPort只写入了部分数据，剩余部分保存下来先于后面的帧写出，从设备端读出的字节流完整且按顺序
+static void test_fd_port_partial_write()
+{
+  PtySerial pty;
+  TEST_ASSERT_TRUE(pty.open());
+  const int slave{open(pty.slave_name(), O_RDWR | O_NOCTTY | O_NONBLOCK)};
+  TEST_ASSERT_TRUE(slave >= 0);
+  termios attr;
+  tcgetattr(slave, &attr);
+  cfmakeraw(&attr);
+  tcsetattr(slave, TCSANOW, &attr);
+
+  FdPort port{pty.fd()};
+  std::vector<uint8_t> expected, received;
+  auto read_some = [&]
+  {
+    uint8_t buffer[100];
+    const ssize_t len{read(slave, buffer, sizeof(buffer))};
+    if (len > 0)
+    {
+      received.insert(received.end(), buffer, buffer + len);
+    }
+  };
+  uint32_t rejected{0};
+  for (uint32_t k = 0; k < 400;)
+  {
+    uint8_t frame[0xFF];
+    for (size_t i = 0; i < sizeof(frame); ++i)
+    {
+      frame[i] = static_cast<uint8_t>(k * 7 + i);
+    }
+    if (port.write(frame, sizeof(frame)))
+    {
+      expected.insert(expected.end(), frame, frame + sizeof(frame));
+      ++k;
+    }
+    else
+    {
+      // 缓存已满：读出一部分后重试同一帧
+      ++rejected;
+      read_some();
+    }
+  }
+  while (!port.flush())
+  {
+    read_some();
+  }
+  for (size_t last = SIZE_MAX; last != received.size();)
+  {
+    last = received.size();
+    read_some();
+  }
+  close(slave);
+  TEST_ASSERT_TRUE(rejected > 0);
+  TEST_ASSERT_EQUAL(expected.size(), received.size());
+  TEST_ASSERT_TRUE(expected == received);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_routing_table);
+  RUN_TEST(test_bounded_queues);
+  RUN_TEST(test_busy_port_retries_head);
+  RUN_TEST(test_control_frames_go_first);
+  RUN_TEST(test_weighted_round_robin);
+  RUN_TEST(test_classifier_range_and_budget);
+  RUN_TEST(test_concurrent_input);
+  RUN_TEST(test_scheduling_latency);
+  RUN_TEST(test_fd_port_partial_write);
+  return UNITY_END();
+}
@@ -0,0 +1,229 @@
+/// @brief 两个模拟节点之间的端到端测试：从串口A写入的数据必须完整、按序地从串口B读出，环回时的往返时延，nRF24和FSK速率自适应随距离升降档
+
+#include <unity.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "sim/sim_bridge.h"
+
+struct GoodputResult
+{
+  bool intact;
+  size_t received;
+  double elapsed_s;
+};
+
+/// @brief 与模拟转发程序的--goodput相同：两个节点在同一个线程中轮询，直到全部收到或超时
+static GoodputResult run_goodput(const SimRadio::Config &config, bool arq, size_t bytes, double timeout_s)
+{
+  SimMedium medium{1};
+  SimBridge node_a{"A", medium, config, arq};
+  SimBridge node_b{"B", medium, config, arq};
+  TEST_ASSERT_TRUE(node_a.open() && node_b.open());
+  GoodputTest goodput{bytes, 1};
+  TEST_ASSERT_TRUE(goodput.open(node_a.serial_name(), node_b.serial_name()));
+
+  const auto start{std::chrono::steady_clock::now()};
+  double elapsed_s{0.0};
+  while (!goodput.done() && elapsed_s < timeout_s)
+  {
+    elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    node_a.poll(static_cast<uint32_t>(elapsed_s * 1000), static_cast<uint32_t>(elapsed_s * 1000000));
+    node_b.poll(static_cast<uint32_t>(elapsed_s * 1000), static_cast<uint32_t>(elapsed_s * 1000000));
+    goodput.poll();
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  return {goodput.intact(), goodput.received(), elapsed_s};
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_lossless_link_is_intact()
+{
+  SimRadio::Config config;
+  const auto result{run_goodput(config, false, 16384, 10.0)};
+  TEST_ASSERT_TRUE(result.intact);
+}
+
+static void test_loss_without_arq_drops_data()
+{
+  SimRadio::Config config;
+  config.loss = 0.1;
+  const auto result{run_goodput(config, false, 16384, 2.0)};
+  TEST_ASSERT_FALSE(result.intact);
+  TEST_ASSERT_LESS_THAN(16384, result.received);
+}
+
+/// @brief 0～30%丢包时ARQ必须完整交付，同时输出吞吐量报告
+static void test_arq_is_intact_under_loss()
+{
+  const double losses[]{0.0, 0.1, 0.2, 0.3};
+  for (double loss : losses)
+  {
+    SimRadio::Config config;
+    config.loss = loss;
+    const auto result{run_goodput(config, true, 32768, 20.0)};
+    printf("arq loss=%.2f,received=%zu,intact=%d,elapsed_ms=%.0f,goodput_bps=%.0f\n", loss, result.received,
+           result.intact, result.elapsed_s * 1000, result.received * 8 / result.elapsed_s);
+    TEST_ASSERT_TRUE(result.intact);
+  }
+}
+
+/// @brief 与模拟转发程序的--loopback相同：串口B环回，测量串口A上探测帧的往返时延
+static LoopbackTest::Report run_loopback(const SimRadio::Config &config, bool arq, uint32_t count, double timeout_s)
+{
+  SimMedium medium{1};
+  SimBridge node_a{"A", medium, config, arq};
+  SimBridge node_b{"B", medium, config, arq};
+  TEST_ASSERT_TRUE(node_a.open() && node_b.open());
+  LoopbackTest loopback{count, 1000, 200000};
+  TEST_ASSERT_TRUE(loopback.open(node_a.serial_name(), node_b.serial_name()));
+
+  const auto start{std::chrono::steady_clock::now()};
+  double elapsed_s{0.0};
+  while (!loopback.done() && elapsed_s < timeout_s)
+  {
+    elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const auto now_us{static_cast<uint32_t>(elapsed_s * 1000000)};
+    node_a.poll(now_us / 1000, now_us);
+    node_b.poll(now_us / 1000, now_us);
+    loopback.poll(now_us);
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  return loopback.report();
+}
+
+/// @brief 往返经过两次无线发送，时延不小于两次空中时间，同时输出往返时延报告
+static void test_loopback_round_trip()
+{
+  const uint32_t latencies_us[]{0, 2000};
+  for (const auto latency_us : latencies_us)
+  {
+    SimRadio::Config config;
+    config.latency_us = latency_us;
+    const auto report{run_loopback(config, false, 100, 10.0)};
+    printf("loopback latency_us=%lu,received=%lu,min_us=%lu,mean_us=%lu,p99_us=%lu,max_us=%lu\n",
+           static_cast<unsigned long>(latency_us), static_cast<unsigned long>(report.received),
+           static_cast<unsigned long>(report.min_us), static_cast<unsigned long>(report.mean_us),
+           static_cast<unsigned long>(report.p99_us), static_cast<unsigned long>(report.max_us));
+    TEST_ASSERT_EQUAL(100, report.sent);
+    TEST_ASSERT_EQUAL(100, report.received);
+    TEST_ASSERT_EQUAL(0, report.lost);
+    TEST_ASSERT_TRUE(report.min_us >= 2 * latency_us);
+    TEST_ASSERT_TRUE(report.min_us <= report.mean_us && report.mean_us <= report.p99_us && report.p99_us <= report.max_us);
+  }
+}
+
+/// @brief 与模拟转发程序的--radio=nrf24 --rate-control=1相同：近距离时从启动档位升档，距离变远后两端降到250 kbps
+static void test_nrf24_rate_control()
+{
+  SimRadio::Config config;
+  config.tx_power_dbm = 0.0;
+  config.noise_figure_db = 16.0;
+  SimMedium medium{1};
+  // 2 Mbps、-12 dBm时仍有10 dB余量
+  medium.set_path_loss(60.0);
+  SimBridge node_a{"A", medium, config};
+  SimBridge node_b{"B", medium, config};
+  TEST_ASSERT_TRUE(node_a.open() && node_b.open());
+  node_a.enable_nrf24_rate_control(true);
+  node_b.enable_nrf24_rate_control(false);
+  TEST_ASSERT_EQUAL(NRF24_PROFILE_HOME, node_a.rate_level());
+
+  const auto start{std::chrono::steady_clock::now()};
+  auto run = [&](double until_s, auto &&done)
+  {
+    double elapsed_s{0.0};
+    while (!done() && elapsed_s < until_s)
+    {
+      elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      const auto now_us{static_cast<uint32_t>(elapsed_s * 1000000)};
+      node_a.poll(now_us / 1000, now_us);
+      node_b.poll(now_us / 1000, now_us);
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return elapsed_s;
+  };
+  const double up_s{run(15.0, [&]
+                        { return node_a.rate_level() > NRF24_PROFILE_HOME && node_b.rate_level() == node_a.rate_level(); })};
+  printf("nrf24 rate up level=%d,elapsed_ms=%.0f\n", node_a.rate_level(), up_s * 1000);
+  TEST_ASSERT_TRUE(node_a.rate_level() > NRF24_PROFILE_HOME);
+  TEST_ASSERT_EQUAL(node_a.rate_level(), node_b.rate_level());
+
+  // 1 Mbps及以上档位几乎全部丢包，250 kbps仍有3 dB余量
+  medium.set_path_loss(88.0);
+  const double down_s{run(up_s + 15.0, [&]
+                          { return node_a.rate_level() == 0 && node_b.rate_level() == 0; })};
+  printf("nrf24 rate down level=%d/%d,elapsed_ms=%.0f\n", node_a.rate_level(), node_b.rate_level(), (down_s - up_s) * 1000);
+  TEST_ASSERT_EQUAL(0, node_a.rate_level());
+  TEST_ASSERT_EQUAL(0, node_b.rate_level());
+}
+
+/// @brief 与模拟转发程序的--radio=sx1262 --rate-control=1 --distance=300 --distance-end=7300 --sweep-s=5相同：
+/// 近距离时从启动档位升档，距离按对数逐渐拉远后两端降到4.8 kbps
+static void test_fsk_rate_control()
+{
+  // 默认22 dBm、噪声系数6 dB，路径损耗指数2.7
+  SimRadio::Config config;
+  SimMedium medium{1};
+  const double near_m{300.0}, far_m{7300.0}, sweep_s{5.0};
+  // 300 m时RSSI约-77 dBm，高于120 kbps的门限24 dB
+  medium.set_path_loss(sim_path_loss_db(near_m, 2.7, 915.0));
+  SimBridge node_a{"A", medium, config};
+  SimBridge node_b{"B", medium, config};
+  TEST_ASSERT_TRUE(node_a.open() && node_b.open());
+  node_a.enable_fsk_rate_control(true);
+  node_b.enable_fsk_rate_control(false);
+  TEST_ASSERT_EQUAL(FSK_PROFILE_HOME, node_a.rate_level());
+
+  const auto start{std::chrono::steady_clock::now()};
+  double sweep_start_s{-1.0};
+  auto run = [&](double until_s, auto &&done)
+  {
+    double elapsed_s{0.0};
+    while (!done() && elapsed_s < until_s)
+    {
+      elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      if (sweep_start_s >= 0.0)
+      {
+        const double phase{std::min((elapsed_s - sweep_start_s) / sweep_s, 1.0)};
+        medium.set_path_loss(sim_path_loss_db(near_m * std::pow(far_m / near_m, phase), 2.7, 915.0));
+      }
+      const auto now_us{static_cast<uint32_t>(elapsed_s * 1000000)};
+      node_a.poll(now_us / 1000, now_us);
+      node_b.poll(now_us / 1000, now_us);
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return elapsed_s;
+  };
+  const double up_s{run(15.0, [&]
+                        { return node_a.rate_level() > FSK_PROFILE_HOME && node_b.rate_level() == node_a.rate_level(); })};
+  printf("fsk rate up level=%d,elapsed_ms=%.0f\n", node_a.rate_level(), up_s * 1000);
+  TEST_ASSERT_TRUE(node_a.rate_level() > FSK_PROFILE_HOME);
+  TEST_ASSERT_EQUAL(node_a.rate_level(), node_b.rate_level());
+
+  // 7300 m时RSSI约-114 dBm，低于9.6 kbps的门限，4.8 kbps仍有4 dB余量
+  sweep_start_s = up_s;
+  const double down_s{run(up_s + sweep_s + 20.0, [&]
+                          { return node_a.rate_level() == 0 && node_b.rate_level() == 0; })};
+  printf("fsk rate down level=%d/%d,elapsed_ms=%.0f\n", node_a.rate_level(), node_b.rate_level(), (down_s - up_s) * 1000);
+  TEST_ASSERT_EQUAL(0, node_a.rate_level());
+  TEST_ASSERT_EQUAL(0, node_b.rate_level());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_lossless_link_is_intact);
+  RUN_TEST(test_loss_without_arq_drops_data);
+  RUN_TEST(test_arq_is_intact_under_loss);
+  RUN_TEST(test_loopback_round_trip);
+  RUN_TEST(test_nrf24_rate_control);
+  RUN_TEST(test_fsk_rate_control);
+  return UNITY_END();
+}
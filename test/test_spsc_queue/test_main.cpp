@@ -0,0 +1,152 @@
+/// @brief SpscRingQueue测试：单线程边界条件，以及生产者、消费者分别在两个线程上的压力测试
+
+#include <unity.h>
+
+#include <thread>
+
+#include "spsc_queue.hpp"
+
+#ifndef STRESS_ITEMS
+#define STRESS_ITEMS 4000000U
+#endif
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_push_until_full()
+{
+  SpscRingQueue<uint32_t, 4> queue;
+  TEST_ASSERT_TRUE(queue.empty());
+  for (uint32_t i = 0; i < 4; ++i)
+  {
+    TEST_ASSERT_TRUE(queue.push(i));
+  }
+  TEST_ASSERT_TRUE(queue.full());
+  TEST_ASSERT_FALSE(queue.push(4));
+  uint32_t value{0};
+  TEST_ASSERT_TRUE(queue.pop(value));
+  TEST_ASSERT_EQUAL(0, value);
+  TEST_ASSERT_TRUE(queue.push(4));
+  TEST_ASSERT_EQUAL(4, queue.len());
+  for (uint32_t i = 1; i <= 4; ++i)
+  {
+    TEST_ASSERT_TRUE(queue.pop(value));
+    TEST_ASSERT_EQUAL(i, value);
+  }
+  TEST_ASSERT_FALSE(queue.pop(value));
+  TEST_ASSERT_NULL(queue.front());
+}
+
+/// @brief 索引是自由增长的uint32_t，跨越溢出点后长度和顺序仍然正确
+static void test_index_wraps_around()
+{
+  SpscRingQueue<uint32_t, 8> queue;
+  uint32_t value{0};
+  for (uint32_t i = 0; i < 1000; ++i)
+  {
+    TEST_ASSERT_TRUE(queue.push(i));
+    TEST_ASSERT_TRUE(queue.push(i + 1));
+    TEST_ASSERT_TRUE(queue.pop(value));
+    TEST_ASSERT_EQUAL(i, value);
+    TEST_ASSERT_TRUE(queue.pop(value));
+    TEST_ASSERT_EQUAL(i + 1, value);
+  }
+  TEST_ASSERT_TRUE(queue.empty());
+}
+
+/// @brief 两个线程各自持有一端，消费者检查收到的序列连续且不重复
+///        队列满或空时让出CPU，单核主机上也能在合理时间内完成
+static void test_two_thread_stress()
+{
+  static SpscRingQueue<uint32_t, 256> queue;
+  std::thread producer{[]
+                       {
+                         for (uint32_t i = 0; i < STRESS_ITEMS;)
+                         {
+                           if (queue.push(i))
+                           {
+                             ++i;
+                           }
+                           else
+                           {
+                             std::this_thread::yield();
+                           }
+                         }
+                       }};
+  uint32_t expected{0};
+  bool ordered{true};
+  while (expected < STRESS_ITEMS)
+  {
+    uint32_t value;
+    if (queue.pop(value))
+    {
+      ordered = ordered && value == expected;
+      ++expected;
+    }
+    else
+    {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  TEST_ASSERT_TRUE(ordered);
+  TEST_ASSERT_TRUE(queue.empty());
+}
+
+/// @brief 批量读写的压力测试：每次写入和读取的长度都不同，使区域经常跨越回绕点
+static void test_two_thread_bulk_stress()
+{
+  static SpscRingQueue<uint32_t, 64> queue;
+  std::thread producer{[]
+                       {
+                         uint32_t buffer[23];
+                         for (uint32_t next = 0, step = 1; next < STRESS_ITEMS; step = step % 23 + 1)
+                         {
+                           const uint32_t count{std::min(step, STRESS_ITEMS - next)};
+                           for (uint32_t i = 0; i < count; ++i)
+                           {
+                             buffer[i] = next + i;
+                           }
+                           for (uint32_t written = 0; written < count;)
+                           {
+                             const uint32_t result{queue.write(buffer + written, count - written)};
+                             if (result == 0)
+                             {
+                               std::this_thread::yield();
+                             }
+                             written += result;
+                           }
+                           next += count;
+                         }
+                       }};
+  uint32_t expected{0};
+  bool ordered{true};
+  uint32_t buffer[17];
+  for (uint32_t step = 1; expected < STRESS_ITEMS; step = step % 17 + 1)
+  {
+    const uint32_t count{queue.read(buffer, step)};
+    if (count == 0)
+    {
+      std::this_thread::yield();
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      ordered = ordered && buffer[i] == expected + i;
+    }
+    expected += count;
+  }
+  producer.join();
+  TEST_ASSERT_TRUE(ordered);
+  TEST_ASSERT_EQUAL(STRESS_ITEMS, expected);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_push_until_full);
+  RUN_TEST(test_index_wraps_around);
+  RUN_TEST(test_two_thread_stress);
+  RUN_TEST(test_two_thread_bulk_stress);
+  return UNITY_END();
+}
@@ -0,0 +1,267 @@
+/// @brief 追踪测试：环形缓存的覆盖与清空、数据包标识的分配，以及同一个标识经过串口读入、路由器和ARQ到达设备
+
+#include <unity.h>
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "arq.hpp"
+#include "packet_pool.hpp"
+#include "router.hpp"
+#include "spsc_queue.hpp"
+#include "trace.hpp"
+#include "uart_ingest.h"
+
+struct Event
+{
+  TraceStage stage;
+  uint32_t id;
+};
+
+void setUp()
+{
+  trace_clear();
+  TRACE_SET_CURRENT(0);
+}
+
+void tearDown() {}
+
+static std::vector<Event> events()
+{
+  std::vector<Event> result;
+  trace_rings[0].for_each([&](const TraceRing<TRACE_RING_SIZE>::Event &event)
+                          { result.push_back({event.stage, event.id}); });
+  return result;
+}
+
+static std::vector<uint32_t> ids_of(TraceStage stage)
+{
+  std::vector<uint32_t> ids;
+  for (const auto &event : events())
+  {
+    if (event.stage == stage)
+    {
+      ids.push_back(event.id);
+    }
+  }
+  return ids;
+}
+
+/// @brief 缓存写满后保留最新的记录，按写入顺序遍历，清空后为空
+static void test_ring_overwrites_oldest()
+{
+  TraceRing<8> ring;
+  for (uint32_t i = 0; i < 20; ++i)
+  {
+    ring.record(TraceStage::DEQUEUE, i, i * 10);
+  }
+  std::vector<uint32_t> ids;
+  ring.for_each([&](const TraceRing<8>::Event &event)
+                { ids.push_back(event.id); TEST_ASSERT_EQUAL(event.id * 10, event.ts_us); });
+  TEST_ASSERT_EQUAL(8, ids.size());
+  for (uint32_t i = 0; i < 8; ++i)
+  {
+    TEST_ASSERT_EQUAL(12 + i, ids[i]);
+  }
+  ring.clear();
+  size_t count{0};
+  ring.for_each([&](const TraceRing<8>::Event &)
+                { ++count; });
+  TEST_ASSERT_EQUAL(0, count);
+}
+
+/// @brief 多个线程同时写入时，遍历只返回完整的记录
+static void test_concurrent_record()
+{
+  static TraceRing<64> ring;
+  std::atomic<bool> running{true};
+  std::thread writers[2];
+  for (uint32_t t = 0; t < 2; ++t)
+  {
+    writers[t] = std::thread{[&, t]
+                             {
+                               for (uint32_t i = 0; running; ++i)
+                               {
+                                 // 标识与时间戳一致，遍历时可以检查记录是否完整
+                                 const uint32_t id{t << 24 | (i & 0xFFFFFF)};
+                                 ring.record(TraceStage::PORT_WRITE, id, id);
+                                 if ((i & 0xFF) == 0)
+                                 {
+                                   std::this_thread::yield();
+                                 }
+                               }
+                             }};
+  }
+  for (int round = 0; round < 2000; ++round)
+  {
+    ring.for_each([](const TraceRing<64>::Event &event)
+                  {
+                    TEST_ASSERT_EQUAL(event.id, event.ts_us);
+                    TEST_ASSERT_TRUE(event.stage == TraceStage::PORT_WRITE); });
+    std::this_thread::yield();
+  }
+  running = false;
+  for (auto &writer : writers)
+  {
+    writer.join();
+  }
+}
+
+/// @brief 数据包标识不为0且不重复，计数回绕时跳过0
+static void test_new_id_skips_zero()
+{
+  const uint32_t first{TRACE_NEW_ID()};
+  TEST_ASSERT_TRUE(first != 0);
+  TEST_ASSERT_EQUAL(first + 1, TRACE_NEW_ID());
+  trace_last_id.store(UINT32_MAX - 1);
+  TEST_ASSERT_EQUAL(UINT32_MAX, TRACE_NEW_ID());
+  TEST_ASSERT_EQUAL(1, TRACE_NEW_ID());
+}
+
+/// @brief 导出的Chrome trace JSON包含阶段名称和数据包标识
+static void test_export_chrome()
+{
+  trace_record(TraceStage::UART_INGEST, 7);
+  trace_record(TraceStage::AIR_DONE, 7);
+  std::string json;
+  trace_export_chrome([&](const char *data, size_t len)
+                      { json.append(data, len); });
+  TEST_ASSERT_TRUE(json.rfind("{\"traceEvents\":[\n", 0) == 0);
+  TEST_ASSERT_TRUE(json.find("\"name\":\"uart_ingest\"") != std::string::npos);
+  TEST_ASSERT_TRUE(json.find("\"name\":\"air_done\"") != std::string::npos);
+  TEST_ASSERT_TRUE(json.find("\"args\":{\"id\":7}") != std::string::npos);
+  TEST_ASSERT_EQUAL_STRING("\n]}\n", json.c_str() + json.size() - 4);
+}
+
+class MemoryByteSource : public ByteSource
+{
+private:
+  const uint8_t *__data;
+  size_t __len;
+  size_t __pos{0};
+
+public:
+  MemoryByteSource(const uint8_t *data, size_t len) : __data(data), __len(len) {}
+
+  size_t available() override { return __len - __pos; }
+
+  size_t read(uint8_t *buffer, size_t size) override
+  {
+    size = size < available() ? size : available();
+    memcpy(buffer, __data + __pos, size);
+    __pos += size;
+    return size;
+  }
+};
+
+/// @brief 记录写入时的当前数据包标识，模拟在send_async中读取TRACE_CURRENT的设备
+class CapturePort : public RouterPort
+{
+public:
+  std::vector<uint32_t> ids;
+  bool busy{false};
+
+  bool write(const uint8_t *, size_t) override
+  {
+    if (busy)
+    {
+      return false;
+    }
+    ids.push_back(TRACE_CURRENT());
+    return true;
+  }
+};
+
+/// @brief 串口读入分配的标识经过数据包池、路由器队列传到出口端口，端口忙重试时仍然是同一个标识
+static void test_id_follows_packet_through_router()
+{
+  uint8_t input[40];
+  memset(input, 0x11, sizeof(input));
+  MemoryByteSource source{input, sizeof(input)};
+  PacketPool<16, 4> pool;
+  SpscRingQueue<uint8_t, 4> queue;
+  UartIngest<decltype(pool), decltype(queue)> ingest{source, pool, queue, 16};
+  Router<2, 1, 16, 4> router;
+  CapturePort port;
+  router.attach(1, &port);
+  router.set_route(0, 1UL << 1);
+
+  TEST_ASSERT_EQUAL(3, ingest.poll());
+  uint8_t handle;
+  while (queue.pop(handle))
+  {
+    TRACE_EVENT(DEQUEUE, pool[handle].trace_id);
+    router.input(0, pool[handle].data, pool[handle].len, pool[handle].trace_id);
+    pool.release(handle);
+  }
+  port.busy = true;
+  router.poll();
+  port.busy = false;
+  router.poll();
+  TEST_ASSERT_EQUAL(0, TRACE_CURRENT()); // 调度结束后清除当前数据包
+
+  const auto ingested{ids_of(TraceStage::UART_INGEST)};
+  TEST_ASSERT_EQUAL(3, ingested.size());
+  TEST_ASSERT_TRUE(ingested[0] != ingested[1] && ingested[1] != ingested[2]);
+  TEST_ASSERT_TRUE(ids_of(TraceStage::DEQUEUE) == ingested);
+  TEST_ASSERT_TRUE(ids_of(TraceStage::PORT_WRITE) == ingested);
+  TEST_ASSERT_TRUE(port.ids == ingested);
+}
+
+/// @brief 未指定标识时路由器使用当前数据包，与主循环中经合并器或radio_send进入路由器的路径相同
+static void test_router_input_uses_current_id()
+{
+  Router<2, 1, 16, 4> router;
+  CapturePort port;
+  router.attach(1, &port);
+  router.set_route(0, 1UL << 1);
+  const uint8_t frame[]{1, 2, 3};
+  TRACE_SET_CURRENT(42);
+  router.input(0, frame, sizeof(frame));
+  TRACE_SET_CURRENT(0);
+  router.input(0, frame, sizeof(frame));
+  router.poll();
+  TEST_ASSERT_EQUAL(2, port.ids.size());
+  TEST_ASSERT_EQUAL(42, port.ids[0]);
+  TEST_ASSERT_EQUAL(0, port.ids[1]);
+}
+
+/// @brief ArqLink保存加入发送窗口时的标识，首次发送和超时重发时设备看到的都是这个标识，ACK不属于任何数据包
+static void test_id_follows_arq_retransmission()
+{
+  ArqLink<32> arq;
+  const uint8_t frame[]{1, 2, 3};
+  TRACE_SET_CURRENT(5);
+  TEST_ASSERT_TRUE(arq.send(frame, sizeof(frame)));
+  TRACE_SET_CURRENT(6);
+  TEST_ASSERT_TRUE(arq.send(frame, sizeof(frame)));
+  TRACE_SET_CURRENT(0);
+
+  std::vector<uint32_t> ids;
+  auto transmit = [&](const uint8_t *, size_t)
+  {
+    ids.push_back(TRACE_CURRENT());
+    return true;
+  };
+  arq.poll(0, transmit);
+  arq.poll(arq.rto_us() + 1, transmit);
+  const std::vector<uint32_t> expected{5, 6, 5, 6};
+  TEST_ASSERT_TRUE(ids == expected);
+  TEST_ASSERT_EQUAL(0, TRACE_CURRENT());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_ring_overwrites_oldest);
+  RUN_TEST(test_concurrent_record);
+  RUN_TEST(test_new_id_skips_zero);
+  RUN_TEST(test_export_chrome);
+  RUN_TEST(test_id_follows_packet_through_router);
+  RUN_TEST(test_router_input_uses_current_id);
+  RUN_TEST(test_id_follows_arq_retransmission);
+  return UNITY_END();
+}
@@ -0,0 +1,167 @@
+/// @brief UartIngest测试：分包、数据包池耗尽后的继续读取、转发路径不申请堆内存
+
+#include <unity.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "packet_pool.hpp"
+#include "spsc_queue.hpp"
+#include "uart_ingest.h"
+
+// 统计全局operator new的调用次数，验证转发路径不申请堆内存
+static std::atomic<uint32_t> allocations{0};
+
+void *operator new(size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *ptr = malloc(size ? size : 1))
+  {
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+/// @brief 从内存读取的字节流来源，模拟串口驱动缓存
+class MemoryByteSource : public ByteSource
+{
+private:
+  const uint8_t *__data;
+  size_t __len;
+  size_t __pos{0};
+
+public:
+  MemoryByteSource(const uint8_t *data, size_t len) : __data(data), __len(len) {}
+
+  size_t available() override { return __len - __pos; }
+
+  size_t read(uint8_t *buffer, size_t size) override
+  {
+    size = size < available() ? size : available();
+    memcpy(buffer, __data + __pos, size);
+    __pos += size;
+    return size;
+  }
+};
+
+using Pool = PacketPool<8, 2>;
+using Queue = SpscRingQueue<Pool::handle_t, 2>;
+
+static uint8_t input[64];
+
+/// @brief 取出队列中的所有数据包，追加到output并归还槽位
+template <typename _Pool, typename _Queue>
+static size_t drain(_Pool &pool, _Queue &queue, uint8_t *output, size_t offset)
+{
+  typename _Pool::handle_t handle;
+  while (queue.pop(handle))
+  {
+    memcpy(output + offset, pool[handle].data, pool[handle].len);
+    offset += pool[handle].len;
+    pool.release(handle);
+  }
+  return offset;
+}
+
+void setUp()
+{
+  for (size_t i = 0; i < sizeof(input); ++i)
+  {
+    input[i] = static_cast<uint8_t>(i * 7 + 1);
+  }
+}
+
+void tearDown() {}
+
+static void test_splits_into_chunks()
+{
+  Pool pool;
+  Queue queue;
+  MemoryByteSource source{input, 12};
+  UartIngest<Pool, Queue> ingest{source, pool, queue, 5};
+  TEST_ASSERT_EQUAL(2, ingest.poll());
+  TEST_ASSERT_EQUAL(5, pool[*queue.front()].len);
+  uint8_t output[sizeof(input)];
+  TEST_ASSERT_EQUAL(10, drain(pool, queue, output, 0));
+  TEST_ASSERT_EQUAL(1, ingest.poll());
+  TEST_ASSERT_EQUAL(12, drain(pool, queue, output, 10));
+  TEST_ASSERT_EQUAL_MEMORY(input, output, 12);
+  TEST_ASSERT_FALSE(ingest.stalled());
+  TEST_ASSERT_EQUAL(12, ingest.stats().bytes.load());
+}
+
+/// @brief 数据包池耗尽时剩余数据留在来源中，释放槽位后再次poll即可继续，数据不丢失、不乱序
+static void test_resumes_after_pool_exhausted()
+{
+  PacketPool<8, 2> pool;
+  SpscRingQueue<Pool::handle_t, 4> queue;
+  MemoryByteSource source{input, 40};
+  UartIngest<decltype(pool), decltype(queue)> ingest{source, pool, queue, 8};
+  TEST_ASSERT_EQUAL(2, ingest.poll());
+  TEST_ASSERT_TRUE(ingest.stalled());
+  TEST_ASSERT_EQUAL(1, ingest.stats().pool_exhausted.load());
+  TEST_ASSERT_EQUAL(24, source.available());
+
+  uint8_t output[sizeof(input)];
+  size_t received{0};
+  while (ingest.stalled())
+  {
+    received = drain(pool, queue, output, received);
+    ingest.poll();
+  }
+  received = drain(pool, queue, output, received);
+  TEST_ASSERT_EQUAL(40, received);
+  TEST_ASSERT_EQUAL_MEMORY(input, output, 40);
+  TEST_ASSERT_EQUAL(0, source.available());
+}
+
+/// @brief 队列已满时不读取数据，避免读出后无处存放
+static void test_stops_before_reading_when_queue_full()
+{
+  PacketPool<8, 4> pool;
+  Queue queue;
+  MemoryByteSource source{input, 32};
+  UartIngest<decltype(pool), Queue> ingest{source, pool, queue, 8};
+  TEST_ASSERT_EQUAL(2, ingest.poll());
+  TEST_ASSERT_TRUE(ingest.stalled());
+  TEST_ASSERT_EQUAL(16, source.available());
+  TEST_ASSERT_EQUAL(2, pool.available());
+  TEST_ASSERT_EQUAL(0, ingest.stats().pool_exhausted.load());
+}
+
+/// @brief 转发过程中每个数据包的堆申请次数为0
+static void test_forwarding_does_not_allocate()
+{
+  static Pool pool;
+  static Queue queue;
+  static uint8_t output[sizeof(input)];
+  const uint32_t before{allocations.load()};
+  for (int round = 0; round < 1000; ++round)
+  {
+    MemoryByteSource source{input, sizeof(input)};
+    UartIngest<Pool, Queue> ingest{source, pool, queue, 8};
+    size_t received{0};
+    do
+    {
+      ingest.poll();
+      received = drain(pool, queue, output, received);
+    } while (ingest.stalled());
+    TEST_ASSERT_EQUAL(sizeof(input), received);
+  }
+  TEST_ASSERT_EQUAL(before, allocations.load());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_splits_into_chunks);
+  RUN_TEST(test_resumes_after_pool_exhausted);
+  RUN_TEST(test_stops_before_reading_when_queue_full);
+  RUN_TEST(test_forwarding_does_not_allocate);
+  return UNITY_END();
+}